@@ -1,4 +1,5 @@
 #include "config.h"
+#include "utils/log.h"
 #include <Preferences.h>
 
 // Define the global config instance
@@ -14,6 +15,47 @@ bool layoutsLoaded = false;
 // Preferences object - extern (defined in main.cpp)
 extern Preferences prefs;
 
+#define TEMP_INTERVAL_MIN_MS  100
+#define TEMP_INTERVAL_MAX_MS  10000
+
+// A OneWire bus needs an output-capable GPIO that the board does not use
+static bool isFreeOneWirePin(uint8_t pin) {
+  // 34-39 are input-only, 6-11 are the SPI flash, 20/24/28-31 do not exist,
+  // 1 and 3 are the serial console
+  if (pin > 33 || (pin >= 6 && pin <= 11) || pin == 20 || pin == 24 || (pin >= 28 && pin <= 31) ||
+      pin == 1 || pin == 3) {
+    return false;
+  }
+  const uint8_t used[] = {TFT_CS, TFT_DC, TFT_MOSI, TFT_SCK, TFT_MISO, TFT_BL, TOUCH_CS,
+                          RTC_SDA, RTC_SCL, FAN_PWM, LED_RED, LED_GREEN, LED_BLUE, BTN_MODE,
+                          SD_CS, SD_MOSI, SD_SCK, SD_MISO};
+  for (uint8_t usedPin : used) {
+    if (pin == usedPin) return false;
+  }
+  return true;
+}
+
+// Drop unusable and repeated bus pins from cfg.onewire_pins (NVS "ow_pins");
+// with none left, the default bus pin is used
+static void validateOneWirePins() {
+  uint8_t pins[ONEWIRE_MAX_BUSES];
+  uint8_t count = 0;
+  memset(pins, ONEWIRE_PIN_NONE, sizeof(pins));
+  for (uint8_t i = 0; i < ONEWIRE_MAX_BUSES; i++) {
+    uint8_t pin = cfg.onewire_pins[i];
+    if (pin == ONEWIRE_PIN_NONE) continue;
+    bool repeated = false;
+    for (uint8_t j = 0; j < count; j++) repeated |= pins[j] == pin;
+    if (repeated || !isFreeOneWirePin(pin)) {
+      LOGW("CONFIG", "OneWire bus on GPIO%d ignored (%s)", pin, repeated ? "listed twice" : "not a free GPIO");
+      continue;
+    }
+    pins[count++] = pin;
+  }
+  if (count == 0) pins[0] = ONE_WIRE_BUS_1;
+  memcpy(cfg.onewire_pins, pins, sizeof(pins));
+}
+
 void initDefaultConfig() {
   strcpy(cfg.device_name, "fluiddash");
   strcpy(cfg.fluidnc_ip, "192.168.73.13");
@@ -27,8 +69,17 @@ void initDefaultConfig() {
   cfg.temp_offset_yl = 0.0;
   cfg.temp_offset_yr = 0.0;
   cfg.temp_offset_z = 0.0;
+  cfg.temp_resolution = 12;
+  cfg.temp_update_interval = 1000;
+  memset(cfg.onewire_pins, ONEWIRE_PIN_NONE, sizeof(cfg.onewire_pins));
+  cfg.onewire_pins[0] = ONE_WIRE_BUS_1;
+  cfg.temp_filter = TEMP_FILTER_EMA;
   cfg.fan_min_speed = 30;
   cfg.fan_max_speed_limit = 100;
+  cfg.fan_mode = FAN_MODE_CURVE;
+  cfg.fan_hysteresis = 2.0;
+  cfg.fan_target_temp = 40.0;
+  cfg.fan_max_rpm = 0;
 
   cfg.psu_voltage_cal = 7.3;
   cfg.psu_alert_low = 23.0;
@@ -47,6 +98,7 @@ void initDefaultConfig() {
   cfg.use_inches = false;
 
   cfg.enable_logging = false;
+  cfg.enable_trace = false;
   cfg.status_update_rate = 200;
 }
 
@@ -64,9 +116,21 @@ void loadConfig() {
   cfg.temp_offset_yl = prefs.getFloat("cal_yl", 0.0);
   cfg.temp_offset_yr = prefs.getFloat("cal_yr", 0.0);
   cfg.temp_offset_z = prefs.getFloat("cal_z", 0.0);
+  cfg.temp_resolution = constrain(prefs.getUChar("temp_res", 12), (uint8_t)9, (uint8_t)12);
+  cfg.temp_update_interval = constrain(prefs.getUShort("temp_int", 1000),
+                                       (uint16_t)TEMP_INTERVAL_MIN_MS, (uint16_t)TEMP_INTERVAL_MAX_MS);
+  memset(cfg.onewire_pins, ONEWIRE_PIN_NONE, sizeof(cfg.onewire_pins));
+  cfg.onewire_pins[0] = ONE_WIRE_BUS_1;
+  prefs.getBytes("ow_pins", cfg.onewire_pins, sizeof(cfg.onewire_pins));
+  validateOneWirePins();
+  cfg.temp_filter = min(prefs.getUChar("temp_filt", TEMP_FILTER_EMA), (uint8_t)TEMP_FILTER_MEDIAN);
 
   cfg.fan_min_speed = prefs.getUChar("fan_min", 30);
   cfg.fan_max_speed_limit = prefs.getUChar("fan_max", 100);
+  cfg.fan_mode = min(prefs.getUChar("fan_mode", FAN_MODE_CURVE), (uint8_t)FAN_MODE_PID);
+  cfg.fan_hysteresis = prefs.getFloat("fan_hyst", 2.0);
+  cfg.fan_target_temp = prefs.getFloat("fan_target", 40.0);
+  cfg.fan_max_rpm = prefs.getUShort("fan_rpm", 0);
 
   cfg.psu_voltage_cal = prefs.getFloat("psu_cal", 7.3);
   cfg.psu_alert_low = prefs.getFloat("psu_low", 22.0);
@@ -85,11 +149,12 @@ void loadConfig() {
   cfg.use_inches = prefs.getBool("use_in", false);
 
   cfg.enable_logging = prefs.getBool("logging", false);
+  cfg.enable_trace = prefs.getBool("trace", false);
   cfg.status_update_rate = prefs.getUShort("status_rate", 200);
 
   prefs.end();
 
-  Serial.println("Configuration loaded");
+  LOGI("CONFIG", "Configuration loaded");
 }
 
 void saveConfig() {
@@ -106,9 +171,17 @@ void saveConfig() {
   prefs.putFloat("cal_yl", cfg.temp_offset_yl);
   prefs.putFloat("cal_yr", cfg.temp_offset_yr);
   prefs.putFloat("cal_z", cfg.temp_offset_z);
+  prefs.putUChar("temp_res", cfg.temp_resolution);
+  prefs.putUShort("temp_int", cfg.temp_update_interval);
+  prefs.putBytes("ow_pins", cfg.onewire_pins, sizeof(cfg.onewire_pins));
+  prefs.putUChar("temp_filt", cfg.temp_filter);
 
   prefs.putUChar("fan_min", cfg.fan_min_speed);
   prefs.putUChar("fan_max", cfg.fan_max_speed_limit);
+  prefs.putUChar("fan_mode", cfg.fan_mode);
+  prefs.putFloat("fan_hyst", cfg.fan_hysteresis);
+  prefs.putFloat("fan_target", cfg.fan_target_temp);
+  prefs.putUShort("fan_rpm", cfg.fan_max_rpm);
 
   prefs.putFloat("psu_cal", cfg.psu_voltage_cal);
   prefs.putFloat("psu_low", cfg.psu_alert_low);
@@ -127,9 +200,10 @@ void saveConfig() {
   prefs.putBool("use_in", cfg.use_inches);
 
   prefs.putBool("logging", cfg.enable_logging);
+  prefs.putBool("trace", cfg.enable_trace);
   prefs.putUShort("status_rate", cfg.status_update_rate);
 
   prefs.end();
 
-  Serial.println("Configuration saved");
+  LOGI("CONFIG", "Configuration saved");
 }
@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include <Arduino.h>
+#include "pins.h"
 
 // Display Modes
 enum DisplayMode {
@@ -11,6 +12,18 @@ enum DisplayMode {
   MODE_NETWORK
 };
 
+// Temperature smoothing (sensor pipeline filter stage)
+enum TempFilter {
+  TEMP_FILTER_NONE,
+  TEMP_FILTER_EMA,      // Exponential moving average, alpha 0.25
+  TEMP_FILTER_MEDIAN    // Median of the last 5 samples
+};
+
+enum FanMode {
+  FAN_MODE_CURVE,       // Linear between the temperature thresholds, with hysteresis
+  FAN_MODE_PID          // Hold the hottest channel at fan_target_temp
+};
+
 // Element types for JSON-defined screens
 enum ElementType {
     ELEM_NONE = 0,
@@ -45,6 +58,21 @@ struct ScreenElement {
     bool filled;             // For rectangles - filled or outline
     TextAlign align;         // Text alignment
     bool showLabel;          // Show label prefix
+    uint8_t slot;            // View-model slot with the formatted value (0xFF = none)
+};
+
+// Display list operation kinds (compiled from elements at load time)
+enum DisplayOpKind : uint8_t {
+    OP_FILL_RECT = 0,       // Opaque fill, possibly merged from several rects
+    OP_ELEMENT              // Any other element, drawn via drawElement()
+};
+
+// One entry of a compiled display list
+struct DisplayOp {
+    uint8_t kind;            // DisplayOpKind
+    uint8_t elem;            // Index into ScreenLayout.elements
+    int16_t x, y, w, h;      // Bounds (merged box for fills, text extent for text)
+    uint16_t color;          // Fill colour (OP_FILL_RECT only)
 };
 
 // Screen layout definition
@@ -54,6 +82,19 @@ struct ScreenLayout {
     ScreenElement elements[60];  // Max 60 elements per screen
     uint8_t elementCount;
     bool isValid;
+    uint8_t droppedElements;     // Elements in the JSON beyond the 60-element cap
+    uint64_t unknownSourceMask;  // Bit i set: element i has an unknown data source
+
+    // Compiled display list (see display/display_list.h)
+    DisplayOp ops[60];
+    uint8_t opCount;
+    int16_t bgBandY[8];          // Rows still cleared to backgroundColor (the
+    int16_t bgBandH[8];          // rest is covered by full-width opaque fills)
+    uint8_t bgBandCount;
+    uint32_t pixelsBefore;       // Estimated pixels for a full draw in file order
+    uint32_t pixelsAfter;        // Estimated pixels for a full draw of the display list
+    uint8_t stateChangesBefore;  // Text size/colour changes in file order
+    uint8_t stateChangesAfter;   // Text size/colour changes after reordering
 };
 
 // Configuration Structure
@@ -74,9 +115,19 @@ struct Config {
   float temp_offset_yr;
   float temp_offset_z;
 
+  // Temperature - DS18B20 Acquisition
+  uint8_t temp_resolution;       // 9-12 bits (94-750 ms conversion)
+  uint16_t temp_update_interval; // ms between conversions (>= conversion time), 100-10000
+  uint8_t onewire_pins[ONEWIRE_MAX_BUSES];  // Distinct free GPIOs, ONEWIRE_PIN_NONE if unused
+  uint8_t temp_filter;           // TempFilter
+
   // Fan Control
   uint8_t fan_min_speed;
   uint8_t fan_max_speed_limit;  // Safety limit
+  uint8_t fan_mode;             // FanMode
+  float fan_hysteresis;         // °C a falling temperature must drop before the curve follows
+  float fan_target_temp;        // °C setpoint in PID mode
+  uint16_t fan_max_rpm;         // RPM at 100% duty - enables RPM targeting (0 = open loop)
 
   // PSU Monitoring
   float psu_voltage_cal;
@@ -92,7 +143,7 @@ struct Config {
 
   // Graph Settings
   uint16_t graph_timespan_seconds;  // 60 to 3600 (1-60 minutes)
-  uint16_t graph_update_interval;    // How often to add point (1-60 seconds)
+  uint16_t graph_update_interval;    // Graph point spacing (1-60 seconds)
 
   // Units
   bool use_fahrenheit;
@@ -100,6 +151,7 @@ struct Config {
 
   // Advanced
   bool enable_logging;
+  bool enable_trace;            // Motion trace on SD (history/motion_trace.h)
   uint16_t status_update_rate;  // FluidNC polling rate (ms)
 };
 
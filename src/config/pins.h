@@ -18,6 +18,8 @@
 
 // FluidDash Sensors (External connections via connectors)
 #define ONE_WIRE_BUS_1    21    // Internal motor drivers (P3 SPI_CS pin)
+#define ONEWIRE_MAX_BUSES 4     // Extra buses are configured in NVS ("ow_pins")
+#define ONEWIRE_PIN_NONE  0xFF  // Unused bus slot
 #define RTC_SDA           32    // I2C connector (P4)
 #define RTC_SCL           25    // I2C connector (P4)
 #define FAN_PWM           4     // Fan PWM control (repurpose AUDIO_EN)
@@ -0,0 +1,396 @@
+#include "display_list.h"
+#include "config/pins.h"
+#include "utils/log.h"
+
+// Style key for elements whose text colour depends on live data
+#define STYLE_VOLATILE 0xFFFFFFFFUL
+// Style key for ops that never touch text size/colour
+#define STYLE_NONE     0xFFFFFFFEUL
+
+// ========== GEOMETRY HELPERS ==========
+
+static bool boxesIntersect(const DisplayOp& a, const DisplayOp& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+static bool boxContains(const DisplayOp& outer, const DisplayOp& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.w <= outer.x + outer.w &&
+           inner.y + inner.h <= outer.y + outer.h;
+}
+
+// Two boxes whose union is itself a rectangle (shared edge or overlap, same span)
+static bool boxesMergeable(const DisplayOp& a, const DisplayOp& b) {
+    if (a.x == b.x && a.w == b.w) {
+        return b.y <= a.y + a.h && a.y <= b.y + b.h;
+    }
+    if (a.y == b.y && a.h == b.h) {
+        return b.x <= a.x + a.w && a.x <= b.x + b.w;
+    }
+    return false;
+}
+
+bool isDynamicElement(const ScreenElement& elem) {
+    return elem.type == ELEM_TEXT_DYNAMIC ||
+           elem.type == ELEM_TEMP_VALUE ||
+           elem.type == ELEM_COORD_VALUE ||
+           elem.type == ELEM_STATUS_VALUE ||
+           elem.type == ELEM_PROGRESS_BAR;
+}
+
+uint16_t estimateTextChars(const ScreenElement& elem) {
+    if (elem.type == ELEM_TEXT_STATIC) {
+        return strlen(elem.label);
+    }
+    uint16_t chars = DYNAMIC_VALUE_CHARS;
+    if (elem.showLabel) {
+        chars += strlen(elem.label);
+    }
+    return chars;
+}
+
+// Text size/colour an element sets before drawing
+static uint32_t elementStyle(const ScreenElement& elem) {
+    switch (elem.type) {
+        case ELEM_TEXT_STATIC:
+        case ELEM_TEXT_DYNAMIC:
+        case ELEM_TEMP_VALUE:
+        case ELEM_COORD_VALUE:
+            return ((uint32_t)elem.textSize << 16) | elem.color;
+        case ELEM_STATUS_VALUE:
+            // machineState is colour-coded at draw time
+            if (strcmp(elem.dataSource, "machineState") == 0) {
+                return STYLE_VOLATILE;
+            }
+            return ((uint32_t)elem.textSize << 16) | elem.color;
+        case ELEM_GRAPH:
+            return (1UL << 16) | elem.color;
+        default:
+            return STYLE_NONE;
+    }
+}
+
+static uint32_t opStyle(const ScreenLayout& layout, const DisplayOp& op) {
+    if (op.kind == OP_FILL_RECT) return STYLE_NONE;
+    return elementStyle(layout.elements[op.elem]);
+}
+
+static uint32_t opPixels(const ScreenLayout& layout, const DisplayOp& op) {
+    if (op.kind == OP_FILL_RECT) return (uint32_t)op.w * op.h;
+    return estimateElementPixels(layout.elements[op.elem]);
+}
+
+// ========== PUBLIC FUNCTIONS ==========
+
+int16_t alignTextX(const ScreenElement& elem, uint16_t textWidth) {
+    switch (elem.align) {
+        case ALIGN_CENTER:
+            if (elem.w > 0) return elem.x + ((int16_t)elem.w - (int16_t)textWidth) / 2;
+            return elem.x - textWidth / 2;
+        case ALIGN_RIGHT:
+            if (elem.w > 0) return elem.x + elem.w - textWidth;
+            return elem.x - textWidth;
+        default:
+            return elem.x;
+    }
+}
+
+void getElementBounds(const ScreenElement& elem, int16_t& x, int16_t& y, int16_t& w, int16_t& h) {
+    x = elem.x;
+    y = elem.y;
+    w = elem.w;
+    h = elem.h;
+
+    switch (elem.type) {
+        case ELEM_RECT:
+        case ELEM_PROGRESS_BAR:
+        case ELEM_GRAPH:
+            break;
+
+        case ELEM_LINE:
+            // Lines are drawn 1px thick along their longer axis
+            if (elem.w > elem.h) h = 1;
+            else w = 1;
+            break;
+
+        case ELEM_TEXT_STATIC:
+            w = estimateTextChars(elem) * FONT_CHAR_WIDTH * elem.textSize;
+            h = FONT_CHAR_HEIGHT * elem.textSize;
+            x = alignTextX(elem, w);
+            break;
+
+        default:
+            // Dynamic text: the explicit box if present, else the whole row on
+            // the side(s) the text can grow into (its width is unknown at load)
+            if (elem.w <= 0 || elem.h <= 0) {
+                h = FONT_CHAR_HEIGHT * elem.textSize;
+                if (elem.align == ALIGN_LEFT) {
+                    w = SCREEN_WIDTH - elem.x;
+                } else if (elem.align == ALIGN_RIGHT) {
+                    x = 0;
+                    w = elem.x;
+                } else {
+                    x = 0;
+                    w = SCREEN_WIDTH;
+                }
+            }
+            break;
+    }
+}
+
+uint32_t estimateElementPixels(const ScreenElement& elem) {
+    switch (elem.type) {
+        case ELEM_RECT:
+            if (elem.filled) return (uint32_t)elem.w * elem.h;
+            return 2UL * (elem.w + elem.h);
+
+        case ELEM_LINE:
+            return max(elem.w, elem.h);
+
+        case ELEM_PROGRESS_BAR:
+            return 2UL * (elem.w + elem.h);
+
+        case ELEM_GRAPH:
+            return 2UL * (elem.w + elem.h) + 5UL * FONT_CHAR_WIDTH * FONT_CHAR_HEIGHT;
+
+        case ELEM_TEXT_STATIC:
+        case ELEM_TEXT_DYNAMIC:
+        case ELEM_TEMP_VALUE:
+        case ELEM_COORD_VALUE:
+        case ELEM_STATUS_VALUE:
+            return (uint32_t)estimateTextChars(elem) * FONT_CHAR_WIDTH * FONT_CHAR_HEIGHT *
+                   elem.textSize * elem.textSize;
+
+        default:
+            return 0;
+    }
+}
+
+void compileDisplayList(ScreenLayout& layout) {
+    DisplayOp ops[60];
+    bool alive[60];
+    uint8_t count = 0;
+
+    // Full draw always starts with fillScreen()
+    const uint32_t screenPixels = (uint32_t)SCREEN_WIDTH * SCREEN_HEIGHT;
+    layout.pixelsBefore = screenPixels;
+    layout.stateChangesBefore = 0;
+
+    // Build one op per drawable element, in file order
+    uint32_t style = STYLE_NONE;
+    for (uint8_t i = 0; i < layout.elementCount; i++) {
+        const ScreenElement& elem = layout.elements[i];
+        if (elem.type == ELEM_NONE) continue;
+
+        layout.pixelsBefore += estimateElementPixels(elem);
+        uint32_t s = elementStyle(elem);
+        if (s != STYLE_NONE) {
+            if (s != style || s == STYLE_VOLATILE) layout.stateChangesBefore++;
+            style = s;
+        }
+
+        // Nothing to draw
+        if (elem.type == ELEM_TEXT_STATIC && elem.label[0] == '\0') continue;
+
+        DisplayOp& op = ops[count];
+        op.elem = i;
+        op.color = elem.color;
+        if (elem.type == ELEM_RECT && elem.filled) {
+            if (elem.w <= 0 || elem.h <= 0) continue;
+            op.kind = OP_FILL_RECT;
+            op.x = elem.x;
+            op.y = elem.y;
+            op.w = elem.w;
+            op.h = elem.h;
+        } else {
+            op.kind = OP_ELEMENT;
+            getElementBounds(elem, op.x, op.y, op.w, op.h);
+        }
+        alive[count] = true;
+        count++;
+    }
+
+    // Overdraw elimination and fill merging - repeat until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint8_t i = 0; i < count; i++) {
+            if (!alive[i]) continue;
+
+            // Dynamic elements are redrawn by updates anyway, never drop them
+            bool isStatic = ops[i].kind == OP_FILL_RECT ||
+                            !isDynamicElement(layout.elements[ops[i].elem]);
+            if (!isStatic) continue;
+
+            // Fully covered by a later opaque fill
+            for (uint8_t j = i + 1; j < count; j++) {
+                if (alive[j] && ops[j].kind == OP_FILL_RECT && boxContains(ops[j], ops[i])) {
+                    alive[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+            if (!alive[i]) continue;
+
+            // Background-coloured fill with nothing underneath it
+            if (ops[i].kind == OP_FILL_RECT && ops[i].color == layout.backgroundColor) {
+                bool coversSomething = false;
+                for (uint8_t k = 0; k < i; k++) {
+                    if (alive[k] && boxesIntersect(ops[k], ops[i])) {
+                        coversSomething = true;
+                        break;
+                    }
+                }
+                if (!coversSomething) {
+                    alive[i] = false;
+                    changed = true;
+                }
+            }
+        }
+
+        // Merge a later same-colour fill into an earlier one when nothing
+        // drawn in between touches the later fill
+        for (uint8_t i = 0; i < count; i++) {
+            if (!alive[i] || ops[i].kind != OP_FILL_RECT) continue;
+
+            for (uint8_t j = i + 1; j < count; j++) {
+                if (!alive[j] || ops[j].kind != OP_FILL_RECT) continue;
+                if (ops[j].color != ops[i].color || !boxesMergeable(ops[i], ops[j])) continue;
+
+                bool blocked = false;
+                for (uint8_t k = i + 1; k < j; k++) {
+                    if (alive[k] && boxesIntersect(ops[k], ops[j])) {
+                        blocked = true;
+                        break;
+                    }
+                }
+                if (blocked) continue;
+
+                int16_t x2 = max(ops[i].x + ops[i].w, ops[j].x + ops[j].w);
+                int16_t y2 = max(ops[i].y + ops[i].h, ops[j].y + ops[j].h);
+                ops[i].x = min(ops[i].x, ops[j].x);
+                ops[i].y = min(ops[i].y, ops[j].y);
+                ops[i].w = x2 - ops[i].x;
+                ops[i].h = y2 - ops[i].y;
+                alive[j] = false;
+                changed = true;
+            }
+        }
+    }
+
+    // Background clear: drop rows painted by full-width fills that sit
+    // directly on the background (nothing earlier overlaps them)
+    layout.bgBandCount = 1;
+    layout.bgBandY[0] = 0;
+    layout.bgBandH[0] = SCREEN_HEIGHT;
+    uint32_t clearPixels = screenPixels;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!alive[i] || ops[i].kind != OP_FILL_RECT) continue;
+        if (ops[i].x > 0 || ops[i].x + ops[i].w < SCREEN_WIDTH) continue;
+
+        bool onBackground = true;
+        for (uint8_t k = 0; k < i; k++) {
+            if (alive[k] && boxesIntersect(ops[k], ops[i])) {
+                onBackground = false;
+                break;
+            }
+        }
+        if (!onBackground) continue;
+
+        int16_t cutTop = max((int16_t)0, ops[i].y);
+        int16_t cutBottom = min((int16_t)SCREEN_HEIGHT, (int16_t)(ops[i].y + ops[i].h));
+        int16_t newY[8], newH[8];
+        uint8_t newCount = 0;
+        bool overflow = false;
+
+        for (uint8_t b = 0; b < layout.bgBandCount; b++) {
+            int16_t top = layout.bgBandY[b];
+            int16_t bottom = top + layout.bgBandH[b];
+            if (cutBottom <= top || cutTop >= bottom) {
+                newY[newCount] = top;
+                newH[newCount++] = bottom - top;
+                continue;
+            }
+            if (top < cutTop) {
+                newY[newCount] = top;
+                newH[newCount++] = cutTop - top;
+            }
+            if (cutBottom < bottom) {
+                if (newCount >= 8) { overflow = true; break; }
+                newY[newCount] = cutBottom;
+                newH[newCount++] = bottom - cutBottom;
+            }
+            if (newCount >= 8) { overflow = true; break; }
+        }
+        if (overflow) continue;  // Keep the previous (larger) clear
+
+        layout.bgBandCount = newCount;
+        clearPixels = 0;
+        for (uint8_t b = 0; b < newCount; b++) {
+            layout.bgBandY[b] = newY[b];
+            layout.bgBandH[b] = newH[b];
+            clearPixels += (uint32_t)SCREEN_WIDTH * newH[b];
+        }
+    }
+
+    // Reorder: an op may move ahead of earlier ops it does not overlap.
+    // Greedily prefer ops that keep the current text style.
+    bool scheduled[60];
+    uint8_t remaining = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        scheduled[i] = !alive[i];
+        if (alive[i]) remaining++;
+    }
+
+    layout.opCount = 0;
+    layout.pixelsAfter = clearPixels;
+    layout.stateChangesAfter = 0;
+    style = STYLE_NONE;
+
+    while (remaining > 0) {
+        int pickSame = -1, pickStateless = -1, pickFirst = -1;
+
+        for (uint8_t j = 0; j < count; j++) {
+            if (scheduled[j]) continue;
+
+            bool ready = true;
+            for (uint8_t i = 0; i < j; i++) {
+                if (!scheduled[i] && boxesIntersect(ops[i], ops[j])) {
+                    ready = false;
+                    break;
+                }
+            }
+            if (!ready) continue;
+
+            uint32_t s = opStyle(layout, ops[j]);
+            if (pickFirst < 0) pickFirst = j;
+            if (pickStateless < 0 && s == STYLE_NONE) pickStateless = j;
+            if (pickSame < 0 && s == style && s != STYLE_VOLATILE && s != STYLE_NONE) {
+                pickSame = j;
+                break;
+            }
+        }
+
+        // The lowest unscheduled op is always ready, so pickFirst is valid
+        int pick = pickSame >= 0 ? pickSame : (pickStateless >= 0 ? pickStateless : pickFirst);
+
+        uint32_t s = opStyle(layout, ops[pick]);
+        if (s != STYLE_NONE) {
+            if (s != style || s == STYLE_VOLATILE) layout.stateChangesAfter++;
+            style = s;
+        }
+
+        layout.pixelsAfter += opPixels(layout, ops[pick]);
+        layout.ops[layout.opCount++] = ops[pick];
+        scheduled[pick] = true;
+        remaining--;
+    }
+
+    LOGI("DLIST", "%s: %d elements -> %d ops, %lu -> %lu px, %d -> %d style changes",
+         layout.name, layout.elementCount, layout.opCount,
+         (unsigned long)layout.pixelsBefore, (unsigned long)layout.pixelsAfter,
+         layout.stateChangesBefore, layout.stateChangesAfter);
+}
@@ -0,0 +1,40 @@
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <Arduino.h>
+#include "config/config.h"
+
+// Default LovyanGFX font (Font0) glyph cell, multiplied by textSize
+#define FONT_CHAR_WIDTH   6
+#define FONT_CHAR_HEIGHT  8
+
+// Characters assumed for a data value when estimating dynamic text extents
+#define DYNAMIC_VALUE_CHARS 8
+
+// Compile layout.elements into layout.ops (call once after loading a layout)
+// - Drops static primitives fully covered by a later opaque fill
+// - Drops background-coloured fills that only paint over the cleared screen
+// - Skips clearing rows that a full-width opaque fill paints over anyway
+// - Merges adjacent same-colour fills into one rectangle
+// - Reorders independent ops so text size/colour changes are minimised
+// - Precomputes text extents and pixel/state-change statistics
+void compileDisplayList(ScreenLayout& layout);
+
+// Left edge of an element's text of the given width, honouring elem.align.
+// With a box (w > 0) text is aligned inside it; without one, x is the
+// left edge, centre or right edge of the text respectively.
+int16_t alignTextX(const ScreenElement& elem, uint16_t textWidth);
+
+// Bounding box an element touches when drawn (text extents for text types)
+void getElementBounds(const ScreenElement& elem, int16_t& x, int16_t& y, int16_t& w, int16_t& h);
+
+// Elements whose content changes at runtime (redrawn by updateElement)
+bool isDynamicElement(const ScreenElement& elem);
+
+// Number of characters printed by a text element (label + estimated value)
+uint16_t estimateTextChars(const ScreenElement& elem);
+
+// Estimated number of pixels written when drawing an element
+uint32_t estimateElementPixels(const ScreenElement& elem);
+
+#endif // DISPLAY_LIST_H
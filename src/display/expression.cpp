@@ -0,0 +1,417 @@
+#include "expression.h"
+#include "view_model.h"
+#include "utils/log.h"
+
+// Parentheses/unary minus nesting accepted by the parser
+#define EXPR_MAX_NESTING 16
+
+// Compiled programs (append-only; identical expressions are shared)
+static ExprProgram programs[EXPR_MAX_PROGRAMS];
+static uint8_t programCount = 0;
+
+// ========== COMPILER ==========
+
+// Recursive-descent parser state, emitting postfix bytecode as it goes
+struct ExprCompiler {
+    const char* text;
+    const char* pos;
+    ExprProgram* prog;
+    uint8_t depth;           // Current stack depth
+    uint8_t nesting;         // Parser recursion depth (bounds loop-task stack use)
+    const char* error;       // First error, nullptr while OK
+};
+
+static void fail(ExprCompiler& c, const char* message) {
+    if (c.error == nullptr) c.error = message;
+}
+
+static void skipSpaces(ExprCompiler& c) {
+    while (*c.pos == ' ' || *c.pos == '\t') c.pos++;
+}
+
+static void emit(ExprCompiler& c, uint8_t byte) {
+    if (c.prog->codeLen >= EXPR_MAX_CODE - 1) {   // Keep room for XOP_END
+        fail(c, "expression too long");
+        return;
+    }
+    c.prog->code[c.prog->codeLen++] = byte;
+}
+
+// Account for a push (or, with a negative delta, pops)
+static void adjustDepth(ExprCompiler& c, int delta) {
+    int depth = c.depth + delta;
+    if (depth > EXPR_MAX_STACK) {
+        fail(c, "expression nested too deeply");
+        return;
+    }
+    c.depth = depth;
+}
+
+static void emitConst(ExprCompiler& c, float value) {
+    ExprProgram& p = *c.prog;
+    uint8_t index = 0;
+    while (index < p.constCount && p.consts[index] != value) index++;
+    if (index == p.constCount) {
+        if (p.constCount >= EXPR_MAX_CONSTS) {
+            fail(c, "too many constants");
+            return;
+        }
+        p.consts[p.constCount++] = value;
+    }
+    emit(c, XOP_CONST);
+    emit(c, index);
+    adjustDepth(c, 1);
+}
+
+static void emitSource(ExprCompiler& c, uint8_t source) {
+    ExprProgram& p = *c.prog;
+    uint8_t i = 0;
+    while (i < p.inputCount && p.inputs[i] != source) i++;
+    if (i == p.inputCount) {
+        if (p.inputCount >= EXPR_MAX_INPUTS) {
+            fail(c, "too many inputs");
+            return;
+        }
+        p.inputs[p.inputCount++] = source;
+    }
+    emit(c, XOP_SOURCE);
+    emit(c, source);
+    adjustDepth(c, 1);
+}
+
+static void parseExpr(ExprCompiler& c);
+
+// Function call: name already consumed, c.pos is at '('
+static void parseCall(ExprCompiler& c, const char* name, size_t nameLen) {
+    uint8_t opcode;
+    uint8_t maxArgs = 8;
+    if (nameLen == 3 && strncmp(name, "min", 3) == 0) opcode = XOP_MIN;
+    else if (nameLen == 3 && strncmp(name, "max", 3) == 0) opcode = XOP_MAX;
+    else if (nameLen == 3 && strncmp(name, "avg", 3) == 0) opcode = XOP_AVG;
+    else if (nameLen == 3 && strncmp(name, "abs", 3) == 0) { opcode = XOP_ABS; maxArgs = 1; }
+    else {
+        fail(c, "unknown function");
+        return;
+    }
+
+    c.pos++;  // '('
+    uint8_t args = 0;
+    while (c.error == nullptr) {
+        parseExpr(c);
+        args++;
+        skipSpaces(c);
+        if (*c.pos == ',') {
+            c.pos++;
+            continue;
+        }
+        if (*c.pos == ')') {
+            c.pos++;
+            break;
+        }
+        fail(c, "expected ',' or ')'");
+    }
+    if (c.error != nullptr) return;
+
+    if (args > maxArgs) {
+        fail(c, "too many arguments");
+        return;
+    }
+
+    emit(c, opcode);
+    if (opcode != XOP_ABS) {
+        emit(c, args);
+        adjustDepth(c, 1 - args);
+    }
+}
+
+static void parsePrimary(ExprCompiler& c) {
+    skipSpaces(c);
+    char ch = *c.pos;
+
+    if (ch == '(') {
+        c.pos++;
+        parseExpr(c);
+        skipSpaces(c);
+        if (*c.pos != ')') {
+            fail(c, "expected ')'");
+            return;
+        }
+        c.pos++;
+        return;
+    }
+
+    if (isdigit((unsigned char)ch) || ch == '.') {
+        char* end;
+        float value = strtof(c.pos, &end);
+        if (end == c.pos) {
+            fail(c, "bad number");
+            return;
+        }
+        c.pos = end;
+        emitConst(c, value);
+        return;
+    }
+
+    if (isalpha((unsigned char)ch)) {
+        const char* start = c.pos;
+        while (isalnum((unsigned char)*c.pos) || *c.pos == '_') c.pos++;
+        size_t len = c.pos - start;
+
+        skipSpaces(c);
+        if (*c.pos == '(') {
+            parseCall(c, start, len);
+            return;
+        }
+
+        char name[32];
+        if (len >= sizeof(name)) {
+            fail(c, "unknown source");
+            return;
+        }
+        memcpy(name, start, len);
+        name[len] = '\0';
+
+        uint8_t source = lookupDataSource(name);
+        if (source == DS_NONE || isStringSource(source)) {
+            fail(c, "unknown source");
+            return;
+        }
+        emitSource(c, source);
+        return;
+    }
+
+    fail(c, "unexpected character");
+}
+
+static void parseUnary(ExprCompiler& c) {
+    if (++c.nesting > EXPR_MAX_NESTING) {
+        fail(c, "expression nested too deeply");
+        return;
+    }
+
+    skipSpaces(c);
+    if (*c.pos == '-') {
+        c.pos++;
+        parseUnary(c);
+        emit(c, XOP_NEG);
+    } else {
+        parsePrimary(c);
+    }
+    c.nesting--;
+}
+
+static void parseTerm(ExprCompiler& c) {
+    parseUnary(c);
+    while (c.error == nullptr) {
+        skipSpaces(c);
+        char op = *c.pos;
+        if (op != '*' && op != '/') return;
+        c.pos++;
+        parseUnary(c);
+        emit(c, op == '*' ? XOP_MUL : XOP_DIV);
+        adjustDepth(c, -1);
+    }
+}
+
+static void parseExpr(ExprCompiler& c) {
+    parseTerm(c);
+    while (c.error == nullptr) {
+        skipSpaces(c);
+        char op = *c.pos;
+        if (op != '+' && op != '-') return;
+        c.pos++;
+        parseTerm(c);
+        emit(c, op == '+' ? XOP_ADD : XOP_SUB);
+        adjustDepth(c, -1);
+    }
+}
+
+// ========== EVALUATION ==========
+
+static float evaluate(const ExprProgram& p) {
+    float stack[EXPR_MAX_STACK];
+    uint8_t sp = 0;
+    const uint8_t* ip = p.code;
+
+    while (true) {
+        switch (*ip++) {
+            case XOP_CONST:
+                stack[sp++] = p.consts[*ip++];
+                break;
+
+            case XOP_SOURCE:
+                stack[sp++] = readDataSource(*ip++);
+                break;
+
+            case XOP_ADD: sp--; stack[sp - 1] += stack[sp]; break;
+            case XOP_SUB: sp--; stack[sp - 1] -= stack[sp]; break;
+            case XOP_MUL: sp--; stack[sp - 1] *= stack[sp]; break;
+
+            case XOP_DIV:
+                sp--;
+                stack[sp - 1] = (stack[sp] == 0.0f) ? 0.0f : stack[sp - 1] / stack[sp];
+                break;
+
+            case XOP_NEG: stack[sp - 1] = -stack[sp - 1]; break;
+            case XOP_ABS: stack[sp - 1] = fabsf(stack[sp - 1]); break;
+
+            case XOP_MIN:
+            case XOP_MAX:
+            case XOP_AVG:
+                {
+                    uint8_t opcode = ip[-1];
+                    uint8_t count = *ip++;
+                    sp -= count;
+                    // Stale sensors (NAN) are skipped; all stale gives NAN
+                    float result = NAN;
+                    uint8_t used = 0;
+                    for (uint8_t i = 0; i < count; i++) {
+                        float v = stack[sp + i];
+                        if (isnan(v)) continue;
+                        if (used++ == 0) result = v;
+                        else if (opcode == XOP_MIN) { if (v < result) result = v; }
+                        else if (opcode == XOP_MAX) { if (v > result) result = v; }
+                        else result += v;
+                    }
+                    if (opcode == XOP_AVG && used > 0) result /= used;
+                    stack[sp++] = result;
+                }
+                break;
+
+            default:   // XOP_END
+                return sp > 0 ? stack[sp - 1] : 0.0f;
+        }
+    }
+}
+
+// Record the current input generations; true if any moved on since the last
+// call. Compared one by one: a sum can stay put while two inputs change.
+static bool captureInputGenerations(ExprProgram& p) {
+    bool changed = false;
+    for (uint8_t i = 0; i < p.inputCount; i++) {
+        uint16_t generation = getSourceGeneration(p.inputs[i]);
+        if (generation != p.inputGens[i]) {
+            p.inputGens[i] = generation;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Evaluate one program; bumps its generation only if the value changed
+static void refreshProgram(ExprProgram& p) {
+    float value = evaluate(p);
+    if (memcmp(&value, &p.value, sizeof(float)) != 0) {
+        p.value = value;
+        p.generation++;
+    }
+}
+
+// ========== PUBLIC FUNCTIONS ==========
+
+// Parse text into p. Returns nullptr on success, else the error message
+// (with the 1-based column in *column).
+static const char* compileInto(const char* text, ExprProgram& p, int* column) {
+    memset(&p, 0, sizeof(p));
+
+    ExprCompiler c = { text, text, &p, 0, 0, nullptr };
+    parseExpr(c);
+    skipSpaces(c);
+    if (c.error == nullptr && *c.pos != '\0') fail(c, "unexpected character");
+    if (c.error == nullptr && p.codeLen == 0) fail(c, "empty expression");
+
+    *column = (int)(c.pos - text) + 1;
+    if (c.error == nullptr) {
+        p.code[p.codeLen++] = XOP_END;
+    }
+    return c.error;
+}
+
+uint8_t compileExpression(const char* text) {
+    if (text == nullptr) return EXPR_NONE;
+    if (text[0] == '=') text++;
+
+    // Compile into the next free entry, then dedupe against existing programs
+    if (programCount >= EXPR_MAX_PROGRAMS) {
+        LOGW("EXPR", "Program pool full, cannot compile \"%s\"", text);
+        return EXPR_NONE;
+    }
+
+    ExprProgram& p = programs[programCount];
+    int column;
+    const char* error = compileInto(text, p, &column);
+    if (error != nullptr) {
+        LOGW("EXPR", "\"%s\": %s at column %d", text, error, column);
+        return EXPR_NONE;
+    }
+
+    for (uint8_t i = 0; i < programCount; i++) {
+        const ExprProgram& q = programs[i];
+        if (q.codeLen == p.codeLen && q.constCount == p.constCount &&
+            memcmp(q.code, p.code, p.codeLen) == 0 &&
+            memcmp(q.consts, p.consts, p.constCount * sizeof(float)) == 0) {
+            return i;
+        }
+    }
+
+    strlcpy(p.text, text, sizeof(p.text));
+    captureInputGenerations(p);
+    p.value = evaluate(p);
+    LOGI("EXPR", "#%d \"%s\": %d bytes, %d inputs",
+         programCount, p.text, p.codeLen, p.inputCount);
+    return programCount++;
+}
+
+const char* checkExpression(const char* text) {
+    if (text == nullptr) return "empty expression";
+    if (text[0] == '=') text++;
+
+    ExprProgram* scratch = (ExprProgram*)malloc(sizeof(ExprProgram));
+    if (scratch == nullptr) return "out of memory";
+    int column;
+    const char* error = compileInto(text, *scratch, &column);
+    free(scratch);
+    return error;
+}
+
+void exprReset() {
+    programCount = 0;
+}
+
+void exprUpdate() {
+    for (uint8_t i = 0; i < programCount; i++) {
+        ExprProgram& p = programs[i];
+        if (captureInputGenerations(p)) refreshProgram(p);
+    }
+}
+
+uint32_t exprBenchmark(uint16_t passes) {
+    if (passes == 0 || programCount == 0) return 0;
+
+    unsigned long start = micros();
+    for (uint16_t n = 0; n < passes; n++) {
+        for (uint8_t i = 0; i < programCount; i++) {
+            refreshProgram(programs[i]);
+        }
+    }
+    return (micros() - start) / passes;
+}
+
+uint8_t exprCount() {
+    return programCount;
+}
+
+float exprValue(uint8_t program) {
+    if (program >= programCount) return 0.0f;
+    return programs[program].value;
+}
+
+uint16_t exprGeneration(uint8_t program) {
+    if (program >= programCount) return 0;
+    return programs[program].generation;
+}
+
+const char* exprText(uint8_t program) {
+    if (program >= programCount) return "";
+    return programs[program].text;
+}
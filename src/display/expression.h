@@ -0,0 +1,86 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <Arduino.h>
+
+// ========== Computed Data Sources ==========
+// Layout "data" fields starting with '=' are expressions over the numeric
+// data sources, e.g. "=max(temp0,temp1,temp2,temp3)" or "=psuVoltage-24".
+//
+//   expr    := term (('+' | '-') term)*
+//   term    := unary (('*' | '/') unary)*
+//   unary   := '-' unary | primary
+//   primary := number | source | func '(' expr (',' expr)* ')' | '(' expr ')'
+//   func    := min | max | avg (1-8 args), abs (1 arg)
+//
+// Expressions are compiled once (at layout load) into stack bytecode and
+// only re-evaluated when one of their input sources changes.
+
+#define EXPR_MAX_PROGRAMS  64     // Distinct expressions across all layouts
+#define EXPR_MAX_CODE      32     // Bytecode bytes per expression
+#define EXPR_MAX_CONSTS    4      // Numeric literals per expression
+#define EXPR_MAX_INPUTS    8      // Distinct input sources per expression
+#define EXPR_MAX_STACK     8      // Evaluation stack depth
+#define EXPR_TEXT_LEN      48     // Expression text kept for reporting
+#define EXPR_NONE          0xFF
+
+// Bytecode instructions (operands follow the opcode byte)
+enum ExprOpcode : uint8_t {
+    XOP_CONST = 0,    // [index]  push consts[index]
+    XOP_SOURCE,       // [source] push readDataSource(source)
+    XOP_ADD,
+    XOP_SUB,
+    XOP_MUL,
+    XOP_DIV,          // Division by zero yields 0
+    XOP_NEG,
+    XOP_ABS,
+    XOP_MIN,          // [count]  pop count values, push the smallest
+    XOP_MAX,          // [count]  pop count values, push the largest
+    XOP_AVG,          // [count]  pop count values, push their mean
+    XOP_END
+};
+
+// One compiled expression
+struct ExprProgram {
+    uint8_t code[EXPR_MAX_CODE];
+    uint8_t codeLen;
+    float consts[EXPR_MAX_CONSTS];
+    uint8_t constCount;
+    uint8_t inputs[EXPR_MAX_INPUTS];     // Source ids read by the program
+    uint8_t inputCount;
+    uint16_t inputGens[EXPR_MAX_INPUTS]; // Input generations at last evaluation
+    float value;                         // Last result
+    uint16_t generation;                 // Incremented whenever value changes
+    char text[EXPR_TEXT_LEN];
+};
+
+// ========== Functions ==========
+// Compile an expression (with or without the leading '='). Identical
+// expressions share one program. Returns the program index, or EXPR_NONE
+// on a syntax error or when the program pool is full (both logged as warnings).
+uint8_t compileExpression(const char* text);
+
+// Drop every program, before the layouts are loaded again and recompile.
+// Call together with viewModelReset(): slots of DS_EXPR_BASE sources refer
+// to program indices.
+void exprReset();
+
+// Syntax-check an expression without adding it to the pool (safe from any
+// task). Returns nullptr if it compiles, else a short error message.
+const char* checkExpression(const char* text);
+
+// Re-evaluate programs whose input generations changed. Call from the loop
+// task after source values were refreshed (viewModelUpdate does this).
+void exprUpdate();
+
+// Evaluate every program regardless of input changes, 'passes' times.
+// Returns the average microseconds per pass (for cost reporting).
+uint32_t exprBenchmark(uint16_t passes);
+
+// Accessors for compiled programs
+uint8_t exprCount();
+float exprValue(uint8_t program);
+uint16_t exprGeneration(uint8_t program);
+const char* exprText(uint8_t program);
+
+#endif // EXPRESSION_H
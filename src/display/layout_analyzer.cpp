@@ -0,0 +1,218 @@
+#include "layout_analyzer.h"
+#include "display.h"
+#include "display_list.h"
+#include "utils/log.h"
+
+static RenderCostModel costModel = {
+    400.0f,    // 16 bits per pixel at 40 MHz
+    2.0f,
+    20.0f,
+    7.2f,      // FONT0_LIT_PIXELS at 400 ns
+    false
+};
+
+// ========== CALIBRATION ==========
+
+void calibrateRenderCost() {
+    const int callRepeats = 200;
+    const char* probe = "88888888";
+    const int probeGlyphs = 8;
+
+    // Streaming fill: one full-screen fill is almost all pixel time
+    unsigned long start = micros();
+    gfx.fillScreen(COLOR_BG);
+    float fillUs = micros() - start;
+    costModel.nsPerPixel = fillUs * 1000.0f / ((float)SCREEN_WIDTH * SCREEN_HEIGHT);
+
+    // Per-call overhead: 1x1 fills are almost all window setup
+    start = micros();
+    for (int i = 0; i < callRepeats; i++) {
+        gfx.fillRect(i % SCREEN_WIDTH, 0, 1, 1, COLOR_BG);
+    }
+    float callUs = (float)(micros() - start) / callRepeats;
+    costModel.usPerCall = max(0.0f, callUs - costModel.nsPerPixel / 1000.0f);
+
+    // Transparent glyphs at size 1 and 4, fitted to base + k * size^2
+    float glyphUs[2];
+    const uint8_t sizes[2] = {1, 4};
+    gfx.setTextColor(COLOR_BG);
+    for (int s = 0; s < 2; s++) {
+        gfx.setTextSize(sizes[s]);
+        start = micros();
+        gfx.setCursor(0, 0);
+        gfx.print(probe);
+        glyphUs[s] = (float)(micros() - start) / probeGlyphs;
+    }
+    costModel.usPerGlyphSizeSq = max(0.0f, (glyphUs[1] - glyphUs[0]) / 15.0f);
+    costModel.usPerGlyphBase = max(0.0f, glyphUs[0] - costModel.usPerGlyphSizeSq);
+    costModel.calibrated = true;
+
+    LOGI("LINT", "Render cost: %.0f ns/px, %.1f us/call, glyph %.1f + %.1f*size^2 us",
+         costModel.nsPerPixel, costModel.usPerCall,
+         costModel.usPerGlyphBase, costModel.usPerGlyphSizeSq);
+}
+
+const RenderCostModel& getRenderCostModel() {
+    return costModel;
+}
+
+// ========== COST ESTIMATES ==========
+
+static bool isTextElement(const ScreenElement& elem) {
+    return elem.type == ELEM_TEXT_STATIC || elem.type == ELEM_TEXT_DYNAMIC ||
+           elem.type == ELEM_TEMP_VALUE || elem.type == ELEM_COORD_VALUE ||
+           elem.type == ELEM_STATUS_VALUE;
+}
+
+static float fillUs(uint32_t pixels) {
+    return costModel.usPerCall + pixels * costModel.nsPerPixel / 1000.0f;
+}
+
+static uint32_t fillBytes(uint32_t pixels) {
+    return SPI_BYTES_PER_CALL + pixels * 2;
+}
+
+// Transparent text, as drawn on a full screen draw
+static void estimateText(const ScreenElement& elem, float& us, uint32_t& bytes) {
+    uint32_t glyphs = estimateTextChars(elem);
+    uint32_t sizeSq = (uint32_t)elem.textSize * elem.textSize;
+    us += glyphs * (costModel.usPerGlyphBase + costModel.usPerGlyphSizeSq * sizeSq);
+    bytes += glyphs * (FONT0_RUNS_PER_GLYPH * SPI_BYTES_PER_CALL + FONT0_LIT_PIXELS * sizeSq * 2);
+}
+
+// Outline rectangle: four 1px lines
+static void estimateOutline(const ScreenElement& elem, float& us, uint32_t& bytes) {
+    uint32_t perimeter = 2UL * (elem.w + elem.h);
+    us += 3 * costModel.usPerCall + fillUs(perimeter);
+    bytes += 3 * SPI_BYTES_PER_CALL + fillBytes(perimeter);
+}
+
+// Cost of an element on a full draw
+static void estimateElement(const ScreenElement& elem, float& us, uint32_t& bytes) {
+    if (isTextElement(elem)) {
+        estimateText(elem, us, bytes);
+        return;
+    }
+
+    switch (elem.type) {
+        case ELEM_RECT:
+            if (elem.filled) {
+                us += fillUs((uint32_t)elem.w * elem.h);
+                bytes += fillBytes((uint32_t)elem.w * elem.h);
+            } else {
+                estimateOutline(elem, us, bytes);
+            }
+            break;
+
+        case ELEM_LINE:
+            us += fillUs(max(elem.w, elem.h));
+            bytes += fillBytes(max(elem.w, elem.h));
+            break;
+
+        case ELEM_PROGRESS_BAR:
+            estimateOutline(elem, us, bytes);
+            break;
+
+        case ELEM_GRAPH:
+            estimateOutline(elem, us, bytes);
+            us += 5 * (costModel.usPerGlyphBase + costModel.usPerGlyphSizeSq);
+            bytes += 5 * (FONT0_RUNS_PER_GLYPH * SPI_BYTES_PER_CALL + FONT0_LIT_PIXELS * 2);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Cost of one updateElement(): opaque text cells, or box clear + redraw
+static void estimateUpdate(const ScreenElement& elem, float& us, uint32_t& bytes) {
+    if (isTextElement(elem)) {
+        uint32_t glyphs = estimateTextChars(elem);
+        uint32_t cellPixels = (uint32_t)FONT_CHAR_WIDTH * FONT_CHAR_HEIGHT *
+                              elem.textSize * elem.textSize;
+        us += glyphs * fillUs(cellPixels);
+        bytes += glyphs * fillBytes(cellPixels);
+        return;
+    }
+
+    uint32_t boxPixels = (uint32_t)elem.w * elem.h;
+    us += fillUs(boxPixels);
+    bytes += fillBytes(boxPixels);
+    estimateElement(elem, us, bytes);
+}
+
+// ========== PUBLIC FUNCTIONS ==========
+
+void analyzeLayout(const ScreenLayout& layout, uint32_t budgetUs, LayoutReport& report) {
+    memset(&report, 0, sizeof(report));
+    report.budgetUs = budgetUs;
+    report.droppedElements = layout.droppedElements;
+    report.overdraw = (float)layout.pixelsAfter / ((float)SCREEN_WIDTH * SCREEN_HEIGHT);
+
+    float drawUs = 0;
+    uint32_t drawBytes = 0;
+    for (uint8_t i = 0; i < layout.bgBandCount; i++) {
+        uint32_t pixels = (uint32_t)SCREEN_WIDTH * layout.bgBandH[i];
+        drawUs += fillUs(pixels);
+        drawBytes += fillBytes(pixels);
+    }
+    for (uint8_t i = 0; i < layout.opCount; i++) {
+        const DisplayOp& op = layout.ops[i];
+        if (op.kind == OP_FILL_RECT) {
+            drawUs += fillUs((uint32_t)op.w * op.h);
+            drawBytes += fillBytes((uint32_t)op.w * op.h);
+        } else {
+            estimateElement(layout.elements[op.elem], drawUs, drawBytes);
+        }
+    }
+
+    float updateUs = 0;
+    uint32_t updateBytes = 0;
+    for (uint8_t i = 0; i < layout.elementCount; i++) {
+        const ScreenElement& elem = layout.elements[i];
+        if (layout.unknownSourceMask & ((uint64_t)1 << i)) report.unknownSources++;
+        if (!isDynamicElement(elem)) continue;
+
+        report.dynamicCount++;
+        if (elem.w <= 0 || elem.h <= 0) report.unboxedDynamic++;
+        estimateUpdate(elem, updateUs, updateBytes);
+    }
+
+    report.fullDrawUs = drawUs;
+    report.fullDrawBytes = drawBytes;
+    report.updateUs = updateUs;
+    report.updateBytes = updateBytes;
+    report.withinBudget = report.fullDrawUs <= budgetUs;
+}
+
+void layoutReportToJson(const ScreenLayout& layout, const LayoutReport& report, JsonObject out) {
+    out["name"] = layout.name;
+    out["elements"] = layout.elementCount;
+    out["ops"] = layout.opCount;
+    out["overdraw"] = report.overdraw;
+    out["pixels_before"] = layout.pixelsBefore;
+    out["pixels_after"] = layout.pixelsAfter;
+    out["full_draw_bytes"] = report.fullDrawBytes;
+    out["update_bytes"] = report.updateBytes;
+    out["full_draw_ms"] = report.fullDrawUs / 1000.0f;
+    out["update_ms"] = report.updateUs / 1000.0f;
+    out["budget_ms"] = report.budgetUs / 1000.0f;
+    out["within_budget"] = report.withinBudget;
+    out["cost_model_calibrated"] = costModel.calibrated;
+    out["dynamic_elements"] = report.dynamicCount;
+    out["dropped_elements"] = report.droppedElements;
+
+    JsonArray unboxed = out["unboxed_dynamic"].to<JsonArray>();
+    JsonArray unknown = out["unknown_sources"].to<JsonArray>();
+    for (uint8_t i = 0; i < layout.elementCount; i++) {
+        const ScreenElement& elem = layout.elements[i];
+        if (isDynamicElement(elem) && (elem.w <= 0 || elem.h <= 0)) {
+            unboxed.add(i);
+        }
+        if (layout.unknownSourceMask & ((uint64_t)1 << i)) {
+            JsonObject entry = unknown.add<JsonObject>();
+            entry["element"] = i;
+            entry["data"] = elem.dataSource;
+        }
+    }
+}
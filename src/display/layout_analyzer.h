@@ -0,0 +1,61 @@
+#ifndef LAYOUT_ANALYZER_H
+#define LAYOUT_ANALYZER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config/config.h"
+
+// Default frame budget for a full screen draw (overridable per request,
+// up to LAYOUT_BUDGET_MAX_MS)
+#define LAYOUT_FRAME_BUDGET_MS 100
+#define LAYOUT_BUDGET_MAX_MS   1000
+
+// ST7796 window setup per primitive: CASET + 4, RASET + 4, RAMWR
+#define SPI_BYTES_PER_CALL     11
+
+// Font0 averages (6x8 cell): horizontal pixel runs and lit pixels per glyph.
+// Transparent text is drawn run by run, opaque text as one full cell.
+#define FONT0_RUNS_PER_GLYPH   10
+#define FONT0_LIT_PIXELS       18
+
+// Render cost model: time = calls * usPerCall + pixels * nsPerPixel,
+// transparent glyph = usPerGlyphBase + usPerGlyphSizeSq * textSize^2.
+// Defaults assume 40 MHz SPI; calibrateRenderCost() measures the real panel.
+struct RenderCostModel {
+    float nsPerPixel;
+    float usPerCall;
+    float usPerGlyphBase;
+    float usPerGlyphSizeSq;
+    bool calibrated;
+};
+
+// Lint results for one layout
+struct LayoutReport {
+    float overdraw;              // Pixels written per screen pixel on a full draw
+    uint32_t fullDrawBytes;      // Estimated SPI bytes for a full draw
+    uint32_t updateBytes;        // Estimated SPI bytes when every dynamic element updates
+    uint32_t fullDrawUs;         // Estimated full draw time
+    uint32_t updateUs;           // Estimated time to update every dynamic element
+    uint32_t budgetUs;           // Frame budget the layout was checked against
+    uint8_t dynamicCount;        // Elements redrawn by updates
+    uint8_t unboxedDynamic;      // Dynamic elements without a w/h clear box
+    uint8_t unknownSources;      // Elements whose data source does not exist
+    uint8_t droppedElements;     // Elements beyond the 60-element cap
+    bool withinBudget;
+};
+
+// ========== Functions ==========
+// Measure fill, call and glyph costs on the panel. Draws in COLOR_BG, so
+// call it while the screen is blank (before the splash screen).
+void calibrateRenderCost();
+
+// Cost model currently used for estimates
+const RenderCostModel& getRenderCostModel();
+
+// Analyse a parsed layout (see parseScreenJson) against a frame budget
+void analyzeLayout(const ScreenLayout& layout, uint32_t budgetUs, LayoutReport& report);
+
+// Write a report (plus per-element findings) into a JSON object
+void layoutReportToJson(const ScreenLayout& layout, const LayoutReport& report, JsonObject out);
+
+#endif // LAYOUT_ANALYZER_H
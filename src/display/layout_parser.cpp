@@ -0,0 +1,174 @@
+#include "layout_parser.h"
+#include "display_list.h"
+#include "view_model.h"
+#include "expression.h"
+#include <ArduinoJson.h>
+#include "utils/log.h"
+
+// ========== JSON PARSING FUNCTIONS ==========
+
+// Convert hex color string to uint16_t RGB565
+uint16_t parseColor(const char* hexColor) {
+    if (hexColor == nullptr || strlen(hexColor) < 4) {
+        return 0x0000; // Default to black
+    }
+
+    // Skip '#' if present
+    const char* hex = (hexColor[0] == '#') ? hexColor + 1 : hexColor;
+
+    // Parse hex string
+    uint32_t color = strtoul(hex, nullptr, 16);
+
+    // Convert to RGB565
+    if (strlen(hex) == 4) {
+        // Short form: RGB -> RRGGBB
+        uint8_t r = ((color >> 8) & 0xF) * 17;
+        uint8_t g = ((color >> 4) & 0xF) * 17;
+        uint8_t b = (color & 0xF) * 17;
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    } else {
+        // Full form: RRGGBB
+        uint8_t r = (color >> 16) & 0xFF;
+        uint8_t g = (color >> 8) & 0xFF;
+        uint8_t b = color & 0xFF;
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+}
+
+// Parse element type from string
+ElementType parseElementType(const char* typeStr) {
+    if (strcmp(typeStr, "rect") == 0) return ELEM_RECT;
+    if (strcmp(typeStr, "line") == 0) return ELEM_LINE;
+    if (strcmp(typeStr, "text") == 0) return ELEM_TEXT_STATIC;
+    if (strcmp(typeStr, "dynamic") == 0) return ELEM_TEXT_DYNAMIC;
+    if (strcmp(typeStr, "temp") == 0) return ELEM_TEMP_VALUE;
+    if (strcmp(typeStr, "coord") == 0) return ELEM_COORD_VALUE;
+    if (strcmp(typeStr, "status") == 0) return ELEM_STATUS_VALUE;
+    if (strcmp(typeStr, "progress") == 0) return ELEM_PROGRESS_BAR;
+    if (strcmp(typeStr, "graph") == 0) return ELEM_GRAPH;
+    return ELEM_NONE;
+}
+
+// Parse text alignment from string
+TextAlign parseAlignment(const char* alignStr) {
+    if (strcmp(alignStr, "center") == 0) return ALIGN_CENTER;
+    if (strcmp(alignStr, "right") == 0) return ALIGN_RIGHT;
+    return ALIGN_LEFT;
+}
+
+// View-model slot for an element's value (VM_NO_SLOT if it shows no data).
+// dataText is the full JSON "data" string - expressions may be longer than
+// se.dataSource, which only keeps a truncated copy.
+static uint8_t bindElementSlot(const ScreenElement& se, const char* dataText) {
+    uint8_t source;
+    if (dataText[0] == '=') {
+        uint8_t program = compileExpression(dataText);
+        if (program == EXPR_NONE) return VM_NO_SLOT;
+        source = DS_EXPR_BASE + program;
+    } else {
+        source = lookupDataSource(dataText);
+    }
+
+    switch (se.type) {
+        case ELEM_TEXT_DYNAMIC:
+        case ELEM_STATUS_VALUE:
+            // Computed values are numeric - honour "decimals" like temp/coord do
+            if (source >= DS_EXPR_BASE) return viewModelBind(source, FMT_FIXED, se.decimals);
+            return viewModelBind(source, FMT_RAW, 0);
+        case ELEM_TEMP_VALUE:
+            return viewModelBind(source, FMT_TEMP, se.decimals);
+        case ELEM_COORD_VALUE:
+            return viewModelBind(source, FMT_COORD, se.decimals);
+        default:
+            return VM_NO_SLOT;
+    }
+}
+
+// Does an element's "data" string name a known source (or a valid expression)?
+static bool isKnownDataSource(const char* dataText) {
+    if (dataText[0] == '=') return checkExpression(dataText) == nullptr;
+    return lookupDataSource(dataText) != DS_NONE;
+}
+
+static bool elementUsesData(ElementType type) {
+    return type == ELEM_TEXT_DYNAMIC || type == ELEM_STATUS_VALUE ||
+           type == ELEM_TEMP_VALUE || type == ELEM_COORD_VALUE;
+}
+
+// Parse a screen JSON document into layout and compile its display list
+bool parseScreenJson(const char* json, ScreenLayout& layout, bool bindData) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, json);
+
+    if (error) {
+        LOGE("JSON", "Parse error: %s", error.c_str());
+        return false;
+    }
+
+    // Extract layout info
+    strncpy(layout.name, doc["name"] | "Unnamed", sizeof(layout.name) - 1);
+    layout.backgroundColor = parseColor(doc["background"] | "0000");
+    layout.elementCount = 0;
+    layout.isValid = false;
+    layout.droppedElements = 0;
+    layout.unknownSourceMask = 0;
+
+    // Parse elements array
+    JsonArray elements = doc["elements"].as<JsonArray>();
+    if (!elements) {
+        LOGW("JSON", "No elements array found");
+        return false;
+    }
+
+    int elementIndex = 0;
+    for (JsonObject elem : elements) {
+        if (elementIndex >= 60) {
+            layout.droppedElements++;
+            continue;
+        }
+
+        ScreenElement& se = layout.elements[elementIndex];
+
+        // Parse element properties
+        se.type = parseElementType(elem["type"] | "none");
+        se.x = elem["x"] | 0;
+        se.y = elem["y"] | 0;
+        se.w = elem["w"] | 0;
+        se.h = elem["h"] | 0;
+        se.color = parseColor(elem["color"] | "FFFF");
+        se.bgColor = parseColor(elem["bgColor"] | "0000");
+        se.textSize = elem["size"] | 2;
+        se.decimals = elem["decimals"] | 2;
+        se.filled = elem["filled"] | true;
+        se.showLabel = elem["showLabel"] | true;
+        se.align = parseAlignment(elem["align"] | "left");
+
+        // Copy strings
+        strncpy(se.label, elem["label"] | "", sizeof(se.label) - 1);
+        strncpy(se.dataSource, elem["data"] | "", sizeof(se.dataSource) - 1);
+
+        const char* dataText = elem["data"] | "";
+        if (elementUsesData(se.type) && !isKnownDataSource(dataText)) {
+            layout.unknownSourceMask |= (uint64_t)1 << elementIndex;
+            LOGW("JSON", "Element %d: unknown data source \"%s\"", elementIndex, dataText);
+        }
+
+        // Bind dynamic elements to a pre-formatted view-model slot
+        se.slot = bindData ? bindElementSlot(se, dataText) : VM_NO_SLOT;
+
+        elementIndex++;
+    }
+
+    if (layout.droppedElements > 0) {
+        LOGW("JSON", "Max 60 elements, ignored %d", layout.droppedElements);
+    }
+
+    layout.elementCount = elementIndex;
+    layout.isValid = true;
+
+    LOGI("JSON", "Loaded %d elements from %s", elementIndex, layout.name);
+
+    // Compile into a display list once, instead of interpreting on every draw
+    compileDisplayList(layout);
+    return true;
+}
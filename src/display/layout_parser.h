@@ -0,0 +1,21 @@
+#ifndef LAYOUT_PARSER_H
+#define LAYOUT_PARSER_H
+
+#include <Arduino.h>
+#include "config/config.h"
+
+// ========== Screen Layout Parser ==========
+// Screen JSON to ScreenLayout (element model + compiled display list).
+// Nothing here draws or touches the SD card: the display, the web API's
+// layout analysis and the host tests all parse with this code.
+
+// JSON parsing functions
+uint16_t parseColor(const char* hexColor);
+ElementType parseElementType(const char* typeStr);
+TextAlign parseAlignment(const char* alignStr);
+
+// Parse screen JSON into layout (element model + display list). With bindData
+// false nothing is bound to the view model, so it is safe from any task.
+bool parseScreenJson(const char* json, ScreenLayout& layout, bool bindData);
+
+#endif // LAYOUT_PARSER_H
@@ -1,13 +1,19 @@
 #include "screen_renderer.h"
+#include "layout_parser.h"
 #include "display.h"
+#include "display_list.h"
+#include "view_model.h"
+#include "expression.h"
+#include "layout_analyzer.h"
 #include <WiFi.h>
 #include <SD.h>
-#include <ArduinoJson.h>
 #include "../webserver/sd_mutex.h"
+#include "utils/log.h"
+#include "utils/event_trace.h"
+#include "utils/heap_telemetry.h"
 
 // External variables from main.cpp (needed for data access)
 extern bool sdCardAvailable;
-extern float temperatures[4];
 extern float posX, posY, posZ, posA;
 extern float wposX, wposY, wposZ, wposA;
 extern int feedRate;
@@ -16,107 +22,58 @@ extern float psuVoltage;
 extern uint8_t fanSpeed;
 extern String machineState;
 
-// ========== JSON PARSING FUNCTIONS ==========
-
-// Convert hex color string to uint16_t RGB565
-uint16_t parseColor(const char* hexColor) {
-    if (hexColor == nullptr || strlen(hexColor) < 4) {
-        return 0x0000; // Default to black
-    }
-
-    // Skip '#' if present
-    const char* hex = (hexColor[0] == '#') ? hexColor + 1 : hexColor;
-
-    // Parse hex string
-    uint32_t color = strtoul(hex, nullptr, 16);
-
-    // Convert to RGB565
-    if (strlen(hex) == 4) {
-        // Short form: RGB -> RRGGBB
-        uint8_t r = ((color >> 8) & 0xF) * 17;
-        uint8_t g = ((color >> 4) & 0xF) * 17;
-        uint8_t b = (color & 0xF) * 17;
-        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-    } else {
-        // Full form: RRGGBB
-        uint8_t r = (color >> 16) & 0xFF;
-        uint8_t g = (color >> 8) & 0xFF;
-        uint8_t b = color & 0xFF;
-        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-    }
-}
-
-// Parse element type from string
-ElementType parseElementType(const char* typeStr) {
-    if (strcmp(typeStr, "rect") == 0) return ELEM_RECT;
-    if (strcmp(typeStr, "line") == 0) return ELEM_LINE;
-    if (strcmp(typeStr, "text") == 0) return ELEM_TEXT_STATIC;
-    if (strcmp(typeStr, "dynamic") == 0) return ELEM_TEXT_DYNAMIC;
-    if (strcmp(typeStr, "temp") == 0) return ELEM_TEMP_VALUE;
-    if (strcmp(typeStr, "coord") == 0) return ELEM_COORD_VALUE;
-    if (strcmp(typeStr, "status") == 0) return ELEM_STATUS_VALUE;
-    if (strcmp(typeStr, "progress") == 0) return ELEM_PROGRESS_BAR;
-    if (strcmp(typeStr, "graph") == 0) return ELEM_GRAPH;
-    return ELEM_NONE;
-}
-
-// Parse text alignment from string
-TextAlign parseAlignment(const char* alignStr) {
-    if (strcmp(alignStr, "center") == 0) return ALIGN_CENTER;
-    if (strcmp(alignStr, "right") == 0) return ALIGN_RIGHT;
-    return ALIGN_LEFT;
-}
-
 // Load screen configuration from JSON file
 bool loadScreenConfig(const char* filename, ScreenLayout& layout) {
+    EVT_SCOPE("loadScreenConfig");
+    HEAP_SCOPE(HEAP_RENDER, "loadScreenConfig");
     if (!sdCardAvailable) {
-        Serial.printf("[JSON] SD card not available, cannot load %s\n", filename);
+        LOGW("JSON", "SD card not available, cannot load %s", filename);
         return false;
     }
 
-    Serial.printf("[JSON] Loading screen config: %s\n", filename);
+    LOGI("JSON", "Loading screen config: %s", filename);
 
     // EXPLICIT NULL check for mutex
     if (g_sdCardMutex == NULL) {
-        Serial.println("[JSON/loadScreenConfig] CRASH PREVENTED: Mutex is NULL!");
+        LOGE("JSON/loadScreenConfig", "CRASH PREVENTED: Mutex is NULL!");
         return false;
     }
 
     // EXPLICIT lock with timeout
-    Serial.printf("[JSON/loadScreenConfig] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-    BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+    LOGD("JSON/loadScreenConfig", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+    BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
     if (lockResult != pdTRUE) {
-        Serial.println("[JSON/loadScreenConfig] Failed to acquire lock (timeout)");
+        LOGE("JSON/loadScreenConfig", "Failed to acquire lock (timeout)");
         return false;
     }
-    Serial.println("[JSON/loadScreenConfig] ✓ Lock acquired");
+    LOGD("JSON/loadScreenConfig", "✓ Lock acquired");
 
     // Open file
     File file = SD.open(filename, FILE_READ);
     if (!file) {
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[JSON/loadScreenConfig] ✓ Unlocked (result=%d)\n", unlockResult);
-        Serial.printf("[JSON] Failed to open %s\n", filename);
+        sdMutexGive();
+        LOGD("JSON/loadScreenConfig", "✓ Unlocked");
+        LOGE("JSON", "Failed to open %s", filename);
         return false;
     }
 
     // Read file content
     size_t fileSize = file.size();
     if (fileSize > 8192) {
-        Serial.printf("[JSON] File too large: %d bytes (max 8192)\n", fileSize);
+        LOGW("JSON", "File too large: %d bytes (max 8192)", fileSize);
         file.close();
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[JSON/loadScreenConfig] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("JSON/loadScreenConfig", "✓ Unlocked");
         return false;
     }
 
     // Allocate buffer
     char* jsonBuffer = (char*)malloc(fileSize + 1);
     if (!jsonBuffer) {
-        Serial.println("[JSON] Failed to allocate memory");
+        LOGE("JSON", "Failed to allocate memory");
         file.close();
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[JSON/loadScreenConfig] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("JSON/loadScreenConfig", "✓ Unlocked");
         return false;
     }
 
@@ -126,66 +83,56 @@ bool loadScreenConfig(const char* filename, ScreenLayout& layout) {
     file.close();
 
     // EXPLICIT unlock - file is closed, data is in memory
-    BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-    Serial.printf("[JSON/loadScreenConfig] ✓ Unlocked (result=%d)\n", unlockResult);
+    sdMutexGive();
+    LOGD("JSON/loadScreenConfig", "✓ Unlocked");
 
-    // Parse JSON
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonBuffer);
+    bool loaded = parseScreenJson(jsonBuffer, layout, true);
     free(jsonBuffer);
 
-    if (error) {
-        Serial.printf("[JSON] Parse error: %s\n", error.c_str());
-        return false;
+    if (loaded) {
+        LayoutReport report;
+        analyzeLayout(layout, LAYOUT_FRAME_BUDGET_MS * 1000UL, report);
+        LOGI("LINT", "%s: full draw ~%.1f ms (%lu B), update ~%.1f ms, overdraw %.2fx%s",
+             layout.name, report.fullDrawUs / 1000.0f, (unsigned long)report.fullDrawBytes,
+             report.updateUs / 1000.0f, report.overdraw,
+             report.withinBudget ? "" : " - OVER BUDGET");
     }
+    return loaded;
+}
+
+// Defined in main.cpp
+void bindStatusSlots();
 
-    // Extract layout info
-    strncpy(layout.name, doc["name"] | "Unnamed", sizeof(layout.name) - 1);
-    layout.backgroundColor = parseColor(doc["background"] | "0000");
-    layout.elementCount = 0;
-    layout.isValid = false;
+bool loadScreenLayouts() {
+    // Slots and programs are only ever added by viewModelBind and
+    // compileExpression: drop them all, so a reload does not leave the old
+    // layouts' bindings filling the pools
+    viewModelReset();
+    exprReset();
+    bindStatusSlots();
+    initDefaultLayouts();
 
-    // Parse elements array
-    JsonArray elements = doc["elements"].as<JsonArray>();
-    if (!elements) {
-        Serial.println("[JSON] No elements array found");
+    if (!sdCardAvailable) {
+        layoutsLoaded = false;
         return false;
     }
 
-    int elementIndex = 0;
-    for (JsonObject elem : elements) {
-        if (elementIndex >= 60) {
-            Serial.println("[JSON] Warning: Max 60 elements, ignoring rest");
-            break;
-        }
-
-        ScreenElement& se = layout.elements[elementIndex];
-
-        // Parse element properties
-        se.type = parseElementType(elem["type"] | "none");
-        se.x = elem["x"] | 0;
-        se.y = elem["y"] | 0;
-        se.w = elem["w"] | 0;
-        se.h = elem["h"] | 0;
-        se.color = parseColor(elem["color"] | "FFFF");
-        se.bgColor = parseColor(elem["bgColor"] | "0000");
-        se.textSize = elem["size"] | 2;
-        se.decimals = elem["decimals"] | 2;
-        se.filled = elem["filled"] | true;
-        se.showLabel = elem["showLabel"] | true;
-        se.align = parseAlignment(elem["align"] | "left");
-
-        // Copy strings
-        strncpy(se.label, elem["label"] | "", sizeof(se.label) - 1);
-        strncpy(se.dataSource, elem["data"] | "", sizeof(se.dataSource) - 1);
-
-        elementIndex++;
+    if (loadScreenConfig("/screens/monitor.json", monitorLayout)) {
+        LOGI("JSON", "     ✓ Monitor layout loaded");
+    } else {
+        LOGW("JSON", "     ⚠ Monitor layout not found, using fallback");
+    }
+    if (loadScreenConfig("/screens/alignment.json", alignmentLayout)) {
+        LOGI("JSON", "     ✓ Alignment layout loaded");
+    }
+    if (loadScreenConfig("/screens/graph.json", graphLayout)) {
+        LOGI("JSON", "     ✓ Graph layout loaded");
+    }
+    if (loadScreenConfig("/screens/network.json", networkLayout)) {
+        LOGI("JSON", "     ✓ Network layout loaded");
     }
 
-    layout.elementCount = elementIndex;
-    layout.isValid = true;
-
-    Serial.printf("[JSON] Loaded %d elements from %s\n", elementIndex, layout.name);
+    layoutsLoaded = true;
     return true;
 }
 
@@ -196,40 +143,28 @@ void initDefaultLayouts() {
     alignmentLayout.isValid = false;
     graphLayout.isValid = false;
     networkLayout.isValid = false;
+    monitorLayout.opCount = 0;
+    alignmentLayout.opCount = 0;
+    graphLayout.opCount = 0;
+    networkLayout.opCount = 0;
+    monitorLayout.bgBandCount = 0;
+    alignmentLayout.bgBandCount = 0;
+    graphLayout.bgBandCount = 0;
+    networkLayout.bgBandCount = 0;
 
     strcpy(monitorLayout.name, "Monitor (Fallback)");
     strcpy(alignmentLayout.name, "Alignment (Fallback)");
     strcpy(graphLayout.name, "Graph (Fallback)");
     strcpy(networkLayout.name, "Network (Fallback)");
 
-    Serial.println("[JSON] Default layouts initialized (fallback mode)");
+    LOGI("JSON", "Default layouts initialized (fallback mode)");
 }
 
 // ========== DATA ACCESS FUNCTIONS ==========
 
 // Get numeric data value from data source identifier
 float getDataValue(const char* dataSource) {
-    if (strcmp(dataSource, "posX") == 0) return posX;
-    if (strcmp(dataSource, "posY") == 0) return posY;
-    if (strcmp(dataSource, "posZ") == 0) return posZ;
-    if (strcmp(dataSource, "posA") == 0) return posA;
-
-    if (strcmp(dataSource, "wposX") == 0) return wposX;
-    if (strcmp(dataSource, "wposY") == 0) return wposY;
-    if (strcmp(dataSource, "wposZ") == 0) return wposZ;
-    if (strcmp(dataSource, "wposA") == 0) return wposA;
-
-    if (strcmp(dataSource, "feedRate") == 0) return feedRate;
-    if (strcmp(dataSource, "spindleRPM") == 0) return spindleRPM;
-    if (strcmp(dataSource, "psuVoltage") == 0) return psuVoltage;
-    if (strcmp(dataSource, "fanSpeed") == 0) return fanSpeed;
-
-    if (strcmp(dataSource, "temp0") == 0) return temperatures[0];
-    if (strcmp(dataSource, "temp1") == 0) return temperatures[1];
-    if (strcmp(dataSource, "temp2") == 0) return temperatures[2];
-    if (strcmp(dataSource, "temp3") == 0) return temperatures[3];
-
-    return 0.0f;
+    return readDataSource(lookupDataSource(dataSource));
 }
 
 // Get string data value from data source identifier
@@ -247,113 +182,186 @@ String getDataString(const char* dataSource) {
 
 // ========== DRAWING FUNCTIONS ==========
 
-// Draw a single screen element
-void drawElement(const ScreenElement& elem) {
-    switch(elem.type) {
-        case ELEM_RECT:
-            if (elem.filled) {
-                gfx.fillRect(elem.x, elem.y, elem.w, elem.h, elem.color);
-            } else {
-                gfx.drawRect(elem.x, elem.y, elem.w, elem.h, elem.color);
-            }
-            break;
+// Last text style sent to gfx, so repeated identical styles are skipped.
+// bg == fg means transparent text (LovyanGFX convention).
+static uint8_t currentTextSize = 0;
+static uint16_t currentTextColor = 0;
+static uint16_t currentTextBg = 0;
+static bool textStyleValid = false;
 
-        case ELEM_LINE:
-            if (elem.w > elem.h) {
-                // Horizontal line
-                gfx.drawFastHLine(elem.x, elem.y, elem.w, elem.color);
-            } else {
-                // Vertical line
-                gfx.drawFastVLine(elem.x, elem.y, elem.h, elem.color);
-            }
-            break;
+static void setTextStyle(uint8_t size, uint16_t color, uint16_t bg) {
+    if (textStyleValid && size == currentTextSize &&
+        color == currentTextColor && bg == currentTextBg) {
+        return;
+    }
+    gfx.setTextSize(size);
+    if (bg == color) {
+        gfx.setTextColor(color);
+    } else {
+        gfx.setTextColor(color, bg);
+    }
+    currentTextSize = size;
+    currentTextColor = color;
+    currentTextBg = bg;
+    textStyleValid = true;
+}
+
+static void setTextStyle(uint8_t size, uint16_t color) {
+    setTextStyle(size, color, color);
+}
+
+// Forget the cached style (other code may have changed gfx state since)
+void invalidateTextStyle() {
+    textStyleValid = false;
+}
+
+// Glyph width per text size, measured once from the font. Font0 is
+// monospaced, so digits (and every other glyph) share one advance width.
+static uint8_t glyphWidthCache[9] = {0};
 
+uint16_t getTextWidth(const char* text, uint8_t textSize) {
+    if (textSize == 0 || textSize > 8) {
+        return strlen(text) * FONT_CHAR_WIDTH * textSize;
+    }
+    if (glyphWidthCache[textSize] == 0) {
+        gfx.setTextSize(textSize);
+        glyphWidthCache[textSize] = gfx.textWidth("0");
+        invalidateTextStyle();
+    }
+    return strlen(text) * glyphWidthCache[textSize];
+}
+
+// Last drawn text extent per element of the layout on screen, so updates
+// only clear what the new text no longer covers
+static const ScreenLayout* extentLayout = nullptr;
+static int16_t lastTextX[60];
+static int16_t lastTextW[60];
+static uint16_t lastSlotVersion[60];   // View-model version last drawn
+
+// Build the full text an element prints (label prefix + formatted value).
+// Returns false for elements that do not print text.
+static bool formatElementText(const ScreenElement& elem, char* buf, size_t len) {
+    const char* label = (elem.showLabel && elem.label[0] != '\0') ? elem.label : "";
+
+    switch (elem.type) {
         case ELEM_TEXT_STATIC:
-            gfx.setTextSize(elem.textSize);
-            gfx.setTextColor(elem.color);
-            gfx.setCursor(elem.x, elem.y);
-            gfx.print(elem.label);
-            break;
+            strlcpy(buf, elem.label, len);
+            return true;
 
         case ELEM_TEXT_DYNAMIC:
-            {
-                gfx.setTextSize(elem.textSize);
-                gfx.setTextColor(elem.color);
-                gfx.setCursor(elem.x, elem.y);
-
-                String value = getDataString(elem.dataSource);
-                if (elem.showLabel && strlen(elem.label) > 0) {
-                    gfx.print(elem.label);
+        case ELEM_STATUS_VALUE:
+        case ELEM_TEMP_VALUE:
+        case ELEM_COORD_VALUE:
+            if (elem.slot != VM_NO_SLOT) {
+                // Pre-formatted by the view model - just copy bytes
+                size_t labelLen = strlcpy(buf, label, len);
+                if (labelLen < len) {
+                    viewModelCopy(elem.slot, buf + labelLen, len - labelLen);
                 }
-                gfx.print(value);
+                return true;
             }
             break;
 
+        default:
+            return false;
+    }
+
+    // Unbound element (unknown source or slot pool full) - format directly
+    switch (elem.type) {
+        case ELEM_TEXT_DYNAMIC:
+        case ELEM_STATUS_VALUE:
+            snprintf(buf, len, "%s%s", label, getDataString(elem.dataSource).c_str());
+            return true;
+
         case ELEM_TEMP_VALUE:
             {
-                gfx.setTextSize(elem.textSize);
-                gfx.setTextColor(elem.color);
-                gfx.setCursor(elem.x, elem.y);
-
                 float temp = getDataValue(elem.dataSource);
                 if (cfg.use_fahrenheit) {
                     temp = temp * 9.0 / 5.0 + 32.0;
                 }
-
-                if (elem.showLabel && strlen(elem.label) > 0) {
-                    gfx.print(elem.label);
-                }
-                gfx.printf("%.*f%c", elem.decimals, temp,
-                          cfg.use_fahrenheit ? 'F' : 'C');
+                snprintf(buf, len, "%s%.*f%c", label, elem.decimals, temp,
+                         cfg.use_fahrenheit ? 'F' : 'C');
             }
-            break;
+            return true;
 
         case ELEM_COORD_VALUE:
             {
-                gfx.setTextSize(elem.textSize);
-                gfx.setTextColor(elem.color);
-                gfx.setCursor(elem.x, elem.y);
-
                 float value = getDataValue(elem.dataSource);
                 if (cfg.use_inches) {
                     value = value / 25.4;
                 }
-
-                if (elem.showLabel && strlen(elem.label) > 0) {
-                    gfx.print(elem.label);
-                }
-                gfx.printf("%.*f", elem.decimals, value);
+                snprintf(buf, len, "%s%.*f", label, elem.decimals, value);
             }
-            break;
+            return true;
 
-        case ELEM_STATUS_VALUE:
-            {
-                gfx.setTextSize(elem.textSize);
-
-                // Color-code machine state
-                if (strcmp(elem.dataSource, "machineState") == 0) {
-                    if (machineState == "RUN") {
-                        gfx.setTextColor(COLOR_GOOD);
-                    } else if (machineState == "ALARM") {
-                        gfx.setTextColor(COLOR_WARN);
-                    } else {
-                        gfx.setTextColor(elem.color);
-                    }
-                } else {
-                    gfx.setTextColor(elem.color);
-                }
+        default:
+            return false;
+    }
+}
 
-                gfx.setCursor(elem.x, elem.y);
+// Foreground colour of a text element (machineState is colour-coded)
+static uint16_t elementTextColor(const ScreenElement& elem) {
+    if (elem.type == ELEM_STATUS_VALUE && strcmp(elem.dataSource, "machineState") == 0) {
+        if (machineState == "RUN") return COLOR_GOOD;
+        if (machineState == "ALARM") return COLOR_WARN;
+    }
+    return elem.color;
+}
 
-                if (elem.showLabel && strlen(elem.label) > 0) {
-                    gfx.print(elem.label);
-                }
+// Draw a text element at its aligned position. With opaque set, glyph cells
+// are painted in elem.bgColor so the previous text is overwritten in place.
+static void drawTextElement(const ScreenElement& elem, int index, bool opaque) {
+    // Read the version before the text, so a concurrent change is redrawn next time
+    if (index >= 0 && elem.slot != VM_NO_SLOT) {
+        lastSlotVersion[index] = viewModelVersion(elem.slot);
+    }
+
+    char text[64];
+    if (!formatElementText(elem, text, sizeof(text))) return;
+
+    uint16_t width = getTextWidth(text, elem.textSize);
+    int16_t x = alignTextX(elem, width);
+    uint16_t color = elementTextColor(elem);
 
-                String value = getDataString(elem.dataSource);
-                gfx.print(value);
+    setTextStyle(elem.textSize, color, opaque ? elem.bgColor : color);
+    gfx.setCursor(x, elem.y);
+    gfx.print(text);
+
+    if (index >= 0) {
+        lastTextX[index] = x;
+        lastTextW[index] = width;
+    }
+}
+
+static void drawElementAt(const ScreenElement& elem, int index) {
+    EVT_SCOPE("drawElement");
+    switch(elem.type) {
+        case ELEM_RECT:
+            if (elem.filled) {
+                gfx.fillRect(elem.x, elem.y, elem.w, elem.h, elem.color);
+            } else {
+                gfx.drawRect(elem.x, elem.y, elem.w, elem.h, elem.color);
+            }
+            break;
+
+        case ELEM_LINE:
+            if (elem.w > elem.h) {
+                // Horizontal line
+                gfx.drawFastHLine(elem.x, elem.y, elem.w, elem.color);
+            } else {
+                // Vertical line
+                gfx.drawFastVLine(elem.x, elem.y, elem.h, elem.color);
             }
             break;
 
+        case ELEM_TEXT_STATIC:
+        case ELEM_TEXT_DYNAMIC:
+        case ELEM_TEMP_VALUE:
+        case ELEM_COORD_VALUE:
+        case ELEM_STATUS_VALUE:
+            drawTextElement(elem, index, false);
+            break;
+
         case ELEM_PROGRESS_BAR:
             {
                 // Draw outline
@@ -374,8 +382,7 @@ void drawElement(const ScreenElement& elem) {
         case ELEM_GRAPH:
             // Placeholder for mini-graph rendering
             gfx.drawRect(elem.x, elem.y, elem.w, elem.h, elem.color);
-            gfx.setTextSize(1);
-            gfx.setTextColor(elem.color);
+            setTextStyle(1, elem.color);
             gfx.setCursor(elem.x + 5, elem.y + 5);
             gfx.print("GRAPH");
             break;
@@ -385,18 +392,83 @@ void drawElement(const ScreenElement& elem) {
     }
 }
 
+// Draw a single screen element
+void drawElement(const ScreenElement& elem) {
+    drawElementAt(elem, -1);
+}
+
+// Redraw one dynamic element of the layout on screen. Text is drawn with an
+// opaque background at its aligned position, then only the part of the
+// previous extent that the new text does not cover is cleared.
+void updateElement(const ScreenLayout& layout, uint8_t index) {
+    const ScreenElement& elem = layout.elements[index];
+
+    bool isText = elem.type == ELEM_TEXT_DYNAMIC ||
+                  elem.type == ELEM_TEMP_VALUE ||
+                  elem.type == ELEM_COORD_VALUE ||
+                  elem.type == ELEM_STATUS_VALUE;
+
+    if (!isText || extentLayout != &layout) {
+        // Clear the element area and redraw
+        if (elem.w > 0 && elem.h > 0) {
+            gfx.fillRect(elem.x, elem.y, elem.w, elem.h, elem.bgColor);
+        }
+        drawElementAt(elem, -1);
+        return;
+    }
+
+    // Unchanged value - nothing to send over SPI
+    if (elem.slot != VM_NO_SLOT && viewModelVersion(elem.slot) == lastSlotVersion[index]) {
+        return;
+    }
+
+    int16_t oldX = lastTextX[index];
+    int16_t oldRight = oldX + lastTextW[index];
+
+    drawTextElement(elem, index, true);
+
+    int16_t newX = lastTextX[index];
+    int16_t newRight = newX + lastTextW[index];
+    int16_t height = FONT_CHAR_HEIGHT * elem.textSize;
+
+    // Clear the delta between the old and new extents
+    if (oldX < newX) {
+        gfx.fillRect(oldX, elem.y, min(newX, oldRight) - oldX, height, elem.bgColor);
+    }
+    if (oldRight > newRight) {
+        int16_t start = max(newRight, oldX);
+        gfx.fillRect(start, elem.y, oldRight - start, height, elem.bgColor);
+    }
+}
+
 // Draw entire screen from layout definition
 void drawScreenFromLayout(const ScreenLayout& layout) {
     if (!layout.isValid) {
-        Serial.println("[JSON] Invalid layout, cannot draw");
+        LOGW("JSON", "Invalid layout, cannot draw");
         return;
     }
 
-    // Clear screen with background color
-    gfx.fillScreen(layout.backgroundColor);
+    // Clear screen with background color, skipping rows that full-width
+    // fills in the display list paint over anyway
+    for (uint8_t i = 0; i < layout.bgBandCount; i++) {
+        gfx.fillRect(0, layout.bgBandY[i], SCREEN_WIDTH, layout.bgBandH[i], layout.backgroundColor);
+    }
+    invalidateTextStyle();
 
-    // Draw all elements
+    // Text extents recorded below belong to this layout from now on
+    extentLayout = &layout;
     for (uint8_t i = 0; i < layout.elementCount; i++) {
-        drawElement(layout.elements[i]);
+        lastTextX[i] = layout.elements[i].x;
+        lastTextW[i] = 0;
+    }
+
+    // Run the compiled display list (occluded ops removed, fills merged)
+    for (uint8_t i = 0; i < layout.opCount; i++) {
+        const DisplayOp& op = layout.ops[i];
+        if (op.kind == OP_FILL_RECT) {
+            gfx.fillRect(op.x, op.y, op.w, op.h, op.color);
+        } else {
+            drawElementAt(layout.elements[op.elem], op.elem);
+        }
     }
 }
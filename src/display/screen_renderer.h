@@ -4,18 +4,24 @@
 #include <Arduino.h>
 #include "config/config.h"
 
-// JSON parsing functions
-uint16_t parseColor(const char* hexColor);
-ElementType parseElementType(const char* typeStr);
-TextAlign parseAlignment(const char* alignStr);
-
 // Screen layout functions
 bool loadScreenConfig(const char* filename, ScreenLayout& layout);
+
+// Load (or reload) all four layouts from /screens, falling back to the
+// legacy screens for any that fail. The view model is reset first and every
+// binding is made again. Loop task only. False if the SD card is missing.
+bool loadScreenLayouts();
+
 void initDefaultLayouts();
 
 // Drawing functions
 void drawScreenFromLayout(const ScreenLayout& layout);
 void drawElement(const ScreenElement& elem);
+void updateElement(const ScreenLayout& layout, uint8_t index);
+void invalidateTextStyle();
+
+// Width in pixels of text at the given size (glyph width cached per size)
+uint16_t getTextWidth(const char* text, uint8_t textSize);
 
 // Data access functions
 float getDataValue(const char* dataSource);
@@ -1,13 +1,21 @@
 #include "ui_modes.h"
 #include "display.h"
 #include "screen_renderer.h"
+#include "view_model.h"
+#include "sensors/sensors.h"
+#include "history/history_store.h"
+#include "utils/log.h"
+#include "utils/perf.h"
+#include "utils/event_trace.h"
+#include "utils/heap_telemetry.h"
 #include <WiFi.h>
 #include <RTClib.h>
 
 // External variables from main.cpp
 extern DisplayMode currentMode;
-extern float temperatures[4];
-extern float peakTemps[4];
+extern float* temperatures;
+extern float* peakTemps;
+extern uint8_t temperatureCount;
 extern float psuVoltage;
 extern uint8_t fanSpeed;
 extern uint16_t fanRPM;
@@ -18,28 +26,53 @@ extern float wposX, wposY, wposZ, wposA;
 extern bool inAPMode;
 extern bool rtcAvailable;
 extern RTC_DS3231 rtc;
-extern float *tempHistory;
-extern uint16_t historySize;
-extern uint16_t historyIndex;
 extern unsigned long buttonPressStart;
 extern bool buttonPressed;
 
 // Function prototypes
 void enterSetupMode();
+void drawPerfHud();
 const char* getMonthName(int month);
 void updateDynamicElements(const ScreenLayout& layout);
 
+// Copy a pre-formatted view-model value (binds the slot on first use)
+static const char* vmText(uint8_t source, ValueFormat format, uint8_t decimals,
+                          char* buf, size_t len) {
+    viewModelCopy(viewModelBind(source, format, decimals), buf, len);
+    return buf;
+}
+
+// Whole-degree temperature with a prefix; "--" while the channel is stale
+static void formatWholeTemp(char* buf, const char* prefix, float value) {
+    if (isnan(value)) {
+        sprintf(buf, "%s--", prefix);
+    } else {
+        sprintf(buf, "%s%d%s", prefix, (int)value, cfg.use_fahrenheit ? "F" : "C");
+    }
+}
+
+// Hottest channel for the status lines (Celsius); "--" with every channel stale
+static void formatMaxTemp(char* buf, float value) {
+    if (isnan(value)) {
+        strcpy(buf, "--");
+    } else {
+        sprintf(buf, "%.0fC", value);
+    }
+}
+
 // ========== MAIN DISPLAY CONTROL ==========
 
 void drawScreen() {
+    EVT_SCOPE("drawScreen");
+    HEAP_SCOPE(HEAP_RENDER, "drawScreen");
     switch(currentMode) {
         case MODE_MONITOR:
             // Try JSON layout first, fallback to legacy if not available
             if (monitorLayout.isValid) {
-                Serial.println("[JSON] Drawing monitor from JSON layout");
+                LOGD("JSON", "Drawing monitor from JSON layout");
                 drawScreenFromLayout(monitorLayout);
             } else {
-                Serial.println("[Legacy] Drawing monitor with legacy code");
+                LOGD("Legacy", "Drawing monitor with legacy code");
                 drawMonitorMode();
             }
             break;
@@ -71,6 +104,11 @@ void drawScreen() {
 }
 
 void updateDisplay() {
+    HEAP_SCOPE(HEAP_RENDER, "updateDisplay");
+    // Pick up anything that changed outside the telemetry producers
+    // (units, network strings) before copying values to the screen
+    viewModelUpdate();
+
     if (currentMode == MODE_MONITOR) {
         // Use JSON dynamic update if available, otherwise legacy
         if (monitorLayout.isValid) {
@@ -97,12 +135,23 @@ void updateDisplay() {
             updateNetworkMode();
         }
     }
+
+    // Profiler overlay (POST /api/perf?hud=1); a full redraw removes it
+    static bool hudShown = false;
+    if (perfHudEnabled()) {
+        drawPerfHud();
+        hudShown = true;
+    } else if (hudShown) {
+        hudShown = false;
+        drawScreen();
+    }
 }
 
 // Update only dynamic elements (for efficient screen updates)
 void updateDynamicElements(const ScreenLayout& layout) {
     if (!layout.isValid) return;
 
+    invalidateTextStyle();
     for (uint8_t i = 0; i < layout.elementCount; i++) {
         const ScreenElement& elem = layout.elements[i];
 
@@ -113,13 +162,8 @@ void updateDynamicElements(const ScreenLayout& layout) {
             elem.type == ELEM_STATUS_VALUE ||
             elem.type == ELEM_PROGRESS_BAR) {
 
-            // Clear the element area
-            if (elem.w > 0 && elem.h > 0) {
-                gfx.fillRect(elem.x, elem.y, elem.w, elem.h, elem.bgColor);
-            }
-
-            // Redraw the element
-            drawElement(elem);
+            // Redraw in place, clearing only what the new value no longer covers
+            updateElement(layout, i);
         }
     }
 }
@@ -160,7 +204,7 @@ void drawMonitorMode() {
   gfx.print("DRIVERS:");
 
   const char* labels[] = {"X:", "YL:", "YR:", "Z:"};
-  for (int i = 0; i < 4; i++) {
+  for (int i = 0; i < 4 && i < temperatureCount; i++) {
     gfx.setCursor(10, 50 + i * 30);
     gfx.setTextColor(COLOR_TEXT);
     gfx.print(labels[i]);
@@ -169,14 +213,14 @@ void drawMonitorMode() {
     gfx.setTextSize(2);
     gfx.setTextColor(temperatures[i] > cfg.temp_threshold_high ? COLOR_WARN : COLOR_VALUE);
     gfx.setCursor(50, 47 + i * 30);
-    sprintf(buffer, "%d%s", (int)temperatures[i], cfg.use_fahrenheit ? "F" : "C");
+    formatWholeTemp(buffer, "", temperatures[i]);
     gfx.print(buffer);
 
     // Peak temp (smaller, to the right)
     gfx.setTextSize(1);
     gfx.setTextColor(COLOR_LINE);
     gfx.setCursor(140, 52 + i * 30);
-    sprintf(buffer, "pk:%d%s", (int)peakTemps[i], cfg.use_fahrenheit ? "F" : "C");
+    formatWholeTemp(buffer, "pk:", peakTemps[i]);
     gfx.print(buffer);
 
     gfx.setTextSize(1);
@@ -266,7 +310,7 @@ void updateMonitorMode() {
   gfx.print(buffer);
 
   // Update temperature values and peaks
-  for (int i = 0; i < 4; i++) {
+  for (int i = 0; i < 4 && i < temperatureCount; i++) {
     // Clear the temperature display area for this driver
     gfx.fillRect(50, 47 + i * 30, 180, 20, COLOR_BG);
 
@@ -274,14 +318,13 @@ void updateMonitorMode() {
     gfx.setTextSize(2);
     gfx.setTextColor(temperatures[i] > cfg.temp_threshold_high ? COLOR_WARN : COLOR_VALUE);
     gfx.setCursor(50, 47 + i * 30);
-    sprintf(buffer, "%d%s", (int)temperatures[i], cfg.use_fahrenheit ? "F" : "C");
-    gfx.print(buffer);
+    gfx.print(vmText(DS_TEMP_BASE + i, FMT_TEMP, 0, buffer, sizeof(buffer)));
 
     // Peak temp
     gfx.setTextSize(1);
     gfx.setTextColor(COLOR_LINE);
     gfx.setCursor(140, 52 + i * 30);
-    sprintf(buffer, "pk:%d%s", (int)peakTemps[i], cfg.use_fahrenheit ? "F" : "C");
+    formatWholeTemp(buffer, "pk:", peakTemps[i]);
     gfx.print(buffer);
   }
 
@@ -299,7 +342,9 @@ void updateMonitorMode() {
   gfx.fillRect(10, 215, 220, 10, COLOR_BG);
   gfx.setCursor(10, 215);
   gfx.setTextColor(COLOR_LINE);
-  sprintf(buffer, "PSU: %.1fV", psuVoltage);
+  char value[VM_TEXT_LEN];
+  snprintf(buffer, sizeof(buffer), "PSU: %sV",
+           vmText(DS_PSU_VOLTAGE, FMT_FIXED, 1, value, sizeof(value)));
   gfx.print(buffer);
 
   // FluidNC Status
@@ -320,21 +365,21 @@ void updateMonitorMode() {
   gfx.fillRect(10, 250, 220, 10, COLOR_BG);
   gfx.setTextColor(COLOR_TEXT);
   gfx.setCursor(10, 250);
-  if (cfg.coord_decimal_places == 3) {
-    sprintf(buffer, "WCS: X:%.3f Y:%.3f Z:%.3f", wposX, wposY, wposZ);
-  } else {
-    sprintf(buffer, "WCS: X:%.2f Y:%.2f Z:%.2f", wposX, wposY, wposZ);
-  }
+  char vx[VM_TEXT_LEN], vy[VM_TEXT_LEN], vz[VM_TEXT_LEN];
+  uint8_t dec = cfg.coord_decimal_places;
+  snprintf(buffer, sizeof(buffer), "WCS: X:%s Y:%s Z:%s",
+           vmText(DS_WPOS_X, FMT_FIXED, dec, vx, sizeof(vx)),
+           vmText(DS_WPOS_Y, FMT_FIXED, dec, vy, sizeof(vy)),
+           vmText(DS_WPOS_Z, FMT_FIXED, dec, vz, sizeof(vz)));
   gfx.print(buffer);
 
   // MCS Coordinates
   gfx.fillRect(10, 265, 220, 10, COLOR_BG);
   gfx.setCursor(10, 265);
-  if (cfg.coord_decimal_places == 3) {
-    sprintf(buffer, "MCS: X:%.3f Y:%.3f Z:%.3f", posX, posY, posZ);
-  } else {
-    sprintf(buffer, "MCS: X:%.2f Y:%.2f Z:%.2f", posX, posY, posZ);
-  }
+  snprintf(buffer, sizeof(buffer), "MCS: X:%s Y:%s Z:%s",
+           vmText(DS_POS_X, FMT_FIXED, dec, vx, sizeof(vx)),
+           vmText(DS_POS_Y, FMT_FIXED, dec, vy, sizeof(vy)),
+           vmText(DS_POS_Z, FMT_FIXED, dec, vz, sizeof(vz)));
   gfx.print(buffer);
 
   // Update temperature graph (if enabled)
@@ -435,14 +480,13 @@ void drawAlignmentMode() {
   else gfx.setTextColor(COLOR_VALUE);
   gfx.printf("Status: %s", machineState.c_str());
 
-  float maxTemp = temperatures[0];
-  for (int i = 1; i < 4; i++) {
-    if (temperatures[i] > maxTemp) maxTemp = temperatures[i];
-  }
+  float maxTemp = getMaxTemperature();
+  char maxText[12];
+  formatMaxTemp(maxText, maxTemp);
 
-  gfx.setTextColor(maxTemp > cfg.temp_threshold_high ? COLOR_WARN : COLOR_LINE);
+  gfx.setTextColor(isnan(maxTemp) || maxTemp > cfg.temp_threshold_high ? COLOR_WARN : COLOR_LINE);
   gfx.setCursor(10, 300);
-  gfx.printf("Temps:%.0fC  Fan:%d%%  PSU:%.1fV", maxTemp, fanSpeed, psuVoltage);
+  gfx.printf("Temps:%s  Fan:%d%%  PSU:%.1fV", maxText, fanSpeed, psuVoltage);
 }
 
 void updateAlignmentMode() {
@@ -528,14 +572,13 @@ void updateAlignmentMode() {
   else gfx.setTextColor(COLOR_VALUE);
   gfx.printf("%s", machineState.c_str());
 
-  float maxTemp = temperatures[0];
-  for (int i = 1; i < 4; i++) {
-    if (temperatures[i] > maxTemp) maxTemp = temperatures[i];
-  }
+  float maxTemp = getMaxTemperature();
+  char maxText[12];
+  formatMaxTemp(maxText, maxTemp);
 
-  gfx.setTextColor(maxTemp > cfg.temp_threshold_high ? COLOR_WARN : COLOR_LINE);
+  gfx.setTextColor(isnan(maxTemp) || maxTemp > cfg.temp_threshold_high ? COLOR_WARN : COLOR_LINE);
   gfx.setCursor(90, 300);
-  gfx.printf("%.0fC  Fan:%d%%  PSU:%.1fV", maxTemp, fanSpeed, psuVoltage);
+  gfx.printf("%s  Fan:%d%%  PSU:%.1fV", maxText, fanSpeed, psuVoltage);
 }
 
 // ========== GRAPH MODE ==========
@@ -719,29 +762,41 @@ void drawTempGraph(int x, int y, int w, int h) {
   float minTemp = 10.0;
   float maxTemp = 60.0;
 
-  // Draw temperature line
-  for (int i = 1; i < historySize; i++) {
-    int idx1 = (historyIndex + i - 1) % historySize;
-    int idx2 = (historyIndex + i) % historySize;
-
-    float temp1 = tempHistory[idx1];
-    float temp2 = tempHistory[idx2];
-
-    int x1 = x + ((i - 1) * w / historySize);
-    int y1 = y + h - ((temp1 - minTemp) / (maxTemp - minTemp) * h);
-    int x2 = x + (i * w / historySize);
-    int y2 = y + h - ((temp2 - minTemp) / (maxTemp - minTemp) * h);
-
-    y1 = constrain(y1, y, y + h);
-    y2 = constrain(y2, y, y + h);
-
-    // Color based on temperature
-    uint16_t color;
-    if (temp2 > cfg.temp_threshold_high) color = COLOR_WARN;
-    else if (temp2 > cfg.temp_threshold_low) color = COLOR_ORANGE;
-    else color = COLOR_GOOD;
-
-    gfx.drawLine(x1, y1, x2, y2, color);
+  // One line per channel over the configured timespan, one point per
+  // graph_update_interval (at most one per pixel); the store picks the tier
+  static HistoryPoint points[240];
+  uint32_t now = millis() / 1000;
+  uint32_t span = cfg.graph_timespan_seconds;
+  uint32_t from = now > span ? now - span : 0;
+  uint32_t wanted = span / max(cfg.graph_update_interval, (uint16_t)1);
+  uint16_t maxPoints = constrain(wanted, (uint32_t)2, (uint32_t)min(w, 240));
+
+  for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+    uint16_t count = historyQuery(ch, from, now, maxPoints, points);
+
+    for (int i = 1; i < count; i++) {
+      if (points[i - 1].avg == HISTORY_NONE || points[i].avg == HISTORY_NONE) continue;
+      float temp1 = historyToCelsius(points[i - 1].avg);
+      float temp2 = historyToCelsius(points[i].avg);
+
+      // Bucket starts may precede from by part of a bucket
+      int x1 = x + (int32_t)(points[i - 1].time - from) * w / (int32_t)span;
+      int y1 = y + h - ((temp1 - minTemp) / (maxTemp - minTemp) * h);
+      int x2 = x + (int32_t)(points[i].time - from) * w / (int32_t)span;
+      int y2 = y + h - ((temp2 - minTemp) / (maxTemp - minTemp) * h);
+
+      x1 = constrain(x1, x, x + w);
+      y1 = constrain(y1, y, y + h);
+      y2 = constrain(y2, y, y + h);
+
+      // Color based on temperature
+      uint16_t color;
+      if (temp2 > cfg.temp_threshold_high) color = COLOR_WARN;
+      else if (temp2 > cfg.temp_threshold_low) color = COLOR_ORANGE;
+      else color = COLOR_GOOD;
+
+      gfx.drawLine(x1, y1, x2, y2, color);
+    }
   }
 
   // Scale markers
@@ -800,6 +855,59 @@ void cycleDisplayMode() {
   drawScreen();
 }
 
+// "850us" / "12.3ms" / "450ms"
+static void formatPerfTime(char* buf, size_t len, float us) {
+  if (us < 1000.0f) {
+    snprintf(buf, len, "%dus", (int)us);
+  } else if (us < 100000.0f) {
+    snprintf(buf, len, "%.1fms", us / 1000.0f);
+  } else {
+    snprintf(buf, len, "%dms", (int)(us / 1000.0f));
+  }
+}
+
+// Loop profiler overlay in the bottom right corner: loop p99 / max, the
+// display and WebSocket p99, and the stage that dominated the worst iteration
+void drawPerfHud() {
+  const int w = 162, h = 36;
+  int x = SCREEN_WIDTH - w;
+  int y = SCREEN_HEIGHT - h;
+
+  PerfStageStats loop = getPerfStageStats(PERF_LOOP);
+  PerfStageStats display = getPerfStageStats(PERF_DISPLAY);
+  PerfStageStats ws = getPerfStageStats(PERF_WEBSOCKET);
+  PerfWorst worst = getPerfWorst();
+  int worstStage = 0;
+  for (int i = 1; i < PERF_LOOP; i++) {
+    if (worst.stageUs[i] > worst.stageUs[worstStage]) worstStage = i;
+  }
+
+  char a[12], b[12];
+  char line[32];
+  gfx.fillRect(x, y, w, h, COLOR_BG);
+  gfx.drawRect(x, y, w, h, COLOR_LINE);
+  gfx.setTextSize(1);
+  gfx.setTextColor(COLOR_VALUE, COLOR_BG);
+
+  formatPerfTime(a, sizeof(a), loop.p99Us);
+  formatPerfTime(b, sizeof(b), loop.maxUs);
+  snprintf(line, sizeof(line), "loop p99 %s max %s", a, b);
+  gfx.setCursor(x + 4, y + 4);
+  gfx.print(line);
+
+  formatPerfTime(a, sizeof(a), display.p99Us);
+  formatPerfTime(b, sizeof(b), ws.p99Us);
+  snprintf(line, sizeof(line), "disp %s  ws %s", a, b);
+  gfx.setCursor(x + 4, y + 14);
+  gfx.print(line);
+
+  formatPerfTime(a, sizeof(a), worst.stageUs[worstStage]);
+  snprintf(line, sizeof(line), "worst %s %s", perfStageName((PerfStage)worstStage), a);
+  gfx.setTextColor(COLOR_WARN, COLOR_BG);
+  gfx.setCursor(x + 4, y + 24);
+  gfx.print(line);
+}
+
 void showHoldProgress() {
   unsigned long elapsed = millis() - buttonPressStart;
   int progress = map(elapsed, 2000, 5000, 0, 100);
@@ -821,7 +929,7 @@ void showHoldProgress() {
 }
 
 void enterSetupMode() {
-  Serial.println("Entering WiFi configuration AP mode...");
+  LOGI("WIFI", "Entering WiFi configuration AP mode...");
 
   // Stop any existing WiFi connection
   WiFi.disconnect();
@@ -832,14 +940,13 @@ void enterSetupMode() {
   WiFi.softAP("FluidDash-Setup");
   inAPMode = true;
 
-  Serial.print("AP started. IP: ");
-  Serial.println(WiFi.softAPIP());
+  LOGI("WIFI", "AP started. IP: %s", WiFi.softAPIP().toString().c_str());
 
   // Show AP mode screen
   currentMode = MODE_NETWORK;
   drawScreen();
 
-  Serial.println("WiFi configuration AP active. Device will continue monitoring.");
+  LOGI("WIFI", "WiFi configuration AP active. Device will continue monitoring.");
 }
 
 const char* getMonthName(int month) {
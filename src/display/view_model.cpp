@@ -0,0 +1,386 @@
+#include "view_model.h"
+#include "expression.h"
+#include "config/config.h"
+#include "sensors/sensors.h"
+#include "sensors/sensor_cache.h"
+#include "utils/heap_telemetry.h"
+#include "utils/log.h"
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+
+// External variables from main.cpp (telemetry owned by the loop task)
+extern float* temperatures;
+extern uint8_t temperatureCount;
+extern float posX, posY, posZ, posA;
+extern float wposX, wposY, wposZ, wposA;
+extern int feedRate;
+extern int spindleRPM;
+extern float psuVoltage;
+extern uint8_t fanSpeed;
+extern String machineState;
+extern unsigned long jobStartTime;
+extern bool isJobRunning;
+
+// Source names as used in layout "data" fields, indexed by DataSourceId
+static const char* const sourceNames[DS_COUNT] = {
+    "",
+    "posX", "posY", "posZ", "posA",
+    "wposX", "wposY", "wposZ", "wposA",
+    "feedRate",
+    "spindleRPM",
+    "psuVoltage",
+    "fanSpeed",
+    "maxTemp",
+    "jobElapsed",
+    "machineState",
+    "ipAddress",
+    "ssid",
+    "deviceName",
+    "fluidncIP"
+};
+
+#define VM_STRING_COUNT (DS_COUNT - DS_FIRST_STRING)
+
+// Last seen raw values and their generation counters
+static float sourceValues[DS_FIRST_STRING];
+static char stringValues[VM_STRING_COUNT][32];
+static uint16_t sourceGen[DS_COUNT];
+
+// Same for temperature channels (DS_TEMP_BASE + channel)
+static float tempValues[VM_MAX_TEMP_SOURCES];
+static uint16_t tempGen[VM_MAX_TEMP_SOURCES];
+static char tempNames[VM_MAX_TEMP_SOURCES][8];
+
+// Formatted slots and the source generation each was formatted from
+static ViewSlot slots[VM_MAX_SLOTS];
+static uint16_t slotSourceGen[VM_MAX_SLOTS];
+static uint8_t slotCount = 0;
+
+// All temperature channels as a JSON list body, for the status API
+static char tempList[VM_MAX_TEMP_SOURCES * 12];
+static size_t tempListLen = 0;
+static uint8_t tempListCount = 0;
+
+// Unit settings the slots were formatted with
+static bool formattedFahrenheit = false;
+static bool formattedInches = false;
+
+// Network strings are polled, not pushed - refresh them at most this often
+static unsigned long lastNetworkRefresh = 0;
+#define VM_NETWORK_REFRESH_MS 2000
+
+// Guards slot text against torn reads from the async_tcp task
+static portMUX_TYPE vmMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ========== SOURCE ACCESS ==========
+
+static bool isTempSource(uint8_t source) {
+    return source >= DS_TEMP_BASE && source < DS_EXPR_BASE;
+}
+
+bool isStringSource(uint8_t source) {
+    return source >= DS_FIRST_STRING && source < DS_COUNT;
+}
+
+uint8_t lookupDataSource(const char* name) {
+    if (name == nullptr || name[0] == '\0') return DS_NONE;
+    for (uint8_t i = 1; i < DS_COUNT; i++) {
+        if (strcmp(sourceNames[i], name) == 0) return i;
+    }
+
+    // Sensor aliases ("spindle"), then "tempN" by channel number
+    int8_t entry = sensorCacheFindAlias(name);
+    if (entry != SENSOR_CACHE_NONE && entry < temperatureCount) return DS_TEMP_BASE + entry;
+    if (strncmp(name, "temp", 4) == 0 && isdigit((unsigned char)name[4])) {
+        char* end;
+        long channel = strtol(name + 4, &end, 10);
+        if (*end == '\0' && channel < temperatureCount) return DS_TEMP_BASE + channel;
+    }
+    return DS_NONE;
+}
+
+const char* dataSourceName(uint8_t source) {
+    if (source >= DS_EXPR_BASE) return exprText(source - DS_EXPR_BASE);
+    if (isTempSource(source)) {
+        char* name = tempNames[source - DS_TEMP_BASE];
+        if (name[0] == '\0') snprintf(name, sizeof(tempNames[0]), "temp%d", source - DS_TEMP_BASE);
+        return name;
+    }
+    if (source >= DS_COUNT) return "";
+    return sourceNames[source];
+}
+
+float readDataSource(uint8_t source) {
+    switch (source) {
+        case DS_POS_X: return posX;
+        case DS_POS_Y: return posY;
+        case DS_POS_Z: return posZ;
+        case DS_POS_A: return posA;
+        case DS_WPOS_X: return wposX;
+        case DS_WPOS_Y: return wposY;
+        case DS_WPOS_Z: return wposZ;
+        case DS_WPOS_A: return wposA;
+        case DS_FEED_RATE: return feedRate;
+        case DS_SPINDLE_RPM: return spindleRPM;
+        case DS_PSU_VOLTAGE: return psuVoltage;
+        case DS_FAN_SPEED: return fanSpeed;
+        case DS_MAX_TEMP: return getMaxTemperature();
+        case DS_JOB_ELAPSED: return isJobRunning ? (millis() - jobStartTime) / 1000 : 0;
+        default:
+            if (source >= DS_EXPR_BASE) return exprValue(source - DS_EXPR_BASE);
+            if (isTempSource(source) && source - DS_TEMP_BASE < temperatureCount) {
+                return temperatures[source - DS_TEMP_BASE];
+            }
+            return 0.0f;
+    }
+}
+
+uint16_t getSourceGeneration(uint8_t source) {
+    if (source >= DS_EXPR_BASE) return exprGeneration(source - DS_EXPR_BASE);
+    if (isTempSource(source)) return tempGen[source - DS_TEMP_BASE];
+    if (source >= DS_COUNT) return 0;
+    return sourceGen[source];
+}
+
+// Fetch the current value of a string source
+static void readStringSource(uint8_t source, char* dst, size_t dstSize) {
+    switch (source) {
+        case DS_MACHINE_STATE: strlcpy(dst, machineState.c_str(), dstSize); break;
+        case DS_IP_ADDRESS: strlcpy(dst, WiFi.localIP().toString().c_str(), dstSize); break;
+        case DS_SSID: strlcpy(dst, WiFi.SSID().c_str(), dstSize); break;
+        case DS_DEVICE_NAME: strlcpy(dst, cfg.device_name, dstSize); break;
+        case DS_FLUIDNC_IP: strlcpy(dst, cfg.fluidnc_ip, dstSize); break;
+        default: dst[0] = '\0'; break;
+    }
+}
+
+// Raw value a numeric source was last seen with
+static float lastSourceValue(uint8_t source) {
+    if (source >= DS_EXPR_BASE) return exprValue(source - DS_EXPR_BASE);
+    if (isTempSource(source)) return tempValues[source - DS_TEMP_BASE];
+    return sourceValues[source];
+}
+
+// ========== FORMATTING ==========
+
+static void formatSlot(const ViewSlot& slot, char* buf, size_t len) {
+    if (isStringSource(slot.source)) {
+        strlcpy(buf, stringValues[slot.source - DS_FIRST_STRING], len);
+        return;
+    }
+
+    float value = lastSourceValue(slot.source);
+    if (isnan(value)) {
+        strlcpy(buf, "--", len);  // Stale sensor channel
+        return;
+    }
+    switch (slot.format) {
+        case FMT_TEMP:
+            if (cfg.use_fahrenheit) {
+                value = value * 9.0 / 5.0 + 32.0;
+            }
+            snprintf(buf, len, "%.*f%c", slot.decimals, value, cfg.use_fahrenheit ? 'F' : 'C');
+            break;
+
+        case FMT_COORD:
+            if (cfg.use_inches) {
+                value = value / 25.4;
+            }
+            snprintf(buf, len, "%.*f", slot.decimals, value);
+            break;
+
+        case FMT_FIXED:
+            snprintf(buf, len, "%.*f", slot.decimals, value);
+            break;
+
+        default:
+            snprintf(buf, len, "%.2f", value);
+            break;
+    }
+}
+
+// Rebuild the temperature list from the last seen channel values
+static void refreshTempList() {
+    char buf[sizeof(tempList)];
+    size_t len = 0;
+    buf[0] = '\0';
+    for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+        int n = isnan(tempValues[ch])
+            ? snprintf(buf + len, sizeof(buf) - len, "%snull", ch ? "," : "")
+            : snprintf(buf + len, sizeof(buf) - len, "%s%.2f", ch ? "," : "", tempValues[ch]);
+        if (n < 0 || len + n >= sizeof(buf)) {
+            buf[len] = '\0';
+            break;
+        }
+        len += n;
+    }
+
+    portENTER_CRITICAL(&vmMux);
+    memcpy(tempList, buf, len + 1);
+    tempListLen = len;
+    portEXIT_CRITICAL(&vmMux);
+    tempListCount = temperatureCount;
+}
+
+// Reformat one slot; bumps its version only if the text actually changed
+static void refreshSlot(uint8_t index) {
+    ViewSlot& slot = slots[index];
+    char buf[VM_TEXT_LEN];
+    formatSlot(slot, buf, sizeof(buf));
+    slotSourceGen[index] = getSourceGeneration(slot.source);
+
+    if (strcmp(buf, slot.text) == 0) return;
+
+    size_t len = strlen(buf);
+    portENTER_CRITICAL(&vmMux);
+    memcpy(slot.text, buf, len + 1);
+    slot.len = len;
+    slot.version++;
+    portEXIT_CRITICAL(&vmMux);
+}
+
+// ========== PUBLIC FUNCTIONS ==========
+
+uint8_t viewModelBind(uint8_t source, ValueFormat format, uint8_t decimals) {
+    if (source == DS_NONE) return VM_NO_SLOT;
+    if (source >= DS_COUNT && !isTempSource(source) &&
+        (source < DS_EXPR_BASE || source - DS_EXPR_BASE >= exprCount())) {
+        return VM_NO_SLOT;
+    }
+
+    // String sources ignore format/decimals - share one slot per source
+    if (isStringSource(source)) {
+        format = FMT_RAW;
+        decimals = 0;
+    }
+
+    for (uint8_t i = 0; i < slotCount; i++) {
+        if (slots[i].source == source && slots[i].format == format &&
+            slots[i].decimals == decimals) {
+            return i;
+        }
+    }
+
+    if (slotCount >= VM_MAX_SLOTS) {
+        LOGW("VM", "Slot pool full, %s will be formatted per draw", dataSourceName(source));
+        return VM_NO_SLOT;
+    }
+
+    uint8_t index = slotCount++;
+    ViewSlot& slot = slots[index];
+    slot.source = source;
+    slot.format = format;
+    slot.decimals = decimals;
+    slot.len = 0;
+    slot.version = 0;
+    slot.text[0] = '\0';
+
+    // Make sure the raw value is current, then format immediately
+    if (source >= DS_EXPR_BASE) {
+        exprUpdate();
+    } else if (isTempSource(source)) {
+        tempValues[source - DS_TEMP_BASE] = readDataSource(source);
+    } else if (source >= DS_FIRST_STRING) {
+        readStringSource(source, stringValues[source - DS_FIRST_STRING], sizeof(stringValues[0]));
+    } else {
+        sourceValues[source] = readDataSource(source);
+    }
+    refreshSlot(index);
+    return index;
+}
+
+void viewModelReset() {
+    portENTER_CRITICAL(&vmMux);
+    slotCount = 0;
+    portEXIT_CRITICAL(&vmMux);
+}
+
+void viewModelUpdate() {
+    // Its own site: called from the sensor paths as well as the display
+    HEAP_SCOPE(HEAP_RENDER, "viewModelUpdate");
+    // Detect changed numeric sources (bitwise compare - cheap, no formatting)
+    for (uint8_t s = 1; s < DS_FIRST_STRING; s++) {
+        float value = readDataSource(s);
+        if (memcmp(&value, &sourceValues[s], sizeof(float)) != 0) {
+            sourceValues[s] = value;
+            sourceGen[s]++;
+        }
+    }
+    bool tempsChanged = (temperatureCount != tempListCount);
+    for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+        float value = temperatures[ch];
+        if (memcmp(&value, &tempValues[ch], sizeof(float)) != 0) {
+            tempValues[ch] = value;
+            tempGen[ch]++;
+            tempsChanged = true;
+        }
+    }
+    if (tempsChanged) refreshTempList();
+
+    // String sources: machineState every call, network strings throttled
+    bool refreshNetwork = (millis() - lastNetworkRefresh >= VM_NETWORK_REFRESH_MS);
+    if (refreshNetwork) lastNetworkRefresh = millis();
+
+    for (uint8_t s = DS_FIRST_STRING; s < DS_COUNT; s++) {
+        if (s != DS_MACHINE_STATE && !refreshNetwork) continue;
+
+        char buf[32];
+        readStringSource(s, buf, sizeof(buf));
+        char* current = stringValues[s - DS_FIRST_STRING];
+        if (strcmp(buf, current) != 0) {
+            strlcpy(current, buf, sizeof(stringValues[0]));
+            sourceGen[s]++;
+        }
+    }
+
+    // Re-evaluate computed sources whose inputs moved on
+    exprUpdate();
+
+    // A unit change invalidates every slot
+    bool unitsChanged = (cfg.use_fahrenheit != formattedFahrenheit ||
+                         cfg.use_inches != formattedInches);
+    formattedFahrenheit = cfg.use_fahrenheit;
+    formattedInches = cfg.use_inches;
+
+    // Reformat only slots whose source moved on
+    for (uint8_t i = 0; i < slotCount; i++) {
+        if (unitsChanged || slotSourceGen[i] != getSourceGeneration(slots[i].source)) {
+            refreshSlot(i);
+        }
+    }
+}
+
+uint16_t viewModelVersion(uint8_t slot) {
+    if (slot >= slotCount) return 0;
+    return slots[slot].version;
+}
+
+size_t viewModelCopy(uint8_t slot, char* dst, size_t dstSize) {
+    if (dstSize == 0) return 0;
+
+    // Checked under the lock: viewModelReset() may run on the loop task
+    portENTER_CRITICAL(&vmMux);
+    size_t len = 0;
+    if (slot < slotCount) {
+        len = slots[slot].len;
+        if (len >= dstSize) len = dstSize - 1;
+        memcpy(dst, slots[slot].text, len);
+    }
+    portEXIT_CRITICAL(&vmMux);
+
+    dst[len] = '\0';
+    return len;
+}
+
+size_t viewModelCopyTemperatures(char* dst, size_t dstSize) {
+    if (dstSize == 0) return 0;
+
+    portENTER_CRITICAL(&vmMux);
+    size_t len = tempListLen;
+    if (len >= dstSize) len = dstSize - 1;
+    memcpy(dst, tempList, len);
+    portEXIT_CRITICAL(&vmMux);
+
+    dst[len] = '\0';
+    return len;
+}
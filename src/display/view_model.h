@@ -0,0 +1,102 @@
+#ifndef VIEW_MODEL_H
+#define VIEW_MODEL_H
+
+#include <Arduino.h>
+
+// ========== Data Sources ==========
+// Every value a layout or API can display. Numeric sources come first,
+// string sources start at DS_FIRST_STRING.
+enum DataSourceId : uint8_t {
+    DS_NONE = 0,
+    DS_POS_X, DS_POS_Y, DS_POS_Z, DS_POS_A,
+    DS_WPOS_X, DS_WPOS_Y, DS_WPOS_Z, DS_WPOS_A,
+    DS_FEED_RATE,
+    DS_SPINDLE_RPM,
+    DS_PSU_VOLTAGE,
+    DS_FAN_SPEED,
+    DS_MAX_TEMP,             // Hottest temperature channel
+    DS_JOB_ELAPSED,          // Seconds since the running job started (0 when idle)
+
+    DS_FIRST_STRING,
+    DS_MACHINE_STATE = DS_FIRST_STRING,
+    DS_IP_ADDRESS,
+    DS_SSID,
+    DS_DEVICE_NAME,
+    DS_FLUIDNC_IP,
+
+    DS_COUNT,
+
+    // Temperature channels ("tempN" or a sensor alias) use DS_TEMP_BASE + channel
+    DS_TEMP_BASE = 0x40,
+
+    // Computed expressions ("=..." data fields) use DS_EXPR_BASE + program index
+    DS_EXPR_BASE = 0x80
+};
+
+#define VM_MAX_TEMP_SOURCES (DS_EXPR_BASE - DS_TEMP_BASE)
+
+// How a slot turns a source value into text
+enum ValueFormat : uint8_t {
+    FMT_RAW = 0,     // Strings as-is, numbers with 2 decimals (getDataString)
+    FMT_FIXED,       // Number with N decimals, no unit conversion
+    FMT_TEMP,        // Temperature, converted to F if configured, with unit suffix
+    FMT_COORD        // Coordinate, converted to inches if configured
+};
+
+#define VM_MAX_SLOTS 64
+#define VM_TEXT_LEN  24
+#define VM_NO_SLOT   0xFF
+
+// One pre-formatted value: (source, format, decimals) -> text
+struct ViewSlot {
+    uint8_t source;
+    uint8_t format;
+    uint8_t decimals;
+    uint8_t len;
+    uint16_t version;        // Incremented whenever text changes
+    char text[VM_TEXT_LEN];
+};
+
+// ========== Functions ==========
+// Resolve a layout/API source name ("wposX", "temp0", a sensor alias) to its
+// id (DS_NONE if unknown). "tempN" resolves for channels that exist.
+uint8_t lookupDataSource(const char* name);
+
+// True for text sources (machineState, ipAddress, ...)
+bool isStringSource(uint8_t source);
+
+// Name of a source id (empty string for DS_NONE)
+const char* dataSourceName(uint8_t source);
+
+// Current raw numeric value of a source (0 for string sources).
+// Computed sources return the value from the last viewModelUpdate().
+float readDataSource(uint8_t source);
+
+// Generation counter of a source, incremented every time its value changes.
+// Also valid for computed sources (DS_EXPR_BASE + program).
+uint16_t getSourceGeneration(uint8_t source);
+
+// Get (or create) the slot for a source/format/decimals combination.
+// Call from the loop task only. Returns VM_NO_SLOT if the pool is full.
+uint8_t viewModelBind(uint8_t source, ValueFormat format, uint8_t decimals);
+
+// Release every slot, before the layouts are loaded again and rebind.
+// Slot indices handed out earlier are invalid afterwards. Loop task only.
+void viewModelReset();
+
+// Detect changed sources and reformat only the slots that depend on them.
+// Call from the loop task whenever telemetry may have changed.
+void viewModelUpdate();
+
+// Change counter of a slot - compare against the version last drawn/sent
+uint16_t viewModelVersion(uint8_t slot);
+
+// Copy a slot's text (NUL-terminated). Safe from any task.
+size_t viewModelCopy(uint8_t slot, char* dst, size_t dstSize);
+
+// Copy every temperature channel as comma-separated JSON numbers, 2 decimals,
+// "null" for a stale channel (NUL-terminated). Follows temperatureCount, so it
+// needs no slots. Safe from any task.
+size_t viewModelCopyTemperatures(char* dst, size_t dstSize);
+
+#endif // VIEW_MODEL_H
@@ -0,0 +1,498 @@
+#include "history_store.h"
+#include "utils/log.h"
+#include <freertos/FreeRTOS.h>
+#include <algorithm>
+
+#define NO_BUCKET   UINT32_MAX
+
+struct Tier {
+    uint16_t period;        // Seconds per bucket
+    uint16_t slots;         // Buckets per channel
+    uint8_t stride;         // int16 per bucket: 1 (raw) or 3 (min, max, avg)
+    int16_t* data;          // [channel][slot][stride], slot = bucket % slots
+    uint32_t newest;        // Newest stored bucket (time / period)
+    uint32_t filled;        // Buckets stored, up to slots
+};
+
+// Open bucket of an aggregate tier, one per channel
+struct Accumulator {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    uint16_t count;
+};
+
+// Reserved at link time: the store never allocates, so a fragmented heap
+// cannot take it down. Series are laid out [tier][channel][slot].
+static int16_t arena[HISTORY_RAM_BUDGET / sizeof(int16_t)];
+static Accumulator accumulators[HISTORY_TIERS - 1][HISTORY_MAX_CHANNELS];
+
+// The smallest layout always fits
+static_assert((size_t)HISTORY_MIN_SLOTS * (1 + 3 * (HISTORY_TIERS - 1)) * HISTORY_MAX_CHANNELS * sizeof(int16_t)
+              <= HISTORY_RAM_BUDGET, "history arena too small");
+
+static Tier tiers[HISTORY_TIERS];
+static uint32_t openBucket[HISTORY_TIERS];
+static uint8_t channelCount = 0;                // 0 = not initialized
+static uint32_t lastTime = 0;
+static bool started = false;
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;   // Appends vs. web API reads
+
+// Set while a resize moves series around the arena (outside historyMux);
+// the generation changes at its start and its end
+static volatile bool reshaping = false;
+static uint32_t layoutGeneration = 0;
+
+static int16_t toCenti(float tempC) {
+    if (isnan(tempC)) return HISTORY_NONE;
+    long centi = lroundf(tempC * 100.0f);
+    return (int16_t)constrain(centi, (long)HISTORY_NONE + 1, (long)INT16_MAX);
+}
+
+static int16_t* bucketAt(const Tier& tier, uint8_t channel, uint32_t bucket) {
+    return tier.data + ((size_t)channel * tier.slots + bucket % tier.slots) * tier.stride;
+}
+
+static Accumulator& accumulatorAt(uint8_t tier, uint8_t channel) {
+    return accumulators[tier - 1][channel];
+}
+
+static void resetAccumulator(Accumulator& acc) {
+    acc = {0, INT16_MAX, INT16_MIN, 0};
+}
+
+// Tier depths for a channel count: full depth while the arena has room,
+// else every tier shrunk by the same factor (a shorter span, never a
+// failure)
+static void layoutSlots(uint8_t channels, uint16_t* slots) {
+    const uint16_t full[HISTORY_TIERS] = {HISTORY_RAW_SLOTS, HISTORY_10S_SLOTS, HISTORY_60S_SLOTS};
+    size_t perChannel = 0;
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        perChannel += (size_t)full[t] * (t == 0 ? 1 : 3) * sizeof(int16_t);
+    }
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        slots[t] = full[t];
+        if (perChannel * channels > sizeof(arena)) {
+            slots[t] = max((uint32_t)HISTORY_MIN_SLOTS,
+                           (uint32_t)((uint64_t)full[t] * sizeof(arena) / (perChannel * channels)));
+        }
+    }
+}
+
+static void logLayout() {
+    LOGI("HISTORY", "%d channels: %us raw, %us at 10 s, %us at 60 s (%u bytes)",
+         channelCount, (unsigned)tiers[0].slots, (unsigned)tiers[1].slots * 10,
+         (unsigned)tiers[2].slots * 60, (unsigned)historyStoreBytes());
+}
+
+bool historyStoreInit(uint8_t channels) {
+    if (channelCount != 0) return historyStoreResize(channels);
+    if (channels == 0) return false;
+    channels = min(channels, (uint8_t)HISTORY_MAX_CHANNELS);
+
+    const uint16_t periods[HISTORY_TIERS] = {1, 10, 60};
+    uint16_t slots[HISTORY_TIERS];
+    layoutSlots(channels, slots);
+
+    int16_t* next = arena;
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        tiers[t].period = periods[t];
+        tiers[t].slots = slots[t];
+        tiers[t].stride = (t == 0) ? 1 : 3;
+        tiers[t].data = next;
+        tiers[t].newest = 0;
+        tiers[t].filled = 0;
+        openBucket[t] = NO_BUCKET;
+        next += (size_t)slots[t] * tiers[t].stride * channels;
+    }
+    channelCount = channels;
+    started = false;
+    logLayout();
+    return true;
+}
+
+// ========== Resize ==========
+// Re-lay the arena for a new channel count without a second buffer. Each
+// tier keeps its newest min(filled, new depth) buckets:
+//   1. pack - rotate every kept series oldest-first and slide it to the
+//      front, in layout order (each moves down, never over an unread one)
+//   2. expand - in reverse order, slide each packed series up to its new
+//      start and rotate it so bucket b sits at slot b % slots again
+// New channels start empty; dropped channels are discarded.
+//
+// The moves run outside historyMux with `reshaping` set, so the critical
+// sections only cover the layout fields: readers see no buckets meanwhile,
+// and a query that spans the resize reads the rest of its span as gaps.
+
+// Start or finish moving series (loop task); readers check under historyMux
+static void setReshaping(bool active) {
+    portENTER_CRITICAL(&historyMux);
+    reshaping = active;
+    layoutGeneration++;
+    portEXIT_CRITICAL(&historyMux);
+}
+
+bool historyStoreResize(uint8_t channels) {
+    if (channelCount == 0) return historyStoreInit(channels);
+    if (channels == 0) return false;
+    channels = min(channels, (uint8_t)HISTORY_MAX_CHANNELS);
+    if (channels == channelCount) return true;
+
+    uint16_t slots[HISTORY_TIERS];
+    layoutSlots(channels, slots);
+    uint8_t keptChannels = min(channels, channelCount);
+
+    setReshaping(true);
+
+    uint32_t kept[HISTORY_TIERS];
+    int16_t* packed = arena;
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        Tier& tier = tiers[t];
+        kept[t] = min(tier.filled, (uint32_t)slots[t]);
+        uint32_t oldest = tier.newest - kept[t] + 1;
+        for (uint8_t ch = 0; ch < keptChannels; ch++) {
+            int16_t* series = tier.data + (size_t)ch * tier.slots * tier.stride;
+            if (kept[t] > 0) {
+                std::rotate(series, series + (oldest % tier.slots) * tier.stride,
+                            series + (size_t)tier.slots * tier.stride);
+                memmove(packed, series, kept[t] * tier.stride * sizeof(int16_t));
+            }
+            packed += kept[t] * tier.stride;
+        }
+    }
+
+    int16_t* starts[HISTORY_TIERS];
+    int16_t* next = arena;
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        starts[t] = next;
+        next += (size_t)slots[t] * tiers[t].stride * channels;
+    }
+
+    for (int8_t t = HISTORY_TIERS - 1; t >= 0; t--) {
+        Tier& tier = tiers[t];
+        size_t length = (size_t)slots[t] * tier.stride;
+        uint32_t oldest = tier.newest - kept[t] + 1;
+        for (int16_t ch = channels - 1; ch >= 0; ch--) {
+            int16_t* series = starts[t] + ch * length;
+            size_t used = 0;
+            if (ch < keptChannels) {
+                packed -= kept[t] * tier.stride;
+                used = kept[t] * tier.stride;
+                memmove(series, packed, used * sizeof(int16_t));
+            }
+            std::fill(series + used, series + length, HISTORY_NONE);
+            if (used > 0) {
+                std::rotate(series, series + (slots[t] - oldest % slots[t]) % slots[t] * tier.stride,
+                            series + length);
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&historyMux);
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        tiers[t].slots = slots[t];
+        tiers[t].data = starts[t];
+        tiers[t].filled = kept[t];
+    }
+    for (uint8_t t = 1; t < HISTORY_TIERS; t++) {
+        for (uint8_t ch = channelCount; ch < channels; ch++) {
+            resetAccumulator(accumulatorAt(t, ch));
+        }
+    }
+    channelCount = channels;
+    portEXIT_CRITICAL(&historyMux);
+
+    setReshaping(false);
+    logLayout();
+    return true;
+}
+
+// ========== Remap ==========
+// Channels move by swapping whole series (and their open buckets) along
+// the cycles of the permutation, so no buffer is needed. Channels gained
+// are added by a resize first, channels lost are dropped by one after.
+
+// Swap the series and accumulators of two channels in every tier
+static void swapChannels(uint8_t a, uint8_t b) {
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        const Tier& tier = tiers[t];
+        size_t length = (size_t)tier.slots * tier.stride;
+        int16_t* first = tier.data + a * length;
+        std::swap_ranges(first, first + length, tier.data + b * length);
+        if (t > 0) std::swap(accumulatorAt(t, a), accumulatorAt(t, b));
+    }
+}
+
+static void clearChannel(uint8_t ch) {
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        const Tier& tier = tiers[t];
+        size_t length = (size_t)tier.slots * tier.stride;
+        std::fill(tier.data + ch * length, tier.data + (ch + 1) * length, HISTORY_NONE);
+        if (t > 0) resetAccumulator(accumulatorAt(t, ch));
+    }
+}
+
+bool historyStoreRemap(const uint8_t* from, uint8_t count) {
+    if (channelCount == 0 || count == 0) return false;
+    count = min(count, (uint8_t)HISTORY_MAX_CHANNELS);
+    uint8_t previous = channelCount;
+    if (count > channelCount && !historyStoreResize(count)) return false;
+
+    // Old channel for every position; positions without one take an unused
+    // old channel (or a new empty one) and are cleared
+    uint8_t source[HISTORY_MAX_CHANNELS];
+    bool used[HISTORY_MAX_CHANNELS] = {};
+    bool clear[HISTORY_MAX_CHANNELS] = {};
+    for (uint8_t ch = 0; ch < channelCount; ch++) {
+        source[ch] = (ch < count && from[ch] < previous && !used[from[ch]]) ? from[ch] : HISTORY_NO_CHANNEL;
+        if (source[ch] != HISTORY_NO_CHANNEL) used[source[ch]] = true;
+    }
+    uint8_t spare = 0;
+    bool moved = false;
+    for (uint8_t ch = 0; ch < channelCount; ch++) {
+        if (source[ch] == HISTORY_NO_CHANNEL) {
+            while (used[spare]) spare++;
+            source[ch] = spare;
+            used[spare] = true;
+            clear[ch] = ch < count;
+        }
+        moved |= source[ch] != ch || clear[ch];
+    }
+
+    if (moved) {
+        setReshaping(true);
+        bool done[HISTORY_MAX_CHANNELS] = {};
+        for (uint8_t start = 0; start < channelCount; start++) {
+            uint8_t ch = start;
+            while (!done[ch] && source[ch] != start) {
+                swapChannels(ch, source[ch]);
+                done[ch] = true;
+                ch = source[ch];
+            }
+            done[ch] = true;
+        }
+        for (uint8_t ch = 0; ch < channelCount; ch++) {
+            if (clear[ch]) clearChannel(ch);
+        }
+        setReshaping(false);
+    }
+
+    return count < channelCount ? historyStoreResize(count) : true;
+}
+
+// ========== Append ==========
+
+// Make bucket the newest of the tier; skipped buckets become gaps
+static void advanceTier(Tier& tier, uint32_t bucket) {
+    if (tier.filled > 0 && bucket <= tier.newest) return;
+
+    uint32_t first = (tier.filled > 0) ? tier.newest + 1 : bucket;
+    if (bucket - first > tier.slots) first = bucket - tier.slots;
+    for (uint32_t b = first; b < bucket; b++) {
+        for (uint8_t ch = 0; ch < channelCount; ch++) {
+            int16_t* v = bucketAt(tier, ch, b);
+            for (uint8_t i = 0; i < tier.stride; i++) v[i] = HISTORY_NONE;
+        }
+    }
+
+    uint32_t added = (tier.filled > 0) ? bucket - tier.newest : 1;
+    tier.filled = min((uint32_t)tier.slots, tier.filled + added);
+    tier.newest = bucket;
+}
+
+// Store the open bucket of an aggregate tier
+static void closeBucket(uint8_t t) {
+    Tier& tier = tiers[t];
+    advanceTier(tier, openBucket[t]);
+    for (uint8_t ch = 0; ch < channelCount; ch++) {
+        const Accumulator& acc = accumulatorAt(t, ch);
+        int16_t* v = bucketAt(tier, ch, openBucket[t]);
+        if (acc.count == 0) {
+            v[0] = v[1] = v[2] = HISTORY_NONE;
+        } else {
+            v[0] = acc.min;
+            v[1] = acc.max;
+            v[2] = (acc.sum + (acc.sum >= 0 ? 1 : -1) * (int32_t)(acc.count / 2)) / (int32_t)acc.count;
+        }
+    }
+}
+
+void historyStoreAppend(uint32_t timeS, const float* values, uint8_t count) {
+    if (channelCount == 0) return;
+    portENTER_CRITICAL(&historyMux);
+    if (started && timeS <= lastTime) {
+        portEXIT_CRITICAL(&historyMux);
+        return;
+    }
+    started = true;
+    lastTime = timeS;
+
+    Tier& raw = tiers[0];
+    advanceTier(raw, timeS);
+    for (uint8_t ch = 0; ch < channelCount; ch++) {
+        *bucketAt(raw, ch, timeS) = (ch < count) ? toCenti(values[ch]) : HISTORY_NONE;
+    }
+
+    for (uint8_t t = 1; t < HISTORY_TIERS; t++) {
+        uint32_t bucket = timeS / tiers[t].period;
+        if (bucket != openBucket[t]) {
+            if (openBucket[t] != NO_BUCKET) closeBucket(t);
+            openBucket[t] = bucket;
+            for (uint8_t ch = 0; ch < channelCount; ch++) {
+                resetAccumulator(accumulatorAt(t, ch));
+            }
+        }
+        for (uint8_t ch = 0; ch < channelCount; ch++) {
+            int16_t v = *bucketAt(raw, ch, timeS);
+            if (v == HISTORY_NONE) continue;
+            Accumulator& acc = accumulatorAt(t, ch);
+            acc.sum += v;
+            if (v < acc.min) acc.min = v;
+            if (v > acc.max) acc.max = v;
+            acc.count++;
+        }
+    }
+    portEXIT_CRITICAL(&historyMux);
+}
+
+// ========== Queries ==========
+
+uint8_t historyStoreChannels() {
+    return channelCount;
+}
+
+size_t historyStoreBytes() {
+    size_t values = 0;
+    for (uint8_t t = 0; t < HISTORY_TIERS; t++) {
+        values += (size_t)tiers[t].slots * tiers[t].stride * channelCount;
+    }
+    return values * sizeof(int16_t) + (HISTORY_TIERS - 1) * channelCount * sizeof(Accumulator);
+}
+
+uint16_t historyTierPeriod(uint8_t tier) {
+    return tier < HISTORY_TIERS ? tiers[tier].period : 0;
+}
+
+bool historyTierSpan(uint8_t t, uint32_t& oldestS, uint32_t& newestS) {
+    if (channelCount == 0 || t >= HISTORY_TIERS) return false;
+    const Tier& tier = tiers[t];
+    portENTER_CRITICAL(&historyMux);
+    bool open = openBucket[t] != NO_BUCKET;
+    bool any = tier.filled > 0 || open;
+    if (any) {
+        uint32_t oldest = (tier.filled > 0) ? tier.newest - tier.filled + 1 : openBucket[t];
+        uint32_t newest = open ? openBucket[t] : tier.newest;
+        oldestS = oldest * tier.period;
+        newestS = (t == 0) ? lastTime : newest * tier.period + tier.period - 1;
+    }
+    portEXIT_CRITICAL(&historyMux);
+    return any;
+}
+
+uint8_t historyChooseTier(uint32_t fromS, uint32_t toS, uint16_t points) {
+    if (toS < fromS) return 0;
+    uint32_t span = toS - fromS + 1;
+
+    int8_t chosen = 0;
+    for (int8_t t = HISTORY_TIERS - 1; t >= 0; t--) {
+        if (span / tiers[t].period >= points) {
+            chosen = t;
+            break;
+        }
+    }
+
+    // A finer tier that has already dropped fromS would cut the span short
+    uint32_t oldest, newest;
+    while (chosen < HISTORY_TIERS - 1 &&
+           (!historyTierSpan(chosen, oldest, newest) || oldest > fromS)) {
+        chosen++;
+    }
+    return chosen;
+}
+
+// One bucket as min/max/avg. False if it holds no reading. Under historyMux.
+static bool readBucket(uint8_t t, uint8_t channel, uint32_t bucket, int16_t& mn, int16_t& mx, int16_t& avg) {
+    if (reshaping || channel >= channelCount) return false;
+    const Tier& tier = tiers[t];
+    if (t > 0 && bucket == openBucket[t]) {
+        const Accumulator& acc = accumulatorAt(t, channel);
+        if (acc.count == 0) return false;
+        mn = acc.min;
+        mx = acc.max;
+        avg = acc.sum / (int32_t)acc.count;
+        return true;
+    }
+    if (tier.filled == 0 || bucket > tier.newest || tier.newest - bucket >= tier.filled) return false;
+
+    const int16_t* v = bucketAt(tier, channel, bucket);
+    if (v[0] == HISTORY_NONE) return false;
+    mn = v[0];
+    mx = (tier.stride == 1) ? v[0] : v[1];
+    avg = (tier.stride == 1) ? v[0] : v[2];
+    return true;
+}
+
+bool historyReadBucket(uint8_t tier, uint8_t channel, uint32_t bucket, HistoryPoint& out) {
+    if (channelCount == 0 || tier >= HISTORY_TIERS || channel >= channelCount) return false;
+    portENTER_CRITICAL(&historyMux);
+    bool found = readBucket(tier, channel, bucket, out.min, out.max, out.avg);
+    portEXIT_CRITICAL(&historyMux);
+    out.time = bucket * tiers[tier].period;
+    return found;
+}
+
+uint16_t historyQuery(uint8_t channel, uint32_t fromS, uint32_t toS, uint16_t points, HistoryPoint* out) {
+    if (channelCount == 0 || channel >= channelCount || toS < fromS || points == 0) return 0;
+
+    // The channel and the tier layout are checked again with every bucket
+    portENTER_CRITICAL(&historyMux);
+    uint32_t generation = layoutGeneration;
+    portEXIT_CRITICAL(&historyMux);
+
+    uint8_t t = historyChooseTier(fromS, toS, points);
+    uint32_t oldest, newest;
+    if (!historyTierSpan(t, oldest, newest)) return 0;
+    fromS = max(fromS, oldest);
+    toS = min(toS, newest);
+    if (toS < fromS) return 0;
+
+    uint16_t period = tiers[t].period;
+    uint32_t first = fromS / period;
+    uint32_t buckets = toS / period - first + 1;
+    uint16_t bins = min(buckets, (uint32_t)points);
+
+    // Merge consecutive buckets into bins
+    uint16_t written = 0;
+    uint32_t binStart = 0;
+    int32_t sum = 0;
+    uint16_t count = 0;
+    int16_t binMin = INT16_MAX, binMax = INT16_MIN;
+    for (uint32_t i = 0; i <= buckets; i++) {
+        uint16_t bin = (i < buckets) ? (uint64_t)i * bins / buckets : bins;
+        if (bin != written) {
+            HistoryPoint& p = out[written++];
+            p.time = (first + binStart) * period;
+            p.min = count ? binMin : HISTORY_NONE;
+            p.max = count ? binMax : HISTORY_NONE;
+            p.avg = count ? sum / count : HISTORY_NONE;
+            binStart = i;
+            sum = 0;
+            count = 0;
+            binMin = INT16_MAX;
+            binMax = INT16_MIN;
+            if (i == buckets) break;
+        }
+
+        int16_t mn, mx, avg;
+        portENTER_CRITICAL(&historyMux);
+        bool found = layoutGeneration == generation && readBucket(t, channel, first + i, mn, mx, avg);
+        portEXIT_CRITICAL(&historyMux);
+        if (found) {
+            sum += avg;
+            count++;
+            if (mn < binMin) binMin = mn;
+            if (mx > binMax) binMax = mx;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,78 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <Arduino.h>
+
+// ========== Temperature History Store ==========
+// Per-channel time series in RAM, in three tiers:
+//   0. raw - one sample per second
+//   1. 10 s - min/max/avg of the raw samples
+//   2. 60 s - min/max/avg of the raw samples
+// The aggregates are rolled up as samples arrive (the open bucket of each
+// tier is an accumulator, readable before it closes). Values are int16
+// centi-degrees; HISTORY_NONE marks seconds with no reading (stale
+// channel, or a gap in sampling). Times are seconds since boot.
+
+#define HISTORY_TIERS         3
+#define HISTORY_NONE          INT16_MIN
+#define HISTORY_RAM_BUDGET    32768   // Static arena for all channels - depths shrink to fit
+#define HISTORY_MAX_CHANNELS  64      // SENSOR_CACHE_MAX
+#define HISTORY_MIN_SLOTS     16      // Depth floor per tier when shrinking
+#define HISTORY_NO_CHANNEL    0xFF    // historyStoreRemap(): no history to keep
+
+// Slots per channel before budget scaling
+#define HISTORY_RAW_SLOTS     300     // 1 s  - 5 minutes
+#define HISTORY_10S_SLOTS     360     // 10 s - 1 hour
+#define HISTORY_60S_SLOTS     720     // 60 s - 12 hours
+
+// One bucket (or several merged): centi-degrees, HISTORY_NONE when empty
+struct HistoryPoint {
+    uint32_t time;            // Start of the bucket, seconds since boot
+    int16_t min;
+    int16_t max;
+    int16_t avg;
+};
+
+// ========== Functions (loop task only) ==========
+// Lay out the tiers for channels (temperature channel N = data source "tempN")
+// in the static arena. False only for 0 channels.
+bool historyStoreInit(uint8_t channels);
+
+// Change the channel count, keeping the stored history: each tier keeps
+// its newest buckets up to the new depth (more channels = shorter spans).
+bool historyStoreResize(uint8_t channels);
+
+// Renumber the channels after the sensors were: channel ch takes the
+// history of from[ch], or starts empty for HISTORY_NO_CHANNEL. The store
+// ends up with count channels.
+bool historyStoreRemap(const uint8_t* from, uint8_t count);
+
+// Add one sample per channel for second timeS (NAN = no reading). Seconds
+// skipped since the last call are recorded as gaps.
+void historyStoreAppend(uint32_t timeS, const float* values, uint8_t count);
+
+// ========== Functions (queries, any task) ==========
+uint8_t historyStoreChannels();
+size_t historyStoreBytes();
+uint16_t historyTierPeriod(uint8_t tier);
+
+// Oldest and newest second held by a tier. False while it is empty.
+bool historyTierSpan(uint8_t tier, uint32_t& oldestS, uint32_t& newestS);
+
+// Coarsest tier with at least `points` buckets in [fromS, toS] that still
+// reaches back to fromS (falling back to the finest / the longest one)
+uint8_t historyChooseTier(uint32_t fromS, uint32_t toS, uint16_t points);
+
+// One bucket of a tier. False if it holds no reading or has been dropped.
+bool historyReadBucket(uint8_t tier, uint8_t channel, uint32_t bucket, HistoryPoint& out);
+
+// Read [fromS, toS] of a channel at most `points` wide: buckets of the
+// chosen tier are merged (min of mins, max of maxes, mean of averages)
+// into out. Returns the number of points written.
+uint16_t historyQuery(uint8_t channel, uint32_t fromS, uint32_t toS, uint16_t points, HistoryPoint* out);
+
+inline float historyToCelsius(int16_t centi) {
+    return centi == HISTORY_NONE ? NAN : centi / 100.0f;
+}
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,553 @@
+#include "history_stream.h"
+#include "history_store.h"
+#include "webserver/sd_mutex.h"
+#include <SD.h>
+#include <new>
+
+#define STREAM_LOCK_MS      1000
+
+// External variables from main.cpp
+extern uint8_t temperatureCount;
+
+// One point in time across the requested sensors (request order)
+struct Sample {
+    uint32_t time;
+    int16_t values[HISTORY_STREAM_MAX_SENSORS];     // HISTORY_NONE = no reading
+};
+
+// Position in the source: SD segment/block/record, or RAM bucket (in block)
+struct Cursor {
+    uint32_t segment;
+    uint32_t block;
+    uint8_t record;
+};
+
+enum StreamPhase {
+    PHASE_HEADER,
+    PHASE_FIRST,        // Bucket 0: first sample
+    PHASE_BUCKETS,      // LTTB picks, last bucket: last sample
+    PHASE_FOOTER,
+    PHASE_DONE
+};
+
+struct HistoryStream {
+    // Query
+    uint32_t from;
+    uint32_t to;
+    uint16_t points;
+    uint8_t sensors[HISTORY_STREAM_MAX_SENSORS];
+    uint8_t sensorCount;
+    HistoryFormat format;
+    bool sd;
+
+    // RAM source
+    uint8_t tier;
+    uint32_t clockAtBoot;       // Record clock - RAM history time
+    uint32_t lastBucket;
+
+    // SD source
+    uint32_t lastSegment;
+    bool rtcClock;
+    File file;
+    uint32_t fileSegment;
+    union {
+        TelemetryBlock block;
+        TelemetrySegmentHeader header;
+    };
+    uint32_t cachedSegment;
+    uint32_t cachedBlock;       // 0 = header, UINT32_MAX = nothing cached
+
+    // LTTB
+    uint16_t bucket;            // Bucket to pick next
+    Cursor cur;                 // Start of that bucket
+    Cursor next;                // Start of the one after
+    bool anchored[HISTORY_STREAM_MAX_SENSORS];
+    float anchorTime[HISTORY_STREAM_MAX_SENSORS];   // Seconds after from
+    float anchorValue[HISTORY_STREAM_MAX_SENSORS];
+
+    // Output
+    StreamPhase phase;
+    bool picked[HISTORY_STREAM_MAX_SENSORS];
+    uint32_t pickTime[HISTORY_STREAM_MAX_SENSORS];
+    int16_t pickValue[HISTORY_STREAM_MAX_SENSORS];
+    uint8_t pickIndex;          // Next pick to print
+    bool firstRow;
+    char line[192];
+    uint8_t lineLen;
+    uint8_t linePos;
+};
+
+static uint8_t openStreams = 0;
+
+static uint32_t bucketStart(const HistoryStream& s, uint32_t bucket) {
+    return s.from + (uint64_t)(s.to - s.from + 1) * bucket / s.points;
+}
+
+// ========== SD Source ==========
+
+static bool loadBlock(HistoryStream& s, uint32_t segment, uint32_t block) {
+    if (s.cachedSegment == segment && s.cachedBlock == block) return true;
+    s.cachedBlock = UINT32_MAX;
+
+    if (sdMutexTake(pdMS_TO_TICKS(STREAM_LOCK_MS)) != pdTRUE) return false;
+    if (!s.file || s.fileSegment != segment) {
+        if (s.file) s.file.close();
+        char path[32];
+        telemetrySegmentPath(path, sizeof(path), segment, "bin");
+        s.file = SD.exists(path) ? SD.open(path, FILE_READ) : File();
+        s.fileSegment = segment;
+    }
+    bool read = s.file && s.file.seek(block * TELEMETRY_BLOCK_SIZE) &&
+                s.file.read((uint8_t*)&s.block, TELEMETRY_BLOCK_SIZE) == TELEMETRY_BLOCK_SIZE;
+    sdMutexGive();
+    if (!read) return false;
+
+    bool valid = block == 0
+        ? telemetryHeaderValid(s.header) && s.header.segment == segment
+        : telemetryBlockValid(s.block) && s.block.segment == segment && s.block.sequence == block;
+    if (!valid) return false;
+
+    s.cachedSegment = segment;
+    s.cachedBlock = block;
+    return true;
+}
+
+// Segment written with the clock this query uses
+static bool segmentUsable(HistoryStream& s, uint32_t segment) {
+    return loadBlock(s, segment, 0) && ((s.header.flags & TLM_FLAG_RTC_TIME) != 0) == s.rtcClock;
+}
+
+// Time of the first record of a block (UINT32_MAX if unreadable)
+static uint32_t blockTime(HistoryStream& s, uint32_t segment, uint32_t block) {
+    return loadBlock(s, segment, block) ? telemetryBlockTime(s.block) : UINT32_MAX;
+}
+
+// Last block of a segment starting at or before time, narrowed with the
+// segment's .idx when it has one, then by bisection
+static uint32_t findBlock(HistoryStream& s, uint32_t segment, uint32_t time) {
+    uint32_t low = 1;
+    uint32_t high = TELEMETRY_SEGMENT_BLOCKS;
+
+    char path[32];
+    telemetrySegmentPath(path, sizeof(path), segment, "idx");
+    if (sdMutexTake(pdMS_TO_TICKS(STREAM_LOCK_MS)) == pdTRUE) {
+        File index = SD.exists(path) ? SD.open(path, FILE_READ) : File();
+        uint32_t header[2];
+        if (index && index.read((uint8_t*)header, sizeof(header)) == sizeof(header) &&
+            header[0] == TELEMETRY_INDEX_MAGIC) {
+            TelemetryIndexEntry entry;
+            for (uint32_t i = 0; i < header[1]; i++) {
+                if (index.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry)) break;
+                if (entry.time > time) {
+                    high = entry.block - 1;
+                    break;
+                }
+                low = entry.block;
+            }
+        }
+        if (index) index.close();
+        sdMutexGive();
+    }
+
+    // Largest block in [low, high] whose first record is <= time
+    while (low < high) {
+        uint32_t mid = low + (high - low + 1) / 2;
+        if (blockTime(s, segment, mid) <= time) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+static bool openSd(HistoryStream& s, HistoryStreamError& error) {
+    TelemetryLogStats stats = getTelemetryLogStats();
+    if (!stats.running) {
+        error = HISTORY_ERROR_NO_SD_LOG;
+        return false;
+    }
+
+    s.rtcClock = telemetryClockIsRtc();
+    s.lastSegment = max(stats.segment, stats.bootSegment > 0 ? stats.bootSegment - 1 : 0);
+    uint32_t first = s.lastSegment > TELEMETRY_MAX_SEGMENTS ? s.lastSegment - TELEMETRY_MAX_SEGMENTS + 1 : 1;
+    if (!s.rtcClock) first = max(first, stats.bootSegment);   // Uptime restarts every boot
+
+    // Newest segment that starts at or before from, else the oldest usable one
+    uint32_t start = 0;
+    for (uint32_t segment = s.lastSegment; segment >= first && segment > 0; segment--) {
+        if (!segmentUsable(s, segment)) continue;
+        start = segment;
+        if (s.header.firstTime <= s.from) break;
+    }
+    if (start == 0 || !loadBlock(s, start, 0)) {
+        error = HISTORY_ERROR_NO_LOGGED_DATA;
+        return false;
+    }
+
+    s.cur.segment = start;
+    s.cur.block = (s.header.firstTime <= s.from) ? findBlock(s, start, s.from) : 1;
+    s.cur.record = 0;
+    return true;
+}
+
+static bool nextSdSample(HistoryStream& s, Cursor& c, Sample& out) {
+    while (c.segment <= s.lastSegment) {
+        if (c.block == 0 || !loadBlock(s, c.segment, c.block)) {
+            // End of this segment (or a torn block): on to the next usable one
+            do {
+                c.segment++;
+            } while (c.segment <= s.lastSegment && !segmentUsable(s, c.segment));
+            c.block = 1;
+            c.record = 0;
+            continue;
+        }
+        if (c.record >= s.block.count) {
+            c.block++;
+            c.record = 0;
+            continue;
+        }
+
+        // Channels the segment did not log yet read as no reading
+        TelemetryRecord record;
+        telemetryBlockRecord(s.block, c.record++, record);
+        out.time = record.time;
+        for (uint8_t k = 0; k < s.sensorCount; k++) {
+            out.values[k] = record.temps[s.sensors[k]];
+        }
+        return true;
+    }
+    return false;
+}
+
+// ========== RAM Source ==========
+
+static bool openRam(HistoryStream& s, HistoryStreamError& error) {
+    s.clockAtBoot = telemetryClockAtBoot();
+    if (s.to < s.clockAtBoot) {
+        error = HISTORY_ERROR_BEFORE_BOOT;
+        return false;
+    }
+    uint32_t ramFrom = s.from > s.clockAtBoot ? s.from - s.clockAtBoot : 0;
+    uint32_t ramTo = s.to - s.clockAtBoot;
+
+    s.tier = historyChooseTier(ramFrom, ramTo, s.points);
+    uint32_t oldest, newest;
+    if (!historyTierSpan(s.tier, oldest, newest)) {
+        error = HISTORY_ERROR_NO_HISTORY;
+        return false;
+    }
+    uint16_t period = historyTierPeriod(s.tier);
+    s.cur.block = max(ramFrom, oldest) / period;
+    s.lastBucket = min(ramTo, newest) / period;
+    return true;
+}
+
+static bool nextRamSample(HistoryStream& s, Cursor& c, Sample& out) {
+    uint16_t period = historyTierPeriod(s.tier);
+    while (c.block <= s.lastBucket) {
+        uint32_t bucket = c.block++;
+        bool any = false;
+        for (uint8_t k = 0; k < s.sensorCount; k++) {
+            HistoryPoint point;
+            bool found = s.sensors[k] < historyStoreChannels() &&
+                         historyReadBucket(s.tier, s.sensors[k], bucket, point);
+            out.values[k] = found ? point.avg : HISTORY_NONE;
+            any |= found;
+        }
+        if (any) {
+            // A bucket starting before from still counts as inside the span
+            out.time = max(bucket * period + s.clockAtBoot, s.from);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Next sample in [from, to]; false at the end
+static bool nextSample(HistoryStream& s, Cursor& c, Sample& out) {
+    for (;;) {
+        if (!(s.sd ? nextSdSample(s, c, out) : nextRamSample(s, c, out))) return false;
+        if (out.time > s.to) return false;
+        if (out.time >= s.from) return true;
+    }
+}
+
+// ========== LTTB ==========
+
+// Mean time and value per sensor of the samples before end; leaves the
+// cursor on the first sample at or after end
+static void averageBucket(HistoryStream& s, Cursor& c, uint32_t end, bool* has, float* avgTime, float* avgValue) {
+    float sumTime[HISTORY_STREAM_MAX_SENSORS] = {};
+    float sumValue[HISTORY_STREAM_MAX_SENSORS] = {};
+    uint16_t count[HISTORY_STREAM_MAX_SENSORS] = {};
+
+    Sample sample;
+    for (;;) {
+        Cursor before = c;
+        if (!nextSample(s, c, sample)) break;
+        if (sample.time >= end) {
+            c = before;
+            break;
+        }
+        for (uint8_t k = 0; k < s.sensorCount; k++) {
+            if (sample.values[k] == HISTORY_NONE) continue;
+            sumTime[k] += sample.time - s.from;
+            sumValue[k] += sample.values[k];
+            count[k]++;
+        }
+    }
+
+    for (uint8_t k = 0; k < s.sensorCount; k++) {
+        has[k] = count[k] > 0;
+        if (has[k]) {
+            avgTime[k] = sumTime[k] / count[k];
+            avgValue[k] = sumValue[k] / count[k];
+        }
+    }
+}
+
+// Pick per sensor from the bucket starting at s.cur: first sample in the
+// first bucket, last in the last, else the LTTB triangle against the next
+// bucket's average (or a flat line from the anchor if it is empty)
+static void pickBucket(HistoryStream& s) {
+    uint32_t bucket = s.bucket;
+    bool first = bucket == 0;
+    bool last = bucket + 1 >= s.points;
+    uint32_t end = bucketStart(s, bucket + 1);
+
+    bool has[HISTORY_STREAM_MAX_SENSORS] = {};
+    float avgTime[HISTORY_STREAM_MAX_SENSORS];
+    float avgValue[HISTORY_STREAM_MAX_SENSORS];
+    Cursor after = s.next;
+    if (!first && !last) {
+        averageBucket(s, after, bucketStart(s, bucket + 2), has, avgTime, avgValue);
+    }
+
+    float bestArea[HISTORY_STREAM_MAX_SENSORS];
+    for (uint8_t k = 0; k < s.sensorCount; k++) {
+        s.picked[k] = false;
+        bestArea[k] = -1;
+        if (!has[k]) {
+            avgTime[k] = end - s.from;
+            avgValue[k] = s.anchorValue[k];
+        }
+    }
+
+    Sample sample;
+    for (;;) {
+        Cursor before = s.cur;
+        if (!nextSample(s, s.cur, sample)) break;
+        if (sample.time >= end) {
+            s.cur = before;
+            break;
+        }
+        for (uint8_t k = 0; k < s.sensorCount; k++) {
+            int16_t value = sample.values[k];
+            if (value == HISTORY_NONE || (first && s.picked[k])) continue;
+
+            float area = 0;
+            if (!first && !last && s.anchored[k]) {
+                float t = sample.time - s.from;
+                area = fabsf((s.anchorTime[k] - avgTime[k]) * (value - s.anchorValue[k]) -
+                             (s.anchorTime[k] - t) * (avgValue[k] - s.anchorValue[k]));
+            }
+            if (last || area > bestArea[k] || !s.picked[k]) {
+                bestArea[k] = area;
+                s.picked[k] = true;
+                s.pickTime[k] = sample.time;
+                s.pickValue[k] = value;
+            }
+        }
+    }
+
+    for (uint8_t k = 0; k < s.sensorCount; k++) {
+        if (!s.picked[k]) continue;
+        s.anchored[k] = true;
+        s.anchorTime[k] = s.pickTime[k] - s.from;
+        s.anchorValue[k] = s.pickValue[k];
+    }
+
+    // The first bucket has no lookahead yet: find where bucket 2 starts
+    if (first && s.points > 2) {
+        after = s.cur;
+        averageBucket(s, after, bucketStart(s, 2), has, avgTime, avgValue);
+    }
+    s.next = after;
+    s.bucket++;
+    s.pickIndex = 0;
+}
+
+// ========== Output ==========
+
+static void formatHeader(HistoryStream& s) {
+    if (s.format == HISTORY_FORMAT_CSV) {
+        s.lineLen = snprintf(s.line, sizeof(s.line), "sensor,time,temp\n");
+        return;
+    }
+    int n = snprintf(s.line, sizeof(s.line),
+                     "{\"source\":\"%s\",\"clock\":\"%s\",\"from\":%u,\"to\":%u,\"points\":%u,\"sensors\":[",
+                     s.sd ? "sd" : "ram", telemetryClockIsRtc() ? "rtc" : "uptime",
+                     (unsigned)s.from, (unsigned)s.to, s.points);
+    for (uint8_t k = 0; k < s.sensorCount; k++) {
+        n += snprintf(s.line + n, sizeof(s.line) - n, k ? ",%u" : "%u", s.sensors[k]);
+    }
+    n += snprintf(s.line + n, sizeof(s.line) - n, "],\"data\":[");
+    s.lineLen = n;
+}
+
+static void formatRow(HistoryStream& s, uint8_t k) {
+    float temp = s.pickValue[k] / 100.0f;
+    if (s.format == HISTORY_FORMAT_CSV) {
+        s.lineLen = snprintf(s.line, sizeof(s.line), "%u,%u,%.2f\n",
+                             s.sensors[k], (unsigned)s.pickTime[k], temp);
+    } else {
+        s.lineLen = snprintf(s.line, sizeof(s.line), "%s\n[%u,%u,%.2f]", s.firstRow ? "" : ",",
+                             s.sensors[k], (unsigned)s.pickTime[k], temp);
+    }
+    s.firstRow = false;
+}
+
+// Put the next line of output in s.line; false when the stream is complete
+static bool nextLine(HistoryStream& s) {
+    s.linePos = 0;
+    s.lineLen = 0;
+    for (;;) {
+        // Picks of the last bucket still to print
+        while (s.pickIndex < s.sensorCount) {
+            uint8_t k = s.pickIndex++;
+            if (s.picked[k]) {
+                formatRow(s, k);
+                return true;
+            }
+        }
+
+        switch (s.phase) {
+            case PHASE_HEADER:
+                formatHeader(s);
+                s.phase = PHASE_FIRST;
+                return true;
+
+            case PHASE_FIRST:
+            case PHASE_BUCKETS:
+                if (s.bucket >= s.points) {
+                    s.phase = PHASE_FOOTER;
+                } else {
+                    pickBucket(s);
+                    s.phase = PHASE_BUCKETS;
+                }
+                break;
+
+            case PHASE_FOOTER:
+                s.phase = PHASE_DONE;
+                if (s.format == HISTORY_FORMAT_JSON) {
+                    s.lineLen = snprintf(s.line, sizeof(s.line), "\n]}\n");
+                    return true;
+                }
+                return false;
+
+            case PHASE_DONE:
+            default:
+                return false;
+        }
+    }
+}
+
+// ========== Public API ==========
+
+HistoryStream* historyStreamOpen(uint32_t from, uint32_t to, uint16_t points,
+                                 const uint8_t* sensors, uint8_t sensorCount,
+                                 HistorySource source, HistoryFormat format, HistoryStreamError& error) {
+    error = HISTORY_ERROR_NONE;
+    if (to < from || points == 0 || sensorCount == 0 || sensorCount > HISTORY_STREAM_MAX_SENSORS) {
+        error = HISTORY_ERROR_BAD_ARGS;
+        return nullptr;
+    }
+    for (uint8_t k = 0; k < sensorCount; k++) {
+        if (sensors[k] >= temperatureCount) {
+            error = HISTORY_ERROR_UNKNOWN_SENSOR;
+            return nullptr;
+        }
+    }
+    if (openStreams >= HISTORY_STREAM_MAX_OPEN) {
+        error = HISTORY_ERROR_TOO_MANY;
+        return nullptr;
+    }
+
+    HistoryStream* s = new (std::nothrow) HistoryStream();
+    if (s == nullptr) {
+        error = HISTORY_ERROR_NO_MEMORY;
+        return nullptr;
+    }
+    s->from = from;
+    s->to = to;
+    s->points = min((uint64_t)min(points, (uint16_t)HISTORY_STREAM_MAX_POINTS), (uint64_t)to - from + 1);
+    memcpy(s->sensors, sensors, sensorCount);
+    s->sensorCount = sensorCount;
+    s->format = format;
+    s->cachedBlock = UINT32_MAX;
+    s->phase = PHASE_HEADER;
+    s->firstRow = true;
+    s->pickIndex = sensorCount;
+    openStreams++;
+
+    // Auto: RAM when it reaches back to from with at least `points` buckets
+    if (source == HISTORY_SOURCE_AUTO) {
+        uint32_t boot = telemetryClockAtBoot();
+        uint32_t ramFrom = from > boot ? from - boot : 0;
+        uint32_t ramTo = to > boot ? to - boot : 0;
+        uint8_t tier = historyChooseTier(ramFrom, ramTo, s->points);
+        uint32_t oldest, newest;
+        bool covered = historyTierSpan(tier, oldest, newest) && oldest <= ramFrom &&
+                       (ramTo - ramFrom + 1) / historyTierPeriod(tier) >= s->points;
+        bool sdRunning = getTelemetryLogStats().running;
+        source = (covered || !sdRunning) ? HISTORY_SOURCE_RAM : HISTORY_SOURCE_SD;
+    }
+    s->sd = source == HISTORY_SOURCE_SD;
+    if (s->sd) {
+        for (uint8_t k = 0; k < sensorCount; k++) {
+            if (sensors[k] >= TELEMETRY_MAX_TEMPS) error = HISTORY_ERROR_NOT_LOGGED;
+        }
+    }
+
+    if (error != HISTORY_ERROR_NONE || !(s->sd ? openSd(*s, error) : openRam(*s, error))) {
+        historyStreamClose(s);
+        return nullptr;
+    }
+    return s;
+}
+
+const char* historyStreamErrorText(HistoryStreamError error) {
+    switch (error) {
+        case HISTORY_ERROR_NONE:            return "OK";
+        case HISTORY_ERROR_BAD_ARGS:        return "Bad from/to/points/sensors";
+        case HISTORY_ERROR_UNKNOWN_SENSOR:  return "Unknown sensor";
+        case HISTORY_ERROR_NOT_LOGGED:      return "Sensor not in the SD log";
+        case HISTORY_ERROR_NO_SD_LOG:       return "No SD telemetry log";
+        case HISTORY_ERROR_NO_LOGGED_DATA:  return "No logged data";
+        case HISTORY_ERROR_BEFORE_BOOT:     return "Span is before this boot";
+        case HISTORY_ERROR_NO_HISTORY:      return "No history yet";
+        case HISTORY_ERROR_TOO_MANY:        return "Too many history requests";
+        case HISTORY_ERROR_NO_MEMORY:       return "Out of memory";
+    }
+    return "Unknown error";
+}
+
+size_t historyStreamRead(HistoryStream* s, uint8_t* buf, size_t len) {
+    size_t written = 0;
+    while (written < len) {
+        if (s->linePos >= s->lineLen && !nextLine(*s)) break;
+        size_t chunk = min((size_t)(s->lineLen - s->linePos), len - written);
+        memcpy(buf + written, s->line + s->linePos, chunk);
+        s->linePos += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+void historyStreamClose(HistoryStream* s) {
+    if (s == nullptr) return;
+    sdMutexClose(s->file, pdMS_TO_TICKS(STREAM_LOCK_MS));
+    delete s;
+    if (openStreams > 0) openStreams--;
+}
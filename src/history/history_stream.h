@@ -0,0 +1,73 @@
+#ifndef HISTORY_STREAM_H
+#define HISTORY_STREAM_H
+
+#include <Arduino.h>
+#include "telemetry_log.h"
+
+// ========== History Query Stream ==========
+// Serves GET /api/history: temperature samples for a time span, read from
+// the RAM store or the SD telemetry log and downsampled to at most `points`
+// per sensor with largest-triangle-three-buckets (LTTB), produced piece by
+// piece into the caller's buffer (chunked response).
+//
+// The span is cut into `points` equal time buckets. LTTB picks, in each
+// bucket, the sample forming the largest triangle with the point picked in
+// the previous bucket and the average of the next one; the first and last
+// buckets keep their first and last sample. Each bucket is read twice -
+// once for its average, once to pick - so a stream holds a few cursors
+// and one SD block, whatever the span. Spans with fewer samples than
+// points come out unchanged (one sample per bucket at most).
+//
+// Times use the record clock (telemetryClockNow()): Unix seconds with the
+// RTC, else seconds since boot. Without the RTC only segments of this boot
+// are read from SD.
+
+#define HISTORY_STREAM_MAX_SENSORS  16      // Channels per query
+#define HISTORY_STREAM_MAX_POINTS   2000
+#define HISTORY_STREAM_MAX_OPEN     2       // Concurrent streams
+
+enum HistorySource {
+    HISTORY_SOURCE_AUTO,      // RAM if it covers the span at >= points buckets, else SD
+    HISTORY_SOURCE_RAM,
+    HISTORY_SOURCE_SD
+};
+
+enum HistoryFormat {
+    HISTORY_FORMAT_JSON,      // {..., "data":[[sensor,time,temp],...]}
+    HISTORY_FORMAT_CSV        // sensor,time,temp
+};
+
+// Why historyStreamOpen() returned nullptr
+enum HistoryStreamError : uint8_t {
+    HISTORY_ERROR_NONE = 0,
+    HISTORY_ERROR_BAD_ARGS,         // from/to/points/sensors
+    HISTORY_ERROR_UNKNOWN_SENSOR,
+    HISTORY_ERROR_NOT_LOGGED,       // Sensor beyond TELEMETRY_MAX_TEMPS
+    HISTORY_ERROR_NO_SD_LOG,
+    HISTORY_ERROR_NO_LOGGED_DATA,
+    HISTORY_ERROR_BEFORE_BOOT,      // RAM span ends before this boot
+    HISTORY_ERROR_NO_HISTORY,       // RAM store still empty
+    HISTORY_ERROR_TOO_MANY,         // HISTORY_STREAM_MAX_OPEN reached
+    HISTORY_ERROR_NO_MEMORY
+};
+
+struct HistoryStream;
+
+// ========== Functions ==========
+// Start a query over [from, to]. Returns nullptr (with the reason in error)
+// on bad arguments, no data for the span, too many open streams or no memory.
+HistoryStream* historyStreamOpen(uint32_t from, uint32_t to, uint16_t points,
+                                 const uint8_t* sensors, uint8_t sensorCount,
+                                 HistorySource source, HistoryFormat format, HistoryStreamError& error);
+
+// Message for an error, for the response body
+const char* historyStreamErrorText(HistoryStreamError error);
+
+// Write the next part of the response into buf. Returns 0 when complete.
+size_t historyStreamRead(HistoryStream* stream, uint8_t* buf, size_t len);
+
+// Release a stream. Its SD file is closed under the SD mutex (deferred to
+// the holder when the card is busy - see sdMutexClose()).
+void historyStreamClose(HistoryStream* stream);
+
+#endif // HISTORY_STREAM_H
@@ -0,0 +1,388 @@
+#include "motion_trace.h"
+#include "telemetry_log.h"
+#include "config/config.h"
+#include "webserver/sd_mutex.h"
+#include "utils/log.h"
+#include <SD.h>
+#include <OneWire.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#define TRACE_TASK_STACK    3072
+#define TRACE_TASK_PRIORITY 1       // As the telemetry writer
+#define TRACE_TASK_CORE     0
+#define TRACE_LOCK_MS       5000
+#define TRACE_RECORD_MAX    (1 + 5 + MOTION_TRACE_AXES * 5 + 5 + 5 + 1 + 3)
+
+// External variables from main.cpp
+extern float posX, posY, posZ, posA;
+extern int feedRate;
+extern int spindleRPM;
+extern int feedOverride;
+extern int rapidOverride;
+extern int spindleOverride;
+extern bool sdCardAvailable;
+
+// Blocks cycle free -> filling (loop) -> full (writer) -> free
+static MotionTraceBlock pool[MOTION_TRACE_POOL_BLOCKS];
+static QueueHandle_t freeBlocks = nullptr;
+static QueueHandle_t fullBlocks = nullptr;
+static TaskHandle_t writerTask = nullptr;
+
+// Encoder (loop task)
+static int8_t filling = -1;
+static bool wasRecording = false;
+static bool haveLast = false;               // A report since recording started
+static MotionTraceState last;               // State after the previous report
+static uint32_t lastMs = 0;
+static int32_t prevPos[MOTION_TRACE_AXES];  // Position one report earlier
+static uint32_t prevDtMs = 0;               // 0 = no prediction
+
+// Writer task
+static File traceFile;
+static uint32_t fileNumber = 0;     // Highest file on the card / open file
+static uint32_t fileBlocks = 0;
+
+static MotionTraceStats stats = {};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+void motionTraceFilePath(char* path, size_t len, uint32_t file) {
+    snprintf(path, len, TELEMETRY_DIR "/trc_%05u.bin", (unsigned)file);
+}
+
+MotionTraceStats getMotionTraceStats() {
+    portENTER_CRITICAL(&statsMux);
+    MotionTraceStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
+}
+
+static uint16_t blockCrc(MotionTraceBlock& block) {
+    static_assert(offsetof(MotionTraceBlock, crc) == 16, "crc offset");
+    uint16_t saved = block.crc;
+    block.crc = 0;
+    uint16_t crc = OneWire::crc16((const uint8_t*)&block, sizeof(block));
+    block.crc = saved;
+    return crc;
+}
+
+// ========== Writer Task ==========
+
+static bool lockCard() {
+    return sdMutexTake(pdMS_TO_TICKS(TRACE_LOCK_MS)) == pdTRUE;
+}
+
+static void countWriteError() {
+    portENTER_CRITICAL(&statsMux);
+    stats.writeErrors++;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static void closeFile() {
+    if (!traceFile) return;
+    // Writer task: wait for the card rather than leave the close to the
+    // File destructor, outside the lock
+    sdMutexTake(portMAX_DELAY);
+    traceFile.close();
+    sdMutexGive();
+    LOGI("TRACE", "Closed file %u: %u blocks", (unsigned)fileNumber, (unsigned)fileBlocks);
+}
+
+static bool openFile() {
+    uint32_t file = fileNumber + 1;
+    char path[32];
+
+    if (!lockCard()) return false;
+    // Keep MOTION_TRACE_MAX_FILES including the new one
+    if (file > MOTION_TRACE_MAX_FILES) {
+        motionTraceFilePath(path, sizeof(path), file - MOTION_TRACE_MAX_FILES);
+        SD.remove(path);
+    }
+    motionTraceFilePath(path, sizeof(path), file);
+    traceFile = SD.open(path, FILE_WRITE);
+    bool ok = (bool)traceFile;
+    sdMutexGive();
+
+    if (!ok) {
+        LOGE("TRACE", "Failed to open %s", path);
+        return false;
+    }
+    fileNumber = file;
+    fileBlocks = 0;
+    portENTER_CRITICAL(&statsMux);
+    stats.file = file;
+    stats.fileBlocks = 0;
+    portEXIT_CRITICAL(&statsMux);
+    LOGI("TRACE", "Opened %s", path);
+    return true;
+}
+
+static void writeBlock(MotionTraceBlock& block) {
+    if (!traceFile && !openFile()) {
+        countWriteError();
+        return;
+    }
+
+    block.magic = MOTION_TRACE_MAGIC;
+    block.file = fileNumber;
+    block.sequence = fileBlocks + 1;
+    block.axes = MOTION_TRACE_AXES;
+    block.crc = blockCrc(block);
+
+    if (!lockCard()) {
+        countWriteError();
+        return;
+    }
+    uint32_t start = micros();
+    bool ok = traceFile.write((const uint8_t*)&block, sizeof(block)) == sizeof(block);
+    traceFile.flush();
+    uint32_t elapsed = micros() - start;
+    sdMutexGive();
+
+    if (!ok) {
+        // Start over in a new file; readers stop at the torn block
+        LOGE("TRACE", "Write failed in file %u, block %u",
+             (unsigned)fileNumber, (unsigned)block.sequence);
+        countWriteError();
+        closeFile();
+        return;
+    }
+
+    fileBlocks++;
+    portENTER_CRITICAL(&statsMux);
+    stats.blocks++;
+    stats.fileBlocks = fileBlocks;
+    if (elapsed > stats.flushMaxUs) stats.flushMaxUs = elapsed;
+    portEXIT_CRITICAL(&statsMux);
+
+    if (fileBlocks >= MOTION_TRACE_FILE_BLOCKS) closeFile();
+}
+
+// Highest file number on the card (0 if none)
+static uint32_t findLastFile() {
+    uint32_t lastFile = 0;
+    if (!lockCard()) return 0;
+    File dir = SD.open(TELEMETRY_DIR);
+    if (dir) {
+        for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+            unsigned file;
+            const char* name = strrchr(entry.name(), '/');
+            name = name ? name + 1 : entry.name();
+            if (sscanf(name, "trc_%u.bin", &file) == 1 && file > lastFile) lastFile = file;
+            entry.close();
+        }
+        dir.close();
+    }
+    sdMutexGive();
+    return lastFile;
+}
+
+static void writerLoop(void*) {
+    // Each boot starts a new file, opened with the first block
+    fileNumber = findLastFile();
+
+    for (;;) {
+        int8_t index;
+        if (xQueueReceive(fullBlocks, &index, portMAX_DELAY) != pdTRUE) continue;
+        writeBlock(pool[index]);
+        xQueueSend(freeBlocks, &index, 0);
+    }
+}
+
+// ========== Encoder (loop task) ==========
+
+static uint8_t* putVarint(uint8_t* p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    *p++ = value;
+    return p;
+}
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Where the axis would be if it kept the speed of the last report
+static int32_t predictPos(uint8_t axis, uint32_t dtMs) {
+    if (prevDtMs == 0) return last.pos[axis];
+    return last.pos[axis] + (int32_t)((int64_t)(last.pos[axis] - prevPos[axis]) * dtMs / prevDtMs);
+}
+
+static void captureState(MotionTraceState& state) {
+    const float pos[MOTION_TRACE_AXES] = {posX, posY, posZ, posA};
+    for (uint8_t i = 0; i < MOTION_TRACE_AXES; i++) {
+        state.pos[i] = lround(pos[i] * 1000.0);     // Double: a float product rounds above 8192
+    }
+    state.feed = feedRate;
+    state.spindle = spindleRPM;
+    state.state = telemetryMachineState();
+    state.overrides[0] = constrain(feedOverride, 0, 255);
+    state.overrides[1] = constrain(rapidOverride, 0, 255);
+    state.overrides[2] = constrain(spindleOverride, 0, 255);
+}
+
+static size_t encodeReport(const MotionTraceState& now, uint32_t dtMs, uint8_t* out) {
+    uint8_t* p = out + 1;
+    uint8_t mask = 0;
+    p = putVarint(p, dtMs);
+
+    for (uint8_t i = 0; i < MOTION_TRACE_AXES; i++) {
+        int32_t residual = now.pos[i] - predictPos(i, dtMs);
+        if (residual == 0) continue;
+        mask |= TRACE_X << i;
+        p = putVarint(p, zigzag(residual));
+    }
+    if (now.feed != last.feed) {
+        mask |= TRACE_FEED;
+        p = putVarint(p, zigzag(now.feed - last.feed));
+    }
+    if (now.spindle != last.spindle) {
+        mask |= TRACE_SPINDLE;
+        p = putVarint(p, zigzag(now.spindle - last.spindle));
+    }
+    if (now.state != last.state) {
+        mask |= TRACE_STATE;
+        *p++ = now.state;
+    }
+    if (memcmp(now.overrides, last.overrides, sizeof(now.overrides)) != 0) {
+        mask |= TRACE_OVERRIDES;
+        memcpy(p, now.overrides, sizeof(now.overrides));
+        p += sizeof(now.overrides);
+    }
+
+    out[0] = mask;
+    return p - out;
+}
+
+// Hand the filling block to the writer (the queues hold the whole pool,
+// so this never blocks)
+static void submitBlock() {
+    if (filling < 0) return;
+    if (pool[filling].count > 0) {
+        xQueueSend(fullBlocks, &filling, 0);
+    } else {
+        xQueueSend(freeBlocks, &filling, 0);
+    }
+    filling = -1;
+}
+
+// New block keyed on the last state; prediction restarts
+static bool startBlock() {
+    int8_t index;
+    if (xQueueReceive(freeBlocks, &index, 0) != pdTRUE) return false;
+    filling = index;
+
+    MotionTraceBlock& block = pool[filling];
+    memset(&block, 0, sizeof(block));
+    block.flags = telemetryClockIsRtc() ? TLM_FLAG_RTC_TIME : 0;
+    block.clock = telemetryClockAtBoot() + lastMs / 1000;
+    block.millis = lastMs;
+    block.base = last;
+    prevDtMs = 0;
+    return true;
+}
+
+void motionTraceReport() {
+    if (writerTask == nullptr || !cfg.enable_trace) return;
+
+    MotionTraceState now;
+    captureState(now);
+    uint32_t ms = millis();
+    if (!haveLast) {
+        // First report: the block starts from it
+        last = now;
+        lastMs = ms;
+        haveLast = true;
+    }
+
+    uint8_t record[TRACE_RECORD_MAX];
+    size_t len = 0;
+    bool stored = filling >= 0 || startBlock();
+    if (stored) {
+        len = encodeReport(now, ms - lastMs, record);
+        if (pool[filling].used + len > sizeof(pool[filling].data)) {
+            submitBlock();
+            stored = startBlock();
+            if (stored) len = encodeReport(now, ms - lastMs, record);
+        }
+    }
+
+    if (stored) {
+        MotionTraceBlock& block = pool[filling];
+        memcpy(block.data + block.used, record, len);
+        block.used += len;
+        block.count++;
+        memcpy(prevPos, last.pos, sizeof(prevPos));
+        prevDtMs = ms - lastMs;
+    } else {
+        // The next block is keyed on this report
+        prevDtMs = 0;
+    }
+    last = now;
+    lastMs = ms;
+
+    portENTER_CRITICAL(&statsMux);
+    if (stored) {
+        stats.reports++;
+        stats.encodedBytes += len;
+    } else {
+        stats.droppedReports++;
+    }
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void motionTraceInit() {
+    if (writerTask != nullptr) return;
+    if (!sdCardAvailable || g_sdCardMutex == NULL) {
+        LOGW("TRACE", "No SD card - motion trace disabled");
+        return;
+    }
+
+    if (sdMutexTake(pdMS_TO_TICKS(TRACE_LOCK_MS)) == pdTRUE) {
+        if (!SD.exists(TELEMETRY_DIR)) SD.mkdir(TELEMETRY_DIR);
+        sdMutexGive();
+    }
+
+    freeBlocks = xQueueCreate(MOTION_TRACE_POOL_BLOCKS, sizeof(int8_t));
+    fullBlocks = xQueueCreate(MOTION_TRACE_POOL_BLOCKS, sizeof(int8_t));
+    if (freeBlocks == nullptr || fullBlocks == nullptr) {
+        LOGE("TRACE", "Failed to create queues");
+        return;
+    }
+    for (int8_t i = 0; i < MOTION_TRACE_POOL_BLOCKS; i++) {
+        xQueueSend(freeBlocks, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(writerLoop, "trc_writer", TRACE_TASK_STACK, nullptr,
+                                TRACE_TASK_PRIORITY, &writerTask, TRACE_TASK_CORE) != pdPASS) {
+        LOGE("TRACE", "Failed to start writer task");
+        writerTask = nullptr;
+        return;
+    }
+    stats.running = true;
+    LOGI("TRACE", "Motion trace ready (%s)", cfg.enable_trace ? "recording" : "idle");
+}
+
+void motionTraceUpdate() {
+    if (writerTask == nullptr) return;
+
+    if (!cfg.enable_trace) {
+        if (wasRecording) {
+            submitBlock();
+            haveLast = false;
+            LOGI("TRACE", "Motion trace stopped");
+        }
+        wasRecording = false;
+        stats.recording = false;
+        return;
+    }
+    if (!wasRecording) {
+        LOGI("TRACE", "Motion trace started");
+        wasRecording = true;
+        stats.recording = true;
+    }
+}
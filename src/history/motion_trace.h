@@ -0,0 +1,98 @@
+#ifndef MOTION_TRACE_H
+#define MOTION_TRACE_H
+
+#include <Arduino.h>
+
+// ========== Motion Trace Recorder ==========
+// With cfg.enable_trace set, every parsed FluidNC status report is appended
+// to /logs/trc_NNNNN.bin (one file per boot) so a job can be examined after
+// the fact: decode with tools/trace_decode.py, or replay it into a
+// dashboard through the normal WebSocket parse path.
+//
+// Files are 512-byte blocks, each decodable on its own: the header carries
+// the state before its first report (keyframe), the records after it hold
+// only what changed. Record:
+//   mask   byte    bit 0-3 X/Y/Z/A, 4 feed, 5 spindle, 6 state, 7 overrides
+//   dt     varint  ms since the previous report
+//   X..A   zigzag varint per set bit: µm (MPos) minus the linear prediction
+//                  last + (last - prev) * dt / dtPrev, truncated; just
+//                  last for the first report of a block or when dtPrev = 0
+//   feed, spindle  zigzag varint delta
+//   state  byte    TelemetryMachineState
+//   ovr    3 bytes feed, rapid, spindle override (%)
+// A report with nothing new is 2 bytes; steady motion is about 1 byte per
+// moving axis. Full blocks go to a low-priority writer task like the
+// telemetry log's; blocks carry a CRC and sequence, readers stop at a torn one.
+
+#define MOTION_TRACE_BLOCK_SIZE     512
+#define MOTION_TRACE_AXES           4
+#define MOTION_TRACE_FILE_BLOCKS    2048    // 1 MB: ~6 h of motion at 10 Hz
+#define MOTION_TRACE_MAX_FILES      16
+#define MOTION_TRACE_POOL_BLOCKS    3
+
+#define MOTION_TRACE_MAGIC          0x3142544D  // "MTB1"
+
+enum MotionTraceMask {
+    TRACE_X         = 0x01,     // X << axis for axis 0-3
+    TRACE_FEED      = 0x10,
+    TRACE_SPINDLE   = 0x20,
+    TRACE_STATE     = 0x40,
+    TRACE_OVERRIDES = 0x80
+};
+
+// Decoded state after a report
+struct __attribute__((packed)) MotionTraceState {
+    int32_t pos[MOTION_TRACE_AXES];     // MPos in µm
+    int32_t feed;
+    int32_t spindle;
+    uint8_t state;                      // TelemetryMachineState
+    uint8_t overrides[3];               // Feed, rapid, spindle (%)
+};
+
+struct __attribute__((packed)) MotionTraceBlock {
+    uint32_t magic;
+    uint32_t file;
+    uint32_t sequence;                  // Block number in the file, from 1
+    uint16_t count;                     // Reports
+    uint16_t used;                      // Bytes of data
+    uint16_t crc;                       // OneWire::crc16 of the block with crc = 0
+    uint8_t flags;                      // TLM_FLAG_RTC_TIME: clock is Unix seconds
+    uint8_t axes;                       // MOTION_TRACE_AXES
+    uint32_t clock;                     // Record clock (s) at millis
+    uint32_t millis;                    // Time of base (ms since boot)
+    MotionTraceState base;              // State before the first report
+    uint8_t data[MOTION_TRACE_BLOCK_SIZE - 56];
+};
+
+static_assert(sizeof(MotionTraceState) == 28, "state layout");
+static_assert(sizeof(MotionTraceBlock) == MOTION_TRACE_BLOCK_SIZE, "block layout");
+
+struct MotionTraceStats {
+    bool running;                 // Writer task started (SD card present)
+    bool recording;               // cfg.enable_trace, as last seen
+    uint32_t file;                // Open file (0 = none yet)
+    uint32_t fileBlocks;
+    uint32_t reports;
+    uint32_t droppedReports;      // No free RAM block (writer behind)
+    uint32_t blocks;
+    uint32_t encodedBytes;        // Record bytes (excluding block headers)
+    uint32_t writeErrors;
+    uint32_t flushMaxUs;
+};
+
+// ========== Functions (loop task) ==========
+// Start the writer task. Call after the SD card and its mutex are set up.
+void motionTraceInit();
+
+// Record the status report just parsed (end of parseFluidNCStatus)
+void motionTraceReport();
+
+// Flush the partly filled block when cfg.enable_trace is switched off
+void motionTraceUpdate();
+
+// ========== Functions (any task) ==========
+MotionTraceStats getMotionTraceStats();
+
+void motionTraceFilePath(char* path, size_t len, uint32_t file);
+
+#endif // MOTION_TRACE_H
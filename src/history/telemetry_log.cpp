@@ -0,0 +1,545 @@
+#include "telemetry_log.h"
+#include "history_store.h"
+#include "config/config.h"
+#include "webserver/sd_mutex.h"
+#include "sensors/fan_tach.h"
+#include "utils/log.h"
+#include <SD.h>
+#include <RTClib.h>
+#include <OneWire.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#define TELEMETRY_TASK_STACK    4096
+#define TELEMETRY_TASK_PRIORITY 1       // Same as loop(), below WiFi / async_tcp
+#define TELEMETRY_TASK_CORE     0
+#define TELEMETRY_LOCK_MS       5000
+#define TELEMETRY_INDEX_MAX     ((TELEMETRY_SEGMENT_BLOCKS + TELEMETRY_INDEX_STRIDE - 1) / TELEMETRY_INDEX_STRIDE)
+
+// External variables from main.cpp
+extern float* temperatures;
+extern uint8_t temperatureCount;
+extern float psuVoltage;
+extern uint8_t fanSpeed;
+extern uint16_t fanRPM;
+extern String machineState;
+extern bool isJobRunning;
+extern bool fluidncConnected;
+extern bool sdCardAvailable;
+extern bool rtcAvailable;
+extern RTC_DS3231 rtc;
+
+// Blocks cycle free -> filling (loop) -> full (writer) -> free
+static TelemetryBlock pool[TELEMETRY_POOL_BLOCKS];
+static QueueHandle_t freeBlocks = nullptr;
+static QueueHandle_t fullBlocks = nullptr;
+static TaskHandle_t writerTask = nullptr;
+
+// Loop task
+static int8_t filling = -1;
+static uint32_t lastRecordMs = 0;
+static uint32_t bootUnix = 0;       // Unix time at millis() == 0, when the RTC is present
+static bool wasLogging = false;
+
+// Writer task
+static File segmentFile;
+static uint32_t segmentNumber = 0;  // Highest segment on the card / open segment
+static uint32_t segmentBlocks = 0;
+static uint8_t segmentTemps = 0;    // Channels per record in the open segment
+static TelemetryIndexEntry segmentIndex[TELEMETRY_INDEX_MAX];
+static uint16_t indexCount = 0;
+static uint64_t flushTotalUs = 0;
+
+static TelemetryLogStats stats = {};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+TelemetryLogStats getTelemetryLogStats() {
+    portENTER_CRITICAL(&statsMux);
+    TelemetryLogStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
+}
+
+uint32_t telemetryClockNow() {
+    return bootUnix + millis() / 1000;
+}
+
+bool telemetryClockIsRtc() {
+    return bootUnix != 0;
+}
+
+uint32_t telemetryClockAtBoot() {
+    return bootUnix;
+}
+
+void telemetrySegmentPath(char* path, size_t len, uint32_t segment, const char* ext) {
+    snprintf(path, len, TELEMETRY_DIR "/tlm_%05u.%s", (unsigned)segment, ext);
+}
+
+// ========== Records ==========
+
+size_t telemetryRecordSize(uint8_t temps) {
+    return offsetof(TelemetryRecord, temps) + temps * sizeof(int16_t);
+}
+
+uint16_t telemetryRecordsPerBlock(uint8_t temps) {
+    return TELEMETRY_BLOCK_DATA / telemetryRecordSize(temps);
+}
+
+void telemetryBlockRecord(const TelemetryBlock& block, uint16_t n, TelemetryRecord& record) {
+    size_t size = telemetryRecordSize(block.temps);
+    memcpy(&record, block.records + n * size, size);
+    for (uint8_t i = block.temps; i < TELEMETRY_MAX_TEMPS; i++) record.temps[i] = HISTORY_NONE;
+}
+
+uint32_t telemetryBlockTime(const TelemetryBlock& block) {
+    uint32_t time;
+    memcpy(&time, block.records + offsetof(TelemetryRecord, time), sizeof(time));
+    return time;
+}
+
+// ========== Block CRC ==========
+
+static uint16_t blockCrc(const void* block) {
+    uint8_t copy[TELEMETRY_BLOCK_SIZE];
+    memcpy(copy, block, sizeof(copy));
+    // crc sits at the same offset in data blocks and the segment header
+    static_assert(offsetof(TelemetryBlock, crc) == 16 && offsetof(TelemetrySegmentHeader, crc) == 16,
+                  "crc offset");
+    copy[16] = copy[17] = 0;
+    return OneWire::crc16(copy, sizeof(copy));
+}
+
+bool telemetryBlockValid(const TelemetryBlock& block) {
+    return block.magic == TELEMETRY_BLOCK_MAGIC &&
+           block.temps <= TELEMETRY_MAX_TEMPS &&
+           block.recordSize == telemetryRecordSize(block.temps) &&
+           block.count > 0 && block.count <= telemetryRecordsPerBlock(block.temps) &&
+           blockCrc(&block) == block.crc;
+}
+
+bool telemetryHeaderValid(const TelemetrySegmentHeader& header) {
+    return header.magic == TELEMETRY_SEGMENT_MAGIC &&
+           header.temps <= TELEMETRY_MAX_TEMPS &&
+           header.recordSize == telemetryRecordSize(header.temps) &&
+           blockCrc(&header) == header.crc;
+}
+
+// ========== Writer Task ==========
+
+static bool lockCard(uint32_t& waitedUs) {
+    uint32_t start = micros();
+    bool locked = sdMutexTake(pdMS_TO_TICKS(TELEMETRY_LOCK_MS)) == pdTRUE;
+    waitedUs = micros() - start;
+    return locked;
+}
+
+// A File dropped without close() is closed by its destructor, outside the
+// lock, so a close waits for the card however long it is held
+static void closeLocked(File& file) {
+    sdMutexTake(portMAX_DELAY);
+    file.close();
+    sdMutexGive();
+}
+
+static void countWritten(size_t bytes) {
+    portENTER_CRITICAL(&statsMux);
+    stats.writtenBytes += bytes;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static void countWriteError() {
+    portENTER_CRITICAL(&statsMux);
+    stats.writeErrors++;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// Write the time index of a segment beside it (entries, then a CRC)
+static bool writeIndex(uint32_t segment, const TelemetryIndexEntry* entries, uint16_t count) {
+    char path[32];
+    telemetrySegmentPath(path, sizeof(path), segment, "idx");
+
+    uint32_t header[2] = {TELEMETRY_INDEX_MAGIC, count};
+    uint16_t crc = OneWire::crc16((const uint8_t*)entries, count * sizeof(TelemetryIndexEntry));
+    size_t len = sizeof(header) + count * sizeof(TelemetryIndexEntry) + sizeof(crc);
+
+    uint32_t waited;
+    if (!lockCard(waited)) return false;
+    File file = SD.open(path, FILE_WRITE);
+    bool ok = file &&
+              file.write((const uint8_t*)header, sizeof(header)) == sizeof(header) &&
+              file.write((const uint8_t*)entries, count * sizeof(TelemetryIndexEntry)) ==
+                  count * sizeof(TelemetryIndexEntry) &&
+              file.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+    if (file) file.close();
+    if (!ok) SD.remove(path);     // A partial index would hide the segment from recovery
+    sdMutexGive();
+
+    if (ok) countWritten(len);
+    return ok;
+}
+
+static void closeSegment() {
+    if (!segmentFile) return;
+
+    closeLocked(segmentFile);
+    if (!writeIndex(segmentNumber, segmentIndex, indexCount)) {
+        LOGE("LOG", "Failed to write index of segment %u", (unsigned)segmentNumber);
+    }
+    LOGI("LOG", "Closed segment %u: %u blocks", (unsigned)segmentNumber, (unsigned)segmentBlocks);
+
+    portENTER_CRITICAL(&statsMux);
+    stats.segmentBlocks = 0;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// A segment for the records of first (its channel count and clock)
+static bool openSegment(const TelemetryBlock& first) {
+    uint32_t segment = segmentNumber + 1;
+    char path[32];
+    TelemetryRecord record;
+    telemetryBlockRecord(first, 0, record);
+
+    TelemetrySegmentHeader header = {};
+    header.magic = TELEMETRY_SEGMENT_MAGIC;
+    header.segment = segment;
+    header.firstTime = record.time;
+    header.recordSize = telemetryRecordSize(first.temps);
+    header.temps = first.temps;
+    header.flags = record.flags & TLM_FLAG_RTC_TIME;
+    header.crc = blockCrc(&header);
+
+    uint32_t waited;
+    if (!lockCard(waited)) return false;
+    // Keep TELEMETRY_MAX_SEGMENTS including the new one
+    if (segment > TELEMETRY_MAX_SEGMENTS) {
+        telemetrySegmentPath(path, sizeof(path), segment - TELEMETRY_MAX_SEGMENTS, "bin");
+        SD.remove(path);
+        telemetrySegmentPath(path, sizeof(path), segment - TELEMETRY_MAX_SEGMENTS, "idx");
+        SD.remove(path);
+    }
+    telemetrySegmentPath(path, sizeof(path), segment, "bin");
+    segmentFile = SD.open(path, FILE_WRITE);
+    bool ok = segmentFile &&
+              segmentFile.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    if (ok) {
+        segmentFile.flush();
+    } else {
+        if (segmentFile) segmentFile.close();
+        SD.remove(path);
+    }
+    sdMutexGive();
+
+    if (!ok) {
+        LOGE("LOG", "Failed to open %s", path);
+        return false;
+    }
+
+    segmentNumber = segment;
+    segmentBlocks = 0;
+    segmentTemps = first.temps;
+    indexCount = 0;
+    countWritten(sizeof(header));
+    portENTER_CRITICAL(&statsMux);
+    stats.segment = segment;
+    stats.segmentBlocks = 0;
+    stats.temps = segmentTemps;
+    portEXIT_CRITICAL(&statsMux);
+    LOGI("LOG", "Opened %s (%u channels)", path, first.temps);
+    return true;
+}
+
+static void writeBlock(TelemetryBlock& block) {
+    // One record size per segment: a new channel count starts a new one
+    if (segmentFile && block.temps != segmentTemps) closeSegment();
+    if (!segmentFile && !openSegment(block)) {
+        countWriteError();
+        return;
+    }
+
+    block.magic = TELEMETRY_BLOCK_MAGIC;
+    block.segment = segmentNumber;
+    block.sequence = segmentBlocks + 1;
+    block.recordSize = telemetryRecordSize(block.temps);
+    block.crc = blockCrc(&block);
+
+    uint32_t waited;
+    if (!lockCard(waited)) {
+        countWriteError();
+        return;
+    }
+    uint32_t start = micros();
+    bool ok = segmentFile.write((const uint8_t*)&block, sizeof(block)) == sizeof(block);
+    segmentFile.flush();
+    uint32_t elapsed = micros() - start;
+    sdMutexGive();
+
+    if (!ok) {
+        // Start over in a new segment; readers stop at the torn block
+        LOGE("LOG", "Write failed in segment %u, block %u",
+             (unsigned)segmentNumber, (unsigned)block.sequence);
+        countWriteError();
+        closeSegment();
+        return;
+    }
+
+    if (segmentBlocks % TELEMETRY_INDEX_STRIDE == 0) {
+        segmentIndex[indexCount++] = {telemetryBlockTime(block), block.sequence};
+    }
+    segmentBlocks++;
+    flushTotalUs += elapsed;
+
+    portENTER_CRITICAL(&statsMux);
+    stats.blocks++;
+    stats.segmentBlocks = segmentBlocks;
+    stats.writtenBytes += sizeof(block);
+    stats.flushAvgUs = flushTotalUs / stats.blocks;
+    if (elapsed > stats.flushMaxUs) stats.flushMaxUs = elapsed;
+    if (waited > stats.lockWaitMaxUs) stats.lockWaitMaxUs = waited;
+    portEXIT_CRITICAL(&statsMux);
+
+    if (segmentBlocks >= TELEMETRY_SEGMENT_BLOCKS) closeSegment();
+}
+
+// ========== Recovery ==========
+
+// Highest segment number on the card (0 if none)
+static uint32_t findLastSegment() {
+    uint32_t last = 0;
+    uint32_t waited;
+    if (!lockCard(waited)) return 0;
+    File dir = SD.open(TELEMETRY_DIR);
+    if (dir) {
+        for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+            unsigned segment;
+            const char* name = strrchr(entry.name(), '/');
+            name = name ? name + 1 : entry.name();
+            if (sscanf(name, "tlm_%u.bin", &segment) == 1 && segment > last) last = segment;
+            entry.close();
+        }
+        dir.close();
+    }
+    sdMutexGive();
+    return last;
+}
+
+// A segment without an index was not closed (power loss or reset): scan
+// its blocks up to the first damaged one and write the index now. The SD
+// mutex is taken per block so the web server is not locked out.
+static void recoverSegment(uint32_t segment) {
+    char path[32];
+    telemetrySegmentPath(path, sizeof(path), segment, "idx");
+    uint32_t waited;
+    if (!lockCard(waited)) return;
+    bool indexed = SD.exists(path);
+    telemetrySegmentPath(path, sizeof(path), segment, "bin");
+    File file = indexed || !SD.exists(path) ? File() : SD.open(path, FILE_READ);
+    size_t size = file ? file.size() : 0;
+    sdMutexGive();
+    if (!file) return;
+
+    static TelemetryBlock block;
+    uint32_t blocks = size > TELEMETRY_BLOCK_SIZE ? size / TELEMETRY_BLOCK_SIZE - 1 : 0;
+    blocks = min(blocks, (uint32_t)TELEMETRY_SEGMENT_BLOCKS);
+    uint32_t valid = 0, torn = 0;
+    indexCount = 0;
+
+    for (uint32_t n = 1; n <= blocks; n++) {
+        if (!lockCard(waited)) break;
+        bool read = file.seek(n * TELEMETRY_BLOCK_SIZE) &&
+                    file.read((uint8_t*)&block, sizeof(block)) == sizeof(block);
+        sdMutexGive();
+
+        // Nothing after a damaged block is trusted
+        if (!read || !telemetryBlockValid(block) || block.sequence != n) {
+            torn++;
+            break;
+        }
+        if ((n - 1) % TELEMETRY_INDEX_STRIDE == 0) {
+            segmentIndex[indexCount++] = {telemetryBlockTime(block), n};
+        }
+        valid++;
+    }
+    // A block cut short by power loss
+    if (valid == blocks && size % TELEMETRY_BLOCK_SIZE != 0) torn++;
+
+    closeLocked(file);
+
+    writeIndex(segment, segmentIndex, indexCount);
+    indexCount = 0;
+
+    portENTER_CRITICAL(&statsMux);
+    stats.recoveredBlocks += valid;
+    stats.tornBlocks += torn;
+    portEXIT_CRITICAL(&statsMux);
+    LOGI("LOG", "Recovered segment %u: %u blocks%s",
+         (unsigned)segment, (unsigned)valid, torn ? ", torn block at the end" : "");
+}
+
+static void writerLoop(void*) {
+    // Any segment still on the card may lack an index (a failed close too,
+    // not only the last one)
+    segmentNumber = findLastSegment();
+    portENTER_CRITICAL(&statsMux);
+    stats.bootSegment = segmentNumber + 1;
+    portEXIT_CRITICAL(&statsMux);
+    uint32_t oldest = segmentNumber > TELEMETRY_MAX_SEGMENTS ? segmentNumber - TELEMETRY_MAX_SEGMENTS + 1 : 1;
+    for (uint32_t segment = oldest; segment <= segmentNumber; segment++) {
+        recoverSegment(segment);
+    }
+
+    for (;;) {
+        int8_t index;
+        if (xQueueReceive(fullBlocks, &index, portMAX_DELAY) != pdTRUE) continue;
+        writeBlock(pool[index]);
+        xQueueSend(freeBlocks, &index, 0);
+    }
+}
+
+// ========== Record Capture (loop task) ==========
+
+uint8_t telemetryMachineState() {
+    static const struct { const char* prefix; uint8_t code; } states[] = {
+        {"OFFLINE", TLM_STATE_OFFLINE}, {"IDLE", TLM_STATE_IDLE}, {"RUN", TLM_STATE_RUN},
+        {"HOLD", TLM_STATE_HOLD}, {"JOG", TLM_STATE_JOG}, {"ALARM", TLM_STATE_ALARM},
+        {"DOOR", TLM_STATE_DOOR}, {"CHECK", TLM_STATE_CHECK}, {"HOME", TLM_STATE_HOME},
+        {"SLEEP", TLM_STATE_SLEEP},
+    };
+    for (const auto& state : states) {
+        if (machineState.startsWith(state.prefix)) return state.code;
+    }
+    return TLM_STATE_OTHER;
+}
+
+// Returns the number of temperature channels filled in
+static uint8_t captureRecord(TelemetryRecord& record) {
+    record.time = telemetryClockNow();
+    record.flags = telemetryClockIsRtc() ? TLM_FLAG_RTC_TIME : 0;
+
+    uint8_t temps = min(temperatureCount, (uint8_t)TELEMETRY_MAX_TEMPS);
+    for (uint8_t i = 0; i < temps; i++) {
+        float t = temperatures[i];
+        record.temps[i] = isnan(t) ? HISTORY_NONE : (int16_t)constrain(lroundf(t * 100.0f), -32767L, 32767L);
+    }
+    record.psuMv = constrain(lroundf(psuVoltage * 1000.0f), 0L, 65535L);
+    record.fanRpm = fanRPM;
+    record.fanDuty = fanSpeed;
+    record.machine = telemetryMachineState();
+    record.reserved = 0;
+
+    if (isJobRunning) record.flags |= TLM_FLAG_JOB;
+    if (fluidncConnected) record.flags |= TLM_FLAG_FLUIDNC;
+    if (getTachStats().stalled && fanSpeed > 0) record.flags |= TLM_FLAG_FAN_STALL;
+    if (psuVoltage < cfg.psu_alert_low || psuVoltage > cfg.psu_alert_high) record.flags |= TLM_FLAG_PSU_ALERT;
+    return temps;
+}
+
+// Hand the filling block to the writer (the queues hold the whole pool,
+// so this never blocks)
+static void submitBlock() {
+    if (filling < 0) return;
+    if (pool[filling].count < telemetryRecordsPerBlock(pool[filling].temps)) {
+        portENTER_CRITICAL(&statsMux);
+        stats.partialBlocks++;
+        portEXIT_CRITICAL(&statsMux);
+    }
+    xQueueSend(fullBlocks, &filling, 0);
+    filling = -1;
+}
+
+static void appendRecord(const TelemetryRecord& record, uint8_t temps) {
+    // The channel count changed (sensor added or removed): records of the
+    // new size go in a new block, which the writer puts in a new segment
+    if (filling >= 0 && pool[filling].temps != temps) submitBlock();
+    if (filling < 0) {
+        int8_t index;
+        if (xQueueReceive(freeBlocks, &index, 0) != pdTRUE) {
+            portENTER_CRITICAL(&statsMux);
+            stats.droppedRecords++;
+            portEXIT_CRITICAL(&statsMux);
+            return;
+        }
+        filling = index;
+        memset(&pool[filling], 0, sizeof(TelemetryBlock));
+        pool[filling].temps = temps;
+    }
+
+    TelemetryBlock& block = pool[filling];
+    size_t size = telemetryRecordSize(temps);
+    memcpy(block.records + block.count * size, &record, size);
+    block.count++;
+
+    portENTER_CRITICAL(&statsMux);
+    stats.records++;
+    stats.payloadBytes += size;
+    portEXIT_CRITICAL(&statsMux);
+
+    if (block.count == telemetryRecordsPerBlock(temps)) submitBlock();
+}
+
+void telemetryLogInit() {
+    if (writerTask != nullptr) return;
+    if (rtcAvailable) {
+        bootUnix = rtc.now().unixtime() - millis() / 1000;
+    }
+    if (!sdCardAvailable || g_sdCardMutex == NULL) {
+        LOGW("LOG", "No SD card - telemetry log disabled");
+        return;
+    }
+
+    if (sdMutexTake(pdMS_TO_TICKS(TELEMETRY_LOCK_MS)) == pdTRUE) {
+        if (!SD.exists(TELEMETRY_DIR)) SD.mkdir(TELEMETRY_DIR);
+        sdMutexGive();
+    }
+
+    freeBlocks = xQueueCreate(TELEMETRY_POOL_BLOCKS, sizeof(int8_t));
+    fullBlocks = xQueueCreate(TELEMETRY_POOL_BLOCKS, sizeof(int8_t));
+    if (freeBlocks == nullptr || fullBlocks == nullptr) {
+        LOGE("LOG", "Failed to create queues");
+        return;
+    }
+    for (int8_t i = 0; i < TELEMETRY_POOL_BLOCKS; i++) {
+        xQueueSend(freeBlocks, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(writerLoop, "tlm_writer", TELEMETRY_TASK_STACK, nullptr,
+                                TELEMETRY_TASK_PRIORITY, &writerTask, TELEMETRY_TASK_CORE) != pdPASS) {
+        LOGE("LOG", "Failed to start writer task");
+        writerTask = nullptr;
+        return;
+    }
+    stats.running = true;
+    LOGI("LOG", "Telemetry log ready (%s, %s time)",
+         cfg.enable_logging ? "logging" : "idle", bootUnix ? "RTC" : "uptime");
+}
+
+void telemetryLogUpdate() {
+    if (writerTask == nullptr) return;
+
+    if (!cfg.enable_logging) {
+        if (wasLogging) {
+            submitBlock();
+            LOGI("LOG", "Telemetry logging stopped");
+        }
+        wasLogging = false;
+        stats.logging = false;
+        return;
+    }
+
+    unsigned long now = millis();
+    if (!wasLogging) {
+        LOGI("LOG", "Telemetry logging started");
+        lastRecordMs = now - TELEMETRY_PERIOD_MS;
+        wasLogging = true;
+        stats.logging = true;
+    }
+    if (now - lastRecordMs < TELEMETRY_PERIOD_MS) return;
+    // Keep the 1 s grid, but do not catch up after a long stall
+    lastRecordMs = (now - lastRecordMs < 2 * TELEMETRY_PERIOD_MS) ? lastRecordMs + TELEMETRY_PERIOD_MS : now;
+
+    TelemetryRecord record;
+    uint8_t temps = captureRecord(record);
+    appendRecord(record, temps);
+}
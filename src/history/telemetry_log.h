@@ -0,0 +1,169 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// ========== SD Telemetry Log ==========
+// Append-only binary log on SD, one record per second while
+// cfg.enable_logging is set. Records are packed into 512-byte blocks in
+// RAM; a full block is handed to a low-priority writer task, which appends
+// it to the open segment holding the SD mutex only for the write + flush.
+//
+// A record stores every temperature channel (up to TELEMETRY_MAX_TEMPS), so
+// its size follows the channel count: the segment header and every block
+// carry it. When the count changes the block being filled is written short
+// and the next one opens a new segment.
+//
+// Segment file /logs/tlm_NNNNN.bin: a header block, then data blocks, all
+// 512 bytes at 512-byte offsets. Every block carries a CRC, so readers stop
+// at a torn or unwritten block instead of trusting the file length. Each
+// boot opens a new segment; segments rotate at TELEMETRY_SEGMENT_BLOCKS and
+// the oldest are deleted beyond TELEMETRY_MAX_SEGMENTS.
+//
+// Time index /logs/tlm_NNNNN.idx: (first record time, block) for every
+// TELEMETRY_INDEX_STRIDE blocks, written when a segment closes. A segment
+// that never closed (power loss) is scanned at the next boot and gets its
+// index then.
+
+#define TELEMETRY_DIR               "/logs"
+#define TELEMETRY_BLOCK_SIZE        512
+#define TELEMETRY_BLOCK_DATA        480     // Record bytes per block
+#define TELEMETRY_MAX_TEMPS         64      // SENSOR_CACHE_MAX: every channel is logged
+#define TELEMETRY_PERIOD_MS         1000
+#define TELEMETRY_SEGMENT_BLOCKS    2048    // Data blocks per segment: 1 MB, ~11 h
+#define TELEMETRY_MAX_SEGMENTS      32
+#define TELEMETRY_INDEX_STRIDE      16      // Data blocks per index entry
+#define TELEMETRY_POOL_BLOCKS       4       // RAM blocks: filling + waiting for the writer
+
+#define TELEMETRY_BLOCK_MAGIC       0x32424C54  // "TLB2"
+#define TELEMETRY_SEGMENT_MAGIC     0x32534C54  // "TLS2"
+#define TELEMETRY_INDEX_MAGIC       0x31494C54  // "TLI1"
+
+enum TelemetryFlags {
+    TLM_FLAG_RTC_TIME   = 0x01,   // time is Unix seconds (else seconds since boot)
+    TLM_FLAG_JOB        = 0x02,
+    TLM_FLAG_FLUIDNC    = 0x04,   // Connected to FluidNC
+    TLM_FLAG_FAN_STALL  = 0x08,
+    TLM_FLAG_PSU_ALERT  = 0x10    // PSU outside psu_alert_low / psu_alert_high
+};
+
+enum TelemetryMachineState {
+    TLM_STATE_OFFLINE,
+    TLM_STATE_IDLE,
+    TLM_STATE_RUN,
+    TLM_STATE_HOLD,
+    TLM_STATE_JOG,
+    TLM_STATE_ALARM,
+    TLM_STATE_DOOR,
+    TLM_STATE_CHECK,
+    TLM_STATE_HOME,
+    TLM_STATE_SLEEP,
+    TLM_STATE_OTHER
+};
+
+// On the card a record ends after its segment's channels
+// (telemetryRecordSize()); the rest of temps is not stored
+struct __attribute__((packed)) TelemetryRecord {
+    uint32_t time;                      // See TLM_FLAG_RTC_TIME
+    uint16_t psuMv;
+    uint16_t fanRpm;
+    uint8_t fanDuty;                    // %
+    uint8_t machine;                    // TelemetryMachineState
+    uint8_t flags;                      // TelemetryFlags
+    uint8_t reserved;
+    int16_t temps[TELEMETRY_MAX_TEMPS]; // Centi-°C, HISTORY_NONE when stale or absent
+};
+
+struct __attribute__((packed)) TelemetryBlock {
+    uint32_t magic;
+    uint32_t segment;
+    uint32_t sequence;                  // Data block number in the segment, from 1
+    uint16_t count;                     // Records used; short when logging stopped or the channels changed
+    uint16_t recordSize;
+    uint16_t crc;                       // OneWire::crc16 of the block with crc = 0
+    uint8_t temps;                      // Temperature channels per record
+    uint8_t reserved[13];
+    uint8_t records[TELEMETRY_BLOCK_DATA];  // count records of recordSize bytes
+};
+
+struct __attribute__((packed)) TelemetrySegmentHeader {
+    uint32_t magic;
+    uint32_t segment;
+    uint32_t firstTime;                 // Time of the first record
+    uint16_t recordSize;
+    uint8_t temps;                      // Temperature channels per record, in every block
+    uint8_t flags;                      // TLM_FLAG_RTC_TIME of the first record
+    uint16_t crc;                       // As TelemetryBlock
+    uint8_t reserved[TELEMETRY_BLOCK_SIZE - 18];
+};
+
+struct TelemetryIndexEntry {
+    uint32_t time;                      // First record time of the block
+    uint32_t block;                     // Data block number (file offset = block * 512)
+};
+
+static_assert(offsetof(TelemetryRecord, temps) == 12, "record layout");
+static_assert(sizeof(TelemetryBlock) == TELEMETRY_BLOCK_SIZE, "block layout");
+static_assert(sizeof(TelemetrySegmentHeader) == TELEMETRY_BLOCK_SIZE, "header layout");
+
+struct TelemetryLogStats {
+    bool running;                 // Writer task started (SD card present)
+    bool logging;                 // cfg.enable_logging, as last seen
+    uint32_t segment;             // Open segment (0 = none yet)
+    uint32_t bootSegment;         // First segment of this boot (older ones are on the card)
+    uint32_t segmentBlocks;       // Data blocks in the open segment
+    uint8_t temps;                // Temperature channels per record in the open segment
+    uint32_t records;
+    uint32_t droppedRecords;      // No free RAM block (writer behind)
+    uint32_t blocks;              // Data blocks written
+    uint32_t partialBlocks;       // Written short because logging stopped
+    uint32_t writeErrors;
+    uint32_t payloadBytes;        // Record bytes
+    uint32_t writtenBytes;        // Bytes written to the card: blocks, headers, indexes
+    uint32_t flushAvgUs;          // Block write + flush, SD mutex held
+    uint32_t flushMaxUs;
+    uint32_t lockWaitMaxUs;       // Waiting for the SD mutex
+    uint32_t recoveredBlocks;     // Valid blocks in the unclosed segment found at boot
+    uint32_t tornBlocks;          // Damaged blocks found there
+};
+
+// ========== Functions (loop task) ==========
+// Start the writer task. Call after the SD card and its mutex are set up.
+void telemetryLogInit();
+
+// Take a record every TELEMETRY_PERIOD_MS while cfg.enable_logging is set;
+// a partly filled block is flushed when logging is switched off.
+void telemetryLogUpdate();
+
+// ========== Functions (any task) ==========
+TelemetryLogStats getTelemetryLogStats();
+
+// Record clock: Unix seconds with the RTC, else seconds since boot
+uint32_t telemetryClockNow();
+bool telemetryClockIsRtc();
+
+// Record clock at boot (0 without the RTC): RAM history time = clock - this
+uint32_t telemetryClockAtBoot();
+
+// machineState as a TelemetryMachineState code (loop task)
+uint8_t telemetryMachineState();
+
+// Bytes of a record with temps channels, and how many fit in a block
+size_t telemetryRecordSize(uint8_t temps);
+uint16_t telemetryRecordsPerBlock(uint8_t temps);
+
+// Record n of a block; channels beyond block.temps read HISTORY_NONE
+void telemetryBlockRecord(const TelemetryBlock& block, uint16_t n, TelemetryRecord& record);
+
+// Time of the first record of a block
+uint32_t telemetryBlockTime(const TelemetryBlock& block);
+
+// True if the block is intact (magic, record size, count and CRC)
+bool telemetryBlockValid(const TelemetryBlock& block);
+bool telemetryHeaderValid(const TelemetrySegmentHeader& header);
+
+// Path of a segment file ("bin") or its index ("idx")
+void telemetrySegmentPath(char* path, size_t len, uint32_t segment, const char* ext);
+
+#endif // TELEMETRY_LOG_H
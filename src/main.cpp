@@ -13,9 +13,19 @@
 #include "display/display.h"
 #include "display/screen_renderer.h"
 #include "display/ui_modes.h"
+#include "display/view_model.h"
+#include "display/layout_analyzer.h"
 #include "sensors/sensors.h"
+#include "sensors/psu_monitor.h"
+#include "sensors/fan_tach.h"
 #include "network/network.h"
 #include "utils/utils.h"
+#include "history/telemetry_log.h"
+#include "history/motion_trace.h"
+#include "utils/log.h"
+#include "utils/perf.h"
+#include "utils/heap_telemetry.h"
+#include "utils/stall_monitor.h"
 #include <LovyanGFX.hpp>
 #include <Wire.h>
 #include <RTClib.h>
@@ -67,27 +77,18 @@ WiFiManager wm;
 // Runtime variables
 DisplayMode currentMode;
 bool sdCardAvailable = false;
-volatile uint16_t tachCounter = 0;
 uint16_t fanRPM = 0;
 uint8_t fanSpeed = 0;
-float temperatures[4] = {0};
-float peakTemps[4] = {0};
+float* temperatures = nullptr;  // Allocated by initDS18B20Sensors()
+float* peakTemps = nullptr;
+uint8_t temperatureCount = 0;
 float psuVoltage = 0;
 float psuMin = 99.9;
 float psuMax = 0.0;
 
-// Non-blocking ADC sampling
-uint32_t adcSamples[5][10];  // 4 thermistors + 1 PSU, 10 samples each
-uint8_t adcSampleIndex = 0;
-uint8_t adcCurrentSensor = 0;
-unsigned long lastAdcSample = 0;
+// PSU block ready (set by sampleSensorsNonBlocking)
 bool adcReady = false;
 
-// Dynamic history buffer
-float *tempHistory = nullptr;
-uint16_t historySize = 0;
-uint16_t historyIndex = 0;
-
 // FluidNC status
 String machineState = "OFFLINE";
 float posX = 0, posY = 0, posZ = 0, posA = 0;
@@ -120,10 +121,10 @@ bool inAPMode = false;
 bool rtcAvailable = false;
 
 // Timing
-unsigned long lastTachRead = 0;
 unsigned long lastDisplayUpdate = 0;
 unsigned long lastHistoryUpdate = 0;
 unsigned long lastStatusRequest = 0;
+uint16_t layoutChannelGeneration = 0;  // Sensor channel generation the layouts were bound with
 unsigned long sessionStartTime = 0;
 unsigned long buttonPressStart = 0;
 bool buttonPressed = false;
@@ -136,15 +137,12 @@ String getAdminHTML();
 String getWiFiConfigHTML();
 String getConfigJSON();
 String getStatusJSON();
+void bindStatusSlots();
 // Display module functions are now in display/ui_modes.h and display/screen_renderer.h
 // Sensor functions are now in sensors/sensors.h
 // Network functions are now in network/network.h
 // Utility functions are now in utils/utils.h
 
-void IRAM_ATTR tachISR() {
-  tachCounter++;
-}
-
 // JSON parsing, screen rendering, and display modes are now in display module
 
 // ============ WEB SERVER HTML TEMPLATES (PROGMEM) ============
@@ -224,14 +222,15 @@ const char MAIN_HTML[] PROGMEM = R"rawliteral(
         .then(data => {
           document.getElementById('cnc_status').textContent = data.machine_state;
 
-          let maxTemp = Math.max(...data.temperatures);
+          let valid = data.temperatures.filter(t => t != null);
+          let maxTemp = Math.max(...valid);
           let tempEl = document.getElementById('max_temp');
-          tempEl.textContent = maxTemp.toFixed(1) + '°C';
-          tempEl.className = 'status-value ' +
-            (maxTemp > 50 ? 'temp-hot' : maxTemp > 35 ? 'temp-warn' : 'temp-ok');
+          tempEl.textContent = valid.length ? maxTemp.toFixed(1) + '°C' : '--';
+          tempEl.className = 'status-value ' + (!valid.length ? 'temp-hot' :
+            maxTemp > 50 ? 'temp-hot' : maxTemp > 35 ? 'temp-warn' : 'temp-ok');
 
           document.getElementById('fan_speed').textContent = data.fan_speed + '%';
-          document.getElementById('psu_volt').textContent = data.psu_voltage.toFixed(1) + 'V';
+          document.getElementById('psu_volt').textContent = data.psu_voltage == null ? '--' : data.psu_voltage.toFixed(1) + 'V';
         });
     }
 
@@ -450,9 +449,9 @@ const char ADMIN_HTML[] PROGMEM = R"rawliteral(
         .then(data => {
           let html = '';
           ['X', 'YL', 'YR', 'Z'].forEach((name, i) => {
-            html += `<div class='current-reading'>${name}: ${data.temperatures[i].toFixed(2)}°C</div>`;
+            html += `<div class='current-reading'>${name}: ${data.temperatures[i] == null ? '--' : data.temperatures[i].toFixed(2) + '°C'}</div>`;
           });
-          html += `<div class='current-reading'>PSU: ${data.psu_voltage.toFixed(2)}V</div>`;
+          html += `<div class='current-reading'>PSU: ${data.psu_voltage == null ? '--' : data.psu_voltage.toFixed(2) + 'V'}</div>`;
           document.getElementById('readings').innerHTML = html;
         });
     }
@@ -592,28 +591,32 @@ const char WIFI_CONFIG_HTML[] PROGMEM = R"rawliteral(
 
 // ============ WEB SERVER FUNCTIONS ============
 void setup() {
+#if HEAP_TAGGING
+  heapTaggingInit();  // Count allocations per HEAP_SCOPE site (utils/heap_telemetry.h)
+#endif
   Serial.begin(115200);
   delay(500);  // Give serial time to stabilize
-  Serial.println("\n\n=== FluidDash - Starting... ===");
+  LOGI("SETUP", "=== FluidDash - Starting... ===");
+  stallInit();  // Report stalls recorded before a watchdog reset
   
   // ========== PHASE 0: MUTEX & HARDWARE INIT (BEFORE ANYTHING ELSE) ==========
-  Serial.println("[SETUP] Phase 0: Initializing mutex and core hardware...");
+  LOGI("SETUP", "Phase 0: Initializing mutex and core hardware...");
   feedLoopWDT();
   initSDMutex();
 
   // SANITY CHECK - Halt if mutex initialization failed
   delay(100);  // Give it time to settle
   if (g_sdCardMutex == NULL) {
-    Serial.println("CRITICAL: Mutex is still NULL after initSDMutex()!");
-    Serial.println("System will crash. Halting.");
+    LOGE("SETUP", "CRITICAL: Mutex is still NULL after initSDMutex()!");
+    LOGE("SETUP", "System will crash. Halting.");
     while(1) {
       delay(1000);
-      Serial.println("HALTED - Mutex initialization failed");
+      LOGE("SETUP", "HALTED - Mutex initialization failed");
     }
   }
 
-  Serial.printf("MUTEX VERIFIED: 0x%p is valid\n", g_sdCardMutex);
-  Serial.println("[SETUP] ✓ SD mutex initialized and verified");
+  LOGI("SETUP", "MUTEX VERIFIED: 0x%p is valid", g_sdCardMutex);
+  LOGI("SETUP", "✓ SD mutex initialized and verified");
 
   feedLoopWDT();
   
@@ -622,17 +625,17 @@ void setup() {
 
   // Enable watchdog timer (10 seconds)
   enableLoopWDT();
-  Serial.println("[SETUP] ✓ Watchdog timer enabled (10s timeout)");
+  LOGI("SETUP", "✓ Watchdog timer enabled (10s timeout)");
 
   // ========== PHASE 1: DISPLAY & HARDWARE ==========
   // Initialize display
   feedLoopWDT();
-  Serial.println("[SETUP] Phase 1: Initializing display...");
+  LOGI("SETUP", "Phase 1: Initializing display...");
   gfx.init();
   gfx.setRotation(1);  // 90° rotation for landscape mode (480x320)
   gfx.setBrightness(255);
-  Serial.println("[SETUP] ✓ Display initialized");
-  gfx.fillScreen(COLOR_BG);
+  LOGI("SETUP", "✓ Display initialized");
+  calibrateRenderCost();  // Times a few invisible draws (includes the initial clear)
   showSplashScreen();
   delay(2000);  // Show splash briefly
 
@@ -642,10 +645,10 @@ void setup() {
 
   // Check if RTC is present
   if (!rtc.begin()) {
-    Serial.println("[SETUP] ⚠ RTC not found - time display will show 'No RTC'");
+    LOGW("SETUP", "⚠ RTC not found - time display will show 'No RTC'");
     rtcAvailable = false;
   } else {
-    Serial.println("[SETUP] ✓ RTC initialized");
+    LOGI("SETUP", "✓ RTC initialized");
     rtcAvailable = true;
   }
 
@@ -660,92 +663,70 @@ void setup() {
   ledcAttachPin(FAN_PWM, 0);
   ledcWrite(0, 0);
   pinMode(FAN_TACH, INPUT_PULLUP);
-  attachInterrupt(digitalPinToInterrupt(FAN_TACH), tachISR, FALLING);
-  Serial.println("[SETUP] ✓ ADC & PWM configured");
+  tachInit(FAN_TACH);
+  LOGI("SETUP", "✓ ADC & PWM configured");
 
   // Load configuration
   feedLoopWDT();
   loadConfig();
-  allocateHistoryBuffer();
 
-  // Initialize DS18B20 temperature sensors
+  // Initialize DS18B20 temperature sensors (mappings first - they size the channels)
   feedLoopWDT();
+  loadSensorConfig();
   initDS18B20Sensors();
-  Serial.println("[SETUP] ✓ Temperature sensors initialized");
+  psuMonitorInit();
+  allocateHistoryBuffer();  // Needs the channel count
+  LOGI("SETUP", "✓ Temperature sensors initialized");
 
   // ========== PHASE 2: SD CARD (SINGLE INITIALIZATION) ==========
-  Serial.println("[SETUP] Phase 2: Initializing SD card...");
+  LOGI("SETUP", "Phase 2: Initializing SD card...");
   feedLoopWDT();
   
-  SPIClass spiSD(VSPI);
+  // Static: SD keeps a reference, and the telemetry writer uses it after setup()
+  static SPIClass spiSD(VSPI);
   spiSD.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
 
   if (SD.begin(SD_CS, spiSD)) {
     sdCardAvailable = true;
-    Serial.println("[SETUP] ✓ SD card initialized");
+    LOGI("SETUP", "✓ SD card initialized");
     
     // Get card info
     uint8_t cardType = SD.cardType();
-    Serial.print("     Card Type: ");
-    if (cardType == CARD_MMC) {
-      Serial.println("MMC");
-    } else if (cardType == CARD_SD) {
-      Serial.println("SDSC");
-    } else if (cardType == CARD_SDHC) {
-      Serial.println("SDHC");
-    } else {
-      Serial.println("Unknown");
-    }
+    LOGI("SETUP", "     Card Type: %s", cardType == CARD_MMC ? "MMC" :
+                                            cardType == CARD_SD ? "SDSC" :
+                                            cardType == CARD_SDHC ? "SDHC" : "Unknown");
     
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
-    Serial.printf("     Card Size: %lluMB\n", cardSize);
+    LOGI("SETUP", "     Card Size: %lluMB", cardSize);
     
     // Create screens directory
     if (!SD.exists("/screens")) {
       if (SD.mkdir("/screens")) {
-        Serial.println("     Created directory: /screens");
+        LOGI("SETUP", "     Created directory: /screens");
       } else {
-        Serial.println("     ⚠ Failed to create /screens directory");
+        LOGW("SETUP", "     ⚠ Failed to create /screens directory");
       }
     } else {
-      Serial.println("     Directory exists: /screens");
+      LOGI("SETUP", "     Directory exists: /screens");
     }
     
     // Load JSON layouts (ONLY if SD is available)
     feedLoopWDT();
-    Serial.println("[SETUP] Loading JSON screen layouts...");
-    initDefaultLayouts();
-    
-    if (loadScreenConfig("/screens/monitor.json", monitorLayout)) {
-      Serial.println("     ✓ Monitor layout loaded");
-    } else {
-      Serial.println("     ⚠ Monitor layout not found, using fallback");
-    }
-    
-    if (loadScreenConfig("/screens/alignment.json", alignmentLayout)) {
-      Serial.println("     ✓ Alignment layout loaded");
-    }
-    
-    if (loadScreenConfig("/screens/graph.json", graphLayout)) {
-      Serial.println("     ✓ Graph layout loaded");
-    }
-    
-    if (loadScreenConfig("/screens/network.json", networkLayout)) {
-      Serial.println("     ✓ Network layout loaded");
-    }
-    
-    layoutsLoaded = true;
-    Serial.println("[SETUP] ✓ JSON layouts loaded");
+    LOGI("SETUP", "Loading JSON screen layouts...");
+    loadScreenLayouts();
+    LOGI("SETUP", "✓ JSON layouts loaded");
   } else {
     sdCardAvailable = false;
-    layoutsLoaded = false;
-    initDefaultLayouts();
-    Serial.println("[SETUP] ⚠ SD card not detected - using fallback layouts");
+    loadScreenLayouts();
+    LOGW("SETUP", "⚠ SD card not detected - using fallback layouts");
   }
+  layoutChannelGeneration = getSensorChannelGeneration();
+  telemetryLogInit();
+  motionTraceInit();
 
   // ========== PHASE 3: NETWORK (WIFI & WEB SERVER) ==========
   feedLoopWDT();
-  Serial.println("[SETUP] Phase 3: Connecting to network...");
+  LOGI("SETUP", "Phase 3: Connecting to network...");
   
   // Read WiFi credentials
   prefs.begin("fluiddash", true);
@@ -754,11 +735,11 @@ void setup() {
   prefs.end();
 
   if (wifi_ssid.length() > 0) {
-    Serial.printf("     Connecting to: %s\n", wifi_ssid.c_str());
+    LOGI("SETUP", "     Connecting to: %s", wifi_ssid.c_str());
     WiFi.mode(WIFI_STA);
     WiFi.begin(wifi_ssid.c_str(), wifi_pass.c_str());
   } else {
-    Serial.println("     No saved WiFi credentials");
+    LOGI("SETUP", "     No saved WiFi credentials");
     WiFi.mode(WIFI_STA);
   }
 
@@ -767,20 +748,18 @@ void setup() {
   int wifi_retry = 0;
   while (WiFi.status() != WL_CONNECTED && wifi_retry < 20) {
     delay(500);
-    Serial.print(".");
     wifi_retry++;
     feedLoopWDT();
   }
-  Serial.println();
 
   if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("[SETUP] ✓ WiFi connected: %s\n", WiFi.localIP().toString().c_str());
+    LOGI("SETUP", "✓ WiFi connected: %s", WiFi.localIP().toString().c_str());
     
     feedLoopWDT();
     
     // Set up mDNS
     if (MDNS.begin(cfg.device_name)) {
-      Serial.printf("     mDNS: http://%s.local\n", cfg.device_name);
+      LOGI("SETUP", "     mDNS: http://%s.local", cfg.device_name);
       MDNS.addService("http", "tcp", 80);
     }
 
@@ -793,17 +772,17 @@ void setup() {
       connectFluidNC();
     }
   } else {
-    Serial.println("[SETUP] ⚠ WiFi connection failed - standalone mode");
-    Serial.println("     Hold button for 10 seconds to enter WiFi config mode");
+    LOGW("SETUP", "⚠ WiFi connection failed - standalone mode");
+    LOGI("SETUP", "     Hold button for 10 seconds to enter WiFi config mode");
   }
 
   feedLoopWDT();
 
   // ========== PHASE 4: START WEB SERVER (LAST - AFTER MUTEX IS STABLE) ==========
-  Serial.println("[SETUP] Phase 4: Starting web server...");
+  LOGI("SETUP", "Phase 4: Starting web server...");
   feedLoopWDT();
   webServer.begin();
-  Serial.println("[SETUP] ✓ Web server started");
+  LOGI("SETUP", "✓ Web server started");
   
   feedLoopWDT();
 
@@ -816,11 +795,14 @@ void setup() {
   feedLoopWDT();
 
   // Draw main interface
-  Serial.println("[SETUP] Drawing main interface...");
+  LOGI("SETUP", "Drawing main interface...");
   drawScreen();
   feedLoopWDT();
 
-  Serial.println("\n[SETUP] ✓✓✓ Setup complete - entering main loop ✓✓✓\n");
+  perfInit();
+  stallStart();
+  LOGI("SETUP", "✓✓✓ Setup complete - entering main loop ✓✓✓");
+  logInit();  // From here on log lines are printed by the drain task
   feedLoopWDT();
 }
 
@@ -832,28 +814,72 @@ void loop() {
 
   // FTP server temporarily disabled
 
+  // Stage timing for /api/perf (see utils/perf.h); stallEnter() marks the
+  // running stage for the stall monitor (utils/stall_monitor.h)
+  perfLoopBegin();
+
+  stallEnter(PERF_BUTTON);
   handleButton();
+  perfPoll(PERF_BUTTON);
 
-  // Non-blocking ADC sampling (takes one sample every 5ms)
+  // Drain PSU ADC samples (one block every 50 ms)
+  stallEnter(PERF_PSU_SAMPLE);
   sampleSensorsNonBlocking();
+  perfPoll(PERF_PSU_SAMPLE);
+
+  // DS18B20 conversion/readout state machine (never waits on the bus)
+  stallEnter(PERF_TEMPERATURE);
+  updateTemperatureAcquisition();
+  perfPoll(PERF_TEMPERATURE);
+
+  // Sensors renumbered or renamed: "tempN", aliases and expressions in the
+  // layouts point at other channels now, so load and bind them again
+  if (layoutChannelGeneration != getSensorChannelGeneration()) {
+    stallEnter(PERF_DISPLAY);
+    perfStart();
+    layoutChannelGeneration = getSensorChannelGeneration();
+    LOGI("SENSORS", "Temperature channels changed, reloading layouts");
+    loadScreenLayouts();
+    drawScreen();
+    perfMark(PERF_DISPLAY);
+  }
 
-  // Process complete ADC readings when ready
+  // Process a completed PSU block
   if (adcReady) {
+    stallEnter(PERF_ADC);
+    perfStart();
     processAdcReadings();
+    perfMark(PERF_ADC);
+    stallEnter(PERF_FAN);
     controlFan();
+    perfMark(PERF_FAN);
     adcReady = false;
   }
 
-  if (millis() - lastTachRead >= 1000) {
-    calculateRPM();
-    lastTachRead = millis();
-  }
+  // Fan RPM (new period after every revolution)
+  stallEnter(PERF_TACH);
+  calculateRPM();
+  perfPoll(PERF_TACH);
 
-  if (millis() - lastHistoryUpdate >= (cfg.graph_update_interval * 1000)) {
+  // History store samples every channel at 1 Hz (graph_update_interval
+  // only sets the point spacing when drawing); heap telemetry every 20 s
+  if (millis() - lastHistoryUpdate >= 1000) {
+    stallEnter(PERF_HISTORY);
+    perfStart();
     updateTempHistory();
+    heapTelemetryUpdate();
+    perfMark(PERF_HISTORY);
     lastHistoryUpdate = millis();
   }
 
+  // SD telemetry log (records at 1 Hz while cfg.enable_logging is set);
+  // the motion trace records from parseFluidNCStatus()
+  stallEnter(PERF_RECORDERS);
+  perfStart();
+  telemetryLogUpdate();
+  motionTraceUpdate();
+  perfPoll(PERF_RECORDERS);
+
   // FluidNC WebSocket handling - throttled to prevent watchdog issues
   if (WiFi.status() == WL_CONNECTED) {
       static unsigned long lastWebSocketLoop = 0;
@@ -870,7 +896,10 @@ void loop() {
               attemptingConnection = true;
           }
 
+          stallEnter(PERF_WEBSOCKET);
+          perfStart();
           webSocket.loop();
+          perfMark(PERF_WEBSOCKET);
           lastWebSocketLoop = millis();
 
           // If connection succeeds, reset attempt tracking
@@ -896,7 +925,7 @@ void loop() {
       // Always poll for status - FluidNC doesn't have automatic reporting
       if (fluidncConnected && (millis() - lastStatusRequest >= cfg.status_update_rate)) {
           if (debugWebSocket) {
-              Serial.println("[FluidNC] Sending status request");
+              LOGD("FluidNC", "Sending status request");
           }
           webSocket.sendTXT("?");
           lastStatusRequest = millis();
@@ -905,20 +934,26 @@ void loop() {
       // Periodic debug output (only every 10 seconds now)
       static unsigned long lastDebug = 0;
       if (debugWebSocket && millis() - lastDebug >= 10000) {
-          Serial.printf("[DEBUG] State:%s MPos:(%.2f,%.2f,%.2f,%.2f) WPos:(%.2f,%.2f,%.2f,%.2f)\n",
-                        machineState.c_str(),
-                        posX, posY, posZ, posA,
-                        wposX, wposY, wposZ, wposA);
+          LOGD("FluidNC", "State:%s MPos:(%.2f,%.2f,%.2f,%.2f) WPos:(%.2f,%.2f,%.2f,%.2f)",
+               machineState.c_str(),
+               posX, posY, posZ, posA,
+               wposX, wposY, wposZ, wposA);
           lastDebug = millis();
       }
   }
 
 
   if (millis() - lastDisplayUpdate >= 1000) {
+    stallEnter(PERF_DISPLAY);
+    perfStart();
     updateDisplay();
+    perfMark(PERF_DISPLAY);
     lastDisplayUpdate = millis();
   }
 
+  perfLoopEnd();
+  stallEnter(PERF_LOOP);
+
   // Short yield instead of delay for better responsiveness
   yield();
 }
@@ -939,6 +974,7 @@ void loop() {
 // Current implementation is acceptable for occasional web interface access.
 
 String getMainHTML() {
+  HEAP_SCOPE(HEAP_WEB, "getMainHTML");
   String html = String(FPSTR(MAIN_HTML));
 
   // Replace all placeholders with dynamic content
@@ -950,6 +986,7 @@ String getMainHTML() {
 }
 
 String getSettingsHTML() {
+  HEAP_SCOPE(HEAP_WEB, "getSettingsHTML");
   String html = String(FPSTR(SETTINGS_HTML));
 
   // Replace numeric input values
@@ -981,6 +1018,7 @@ String getSettingsHTML() {
 }
 
 String getAdminHTML() {
+  HEAP_SCOPE(HEAP_WEB, "getAdminHTML");
   String html = String(FPSTR(ADMIN_HTML));
 
   // Replace calibration offset values (with 2 decimal places for temp)
@@ -996,6 +1034,7 @@ String getAdminHTML() {
 }
 
 String getWiFiConfigHTML() {
+  HEAP_SCOPE(HEAP_WEB, "getWiFiConfigHTML");
   String html = String(FPSTR(WIFI_CONFIG_HTML));
 
   // Get current WiFi status
@@ -1025,6 +1064,7 @@ String getWiFiConfigHTML() {
 // ========== JSON API Functions ==========
 
 String getConfigJSON() {
+  HEAP_SCOPE(HEAP_WEB, "getConfigJSON");
   String json = "{";
   json += "\"device_name\":\"" + String(cfg.device_name) + "\",";
   json += "\"fluidnc_ip\":\"" + String(cfg.fluidnc_ip) + "\",";
@@ -1034,32 +1074,65 @@ String getConfigJSON() {
   json += "\"psu_low\":" + String(cfg.psu_alert_low) + ",";
   json += "\"psu_high\":" + String(cfg.psu_alert_high) + ",";
   json += "\"graph_time\":" + String(cfg.graph_timespan_seconds) + ",";
-  json += "\"graph_interval\":" + String(cfg.graph_update_interval);
+  json += "\"graph_interval\":" + String(cfg.graph_update_interval) + ",";
+  json += "\"logging\":" + String(cfg.enable_logging ? "true" : "false") + ",";
+  json += "\"trace\":" + String(cfg.enable_trace ? "true" : "false");
   json += "}";
   return json;
 }
 
+// View-model slots used by the status API (bound before the layouts on every
+// load, so the async_tcp task only ever copies pre-formatted bytes). The
+// temperatures come from the view model's channel list, not from slots.
+static uint8_t statusStateSlot;
+static uint8_t statusPsuSlot;
+static uint8_t statusWposSlots[3];
+static uint8_t statusMposSlots[3];
+
+void bindStatusSlots() {
+  statusStateSlot = viewModelBind(DS_MACHINE_STATE, FMT_RAW, 0);
+  statusPsuSlot = viewModelBind(DS_PSU_VOLTAGE, FMT_FIXED, 2);
+  statusWposSlots[0] = viewModelBind(DS_WPOS_X, FMT_FIXED, 3);
+  statusWposSlots[1] = viewModelBind(DS_WPOS_Y, FMT_FIXED, 3);
+  statusWposSlots[2] = viewModelBind(DS_WPOS_Z, FMT_FIXED, 3);
+  statusMposSlots[0] = viewModelBind(DS_POS_X, FMT_FIXED, 3);
+  statusMposSlots[1] = viewModelBind(DS_POS_Y, FMT_FIXED, 3);
+  statusMposSlots[2] = viewModelBind(DS_POS_Z, FMT_FIXED, 3);
+}
+
+// A slot's text as a JSON number: "null" when stale or not bound
+static void copyStatusNumber(uint8_t slot, char* dst) {
+  if (viewModelCopy(slot, dst, VM_TEXT_LEN) == 0 || strcmp(dst, "--") == 0) {
+    strcpy(dst, "null");
+  }
+}
+
 String getStatusJSON() {
-  String json = "{";
-  json += "\"machine_state\":\"" + machineState + "\",";
-  json += "\"temperatures\":[";
-  for (int i = 0; i < 4; i++) {
-    json += String(temperatures[i], 2);
-    if (i < 3) json += ",";
+  HEAP_SCOPE(HEAP_WEB, "getStatusJSON");
+  char temps[VM_MAX_TEMP_SOURCES * 12];
+  char psu[VM_TEXT_LEN], wpos[3][VM_TEXT_LEN], mpos[3][VM_TEXT_LEN];
+  char state[VM_TEXT_LEN];
+
+  viewModelCopyTemperatures(temps, sizeof(temps));
+  for (int i = 0; i < 3; i++) {
+    copyStatusNumber(statusWposSlots[i], wpos[i]);
+    copyStatusNumber(statusMposSlots[i], mpos[i]);
   }
-  json += "],";
-  json += "\"fan_speed\":" + String(fanSpeed) + ",";
-  json += "\"fan_rpm\":" + String(fanRPM) + ",";
-  json += "\"psu_voltage\":" + String(psuVoltage, 2) + ",";
-  json += "\"wpos_x\":" + String(wposX, 3) + ",";
-  json += "\"wpos_y\":" + String(wposY, 3) + ",";
-  json += "\"wpos_z\":" + String(wposZ, 3) + ",";
-  json += "\"mpos_x\":" + String(posX, 3) + ",";
-  json += "\"mpos_y\":" + String(posY, 3) + ",";
-  json += "\"mpos_z\":" + String(posZ, 3) + ",";
-  json += "\"connected\":" + String(fluidncConnected ? "true" : "false");
-  json += "}";
-  return json;
+  copyStatusNumber(statusPsuSlot, psu);
+  viewModelCopy(statusStateSlot, state, sizeof(state));
+
+  char json[384 + sizeof(temps)];
+  snprintf(json, sizeof(json),
+           "{\"machine_state\":\"%s\",\"temperatures\":[%s],"
+           "\"fan_speed\":%u,\"fan_rpm\":%u,\"psu_voltage\":%s,"
+           "\"wpos_x\":%s,\"wpos_y\":%s,\"wpos_z\":%s,"
+           "\"mpos_x\":%s,\"mpos_y\":%s,\"mpos_z\":%s,\"connected\":%s}",
+           state, temps,
+           fanSpeed, fanRPM, psu,
+           wpos[0], wpos[1], wpos[2],
+           mpos[0], mpos[1], mpos[2],
+           fluidncConnected ? "true" : "false");
+  return String(json);
 }
 
 // ========== FluidNC Connection ==========
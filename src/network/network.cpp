@@ -1,5 +1,10 @@
 #include "network.h"
 #include "config/config.h"
+#include "display/view_model.h"
+#include "history/motion_trace.h"
+#include "utils/log.h"
+#include "utils/event_trace.h"
+#include "utils/heap_telemetry.h"
 #include <WiFi.h>
 #include <WiFiManager.h>
 #include <WebSocketsClient.h>
@@ -20,16 +25,16 @@ void setupWiFiManager() {
 // ========== FluidNC Connection ==========
 
 void connectFluidNC() {
-    Serial.printf("[FluidNC] Attempting to connect to ws://%s:%d/ws\n",
-                  cfg.fluidnc_ip, cfg.fluidnc_port);
+    LOGI("FluidNC", "Attempting to connect to ws://%s:%d/ws",
+         cfg.fluidnc_ip, cfg.fluidnc_port);
     webSocket.begin(cfg.fluidnc_ip, cfg.fluidnc_port, "/ws");  // Add /ws path
     webSocket.onEvent(fluidNCWebSocketEvent);
     webSocket.setReconnectInterval(10000);  // 10 seconds between reconnect attempts
-    Serial.println("[FluidNC] WebSocket initialized (reconnect: 10s), device can run without FluidNC");
+    LOGI("FluidNC", "WebSocket initialized (reconnect: 10s), device can run without FluidNC");
 }
 
 void discoverFluidNC() {
-  Serial.println("Auto-discovering FluidNC...");
+  LOGI("FluidNC", "Auto-discovering FluidNC...");
 
   // Try mDNS discovery first
   int n = MDNS.queryService("http", "tcp");
@@ -38,29 +43,33 @@ void discoverFluidNC() {
     if (hostname.indexOf("fluidnc") >= 0) {
       IPAddress ip = MDNS.IP(i);
       strlcpy(cfg.fluidnc_ip, ip.toString().c_str(), sizeof(cfg.fluidnc_ip));
-      Serial.printf("Found FluidNC at: %s\n", cfg.fluidnc_ip);
+      LOGI("FluidNC", "Found FluidNC at: %s", cfg.fluidnc_ip);
       connectFluidNC();
       return;
     }
   }
 
   // Fallback to configured IP
-  Serial.println("Using configured FluidNC IP");
+  LOGI("FluidNC", "Using configured FluidNC IP");
   connectFluidNC();
 }
 
 void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
+    EVT_SCOPE("ws_event");
+    HEAP_SCOPE(HEAP_NETWORK, "fluidNCWebSocketEvent");
     switch(type) {
         case WStype_DISCONNECTED:
-            Serial.println("[FluidNC] Disconnected!");
+            LOGW("FluidNC", "Disconnected!");
             fluidncConnected = false;
             machineState = "OFFLINE";
+            viewModelUpdate();
             break;
 
         case WStype_CONNECTED:
-            Serial.printf("[FluidNC] Connected to: %s\n", payload);
+            LOGI("FluidNC", "Connected to: %s", payload);
             fluidncConnected = true;
             machineState = "IDLE";
+            viewModelUpdate();
 
             // DON'T send ReportInterval - FluidNC doesn't support it
             // We'll use manual polling with ? status requests
@@ -71,11 +80,7 @@ void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
             {
                 char* msg = (char*)payload;
                 if (debugWebSocket) {
-                    Serial.printf("[FluidNC] RX TEXT (%d bytes): ", length);
-                    for(size_t i = 0; i < length; i++) {
-                        Serial.print(msg[i]);
-                    }
-                    Serial.println();
+                    LOGD("FluidNC", "RX TEXT (%d bytes): %.*s", length, (int)length, msg);
                 }
 
                 String msgStr = String(msg);
@@ -91,10 +96,6 @@ void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
         case WStype_BIN:
             {
                 // FluidNC sends status as BINARY data
-                if (debugWebSocket) {
-                    Serial.printf("[FluidNC] RX BINARY (%d bytes): ", length);
-                }
-
                 // Convert binary payload to null-terminated string
                 char* msg = (char*)malloc(length + 1);
                 if (msg != nullptr) {
@@ -102,7 +103,7 @@ void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
                     msg[length] = '\0';
 
                     if (debugWebSocket) {
-                        Serial.println(msg);
+                        LOGD("FluidNC", "RX BINARY (%d bytes): %s", length, msg);
                     }
 
                     // Parse the status message
@@ -111,13 +112,13 @@ void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
 
                     free(msg);
                 } else {
-                    Serial.println("[FluidNC] ERROR: Failed to allocate memory");
+                    LOGE("FluidNC", "Failed to allocate memory");
                 }
             }
             break;
 
         case WStype_ERROR:
-            Serial.println("[FluidNC] WebSocket Error!");
+            LOGE("FluidNC", "WebSocket Error!");
             break;
 
         case WStype_PING:
@@ -129,13 +130,15 @@ void fluidNCWebSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
 
         default:
             if (debugWebSocket) {
-                Serial.printf("[FluidNC] Event type: %d\n", type);
+                LOGD("FluidNC", "Event type: %d", type);
             }
             break;
     }
 }
 
 void parseFluidNCStatus(String status) {
+    EVT_SCOPE("parseFluidNCStatus");
+    HEAP_SCOPE(HEAP_NETWORK, "parseFluidNCStatus");
     String oldState = machineState;
 
     // Parse state (between < and |)
@@ -247,4 +250,8 @@ void parseFluidNCStatus(String status) {
         String ovStr = status.substring(ovIndex + 3, endIndex);
         sscanf(ovStr.c_str(), "%d,%d,%d", &feedOverride, &rapidOverride, &spindleOverride);
     }
+
+    // Reformat only the display values that changed
+    viewModelUpdate();
+    motionTraceReport();
 }
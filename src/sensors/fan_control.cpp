@@ -0,0 +1,200 @@
+#include "fan_control.h"
+#include "config/config.h"
+#include "utils/log.h"
+
+static FanControlStatus status = {};
+static bool started = false;
+static uint32_t lastMs = 0;
+static uint32_t stateMs = 0;        // Entry time of the current state
+static uint8_t kicksInRow = 0;
+static float curveTemp = NAN;       // Temperature the curve is evaluated at
+static float lastTemp = NAN;
+static float slope = 0;             // °C/s, smoothed, for the D term
+static float handoverDemand = NAN;  // Demand to continue from when the PID (re)starts
+
+void fanControlReset() {
+    uint32_t kicks = status.kicks;
+    uint32_t faults = status.faults;
+    status = {};
+    status.kicks = kicks;
+    status.faults = faults;
+    started = false;
+    kicksInRow = 0;
+    curveTemp = NAN;
+    lastTemp = NAN;
+    slope = 0;
+    handoverDemand = NAN;
+}
+
+const FanControlStatus& getFanControlStatus() {
+    return status;
+}
+
+// ========== Demand ==========
+
+static float clampSpeed(float speed) {
+    return constrain(speed, (float)cfg.fan_min_speed, (float)cfg.fan_max_speed_limit);
+}
+
+// Rising temperatures move along the curve at once; falling ones only
+// after dropping fan_hysteresis below the point last used
+static float curveDemand(float tempC) {
+    if (isnan(curveTemp) || tempC > curveTemp) {
+        curveTemp = tempC;
+    } else if (tempC < curveTemp - cfg.fan_hysteresis) {
+        curveTemp = tempC + cfg.fan_hysteresis;
+    }
+
+    float span = cfg.temp_threshold_high - cfg.temp_threshold_low;
+    float position = span > 0 ? (curveTemp - cfg.temp_threshold_low) / span : (curveTemp >= cfg.temp_threshold_high);
+    position = constrain(position, 0.0f, 1.0f);
+    return cfg.fan_min_speed + position * (cfg.fan_max_speed_limit - cfg.fan_min_speed);
+}
+
+static float pidDemand(float tempC, float dt) {
+    float error = tempC - cfg.fan_target_temp;
+
+    // Derivative on the measurement (no kick on setpoint changes), smoothed:
+    // the DS18B20 channels only move once per conversion
+    if (!isnan(lastTemp) && dt > 0) {
+        slope += 0.1f * ((tempC - lastTemp) / dt - slope);
+    }
+    lastTemp = tempC;
+
+    float proportional = FAN_PID_KP * error;
+    float derivative = FAN_PID_KD * slope;
+    if (!isnan(handoverDemand)) {
+        status.integral = handoverDemand - proportional;
+        handoverDemand = NAN;
+    }
+    float output = proportional + status.integral + derivative;
+
+    // Integrate only while the output is not pinned in the direction the
+    // error pushes (anti-windup)
+    bool pinnedHigh = output >= cfg.fan_max_speed_limit && error > 0;
+    bool pinnedLow = output <= cfg.fan_min_speed && error < 0;
+    if (!pinnedHigh && !pinnedLow) {
+        status.integral += FAN_PID_KI * error * dt;
+        status.integral = constrain(status.integral, -100.0f, 100.0f);
+    }
+    return clampSpeed(proportional + status.integral + derivative);
+}
+
+// ========== Duty ==========
+
+// RPM targeting: integrate the RPM error into a bounded duty trim
+static float trimmedDuty(float demand, uint16_t rpm, bool tachPresent, float dt) {
+    if (cfg.fan_max_rpm == 0 || !tachPresent || demand <= 0) {
+        status.targetRpm = 0;
+        status.trim = 0;
+        return demand;
+    }
+
+    status.targetRpm = demand * cfg.fan_max_rpm / 100.0f;
+    float errorPct = ((float)status.targetRpm - rpm) * 100.0f / cfg.fan_max_rpm;
+    float duty = demand + status.trim;
+    bool pinnedHigh = duty >= cfg.fan_max_speed_limit && errorPct > 0;
+    bool pinnedLow = duty <= 0 && errorPct < 0;
+    if (!pinnedHigh && !pinnedLow) {
+        status.trim += FAN_RPM_KI * errorPct * dt;
+        status.trim = constrain(status.trim, -FAN_TRIM_LIMIT, FAN_TRIM_LIMIT);
+    }
+    return constrain(demand + status.trim, 0.0f, (float)cfg.fan_max_speed_limit);
+}
+
+static void enterState(FanState state, uint32_t nowMs) {
+    status.state = state;
+    stateMs = nowMs;
+}
+
+// Stall handling: kick, and after FAN_KICK_MAX kicks in a row run at full
+// duty and retry periodically. Returns the duty override, or NAN.
+static float stallOverride(bool stalled, bool tachPresent, uint32_t nowMs) {
+    float full = cfg.fan_max_speed_limit;
+    switch (status.state) {
+        case FAN_STATE_RUN:
+            if (!stalled) {
+                kicksInRow = 0;
+                return NAN;
+            }
+            if (!tachPresent || status.demand <= 0 || nowMs - stateMs < FAN_KICK_SETTLE_MS) return NAN;
+            if (kicksInRow >= FAN_KICK_MAX) {
+                status.faults++;
+                LOGW("FAN", "Fault: still stalled after %d kicks, running at %d%%",
+                     kicksInRow, cfg.fan_max_speed_limit);
+                enterState(FAN_STATE_FAULT, nowMs);
+                return full;
+            }
+            kicksInRow++;
+            status.kicks++;
+            LOGW("FAN", "Stalled at %.0f%% - spin-up kick %d/%d",
+                 status.duty, kicksInRow, FAN_KICK_MAX);
+            status.trim = 0;
+            enterState(FAN_STATE_KICK, nowMs);
+            return full;
+
+        case FAN_STATE_KICK:
+            if (nowMs - stateMs >= FAN_KICK_MS) {
+                enterState(FAN_STATE_RUN, nowMs);
+                return NAN;
+            }
+            return full;
+
+        case FAN_STATE_FAULT:
+        default:
+            if (!stalled) {
+                LOGI("FAN", "Recovered from stall fault");
+                kicksInRow = 0;
+                enterState(FAN_STATE_RUN, nowMs);
+                return NAN;
+            }
+            if (nowMs - stateMs >= FAN_FAULT_RETRY_MS) {
+                status.kicks++;
+                enterState(FAN_STATE_KICK, nowMs);
+            }
+            return full;
+    }
+}
+
+uint8_t fanControlUpdate(float tempC, uint16_t rpm, bool stalled, bool tachPresent, uint32_t nowMs) {
+    float dt = started ? min(nowMs - lastMs, (uint32_t)1000) / 1000.0f : 0;
+    lastMs = nowMs;
+
+    // Mode switch: start the PID where the curve left off (bumpless)
+    if (!started || status.mode != cfg.fan_mode) {
+        status.mode = cfg.fan_mode;
+        handoverDemand = started ? status.demand : cfg.fan_min_speed;
+        lastTemp = NAN;
+        slope = 0;
+        curveTemp = NAN;
+        if (!started) stateMs = nowMs;
+        started = true;
+    }
+
+    // Every channel stale or absent: cool at the limit until one is back,
+    // then continue from there
+    bool noTemp = isnan(tempC);
+    if (noTemp != status.noTemp) {
+        if (noTemp) {
+            LOGW("FAN", "No valid temperature channel - running at %d%%", cfg.fan_max_speed_limit);
+        } else {
+            LOGI("FAN", "Temperature back at %.1fC", tempC);
+        }
+        status.noTemp = noTemp;
+    }
+    if (noTemp) {
+        status.demand = cfg.fan_max_speed_limit;
+        handoverDemand = status.demand;
+        lastTemp = NAN;
+        slope = 0;
+    } else {
+        status.demand = (status.mode == FAN_MODE_PID) ? pidDemand(tempC, dt) : curveDemand(tempC);
+    }
+
+    float duty = stallOverride(stalled, tachPresent, nowMs);
+    if (isnan(duty)) {
+        duty = trimmedDuty(status.demand, rpm, tachPresent, dt);
+    }
+    status.duty = duty;
+    return (uint8_t)lroundf(duty * 2.55f);
+}
@@ -0,0 +1,59 @@
+#ifndef FAN_CONTROL_H
+#define FAN_CONTROL_H
+
+#include <Arduino.h>
+
+// ========== Fan Control Engine ==========
+// Two stages, run on every PSU block (~20 Hz):
+//   1. demand - % speed from the hottest temperature channel, either the
+//      threshold curve with hysteresis (FAN_MODE_CURVE) or a PID holding
+//      cfg.fan_target_temp (FAN_MODE_PID)
+//   2. duty   - with cfg.fan_max_rpm set, the demand becomes an RPM target
+//      and an integral trim corrects the duty from the measured RPM.
+//      A stalled fan is kicked at full duty to restart it.
+// Pure logic: the caller measures and writes the PWM (see controlFan()).
+
+#define FAN_PID_KP            14.0    // % per °C above target
+#define FAN_PID_KI            0.07    // % per °C·s
+#define FAN_PID_KD            0.0     // % per °C/s (on the measurement). Off: the 1 Hz
+                                      // DS18B20 steps make it noise and PWM writes
+#define FAN_RPM_KI            0.5     // % duty per s per % of max RPM error. Higher rings
+                                      // against the ~2 s spin-up lag of a PC fan
+#define FAN_TRIM_LIMIT        30.0f   // % duty the RPM loop may add or remove
+#define FAN_KICK_MS           1000    // Full-duty spin-up pulse
+#define FAN_KICK_SETTLE_MS    3000    // Wait after a kick before judging the tach again
+#define FAN_KICK_MAX          3       // Kicks in a row before declaring a fault
+#define FAN_FAULT_RETRY_MS    30000   // Kick interval while faulted
+
+enum FanState {
+    FAN_STATE_RUN,
+    FAN_STATE_KICK,       // Spin-up pulse after a stall
+    FAN_STATE_FAULT       // Still stalled after FAN_KICK_MAX kicks - full duty, periodic retry
+};
+
+struct FanControlStatus {
+    uint8_t mode;         // FanMode in use
+    uint8_t state;        // FanState
+    float demand;         // % speed from the curve or PID
+    float duty;           // % duty after the RPM trim and stall handling
+    uint16_t targetRpm;   // 0 when running open loop
+    float trim;           // % duty added by the RPM loop
+    float integral;       // PID integral term (%)
+    uint32_t kicks;
+    uint32_t faults;
+    bool noTemp;          // No valid temperature: demand is cfg.fan_max_speed_limit
+};
+
+// ========== Functions ==========
+// Forget controller state (integrators, hysteresis, stall handling)
+void fanControlReset();
+
+// Advance the controller. tempC is the hottest channel (NAN when every
+// channel is stale: full speed up to the limit), rpm/stalled come
+// from the tachometer; tachPresent is false until it has seen a revolution
+// (no stall handling without a tach). Returns the PWM duty, 0-255.
+uint8_t fanControlUpdate(float tempC, uint16_t rpm, bool stalled, bool tachPresent, uint32_t nowMs);
+
+const FanControlStatus& getFanControlStatus();
+
+#endif // FAN_CONTROL_H
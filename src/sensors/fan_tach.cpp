@@ -0,0 +1,189 @@
+#include "fan_tach.h"
+#include "utils/log.h"
+#include <freertos/FreeRTOS.h>
+
+#ifdef TACH_PCNT_SOURCE
+#include <driver/pcnt.h>
+#endif
+
+#define TACH_RING           8       // Revolution periods buffered between updates
+#define TACH_MIN_PERIOD_US  (60000000UL / TACH_MAX_RPM)
+
+// Written by the revolution event (ISR on target), read by tachUpdate()
+static volatile uint32_t ringPeriodUs[TACH_RING];
+static volatile uint32_t eventCount = 0;
+static volatile uint32_t lastEventUs = 0;
+static portMUX_TYPE tachMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Loop task only
+static TachStats stats = {};
+static uint32_t consumed = 0;
+static uint32_t pendingUs = 0;      // Step waiting for confirmation
+
+// One revolution ended at now. The first event after init has no period.
+static void IRAM_ATTR recordRevolution(uint32_t now) {
+    portENTER_CRITICAL_ISR(&tachMux);
+    ringPeriodUs[eventCount % TACH_RING] = eventCount ? now - lastEventUs : 0;
+    lastEventUs = now;
+    eventCount++;
+    portEXIT_CRITICAL_ISR(&tachMux);
+}
+
+// ========== Period Filter ==========
+
+// +1 / -1 when periodUs is longer / shorter than the tolerance allows, else 0
+static int8_t stepDirection(uint32_t periodUs, uint32_t referenceUs) {
+    uint64_t scaled = (uint64_t)periodUs * 100;
+    if (scaled > (uint64_t)referenceUs * (100 + TACH_STEP_TOLERANCE)) return 1;
+    if (scaled < (uint64_t)referenceUs * (100 - TACH_STEP_TOLERANCE)) return -1;
+    return 0;
+}
+
+static void acceptPeriod(uint32_t periodUs) {
+    // No period yet, or the first revolution after a stall: just a restart
+    if (periodUs == 0 || periodUs > TACH_STALL_US) return;
+
+    if (periodUs < TACH_MIN_PERIOD_US) {
+        stats.glitches++;
+        return;
+    }
+
+    // A fan cannot change speed by this much within one revolution. A real
+    // step moves the next period the same way too; a split or merged pulse
+    // is followed by a normal period (the first revolution of a step is
+    // partly at the old speed, so the second one is what gets used)
+    int8_t step = stats.periodUs != 0 ? stepDirection(periodUs, stats.periodUs) : 0;
+    if (step != 0 && (pendingUs == 0 || stepDirection(pendingUs, stats.periodUs) != step)) {
+        pendingUs = periodUs;
+        stats.glitches++;
+        return;
+    }
+
+    pendingUs = 0;
+    stats.periodUs = periodUs;
+    stats.revolutions++;
+    stats.stalled = false;
+}
+
+uint16_t tachUpdate() {
+    uint32_t periods[TACH_RING];
+
+    portENTER_CRITICAL(&tachMux);
+    uint32_t count = eventCount;
+    uint32_t eventUs = lastEventUs;
+    uint32_t fresh = count - consumed;
+    if (fresh > TACH_RING) {
+        stats.lostPeriods += fresh - TACH_RING;
+        fresh = TACH_RING;
+    }
+    for (uint32_t i = 0; i < fresh; i++) {
+        periods[i] = ringPeriodUs[(count - fresh + i) % TACH_RING];
+    }
+    portEXIT_CRITICAL(&tachMux);
+    consumed = count;
+
+    for (uint32_t i = 0; i < fresh; i++) {
+        acceptPeriod(periods[i]);
+    }
+
+    // The event may land between the snapshot and now
+    uint32_t elapsed = micros() - eventUs;
+    if ((int32_t)elapsed < 0) elapsed = 0;
+
+    if (elapsed > TACH_STALL_US) {
+        if (!stats.stalled) stats.stalls++;
+        stats.stalled = true;
+        stats.periodUs = 0;
+        pendingUs = 0;
+    }
+
+    if (stats.periodUs == 0) {
+        stats.rpm = 0;
+        return 0;
+    }
+
+    uint32_t rpm = (60000000UL + stats.periodUs / 2) / stats.periodUs;
+    // Slowing down: the revolution in progress is already longer than the
+    // last one, which bounds the speed before it completes
+    if (elapsed > stats.periodUs + stats.periodUs / 4) {
+        rpm = min(rpm, (uint32_t)(60000000UL / elapsed));
+    }
+    stats.rpm = rpm;
+    return stats.rpm;
+}
+
+const TachStats& getTachStats() {
+    return stats;
+}
+
+#ifdef TACH_PCNT_SOURCE
+// ========== Pulse Counter (target) ==========
+// PCNT unit 0 counts falling edges and interrupts when the count reaches
+// one revolution (h_lim), resetting itself - one interrupt per revolution
+// instead of one per pulse, whatever the speed.
+
+static void IRAM_ATTR onPcntLimit(void*) {
+    recordRevolution(micros());
+}
+
+bool tachInit(uint8_t pin) {
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = pin;
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.channel = PCNT_CHANNEL_0;
+    config.unit = PCNT_UNIT_0;
+    config.pos_mode = PCNT_COUNT_DIS;
+    config.neg_mode = PCNT_COUNT_INC;   // Open-collector output pulls low
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.counter_h_lim = TACH_PULSES_PER_REV;
+    config.counter_l_lim = -1;
+
+    if (pcnt_unit_config(&config) != ESP_OK) {
+        LOGE("FAN", "PCNT config failed");
+        return false;
+    }
+    pcnt_set_filter_value(PCNT_UNIT_0, 1023);   // 12.8 us at 80 MHz APB
+    pcnt_filter_enable(PCNT_UNIT_0);
+    pcnt_event_enable(PCNT_UNIT_0, PCNT_EVT_H_LIM);
+    pcnt_counter_pause(PCNT_UNIT_0);
+    pcnt_counter_clear(PCNT_UNIT_0);
+
+    esp_err_t err = pcnt_isr_service_install(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // Already installed is fine
+        LOGE("FAN", "PCNT ISR service failed");
+        return false;
+    }
+    pcnt_isr_handler_add(PCNT_UNIT_0, onPcntLimit, nullptr);
+
+    lastEventUs = micros();
+    pcnt_counter_resume(PCNT_UNIT_0);
+    LOGI("FAN", "Tach on GPIO%d: PCNT, %d pulses/rev, period measurement",
+         pin, TACH_PULSES_PER_REV);
+    return true;
+}
+
+#else
+// ========== Software Edge Source (host) ==========
+// Same behaviour as the PCNT path: edges inside the filter window are
+// dropped, and every TACH_PULSES_PER_REV edges close a revolution.
+
+static uint8_t edgeCount = 0;
+static uint32_t lastEdgeUs = 0;
+static bool haveEdge = false;
+
+void tachSimulateEdge(uint32_t timeUs) {
+    if (haveEdge && timeUs - lastEdgeUs < TACH_FILTER_US) return;
+    haveEdge = true;
+    lastEdgeUs = timeUs;
+    if (++edgeCount < TACH_PULSES_PER_REV) return;
+    edgeCount = 0;
+    recordRevolution(timeUs);
+}
+
+bool tachInit(uint8_t pin) {
+    lastEventUs = micros();
+    LOGI("FAN", "Tach on GPIO%d: software edge source", pin);
+    return true;
+}
+#endif
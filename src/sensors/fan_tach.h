@@ -0,0 +1,50 @@
+#ifndef FAN_TACH_H
+#define FAN_TACH_H
+
+#include <Arduino.h>
+
+// ========== Fan Tachometer ==========
+// RPM from the revolution period instead of a pulse count per second.
+// Edges are counted in hardware and one event is raised per revolution;
+// the event timestamp gives the period, so a new reading is available
+// after every revolution with microsecond resolution.
+//
+// Edge source: the ESP32 pulse counter (PCNT, with its glitch filter) when
+// the IDF driver is available, otherwise - host builds, or
+// TACH_SOFTWARE_SOURCE defined - edges fed through tachSimulateEdge().
+
+#if __has_include(<driver/pcnt.h>) && !defined(TACH_SOFTWARE_SOURCE)
+#define TACH_PCNT_SOURCE 1
+#endif
+
+#define TACH_PULSES_PER_REV   2         // Standard PC fan tach output
+#define TACH_MAX_RPM          20000     // Shorter periods are glitches
+#define TACH_STALL_US         2000000   // No revolution for 2 s = stalled (below 30 RPM)
+#define TACH_STEP_TOLERANCE   40        // % period change accepted without confirmation
+#define TACH_FILTER_US        12        // Edges closer than this are noise (PCNT filter, 1023 APB cycles)
+
+struct TachStats {
+    uint16_t rpm;
+    uint32_t periodUs;        // Last accepted revolution period (0 = none)
+    uint32_t revolutions;     // Accepted periods
+    uint32_t glitches;        // Periods rejected (too short, or an unconfirmed step)
+    uint32_t stalls;          // Transitions into the stalled state
+    uint32_t lostPeriods;     // Revolutions that overran the ISR ring between updates
+    bool stalled;
+};
+
+// ========== Functions ==========
+// Configure the edge source on pin (falling edges)
+bool tachInit(uint8_t pin);
+
+// Consume new revolution periods and return the current RPM - call every loop()
+uint16_t tachUpdate();
+
+const TachStats& getTachStats();
+
+#ifndef TACH_PCNT_SOURCE
+// Software edge source: one falling edge at timeUs (micros() time base)
+void tachSimulateEdge(uint32_t timeUs);
+#endif
+
+#endif // FAN_TACH_H
@@ -0,0 +1,66 @@
+#include "onewire_search.h"
+
+#define OW_CMD_SEARCH_ROM 0xF0
+
+void oneWireSearchBegin(OneWireSearch& search, OneWire* bus) {
+    memset(&search, 0, sizeof(search));
+    search.bus = bus;
+    search.lastDiscrepancy = -1;
+    search.lastZero = -1;
+}
+
+OneWireSearchResult oneWireSearchStep(OneWireSearch& search) {
+    OneWire& bus = *search.bus;
+
+    // Start of a walk: reset, then SEARCH ROM
+    if (!search.inDevice) {
+        if (search.lastDevice) return OW_SEARCH_DONE;
+        if (!bus.reset()) {
+            // No presence pulse - an empty bus is a complete (empty) sweep
+            search.lastDevice = true;
+            return OW_SEARCH_DONE;
+        }
+        bus.write(OW_CMD_SEARCH_ROM);
+        search.bitIndex = 0;
+        search.lastZero = -1;
+        search.inDevice = true;
+        return OW_SEARCH_BUSY;
+    }
+
+    // One triplet: ROM bit, its complement, then the chosen direction
+    uint8_t idBit = bus.read_bit();
+    uint8_t cmpBit = bus.read_bit();
+    if (idBit && cmpBit) {
+        // Nobody answered - device removed mid-walk or bus fault
+        search.inDevice = false;
+        return OW_SEARCH_ERROR;
+    }
+
+    uint8_t index = search.bitIndex;
+    uint8_t mask = 1 << (index & 7);
+    uint8_t direction;
+    if (idBit != cmpBit) {
+        direction = idBit;  // All remaining devices agree
+    } else if (index < search.lastDiscrepancy) {
+        direction = (search.rom[index >> 3] & mask) ? 1 : 0;  // Same branch as last walk
+    } else {
+        direction = (index == search.lastDiscrepancy) ? 1 : 0;
+    }
+    if (idBit == cmpBit && direction == 0) search.lastZero = index;
+
+    if (direction) {
+        search.rom[index >> 3] |= mask;
+    } else {
+        search.rom[index >> 3] &= ~mask;
+    }
+    bus.write_bit(direction);
+
+    if (++search.bitIndex < 64) return OW_SEARCH_BUSY;
+
+    // ROM complete
+    search.inDevice = false;
+    search.lastDiscrepancy = search.lastZero;
+    if (search.lastDiscrepancy < 0) search.lastDevice = true;
+    if (OneWire::crc8(search.rom, 7) != search.rom[7]) return OW_SEARCH_ERROR;
+    return OW_SEARCH_FOUND;
+}
@@ -0,0 +1,42 @@
+#ifndef ONEWIRE_SEARCH_H
+#define ONEWIRE_SEARCH_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+// ========== Incremental OneWire ROM Search ==========
+// The ROM search tree walked one step at a time (Maxim AN187), so a bus
+// scan can be spread over many loop() ticks. A step is either the reset +
+// SEARCH ROM command (~1 ms) or one bit triplet (~200 us). Between the reset
+// and the 64th bit the search owns the bus - any other transaction aborts it.
+
+enum OneWireSearchResult : uint8_t {
+    OW_SEARCH_BUSY = 0,     // Step done, more to come
+    OW_SEARCH_FOUND,        // A ROM was completed (search.rom, CRC-checked)
+    OW_SEARCH_DONE,         // Every device on the bus has been returned
+    OW_SEARCH_ERROR         // No presence, bus fault or bad ROM CRC - sweep is incomplete
+};
+
+struct OneWireSearch {
+    OneWire* bus;
+    uint8_t rom[8];
+    int8_t lastDiscrepancy;  // Branch to take the 1-path at next time (-1: none left)
+    int8_t lastZero;         // Last 0-branch taken in the current walk
+    uint8_t bitIndex;        // Next ROM bit (0..63)
+    bool inDevice;           // Between SEARCH ROM and the 64th bit
+    bool lastDevice;
+};
+
+// ========== Functions ==========
+// Start a new search over a bus
+void oneWireSearchBegin(OneWireSearch& search, OneWire* bus);
+
+// Advance the search by one step
+OneWireSearchResult oneWireSearchStep(OneWireSearch& search);
+
+// True while the search owns the bus (mid-ROM)
+inline bool oneWireSearchInDevice(const OneWireSearch& search) {
+    return search.inDevice;
+}
+
+#endif // ONEWIRE_SEARCH_H
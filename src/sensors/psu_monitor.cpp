@@ -0,0 +1,267 @@
+#include "psu_monitor.h"
+#include "config/pins.h"
+#include "config/config.h"
+#include "utils/log.h"
+
+#ifdef PSU_DMA_SOURCE
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#endif
+
+#define PSU_LUT_POINTS      ((4096 >> PSU_LUT_SHIFT) + 1)
+#define PSU_CAL_SHIFT       12      // Divider factor as Q12 fixed point
+#define PSU_ALERT_LOG_MS    5000    // Rate limit for alert messages
+
+// Raw count -> pin millivolts, one point every 16 counts
+static uint16_t lut[PSU_LUT_POINTS];
+static uint32_t dividerQ12 = 0;    // cfg.psu_voltage_cal, refreshed per block
+
+static PsuBlock lastBlock = {};
+static PsuStats stats = {};
+static unsigned long lastAlertLog = 0;
+static bool alertLogged = false;
+
+// Block being accumulated
+static uint32_t blockSum = 0;
+static uint16_t blockMin = 0xFFFF;
+static uint16_t blockMax = 0;
+static uint16_t blockCount = 0;
+
+// ========== Linearisation ==========
+
+uint16_t psuRawToPinMv(uint16_t raw) {
+    raw &= 0x0FFF;
+    uint16_t index = raw >> PSU_LUT_SHIFT;
+    uint16_t frac = raw & ((1 << PSU_LUT_SHIFT) - 1);
+    int32_t span = (int32_t)lut[index + 1] - lut[index];
+    return lut[index] + ((span * frac) >> PSU_LUT_SHIFT);
+}
+
+// ========== Block Statistics ==========
+
+static void resetBlock() {
+    blockSum = 0;
+    blockMin = 0xFFFF;
+    blockMax = 0;
+    blockCount = 0;
+}
+
+static uint32_t pinToPsuMv(uint32_t pinMv) {
+    return (pinMv * dividerQ12) >> PSU_CAL_SHIFT;
+}
+
+// Close the block: everything is summed at the pin and scaled once
+static void finishBlock() {
+    dividerQ12 = (uint32_t)(cfg.psu_voltage_cal * (1 << PSU_CAL_SHIFT) + 0.5f);
+    lastBlock.seq++;
+    lastBlock.timeMs = millis();
+    lastBlock.samples = blockCount;
+    lastBlock.meanMv = pinToPsuMv((blockSum + blockCount / 2) / blockCount);
+    lastBlock.minMv = pinToPsuMv(blockMin);
+    lastBlock.maxMv = pinToPsuMv(blockMax);
+    lastBlock.rippleMv = lastBlock.maxMv - lastBlock.minMv;
+
+    stats.blocks++;
+    if (lastBlock.meanMv >= PSU_MIN_VALID_MV) {
+        if (stats.minMv == 0 || lastBlock.minMv < stats.minMv) stats.minMv = lastBlock.minMv;
+        if (lastBlock.maxMv > stats.maxMv) stats.maxMv = lastBlock.maxMv;
+        if (lastBlock.rippleMv > stats.maxRippleMv) stats.maxRippleMv = lastBlock.rippleMv;
+
+        bool low = lastBlock.minMv < cfg.psu_alert_low * 1000;
+        bool high = lastBlock.maxMv > cfg.psu_alert_high * 1000;
+        if (low) stats.lowAlerts++;
+        if (high) stats.highAlerts++;
+        if ((low || high) && (!alertLogged || millis() - lastAlertLog >= PSU_ALERT_LOG_MS)) {
+            alertLogged = true;
+            lastAlertLog = millis();
+            LOGI("PSU", "%s: %.2fV-%.2fV in %d ms (mean %.2fV, ripple %.2fV)",
+                 low ? "Dip" : "Overshoot", lastBlock.minMv / 1000.0, lastBlock.maxMv / 1000.0,
+                 blockCount * 1000 / PSU_SAMPLE_RATE_HZ, lastBlock.meanMv / 1000.0,
+                 lastBlock.rippleMv / 1000.0);
+        }
+    }
+    resetBlock();
+}
+
+// Add one raw sample; true when it completed a block
+static bool addSample(uint16_t raw) {
+    uint16_t mv = psuRawToPinMv(raw);
+    blockSum += mv;
+    if (mv < blockMin) blockMin = mv;
+    if (mv > blockMax) blockMax = mv;
+    stats.samples++;
+    if (++blockCount < PSU_BLOCK_SAMPLES) return false;
+    finishBlock();
+    return true;
+}
+
+const PsuBlock& psuLastBlock() {
+    return lastBlock;
+}
+
+const PsuStats& getPsuStats() {
+    return stats;
+}
+
+void psuResetExtremes() {
+    stats.minMv = 0;
+    stats.maxMv = 0;
+    stats.maxRippleMv = 0;
+}
+
+#ifdef PSU_DMA_SOURCE
+// ========== ADC Continuous Mode (target) ==========
+// ADC1 through the I2S0 DMA. The driver buffers PSU_DMA_BUFFER bytes
+// (about 100 ms), so loop() stalls shorter than that lose no samples.
+
+#define PSU_DMA_BUFFER      4096
+#define PSU_DMA_FRAME       256     // Bytes per conversion frame (128 samples)
+#define PSU_MAX_READS       8       // Frames drained per poll
+
+static bool dmaRunning = false;
+
+bool psuMonitorInit() {
+    // The IDF characterisation (eFuse Vref or two-point, with its own
+    // 11 dB non-linearity table) fills our table once
+    esp_adc_cal_characteristics_t chars;
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &chars);
+    for (uint16_t i = 0; i < PSU_LUT_POINTS; i++) {
+        lut[i] = esp_adc_cal_raw_to_voltage(min(i << PSU_LUT_SHIFT, 4095), &chars);
+    }
+    resetBlock();
+
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = PSU_DMA_BUFFER;
+    init.conv_num_each_intr = PSU_DMA_FRAME;
+    init.adc1_chan_mask = BIT(digitalPinToAnalogChannel(PSU_VOLT));
+    init.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init) != ESP_OK) {
+        LOGE("PSU", "ADC DMA init failed");
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_11;
+    pattern.channel = digitalPinToAnalogChannel(PSU_VOLT);
+    pattern.unit = 0;  // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t digi = {};
+    digi.conv_limit_en = 1;
+    digi.conv_limit_num = 250;
+    digi.pattern_num = 1;
+    digi.adc_pattern = &pattern;
+    digi.sample_freq_hz = PSU_SAMPLE_RATE_HZ;
+    digi.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digi.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&digi) != ESP_OK || adc_digi_start() != ESP_OK) {
+        LOGE("PSU", "ADC DMA start failed");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    dmaRunning = true;
+    LOGI("PSU", "ADC DMA: GPIO%d at %d Hz, %d-sample blocks (%d ms), Vref %u mV",
+         PSU_VOLT, PSU_SAMPLE_RATE_HZ, PSU_BLOCK_SAMPLES,
+         PSU_BLOCK_SAMPLES * 1000 / PSU_SAMPLE_RATE_HZ, (unsigned)chars.vref);
+    return true;
+}
+
+bool psuMonitorPoll() {
+    if (!dmaRunning) return false;
+
+    static uint8_t frame[PSU_DMA_FRAME];
+    bool completed = false;
+    for (uint8_t r = 0; r < PSU_MAX_READS; r++) {
+        uint32_t length = 0;
+        esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &length, 0);
+        if (err == ESP_ERR_TIMEOUT) break;  // Nothing buffered
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            stats.readErrors++;
+            break;
+        }
+
+        uint8_t channel = digitalPinToAnalogChannel(PSU_VOLT);
+        for (uint32_t i = 0; i + 1 < length; i += sizeof(adc_digi_output_data_t)) {
+            const adc_digi_output_data_t* sample = (const adc_digi_output_data_t*)&frame[i];
+            if (sample->type1.channel != channel) {
+                stats.readErrors++;
+                continue;
+            }
+            completed |= addSample(sample->type1.data);
+        }
+    }
+    return completed;
+}
+
+#else
+// ========== Synthetic Source (host) ==========
+// Samples are generated for the time elapsed since the last poll, so the
+// block cadence matches the target. The table models the typical ESP32
+// 11 dB curve (cubic fit), and the waveform is quantised through its inverse.
+
+static float synthVolts = 24.0;
+static float synthRippleVpp = 0.2;
+static float synthRippleHz = 100.0;
+static float synthDipVolts = 0.0;
+static uint16_t synthDipMs = 0;
+static uint32_t synthDipEveryMs = 0;
+static uint32_t synthSampleIndex = 0;
+static unsigned long synthLastUs = 0;
+
+void psuSyntheticConfigure(float volts, float rippleVpp, float rippleHz,
+                           float dipVolts, uint16_t dipMs, uint32_t dipEveryMs) {
+    synthVolts = volts;
+    synthRippleVpp = rippleVpp;
+    synthRippleHz = rippleHz;
+    synthDipVolts = dipVolts;
+    synthDipMs = dipMs;
+    synthDipEveryMs = dipEveryMs;
+}
+
+static float modelPinVolts(float raw) {
+    return ((-9.824e-12 * raw + 1.6557283e-8) * raw + 8.54596860691e-4) * raw + 0.065440348;
+}
+
+// Raw count the model ADC reports for a pin voltage
+static uint16_t pinMvToRaw(uint32_t pinMv) {
+    uint16_t lo = 0, hi = 4095;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi + 1) / 2;
+        if (psuRawToPinMv(mid) <= pinMv) lo = mid; else hi = mid - 1;
+    }
+    return lo;
+}
+
+bool psuMonitorInit() {
+    for (uint16_t i = 0; i < PSU_LUT_POINTS; i++) {
+        lut[i] = modelPinVolts(min(i << PSU_LUT_SHIFT, 4095)) * 1000.0 + 0.5;
+    }
+    resetBlock();
+    synthLastUs = micros();
+    LOGI("PSU", "Synthetic source at %d Hz, %d-sample blocks",
+         PSU_SAMPLE_RATE_HZ, PSU_BLOCK_SAMPLES);
+    return true;
+}
+
+bool psuMonitorPoll() {
+    unsigned long now = micros();
+    uint32_t due = (uint64_t)(now - synthLastUs) * PSU_SAMPLE_RATE_HZ / 1000000;
+    if (due == 0) return false;
+    synthLastUs += (uint64_t)due * 1000000 / PSU_SAMPLE_RATE_HZ;
+    due = min(due, (uint32_t)(PSU_SAMPLE_RATE_HZ / 10));  // Same 100 ms slack as the DMA buffer
+
+    bool completed = false;
+    for (uint32_t i = 0; i < due; i++, synthSampleIndex++) {
+        float t = (float)synthSampleIndex / PSU_SAMPLE_RATE_HZ;
+        float volts = synthVolts + 0.5f * synthRippleVpp * sinf(2.0f * PI * synthRippleHz * t);
+        if (synthDipEveryMs > 0 &&
+            (uint32_t)(t * 1000) % synthDipEveryMs < synthDipMs) {
+            volts -= synthDipVolts;
+        }
+        float pinMv = max(volts, 0.0f) * 1000.0f / cfg.psu_voltage_cal;
+        completed |= addSample(pinMvToRaw(pinMv));
+    }
+    return completed;
+}
+#endif
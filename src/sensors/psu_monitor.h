@@ -0,0 +1,66 @@
+#ifndef PSU_MONITOR_H
+#define PSU_MONITOR_H
+
+#include <Arduino.h>
+
+// ========== PSU Voltage Acquisition ==========
+// The PSU divider (PSU_VOLT) is sampled at a fixed rate into blocks; each
+// block yields mean, min, max and ripple computed with integer maths.
+// Raw counts are linearised through a lookup table before any statistics.
+//
+// Sample source: the ESP32 ADC continuous (DMA) mode when the IDF ADC
+// driver is available, otherwise - host builds, or PSU_SYNTHETIC_SOURCE
+// defined - a synthetic waveform running at the same rate.
+
+#if __has_include(<driver/adc.h>) && !defined(PSU_SYNTHETIC_SOURCE)
+#define PSU_DMA_SOURCE 1
+#endif
+
+#define PSU_SAMPLE_RATE_HZ  20000   // Lowest rate of the ESP32 ADC DMA mode
+#define PSU_BLOCK_SAMPLES   1000    // 50 ms per block
+#define PSU_LUT_SHIFT       4       // LUT point every 16 raw counts
+#define PSU_MIN_VALID_MV    10000   // Below this the PSU is off - extremes are not tracked
+
+// Statistics of one block, in millivolts at the PSU (divider applied)
+struct PsuBlock {
+    uint32_t seq;
+    uint32_t timeMs;        // millis() when the block completed
+    uint32_t meanMv;
+    uint32_t minMv;
+    uint32_t maxMv;
+    uint32_t rippleMv;      // Peak to peak within the block
+    uint16_t samples;
+};
+
+struct PsuStats {
+    uint32_t blocks;
+    uint32_t samples;
+    uint32_t lowAlerts;     // Blocks dipping below cfg.psu_alert_low
+    uint32_t highAlerts;    // Blocks peaking above cfg.psu_alert_high
+    uint32_t minMv;         // Since boot (or psuResetExtremes)
+    uint32_t maxMv;
+    uint32_t maxRippleMv;
+    uint32_t readErrors;    // DMA reads that failed or carried a foreign channel
+};
+
+// ========== Functions ==========
+// Build the linearisation table and start the sample source
+bool psuMonitorInit();
+
+// Drain the sample source - call every loop(). True when a block completed.
+bool psuMonitorPoll();
+
+const PsuBlock& psuLastBlock();
+const PsuStats& getPsuStats();
+void psuResetExtremes();
+
+// Pin millivolts for a raw 12-bit reading (table lookup, interpolated)
+uint16_t psuRawToPinMv(uint16_t raw);
+
+#ifndef PSU_DMA_SOURCE
+// Synthetic source: DC level plus a sine ripple and periodic dips, in PSU volts
+void psuSyntheticConfigure(float volts, float rippleVpp, float rippleHz,
+                           float dipVolts, uint16_t dipMs, uint32_t dipEveryMs);
+#endif
+
+#endif // PSU_MONITOR_H
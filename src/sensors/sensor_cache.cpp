@@ -0,0 +1,252 @@
+#include "sensor_cache.h"
+#include "utils/log.h"
+#include <freertos/FreeRTOS.h>
+
+#define BUCKET_EMPTY 0xFF
+
+// Sized at init from the mapping and bus counts, grown when sensors are added
+static SensorReading* entries = nullptr;
+static uint8_t entryCapacity = 0;
+static uint8_t entryCount = 0;
+
+// Open-addressing tables: bucket -> entry index (BUCKET_EMPTY if unused).
+// At least twice the capacity, so probes stay short.
+static uint8_t* uidBuckets = nullptr;
+static uint8_t* aliasBuckets = nullptr;
+static uint8_t bucketMask = 0;
+
+// Writers run on the loop task, readers on any task (async_tcp)
+static portMUX_TYPE cacheMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ========== HASHING ==========
+
+// FNV-1a over the ROM address
+uint32_t sensorUIDHash(const uint8_t uid[8]) {
+    uint32_t h = 2166136261UL;
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ uid[i]) * 16777619UL;
+    }
+    return h;
+}
+
+uint32_t sensorAliasHash(const char* alias) {
+    uint32_t h = 2166136261UL;
+    while (*alias) {
+        h = (h ^ (uint8_t)*alias++) * 16777619UL;
+    }
+    return h;
+}
+
+static uint8_t hashUID(const uint8_t uid[8]) {
+    return sensorUIDHash(uid) & bucketMask;
+}
+
+static uint8_t hashAlias(const char* alias) {
+    return sensorAliasHash(alias) & bucketMask;
+}
+
+// Probe for a UID; returns the entry index or SENSOR_CACHE_NONE. Call with cacheMux held.
+static int8_t probeUID(const uint8_t uid[8]) {
+    uint8_t b = hashUID(uid);
+    for (uint16_t n = 0; n <= bucketMask; n++) {
+        uint8_t index = uidBuckets[b];
+        if (index == BUCKET_EMPTY) return SENSOR_CACHE_NONE;
+        if (memcmp(entries[index].uid, uid, 8) == 0) return index;
+        b = (b + 1) & bucketMask;
+    }
+    return SENSOR_CACHE_NONE;
+}
+
+static int8_t probeAlias(const char* alias) {
+    uint8_t b = hashAlias(alias);
+    for (uint16_t n = 0; n <= bucketMask; n++) {
+        uint8_t index = aliasBuckets[b];
+        if (index == BUCKET_EMPTY) return SENSOR_CACHE_NONE;
+        if (strcmp(entries[index].alias, alias) == 0) return index;
+        b = (b + 1) & bucketMask;
+    }
+    return SENSOR_CACHE_NONE;
+}
+
+static void insertBucket(uint8_t* buckets, uint8_t b, uint8_t index) {
+    while (buckets[b] != BUCKET_EMPTY) {
+        b = (b + 1) & bucketMask;
+    }
+    buckets[b] = index;
+}
+
+// Aliases can change, so the alias table is rebuilt rather than patched
+static void rebuildAliasBuckets() {
+    memset(aliasBuckets, BUCKET_EMPTY, bucketMask + 1);
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].alias[0] != '\0' && probeAlias(entries[i].alias) == SENSOR_CACHE_NONE) {
+            insertBucket(aliasBuckets, hashAlias(entries[i].alias), i);
+        }
+    }
+}
+
+// ========== WRITERS (loop task) ==========
+
+bool sensorCacheInit(uint8_t capacity) {
+    capacity = constrain(capacity, (uint8_t)1, (uint8_t)SENSOR_CACHE_MAX);
+    if (entries != nullptr && capacity <= entryCapacity) return true;
+
+    uint16_t buckets = 8;
+    while (buckets < 2 * capacity) buckets <<= 1;
+
+    SensorReading* newEntries = (SensorReading*)calloc(capacity, sizeof(SensorReading));
+    uint8_t* newUidBuckets = (uint8_t*)malloc(buckets);
+    uint8_t* newAliasBuckets = (uint8_t*)malloc(buckets);
+    if (newEntries == nullptr || newUidBuckets == nullptr || newAliasBuckets == nullptr) {
+        free(newEntries);
+        free(newUidBuckets);
+        free(newAliasBuckets);
+        LOGE("SENSORS", "Failed to allocate sensor cache for %d sensors", capacity);
+        return false;
+    }
+
+    // Swapped under the lock: readers only touch the storage while holding it
+    portENTER_CRITICAL(&cacheMux);
+    SensorReading* oldEntries = entries;
+    uint8_t* oldUidBuckets = uidBuckets;
+    uint8_t* oldAliasBuckets = aliasBuckets;
+    if (oldEntries != nullptr) memcpy(newEntries, oldEntries, entryCount * sizeof(SensorReading));
+    entries = newEntries;
+    uidBuckets = newUidBuckets;
+    aliasBuckets = newAliasBuckets;
+    entryCapacity = capacity;
+    bucketMask = buckets - 1;
+    memset(uidBuckets, BUCKET_EMPTY, buckets);
+    for (uint8_t i = 0; i < entryCount; i++) {
+        insertBucket(uidBuckets, hashUID(entries[i].uid), i);
+    }
+    rebuildAliasBuckets();
+    portEXIT_CRITICAL(&cacheMux);
+
+    free(oldEntries);
+    free(oldUidBuckets);
+    free(oldAliasBuckets);
+    return true;
+}
+
+void sensorCacheClear() {
+    if (entries == nullptr) return;
+    portENTER_CRITICAL(&cacheMux);
+    entryCount = 0;
+    memset(uidBuckets, BUCKET_EMPTY, bucketMask + 1);
+    memset(aliasBuckets, BUCKET_EMPTY, bucketMask + 1);
+    portEXIT_CRITICAL(&cacheMux);
+}
+
+int8_t sensorCacheAdd(const uint8_t uid[8], const char* alias, uint8_t bus) {
+    if (entries == nullptr) return SENSOR_CACHE_NONE;
+    if (alias == nullptr) alias = "";
+
+    portENTER_CRITICAL(&cacheMux);
+    int8_t index = probeUID(uid);
+    if (index == SENSOR_CACHE_NONE) {
+        if (entryCount >= entryCapacity) {
+            portEXIT_CRITICAL(&cacheMux);
+            return SENSOR_CACHE_NONE;
+        }
+        index = entryCount++;
+        SensorReading& e = entries[index];
+        memset(&e, 0, sizeof(e));
+        memcpy(e.uid, uid, 8);
+        insertBucket(uidBuckets, hashUID(uid), index);
+    }
+
+    strlcpy(entries[index].alias, alias, sizeof(entries[index].alias));
+    entries[index].bus = bus;
+    rebuildAliasBuckets();
+    portEXIT_CRITICAL(&cacheMux);
+    return index;
+}
+
+uint8_t sensorCacheCount() {
+    return entryCount;
+}
+
+uint8_t sensorCacheCapacity() {
+    return entryCapacity;
+}
+
+const uint8_t* sensorCacheUID(int8_t index) {
+    if (index < 0 || index >= entryCount) return nullptr;
+    return entries[index].uid;
+}
+
+uint8_t sensorCacheBus(int8_t index) {
+    if (index < 0 || index >= entryCount) return SENSOR_BUS_NONE;
+    return entries[index].bus;
+}
+
+void sensorCacheStore(int8_t index, bool ok, float tempC, bool valid) {
+    if (index < 0 || index >= entryCount) return;
+
+    portENTER_CRITICAL(&cacheMux);
+    SensorReading& e = entries[index];
+    if (ok) {
+        e.timestamp = millis();
+        e.sampleCount++;
+        e.failures = 0;
+    } else if (e.failures < 0xFF) {
+        e.failures++;
+    }
+    if (valid) e.tempC = tempC;
+    e.valid = valid;
+    portEXIT_CRITICAL(&cacheMux);
+}
+
+void sensorCacheRestore(int8_t index, const SensorReading& reading) {
+    if (index < 0 || index >= entryCount) return;
+
+    portENTER_CRITICAL(&cacheMux);
+    SensorReading& e = entries[index];
+    e.tempC = reading.tempC;
+    e.timestamp = reading.timestamp;
+    e.sampleCount = reading.sampleCount;
+    e.failures = reading.failures;
+    e.valid = reading.valid;
+    portEXIT_CRITICAL(&cacheMux);
+}
+
+// ========== READERS (any task) ==========
+
+bool sensorCacheGet(int8_t index, SensorReading& out) {
+    portENTER_CRITICAL(&cacheMux);
+    bool found = (index >= 0 && index < entryCount);
+    if (found) out = entries[index];
+    portEXIT_CRITICAL(&cacheMux);
+    return found;
+}
+
+bool sensorCacheGetByUID(const uint8_t uid[8], SensorReading& out) {
+    portENTER_CRITICAL(&cacheMux);
+    int8_t index = (entryCount > 0) ? probeUID(uid) : SENSOR_CACHE_NONE;
+    if (index != SENSOR_CACHE_NONE) out = entries[index];
+    portEXIT_CRITICAL(&cacheMux);
+    return index != SENSOR_CACHE_NONE;
+}
+
+bool sensorCacheGetByAlias(const char* alias, SensorReading& out) {
+    portENTER_CRITICAL(&cacheMux);
+    int8_t index = (entryCount > 0) ? probeAlias(alias) : SENSOR_CACHE_NONE;
+    if (index != SENSOR_CACHE_NONE) out = entries[index];
+    portEXIT_CRITICAL(&cacheMux);
+    return index != SENSOR_CACHE_NONE;
+}
+
+int8_t sensorCacheFindUID(const uint8_t uid[8]) {
+    portENTER_CRITICAL(&cacheMux);
+    int8_t index = (entryCount > 0) ? probeUID(uid) : SENSOR_CACHE_NONE;
+    portEXIT_CRITICAL(&cacheMux);
+    return index;
+}
+
+int8_t sensorCacheFindAlias(const char* alias) {
+    portENTER_CRITICAL(&cacheMux);
+    int8_t index = (entryCount > 0) ? probeAlias(alias) : SENSOR_CACHE_NONE;
+    portEXIT_CRITICAL(&cacheMux);
+    return index;
+}
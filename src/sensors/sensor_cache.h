@@ -0,0 +1,70 @@
+#ifndef SENSOR_CACHE_H
+#define SENSOR_CACHE_H
+
+#include <Arduino.h>
+
+// ========== Sensor Cache ==========
+// Latest reading of every known DS18B20, filled only by the acquisition
+// state machine. Consumers (display, web API) read the cache and never
+// touch the OneWire bus. Lookups by UID or alias are O(1) hash probes.
+// Entry i is temperature channel i (data source "tempN").
+
+#define SENSOR_CACHE_MAX      64    // Upper bound on the capacity (tempN id range)
+#define SENSOR_CACHE_NONE     -1
+#define SENSOR_BUS_NONE       0xFF  // Mapped sensor not found on any bus
+
+struct SensorReading {
+    uint8_t uid[8];           // 64-bit ROM address
+    char alias[16];           // Mapping alias, or "tempN" for unmapped sensors
+    uint8_t bus;              // OneWire bus index, or SENSOR_BUS_NONE
+    float tempC;              // Last valid temperature (calibrated, filtered)
+    uint32_t timestamp;       // millis() of the last valid reading
+    uint32_t sampleCount;     // Valid readings since the entry was added
+    uint8_t failures;         // Consecutive failed reads
+    bool valid;               // tempC is current (not stale)
+};
+
+// ========== Functions (loop task only) ==========
+// Allocate storage for up to capacity sensors (capped at SENSOR_CACHE_MAX).
+// The first call leaves the cache empty; a later, larger capacity grows the
+// storage and keeps the entries. Returns false (storage unchanged) if out
+// of memory.
+bool sensorCacheInit(uint8_t capacity);
+
+// Forget all sensors (capacity is kept)
+void sensorCacheClear();
+
+// Add a sensor (or update the alias and bus of a known one). Returns its
+// index, or SENSOR_CACHE_NONE if the cache is full.
+int8_t sensorCacheAdd(const uint8_t uid[8], const char* alias, uint8_t bus);
+
+// Number of cached sensors and the capacity allocated
+uint8_t sensorCacheCount();
+uint8_t sensorCacheCapacity();
+
+// UID and bus of an entry, read by the acquisition pass
+const uint8_t* sensorCacheUID(int8_t index);
+uint8_t sensorCacheBus(int8_t index);
+
+// Record one read: ok counts a sample or a failure, tempC and valid are
+// the sensor pipeline output (tempC is kept while the entry is invalid)
+void sensorCacheStore(int8_t index, bool ok, float tempC, bool valid);
+
+// Carry a reading over from before a rebuild (keeps uid, alias and bus)
+void sensorCacheRestore(int8_t index, const SensorReading& reading);
+
+// ========== Functions (any task) ==========
+// Copy an entry out of the cache. Return false if it is unknown.
+bool sensorCacheGet(int8_t index, SensorReading& out);
+bool sensorCacheGetByUID(const uint8_t uid[8], SensorReading& out);
+bool sensorCacheGetByAlias(const char* alias, SensorReading& out);
+
+// Index of a sensor, or SENSOR_CACHE_NONE
+int8_t sensorCacheFindUID(const uint8_t uid[8]);
+int8_t sensorCacheFindAlias(const char* alias);
+
+// FNV-1a hashes used by the cache (and the mapping index)
+uint32_t sensorUIDHash(const uint8_t uid[8]);
+uint32_t sensorAliasHash(const char* alias);
+
+#endif // SENSOR_CACHE_H
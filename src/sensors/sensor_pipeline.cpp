@@ -0,0 +1,203 @@
+#include "sensor_pipeline.h"
+#include "config/config.h"
+#include "utils/log.h"
+
+#define FLAG_VALID          0x01  // value holds a good, non-stale reading
+#define FLAG_HAS_INPUT      0x02  // lastInput is set (spike gate reference)
+#define FLAG_SPIKE_PENDING  0x04  // spikeValue waits for confirmation
+
+// Struct of arrays, index = channel. One allocation, floats first.
+static struct {
+    float* value;           // Filter output
+    float* peak;
+    float* lastInput;       // Last accepted calibrated input
+    float* spikeValue;
+    float* offset;
+    float* window;          // PIPE_MEDIAN_WINDOW inputs per channel
+    uint32_t* lastGoodMs;
+    uint8_t* windowFill;
+    uint8_t* windowHead;
+    uint8_t* flags;
+} pipe;
+
+static void* pipeBlock = nullptr;
+static uint8_t pipeCapacity = 0;
+static uint32_t pipeStaleMs = 3000;
+static SensorPipelineStats pipeStats = {};
+
+bool sensorPipelineInit(uint8_t capacity) {
+    if (pipeBlock != nullptr && capacity <= pipeCapacity) return true;
+
+    size_t floats = (size_t)capacity * (5 + PIPE_MEDIAN_WINDOW);
+    size_t bytes = floats * sizeof(float) + capacity * sizeof(uint32_t) + capacity * 3;
+    void* block = calloc(1, bytes);
+    if (block == nullptr) {
+        LOGE("SENSORS", "Failed to allocate sensor pipeline for %d channels", capacity);
+        return false;
+    }
+    free(pipeBlock);
+    pipeBlock = block;
+
+    float* f = (float*)pipeBlock;
+    pipe.value = f;       f += capacity;
+    pipe.peak = f;        f += capacity;
+    pipe.lastInput = f;   f += capacity;
+    pipe.spikeValue = f;  f += capacity;
+    pipe.offset = f;      f += capacity;
+    pipe.window = f;      f += capacity * PIPE_MEDIAN_WINDOW;
+    pipe.lastGoodMs = (uint32_t*)f;
+    uint8_t* b = (uint8_t*)(pipe.lastGoodMs + capacity);
+    pipe.windowFill = b;  b += capacity;
+    pipe.windowHead = b;  b += capacity;
+    pipe.flags = b;
+
+    pipeCapacity = capacity;
+    sensorPipelineReset(pipeStaleMs);
+    return true;
+}
+
+void sensorPipelineLoadOffsets() {
+    const float legacy[4] = {cfg.temp_offset_x, cfg.temp_offset_yl, cfg.temp_offset_yr, cfg.temp_offset_z};
+    for (uint8_t ch = 0; ch < pipeCapacity; ch++) {
+        pipe.offset[ch] = (ch < 4) ? legacy[ch] : 0.0f;
+    }
+}
+
+static void clearChannel(uint8_t ch) {
+    pipe.value[ch] = NAN;
+    pipe.peak[ch] = NAN;
+    pipe.windowFill[ch] = 0;
+    pipe.windowHead[ch] = 0;
+    pipe.flags[ch] = 0;
+}
+
+void sensorPipelineReset(uint32_t staleMs) {
+    pipeStaleMs = staleMs;
+    for (uint8_t ch = 0; ch < pipeCapacity; ch++) {
+        clearChannel(ch);
+    }
+    sensorPipelineLoadOffsets();
+}
+
+// Restart the filter at one value (first sample, confirmed step, seed)
+static void restartFilter(uint8_t ch, float value) {
+    pipe.value[ch] = value;
+    pipe.lastInput[ch] = value;
+    pipe.window[ch * PIPE_MEDIAN_WINDOW] = value;
+    pipe.windowFill[ch] = 1;
+    pipe.windowHead[ch] = 1 % PIPE_MEDIAN_WINDOW;
+}
+
+void sensorPipelineSeed(uint8_t ch, float value, float peak, uint32_t lastGoodMs) {
+    if (ch >= pipeCapacity || isnan(value)) return;
+    restartFilter(ch, value);
+    pipe.peak[ch] = isnan(peak) ? value : peak;
+    pipe.lastGoodMs[ch] = lastGoodMs;
+    pipe.flags[ch] = FLAG_VALID | FLAG_HAS_INPUT;
+}
+
+static float medianOf(const float* window, uint8_t count) {
+    float sorted[PIPE_MEDIAN_WINDOW];
+    for (uint8_t i = 0; i < count; i++) {
+        float v = window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return (count & 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) * 0.5f;
+}
+
+// Stage 2 for a rejected sample: hold, or go stale
+static PipeResult holdLastGood(uint8_t ch, PipeResult result, uint32_t now) {
+    if ((pipe.flags[ch] & FLAG_VALID) && now - pipe.lastGoodMs[ch] > pipeStaleMs) {
+        pipe.value[ch] = NAN;
+        pipe.flags[ch] &= ~(FLAG_VALID | FLAG_HAS_INPUT | FLAG_SPIKE_PENDING);
+        pipe.windowFill[ch] = 0;
+        pipeStats.staleEvents++;
+    }
+    return result;
+}
+
+PipeResult sensorPipelineProcess(uint8_t ch, bool readOk, float rawC, uint32_t now) {
+    if (ch >= pipeCapacity) return PIPE_READ_FAILED;
+    uint8_t& flags = pipe.flags[ch];
+
+    // Stage 1: gate
+    if (!readOk) {
+        pipeStats.readFailures++;
+        return holdLastGood(ch, PIPE_READ_FAILED, now);
+    }
+    if (!(rawC >= PIPE_MIN_TEMP && rawC <= PIPE_MAX_TEMP)) {
+        pipeStats.outOfRange++;
+        return holdLastGood(ch, PIPE_OUT_OF_RANGE, now);
+    }
+
+    // Stage 3: calibration (ahead of the spike gate so both compare like values)
+    float input = rawC + pipe.offset[ch];
+
+    bool restart = !(flags & FLAG_HAS_INPUT);
+    if (!restart && fabsf(input - pipe.lastInput[ch]) > PIPE_MAX_STEP) {
+        // A real step repeats; a glitch does not
+        if (!(flags & FLAG_SPIKE_PENDING) || fabsf(input - pipe.spikeValue[ch]) > PIPE_MAX_STEP) {
+            pipe.spikeValue[ch] = input;
+            flags |= FLAG_SPIKE_PENDING;
+            pipeStats.spikes++;
+            return holdLastGood(ch, PIPE_SPIKE, now);
+        }
+        restart = true;
+    }
+    flags &= ~FLAG_SPIKE_PENDING;
+
+    // Stage 4: filter
+    if (restart) {
+        restartFilter(ch, input);
+    } else {
+        pipe.lastInput[ch] = input;
+        switch (cfg.temp_filter) {
+            case TEMP_FILTER_EMA:
+                pipe.value[ch] += PIPE_EMA_ALPHA * (input - pipe.value[ch]);
+                break;
+
+            case TEMP_FILTER_MEDIAN: {
+                float* window = pipe.window + ch * PIPE_MEDIAN_WINDOW;
+                window[pipe.windowHead[ch]] = input;
+                pipe.windowHead[ch] = (pipe.windowHead[ch] + 1) % PIPE_MEDIAN_WINDOW;
+                if (pipe.windowFill[ch] < PIPE_MEDIAN_WINDOW) pipe.windowFill[ch]++;
+                pipe.value[ch] = medianOf(window, pipe.windowFill[ch]);
+                break;
+            }
+
+            default:
+                pipe.value[ch] = input;
+                break;
+        }
+    }
+
+    // Stage 2 (good sample) and stage 5
+    pipe.lastGoodMs[ch] = now;
+    flags |= FLAG_VALID | FLAG_HAS_INPUT;
+    if (isnan(pipe.peak[ch]) || pipe.value[ch] > pipe.peak[ch]) {
+        pipe.peak[ch] = pipe.value[ch];
+    }
+    pipeStats.accepted++;
+    return PIPE_ACCEPTED;
+}
+
+float sensorPipelineValue(uint8_t ch) {
+    return (ch < pipeCapacity) ? pipe.value[ch] : NAN;
+}
+
+float sensorPipelinePeak(uint8_t ch) {
+    return (ch < pipeCapacity) ? pipe.peak[ch] : NAN;
+}
+
+bool sensorPipelineValid(uint8_t ch) {
+    return ch < pipeCapacity && (pipe.flags[ch] & FLAG_VALID);
+}
+
+const SensorPipelineStats& getSensorPipelineStats() {
+    return pipeStats;
+}
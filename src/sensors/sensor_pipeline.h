@@ -0,0 +1,63 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <Arduino.h>
+
+// ========== Sensor Processing Pipeline ==========
+// Fixed stages, run once per new sample of a temperature channel:
+//   1. gate    - read failure (presence/CRC), range, single-sample spikes
+//   2. hold    - keep the last good value until it is older than staleMs
+//   3. offset  - calibration (cfg.temp_offset_x/yl/yr/z on channels 0-3)
+//   4. filter  - EMA or median of 5 (cfg.temp_filter)
+//   5. peak    - running maximum of the filtered value
+// State is a struct of arrays indexed by channel, carved from one block.
+// A channel with no good sample in staleMs reads NAN - never 0.0.
+
+#define PIPE_MEDIAN_WINDOW  5
+#define PIPE_EMA_ALPHA      0.25f
+#define PIPE_MIN_TEMP       -55.0f
+#define PIPE_MAX_TEMP       125.0f
+#define PIPE_MAX_STEP       10.0f   // A bigger jump must repeat before it is accepted
+
+// Outcome of one sample
+enum PipeResult : uint8_t {
+    PIPE_ACCEPTED = 0,
+    PIPE_READ_FAILED,        // No presence or bad CRC (reported by the reader)
+    PIPE_OUT_OF_RANGE,
+    PIPE_SPIKE               // Held back until the next sample confirms it
+};
+
+struct SensorPipelineStats {
+    uint32_t accepted;
+    uint32_t readFailures;
+    uint32_t outOfRange;
+    uint32_t spikes;
+    uint32_t staleEvents;    // Channels that went from valid to stale
+};
+
+// ========== Functions (loop task only) ==========
+// Allocate state for up to capacity channels. A later, larger capacity
+// reallocates it with every channel reset (loop task, as for every call
+// here). Returns false (state unchanged) if out of memory.
+bool sensorPipelineInit(uint8_t capacity);
+
+// Empty every channel (value NAN, peak NAN) and set the staleness timeout.
+// Calibration offsets are reloaded from cfg.
+void sensorPipelineReset(uint32_t staleMs);
+
+// Carry a channel over a reset (value becomes the filter state)
+void sensorPipelineSeed(uint8_t ch, float value, float peak, uint32_t lastGoodMs);
+
+// Re-read cfg.temp_offset_* after a config change
+void sensorPipelineLoadOffsets();
+
+// Run one sample through every stage. rawC is ignored when readOk is false.
+PipeResult sensorPipelineProcess(uint8_t ch, bool readOk, float rawC, uint32_t now);
+
+// ========== Outputs ==========
+float sensorPipelineValue(uint8_t ch);   // Calibrated, filtered; NAN if none or stale
+float sensorPipelinePeak(uint8_t ch);    // NAN until the first good sample
+bool sensorPipelineValid(uint8_t ch);
+const SensorPipelineStats& getSensorPipelineStats();
+
+#endif // SENSOR_PIPELINE_H
@@ -1,17 +1,59 @@
 #include "sensors.h"
 #include "config/pins.h"
 #include "config/config.h"
+#include "display/view_model.h"
+#include "sensor_cache.h"
+#include "sensor_pipeline.h"
+#include "onewire_search.h"
+#include "psu_monitor.h"
+#include "fan_tach.h"
+#include "fan_control.h"
+#include "history/history_store.h"
+#include "utils/log.h"
+#include "utils/event_trace.h"
+#include "utils/heap_telemetry.h"
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
-
-// ========== DS18B20 OneWire Setup ==========
-OneWire oneWire(ONE_WIRE_BUS_1);
-DallasTemperature ds18b20Sensors(&oneWire);
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // Sensor mappings vector (stores UID to friendly name mappings)
 std::vector<SensorMapping> sensorMappings;
 
+// Guards sensorMappings and discoveredSensors: web handlers and the bus
+// scan edit them, the loop task rebuilds the sensor cache from them
+static SemaphoreHandle_t mappingMutex = nullptr;
+// Orders mapping edits with their NVS writes, which run without
+// mappingMutex so the loop task never waits out a flash write. Taken
+// before mappingMutex, by the functions that edit and save the mappings.
+static SemaphoreHandle_t mappingSaveMutex = nullptr;
+static volatile bool sensorTablesChanged = false;
+static uint16_t channelGeneration = 0;     // Bumped when channels are renumbered or renamed
+
+static int findMappingByUID(const uint8_t uid[8]);
+static bool identHolds(const uint8_t uid[8]);
+
+static void lockMappings() {
+  if (mappingMutex == nullptr) mappingMutex = xSemaphoreCreateMutex();
+  xSemaphoreTake(mappingMutex, portMAX_DELAY);
+}
+
+static void unlockMappings() {
+  xSemaphoreGive(mappingMutex);
+}
+
+static void lockMappingSave() {
+  if (mappingSaveMutex == nullptr) mappingSaveMutex = xSemaphoreCreateMutex();
+  xSemaphoreTake(mappingSaveMutex, portMAX_DELAY);
+}
+
+static void unlockMappingSave() {
+  xSemaphoreGive(mappingSaveMutex);
+}
+
 // ========== Temperature Monitoring ==========
 
 // Legacy function - now just calls non-blocking version
@@ -37,165 +79,982 @@ float calculateThermistorTemp(float adcValue) {
   return steinhart;
 }
 
-// Update temperature history buffer with max temperature
-void updateTempHistory() {
-  float maxTemp = temperatures[0];
-  for (int i = 1; i < 4; i++) {
-    if (temperatures[i] > maxTemp) {
-      maxTemp = temperatures[i];
+// Hottest valid temperature channel; NAN if none has a reading, so the
+// fan fails safe instead of seeing a cold machine
+float getMaxTemperature() {
+  float maxTemp = NAN;
+  for (uint8_t i = 0; i < temperatureCount; i++) {
+    if (isnan(maxTemp) || temperatures[i] > maxTemp) {
+      maxTemp = temperatures[i];  // NAN (stale) channels never win the compare
     }
   }
+  return maxTemp;
+}
 
-  tempHistory[historyIndex] = maxTemp;
-  historyIndex = (historyIndex + 1) % historySize;
+// Record every channel in the history store (once per second; stale
+// channels are stored as gaps)
+void updateTempHistory() {
+  HEAP_SCOPE(HEAP_HISTORY, "updateTempHistory");
+  // Channels come and go with the sensor mappings
+  if (temperatureCount != historyStoreChannels()) historyStoreResize(temperatureCount);
+  historyStoreAppend(millis() / 1000, temperatures, temperatureCount);
 }
 
 // ========== Fan Control ==========
 
-// Control fan speed based on maximum temperature
-// Maps temperature between low and high thresholds to fan speed range
+// Control fan speed based on maximum temperature (fan_control: curve or
+// PID, RPM targeting, stall kicks). The PWM is only written when the
+// duty changes.
 void controlFan() {
-  float maxTemp = temperatures[0];
-  for (int i = 1; i < 4; i++) {
-    if (temperatures[i] > maxTemp) {
-      maxTemp = temperatures[i];
-    }
-  }
+  static int16_t lastPwm = -1;
 
-  if (maxTemp < cfg.temp_threshold_low) {
-    fanSpeed = cfg.fan_min_speed;
-  } else if (maxTemp > cfg.temp_threshold_high) {
-    fanSpeed = cfg.fan_max_speed_limit;
-  } else {
-    fanSpeed = map(maxTemp * 100, cfg.temp_threshold_low * 100,
-                   cfg.temp_threshold_high * 100,
-                   cfg.fan_min_speed, cfg.fan_max_speed_limit);
-  }
+  const TachStats& tach = getTachStats();
+  uint8_t pwmValue = fanControlUpdate(getMaxTemperature(), fanRPM, tach.stalled,
+                                      tach.revolutions > 0, millis());
+  fanSpeed = lroundf(getFanControlStatus().duty);
 
-  uint8_t pwmValue = map(fanSpeed, 0, 100, 0, 255);
-  ledcWrite(0, pwmValue);  // channel 0
+  if (pwmValue != lastPwm) {
+    ledcWrite(0, pwmValue);  // channel 0
+    lastPwm = pwmValue;
+  }
 }
 
-// Calculate fan RPM from tachometer pulses
-// Assumes tachISR() is incrementing tachCounter on each pulse
-// Most fans output 2 pulses per revolution
+// Update fan RPM from the tachometer (fan_tach) - call every loop()
+// A new value is available after every revolution; a fan that stops while
+// driven is logged once per stall
 void calculateRPM() {
-  fanRPM = (tachCounter * 60) / 2;
-  tachCounter = 0;
-}
+  bool wasStalled = getTachStats().stalled;
+  fanRPM = tachUpdate();
 
-// Tachometer interrupt handler (IRAM for fast execution)
-// Defined in main.cpp - this declaration is here for reference
-// void IRAM_ATTR tachISR() {
-//   tachCounter++;
-// }
+  if (getTachStats().stalled && !wasStalled && fanSpeed > 0) {
+    LOGW("FAN", "Stall: no tach pulses for %lu ms at %d%% PWM",
+         (unsigned long)(TACH_STALL_US / 1000), fanSpeed);
+  }
+}
 
 // ========== PSU Monitoring ==========
 
 // Non-blocking sensor sampling - call this repeatedly in loop()
-// Samples PSU voltage ADC every 5ms and averages 10 samples
+// Drains the PSU sample source (psu_monitor); every completed 50 ms block
+// of 1000 samples flags adcReady
 void sampleSensorsNonBlocking() {
-  if (millis() - lastAdcSample < 5) {
-    return;  // Sample every 5ms
+  // CYD NOTE: Only PSU voltage is ADC-based now (temperatures use DS18B20 OneWire)
+  if (psuMonitorPoll()) {
+    adcReady = true;
   }
-  lastAdcSample = millis();
+}
 
-  // CYD NOTE: Only PSU voltage is ADC-based now (temperatures use DS18B20 OneWire)
-  // Take one sample from PSU voltage sensor only
-  adcSamples[4][adcSampleIndex] = analogRead(PSU_VOLT);  // Index 4 = PSU voltage
+// Process the latest PSU block (called when adcReady is true)
+// psuMin/psuMax follow the block extremes, so dips shorter than a block
+// still register. DS18B20 temperatures are acquired separately by
+// updateTemperatureAcquisition().
+void processAdcReadings() {
+  EVT_SCOPE("processAdcReadings");
+  HEAP_SCOPE(HEAP_SENSORS, "processAdcReadings");
+  const PsuBlock& block = psuLastBlock();
+  psuVoltage = block.meanMv / 1000.0;
 
-  // Move to next sample
-  adcSampleIndex++;
-  if (adcSampleIndex >= 10) {
-    adcSampleIndex = 0;
-    adcReady = true;  // PSU voltage sampling complete
+  if (block.meanMv >= PSU_MIN_VALID_MV) {
+    if (block.minMv / 1000.0 < psuMin) psuMin = block.minMv / 1000.0;
+    if (block.maxMv / 1000.0 > psuMax) psuMax = block.maxMv / 1000.0;
   }
+
+  // Reformat only the display values that changed
+  viewModelUpdate();
 }
 
-// Process averaged ADC readings (called when adcReady is true)
-// Calculates PSU voltage from averaged ADC samples and reads DS18B20 sensors
-void processAdcReadings() {
-  // Read DS18B20 temperature sensors
-  ds18b20Sensors.requestTemperatures();  // Request readings from all sensors
+// ========== DS18B20 Acquisition ==========
+// One broadcast conversion per bus - all buses convert in parallel - then
+// one scratchpad read per loop() call once the resolution-dependent
+// conversion time has elapsed. Every sample runs through the sensor
+// pipeline (gate, hold, calibration, filter, peak); its output goes to
+// the sensor cache and, once per pass, to the channel arrays.
+
+#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+#define DS18B20_POWER_ON_RAW        0x0550  // 85.0C reset value - conversion never ran
+#define DS18B20_MAX_FAILURES        3       // Missed passes before a channel reads NAN
+#define SENSOR_CACHE_SPARE          4       // Room added whenever the cache grows
+
+enum TempAcqState : uint8_t {
+  TEMP_ACQ_IDLE = 0,        // Waiting for the next update interval
+  TEMP_ACQ_CONVERTING,      // Conversion running, buses free for the scan until it completes
+  TEMP_ACQ_READING          // Reading one scratchpad per call
+};
 
-  // Update temperatures array with readings from mapped sensors
-  int deviceCount = ds18b20Sensors.getDeviceCount();
+static TempAcqState tempAcqState = TEMP_ACQ_IDLE;
+static unsigned long conversionStart = 0;
+static uint8_t readCursor = 0;
+static uint8_t passValid = 0;
+static unsigned long passBusUs = 0;
+static bool firstPassLogged = false;
+static uint8_t channelCapacity = 0;         // Length of temperatures / peakTemps
 
-  // Clear temperatures array first
-  for (int i = 0; i < 4; i++) {
-    temperatures[i] = 0.0;
+// One OneWire bus per configured pin (cfg.onewire_pins)
+static OneWire* oneWireBuses[ONEWIRE_MAX_BUSES];
+static DallasTemperature* busDrivers[ONEWIRE_MAX_BUSES];
+static uint8_t busCount = 0;
+static bool parasitePower = false;  // A sensor draws power from the data line
+
+// Sensors found on the buses (at init and by the background scan). Entries
+// are never dropped, so channel numbers stay stable until reboot.
+struct DiscoveredSensor {
+  uint8_t uid[8];
+  uint8_t bus;
+  bool present;           // Seen by the latest scan
+  uint8_t missedSweeps;   // Consecutive scans it was missing from
+};
+static std::vector<DiscoveredSensor> discoveredSensors;
+
+// DS18B20 and DS1822 share the scratchpad format read below
+static bool isDS18B20Family(const uint8_t uid[8]) {
+  return uid[0] == 0x28 || uid[0] == 0x22;
+}
+
+// Conversion time for a resolution (9-12 bits)
+uint16_t ds18b20ConversionTime(uint8_t resolution) {
+  return 750 >> (12 - constrain(resolution, (uint8_t)9, (uint8_t)12));
+}
+
+// Bus a sensor was found on, or SENSOR_BUS_NONE
+static uint8_t findSensorBus(const uint8_t uid[8]) {
+  for (const auto& found : discoveredSensors) {
+    if (memcmp(found.uid, uid, 8) == 0) return found.bus;
   }
+  return SENSOR_BUS_NONE;
+}
 
-  // Read temperatures based on sensor mappings
-  for (size_t i = 0; i < sensorMappings.size() && i < 4; i++) {
-    if (sensorMappings[i].enabled) {
-      float temp = ds18b20Sensors.getTempC(sensorMappings[i].uid);
-      if (temp != DEVICE_DISCONNECTED_C && temp > -55.0 && temp < 125.0) {
-        temperatures[i] = temp;
-        if (temp > peakTemps[i]) {
-          peakTemps[i] = temp;
-        }
-      }
+// Grow the channel arrays, the pipeline and the cache (in that order, so
+// the cache never holds a sensor without a channel) to hold needed sensors
+// plus SENSOR_CACHE_SPARE. Sensors added after boot - hot-plugged or
+// imported - are tracked without a reboot. Growing resets the pipeline.
+static bool reserveChannels(size_t needed) {
+  if (temperatures != nullptr && needed <= channelCapacity && needed <= sensorCacheCapacity()) return true;
+  uint8_t capacity = min(max(needed + SENSOR_CACHE_SPARE, (size_t)4), (size_t)SENSOR_CACHE_MAX);
+  capacity = max(capacity, sensorCacheCapacity());
+
+  if (temperatures == nullptr || capacity > channelCapacity) {
+    float* temps = (float*)realloc(temperatures, capacity * sizeof(float));
+    if (temps != nullptr) temperatures = temps;
+    float* peaks = (float*)realloc(peakTemps, capacity * sizeof(float));
+    if (peaks != nullptr) peakTemps = peaks;
+    if (temps == nullptr || peaks == nullptr) {
+      LOGE("SENSORS", "Failed to allocate %d temperature channels", capacity);
+      return false;
+    }
+    channelCapacity = capacity;
+  }
+  return sensorPipelineInit(capacity) && sensorCacheInit(capacity);
+}
+
+// Rebuild the cache from the mappings and the discovered sensors. Cache
+// entry N is channel N ("tempN"): enabled mappings first in mapping order,
+// then unmapped bus sensors, which get "tempN" as their alias.
+void rebuildSensorCache() {
+  if (temperatures == nullptr) return;
+
+  // Keep the readings and peaks of sensors that stay tracked
+  uint8_t previousChannels = temperatureCount;
+  uint8_t previousCount = sensorCacheCount();
+  SensorReading* previous = (SensorReading*)malloc(max(previousCount, (uint8_t)1) * sizeof(SensorReading));
+  float* previousPeaks = (float*)malloc(max(previousCount, (uint8_t)1) * sizeof(float));
+  if (previous == nullptr || previousPeaks == nullptr) previousCount = 0;
+  for (uint8_t i = 0; i < previousCount; i++) {
+    sensorCacheGet(i, previous[i]);
+    previousPeaks[i] = sensorPipelinePeak(i);
+  }
+
+  // Room for every enabled mapping and bus sensor (an upper bound: mapped
+  // bus sensors count twice). Short of memory, the ones that do not fit are
+  // logged below and retried at the next rebuild.
+  lockMappings();
+  size_t needed = discoveredSensors.size();
+  for (const auto& mapping : sensorMappings) needed += mapping.enabled;
+  unlockMappings();
+  reserveChannels(needed);
+
+  lockMappings();
+  sensorCacheClear();
+
+  for (const auto& mapping : sensorMappings) {
+    if (!mapping.enabled) continue;
+    if (sensorCacheAdd(mapping.uid, mapping.alias, findSensorBus(mapping.uid)) == SENSOR_CACHE_NONE) {
+      LOGW("SENSORS", "Sensor cache full, %s not tracked", mapping.alias);
+    }
+  }
+
+  for (const auto& found : discoveredSensors) {
+    if (sensorCacheFindUID(found.uid) != SENSOR_CACHE_NONE) continue;
+    char alias[8];
+    snprintf(alias, sizeof(alias), "temp%d", sensorCacheCount());
+    if (sensorCacheFindAlias(alias) != SENSOR_CACHE_NONE) alias[0] = '\0';
+    if (sensorCacheAdd(found.uid, alias, found.bus) == SENSOR_CACHE_NONE) {
+      LOGW("SENSORS", "Sensor cache full, unmapped sensor not tracked");
+    }
+  }
+  unlockMappings();
+
+  // Legacy screens always show four channels
+  temperatureCount = min(max(sensorCacheCount(), (uint8_t)4), channelCapacity);
+  uint16_t cycleMs = max(cfg.temp_update_interval, ds18b20ConversionTime(cfg.temp_resolution));
+  sensorPipelineReset(DS18B20_MAX_FAILURES * cycleMs + cycleMs / 2);
+
+  // Channel ch now holds the sensor of channel from[ch]; channels without
+  // a sensor before and after stay where they were
+  uint8_t from[SENSOR_CACHE_MAX];
+  for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+    from[ch] = (ch >= sensorCacheCount() && ch >= previousCount) ? ch : HISTORY_NO_CHANNEL;
+  }
+  bool channelsChanged = (temperatureCount != previousChannels);
+  for (uint8_t i = 0; i < previousCount; i++) {
+    int8_t ch = sensorCacheFindUID(previous[i].uid);
+    if (ch == SENSOR_CACHE_NONE || ch >= temperatureCount) continue;
+    from[ch] = i;
+    SensorReading current;
+    if (sensorCacheGet(ch, current) && strcmp(current.alias, previous[i].alias) != 0) channelsChanged = true;
+    sensorCacheRestore(ch, previous[i]);
+    if (previous[i].valid) {
+      sensorPipelineSeed(ch, previous[i].tempC, previousPeaks[i], previous[i].timestamp);
+    }
+  }
+  for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+    if (from[ch] != ch) channelsChanged = true;
+  }
+
+  // The history follows its sensor; "tempN" and alias bindings are redone
+  // by the loop task once it sees the new generation
+  if (channelsChanged) {
+    if (historyStoreChannels() > 0) historyStoreRemap(from, temperatureCount);
+    channelGeneration++;
+  }
+  free(previous);
+  free(previousPeaks);
+  for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+    temperatures[ch] = sensorPipelineValue(ch);
+    peakTemps[ch] = sensorPipelinePeak(ch);
+  }
+
+  readCursor = 0;
+  tempAcqState = TEMP_ACQ_IDLE;
+}
+
+uint16_t getSensorChannelGeneration() {
+  return channelGeneration;
+}
+
+// Read one sensor's raw scratchpad; false on no presence or bad CRC
+static bool readScratchpadBytes(uint8_t bus, const uint8_t* addr, uint8_t scratchpad[9]) {
+  if (bus >= busCount) return false;
+  OneWire& oneWire = *oneWireBuses[bus];
+
+  if (!oneWire.reset()) return false;
+  oneWire.select(addr);
+  oneWire.write(DS18B20_CMD_READ_SCRATCHPAD);
+  oneWire.read_bytes(scratchpad, 9);
+
+  // An all-zero scratchpad (shorted bus) also passes the CRC
+  return OneWire::crc8(scratchpad, 8) == scratchpad[8] &&
+         !(scratchpad[4] == 0 && scratchpad[8] == 0);
+}
+
+// Read one sensor's temperature; false on no presence, bad CRC or a
+// conversion that never ran (the pipeline gates the range)
+static bool readScratchpad(uint8_t bus, const uint8_t* addr, float& tempC) {
+  uint8_t scratchpad[9];
+  if (!readScratchpadBytes(bus, addr, scratchpad)) return false;
+
+  int16_t raw = (scratchpad[1] << 8) | scratchpad[0];
+  if (raw == DS18B20_POWER_ON_RAW) return false;
+
+  // Low bits are undefined below 12-bit resolution (config register bits 5-6)
+  uint8_t resolution = ((scratchpad[4] >> 5) & 0x03) + 9;
+  raw &= ~((1 << (12 - resolution)) - 1);
+
+  tempC = raw / 16.0f;
+  return true;
+}
+
+// Read the next sensor in the pass; true once every sensor has been read
+static bool readNextScratchpad() {
+  // Identification candidates convert at 9 bits: their channels keep the
+  // last reading at the configured resolution until the session is over
+  while (readCursor < sensorCacheCount() && identHolds(sensorCacheUID(readCursor))) readCursor++;
+  if (readCursor >= sensorCacheCount()) return true;
+  EVT_SCOPE("ds18b20_read");
+
+  unsigned long busStart = micros();
+  float temp = 0.0;
+  bool ok = readScratchpad(sensorCacheBus(readCursor), sensorCacheUID(readCursor), temp);
+  passBusUs += micros() - busStart;
+
+  // The pipeline holds the last good value through a glitch
+  PipeResult result = sensorPipelineProcess(readCursor, ok, temp, millis());
+  sensorCacheStore(readCursor, result == PIPE_ACCEPTED,
+                   sensorPipelineValue(readCursor), sensorPipelineValid(readCursor));
+  if (result == PIPE_ACCEPTED) passValid++;
+  readCursor++;
+  return readCursor >= sensorCacheCount();
+}
+
+// Copy the cache into the channel arrays after a completed pass
+static void publishChannels() {
+  // NAN once a channel is stale - consumers skip it instead of seeing 0
+  for (uint8_t ch = 0; ch < temperatureCount; ch++) {
+    temperatures[ch] = sensorPipelineValue(ch);
+    peakTemps[ch] = sensorPipelinePeak(ch);
+  }
+
+  if (!firstPassLogged) {
+    firstPassLogged = true;
+    LOGI("SENSORS", "DS18B20 pass: %d/%d valid on %d bus(es), %lu us bus time per %u ms cycle",
+         passValid, sensorCacheCount(), busCount, passBusUs,
+         max(cfg.temp_update_interval, ds18b20ConversionTime(cfg.temp_resolution)));
+  }
+}
+
+// Touch identification progress, driven by updateIdentification()
+enum IdentPhase : uint8_t {
+  IDENT_PHASE_OFF = 0,
+  IDENT_PHASE_SETUP,        // Switching candidates to 9-bit, one per call
+  IDENT_PHASE_CONVERT,      // Addressed convert, one candidate per call
+  IDENT_PHASE_WAIT,         // 9-bit conversion time
+  IDENT_PHASE_READ,         // One candidate scratchpad per call
+  IDENT_PHASE_RESTORE       // Back to the configured resolution, one per call
+};
+static IdentPhase identPhase = IDENT_PHASE_OFF;
+
+// ========== Background Bus Scan ==========
+// Every BUS_SCAN_INTERVAL_MS the ROM search tree of each bus is walked a
+// few steps per loop() tick, only while the buses are otherwise idle. The
+// found set is diffed against the known sensors and mappings to raise
+// added/removed events; new sensors get the configured resolution.
+
+#define BUS_SCAN_INTERVAL_MS  5000
+#define BUS_SCAN_SLICE_US     1000  // Bus time per tick (may overrun by one ~1 ms step)
+#define BUS_SCAN_MISSES       2     // Scans a sensor must miss before it is reported removed
+#define SENSOR_EVENT_QUEUE    16
+#define DS18B20_CMD_WRITE_SCRATCHPAD 0x4E
+
+static OneWireSearch busSearch;
+static bool scanActive = false;
+static uint8_t scanBus = 0;
+static unsigned long lastScanEnd = 0;
+static std::vector<DiscoveredSensor> scanFound;
+static std::vector<DiscoveredSensor> resolutionPending;  // New sensors still at their power-on resolution
+static BusScanStats scanStats = {};
+
+static SensorEvent sensorEvents[SENSOR_EVENT_QUEUE];
+static uint32_t sensorEventSeq = 0;  // Sequence number of the newest event
+static portMUX_TYPE eventMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void raiseSensorEvent(SensorEventType type, const DiscoveredSensor& sensor, bool mapped) {
+  SensorEvent event;
+  event.timeMs = millis();
+  event.type = type;
+  event.bus = sensor.bus;
+  event.mapped = mapped;
+  memcpy(event.uid, sensor.uid, 8);
+
+  portENTER_CRITICAL(&eventMux);
+  event.seq = ++sensorEventSeq;
+  sensorEvents[event.seq % SENSOR_EVENT_QUEUE] = event;
+  portEXIT_CRITICAL(&eventMux);
+
+  LOGI("SENSORS", "Sensor %s: %s on bus %d%s",
+       type == SENSOR_EVENT_ADDED ? "added" : "removed",
+       uidToString(sensor.uid).c_str(), sensor.bus, mapped ? " (mapped)" : "");
+}
+
+uint8_t getSensorEvents(uint32_t since, SensorEvent* out, uint8_t maxEvents) {
+  uint8_t count = 0;
+  portENTER_CRITICAL(&eventMux);
+  uint32_t first = since + 1;
+  if (sensorEventSeq >= SENSOR_EVENT_QUEUE && first <= sensorEventSeq - SENSOR_EVENT_QUEUE) {
+    first = sensorEventSeq - SENSOR_EVENT_QUEUE + 1;  // Older events were overwritten
+  }
+  for (uint32_t seq = first; seq <= sensorEventSeq && count < maxEvents; seq++) {
+    out[count++] = sensorEvents[seq % SENSOR_EVENT_QUEUE];
+  }
+  portEXIT_CRITICAL(&eventMux);
+  return count;
+}
+
+const BusScanStats& getBusScanStats() {
+  return scanStats;
+}
+
+// Set one sensor's resolution (scratchpad only, not EEPROM), keeping TH/TL
+static void writeSensorResolution(uint8_t bus, const uint8_t* addr, uint8_t resolution) {
+  uint8_t scratchpad[9];
+  if (!readScratchpadBytes(bus, addr, scratchpad)) return;
+
+  OneWire& oneWire = *oneWireBuses[bus];
+  oneWire.reset();
+  oneWire.select(addr);
+  oneWire.write(DS18B20_CMD_WRITE_SCRATCHPAD);
+  oneWire.write(scratchpad[2]);  // TH
+  oneWire.write(scratchpad[3]);  // TL
+  oneWire.write(((resolution - 9) << 5) | 0x1F);
+}
+
+// Diff a completed scan against the known sensors
+static void finishBusScan() {
+  std::vector<DiscoveredSensor> added;
+  bool changed = false;
+
+  lockMappings();
+  for (const auto& found : scanFound) {
+    DiscoveredSensor* known = nullptr;
+    for (auto& sensor : discoveredSensors) {
+      if (memcmp(sensor.uid, found.uid, 8) == 0) known = &sensor;
+    }
+
+    if (known == nullptr) {
+      discoveredSensors.push_back(found);
+      known = &discoveredSensors.back();
+      known->present = false;
+    }
+    known->missedSweeps = 0;
+    if (known->bus != found.bus) {
+      known->bus = found.bus;  // Moved to another bus
+      changed = true;
+    }
+    if (!known->present) {
+      known->present = true;
+      added.push_back(*known);
+      raiseSensorEvent(SENSOR_EVENT_ADDED, *known, findMappingByUID(known->uid) >= 0);
+      changed = true;
+    }
+  }
+
+  uint8_t present = 0;
+  for (auto& sensor : discoveredSensors) {
+    bool seen = false;
+    for (const auto& found : scanFound) {
+      if (memcmp(sensor.uid, found.uid, 8) == 0) seen = true;
+    }
+    if (seen) {
+      present++;
+    } else if (sensor.present && ++sensor.missedSweeps >= BUS_SCAN_MISSES) {
+      sensor.present = false;
+      raiseSensorEvent(SENSOR_EVENT_REMOVED, sensor, findMappingByUID(sensor.uid) >= 0);
     }
   }
+  unlockMappings();
 
-  // If no mappings exist yet, read first 4 discovered sensors directly
-  if (sensorMappings.empty() && deviceCount > 0) {
-    for (int i = 0; i < min(deviceCount, 4); i++) {
-      float temp = ds18b20Sensors.getTempCByIndex(i);
-      if (temp != DEVICE_DISCONNECTED_C && temp > -55.0 && temp < 125.0) {
-        temperatures[i] = temp;
-        if (temp > peakTemps[i]) {
-          peakTemps[i] = temp;
+  // Written by updateBusScan(), one per tick
+  resolutionPending.insert(resolutionPending.end(), added.begin(), added.end());
+  if (changed) sensorTablesChanged = true;
+
+  scanStats.scans++;
+  scanStats.present = present;
+  scanStats.scanMs = millis() - scanStats.scanStartMs;
+  if (scanStats.scans == 1 || changed) {
+    LOGI("SENSORS", "Bus scan: %d sensor(s), %u steps over %u ticks in %lu ms, max slice %u us",
+         present, scanStats.scanSteps, scanStats.scanTicks,
+         (unsigned long)scanStats.scanMs, scanStats.maxSliceUs);
+  }
+}
+
+// Walk the ROM search a time slice further - call only while the buses are idle
+// (between passes, or converting without parasite power)
+static void updateBusScan() {
+  // A ROM walk in progress owns the bus until its 64th bit
+  if (!resolutionPending.empty() && !oneWireSearchInDevice(busSearch)) {
+    const DiscoveredSensor& sensor = resolutionPending.back();
+    writeSensorResolution(sensor.bus, sensor.uid, cfg.temp_resolution);
+    resolutionPending.pop_back();
+    return;
+  }
+
+  if (!scanActive) {
+    // An identification session keeps the idle time for itself
+    if (busCount == 0 || millis() - lastScanEnd < BUS_SCAN_INTERVAL_MS || identPhase != IDENT_PHASE_OFF) return;
+    scanActive = true;
+    scanBus = 0;
+    scanFound.clear();
+    oneWireSearchBegin(busSearch, oneWireBuses[0]);
+    scanStats.scanStartMs = millis();
+    scanStats.scanSteps = 0;
+    scanStats.scanTicks = 0;
+  }
+
+  unsigned long sliceStart = micros();
+  scanStats.scanTicks++;
+  while (scanActive && micros() - sliceStart < BUS_SCAN_SLICE_US) {
+    unsigned long stepStart = micros();
+    OneWireSearchResult result = oneWireSearchStep(busSearch);
+    uint16_t stepUs = micros() - stepStart;
+    if (stepUs > scanStats.maxStepUs) scanStats.maxStepUs = stepUs;
+    scanStats.scanSteps++;
+
+    switch (result) {
+      case OW_SEARCH_FOUND:
+        if (isDS18B20Family(busSearch.rom)) {
+          DiscoveredSensor found = {};
+          memcpy(found.uid, busSearch.rom, 8);
+          found.bus = scanBus;
+          found.present = true;
+          scanFound.push_back(found);
+        }
+        break;
+
+      case OW_SEARCH_DONE:
+        if (++scanBus < busCount) {
+          oneWireSearchBegin(busSearch, oneWireBuses[scanBus]);
+        } else {
+          scanActive = false;
+          lastScanEnd = millis();
+          finishBusScan();
         }
+        break;
+
+      case OW_SEARCH_ERROR:
+        // Incomplete scan - a partial set would look like removals
+        scanActive = false;
+        lastScanEnd = millis();
+        scanStats.errors++;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  uint16_t sliceUs = micros() - sliceStart;
+  if (sliceUs > scanStats.maxSliceUs) scanStats.maxSliceUs = sliceUs;
+}
+
+// ========== Touch Identification ==========
+// Finds the unmapped sensor a technician is holding by its temperature
+// rise. Candidates are switched to 9-bit resolution (94 ms conversions)
+// and converted by address between the transactions of the normal
+// cycle, which keeps running. Each candidate gets a baseline (mean over
+// the first second) and a smoothed slope; the first one whose rise stays
+// over the threshold for two rounds is reported. The normal pass skips
+// the candidates meanwhile, so their channels hold the last reading at
+// the configured resolution instead of publishing 9-bit samples.
+
+#define IDENT_RESOLUTION        9
+#define IDENT_BASELINE_MS       1000
+#define IDENT_CONFIRM_ROUNDS    2
+#define IDENT_MIN_SLOPE         0.05    // C/s - a hand keeps heating, drift does not
+#define IDENT_MAX_TIMEOUT_MS    120000
+#define DS18B20_CMD_CONVERT     0x44
+
+struct IdentCandidate {
+  uint8_t uid[8];
+  uint8_t bus;
+  uint8_t baselineSamples;
+  uint8_t overRounds;       // Consecutive rounds over the threshold
+  float baseline;
+  float lastTemp;
+  float slope;              // C/s, smoothed
+  unsigned long lastMs;
+};
+
+static std::vector<IdentCandidate> identCandidates;  // Kept until the first convert after the session
+static uint8_t identCursor = 0;
+static unsigned long identStart = 0;
+static unsigned long identConvertEnd = 0;
+static uint32_t identTimeoutMs = 0;
+static float identThreshold = 1.0;
+
+// Shared with the web task
+static SensorIdentStatus identStatus = {};
+static bool identStartPending = false;
+static bool identCancelPending = false;
+static uint32_t pendingTimeoutMs = 0;
+static float pendingThreshold = 0.0;
+static portMUX_TYPE identMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool identRunning(const SensorIdentStatus& status) {
+  return status.state == IDENT_BASELINE || status.state == IDENT_WATCHING;
+}
+
+bool startSensorIdentification(uint32_t timeoutMs, float thresholdDelta) {
+  if (thresholdDelta <= 0.0) return false;
+
+  portENTER_CRITICAL(&identMux);
+  bool started = !identRunning(identStatus);
+  if (started) {
+    uint16_t session = identStatus.session + 1;
+    identStatus = {};
+    identStatus.session = session;
+    identStatus.state = IDENT_BASELINE;
+    identStartPending = true;
+    identCancelPending = false;
+    pendingTimeoutMs = min(timeoutMs, (uint32_t)IDENT_MAX_TIMEOUT_MS);
+    pendingThreshold = thresholdDelta;
+  }
+  portEXIT_CRITICAL(&identMux);
+  return started;
+}
+
+void cancelSensorIdentification() {
+  portENTER_CRITICAL(&identMux);
+  if (identRunning(identStatus)) identCancelPending = true;
+  portEXIT_CRITICAL(&identMux);
+}
+
+void getSensorIdentification(SensorIdentStatus& out) {
+  portENTER_CRITICAL(&identMux);
+  out = identStatus;
+  portEXIT_CRITICAL(&identMux);
+}
+
+// Poll-style wrapper kept for the original API: starts a session when none
+// is running and returns the touched UID once per detection, "" otherwise
+String detectTouchedSensor(unsigned long timeoutMs, float thresholdDelta) {
+  static uint16_t reportedSession = 0;
+
+  SensorIdentStatus status;
+  getSensorIdentification(status);
+  if (status.state == IDENT_DETECTED && status.session != reportedSession) {
+    reportedSession = status.session;
+    return uidToString(status.uid);
+  }
+  if (!identRunning(status)) startSensorIdentification(timeoutMs, thresholdDelta);
+  return "";
+}
+
+// True while a sensor's channel is held for a session: from its switch to
+// 9 bits until the first broadcast convert after it was switched back
+static bool identHolds(const uint8_t uid[8]) {
+  for (const auto& candidate : identCandidates) {
+    if (memcmp(candidate.uid, uid, 8) == 0) return true;
+  }
+  return false;
+}
+
+static void beginIdentification(uint32_t timeoutMs, float threshold) {
+  identCandidates.clear();
+  lockMappings();
+  for (const auto& sensor : discoveredSensors) {
+    if (!sensor.present || findMappingByUID(sensor.uid) >= 0) continue;
+    IdentCandidate candidate = {};
+    memcpy(candidate.uid, sensor.uid, 8);
+    candidate.bus = sensor.bus;
+    identCandidates.push_back(candidate);
+  }
+  unlockMappings();
+
+  identTimeoutMs = timeoutMs;
+  identThreshold = threshold;
+  identStart = millis();
+  identCursor = 0;
+
+  portENTER_CRITICAL(&identMux);
+  identStatus.candidates = identCandidates.size();
+  if (identCandidates.empty()) identStatus.state = IDENT_NO_SENSORS;
+  portEXIT_CRITICAL(&identMux);
+
+  if (identCandidates.empty()) {
+    LOGI("SENSORS", "Identification: every sensor is already mapped");
+    return;
+  }
+  identPhase = IDENT_PHASE_SETUP;
+  LOGI("SENSORS", "Identification started: %d unmapped sensor(s), +%.1fC within %lu ms",
+       (int)identCandidates.size(), threshold, (unsigned long)timeoutMs);
+}
+
+// End the session; resolutions are restored over the next calls
+static void finishIdentification(SensorIdentState state) {
+  portENTER_CRITICAL(&identMux);
+  identStatus.state = state;
+  identStatus.elapsedMs = millis() - identStart;
+  portEXIT_CRITICAL(&identMux);
+
+  identPhase = IDENT_PHASE_RESTORE;
+  identCursor = 0;
+
+  if (state == IDENT_DETECTED) {
+    LOGI("SENSORS", "Identified %s: +%.2fC at %.2fC/s, confidence %d%%",
+         uidToString(identStatus.uid).c_str(), identStatus.rise, identStatus.slope,
+         identStatus.confidence);
+  } else {
+    LOGI("SENSORS", "Identification %s", state == IDENT_TIMEOUT ? "timed out" : "cancelled");
+  }
+}
+
+static void sampleCandidate(IdentCandidate& candidate, float temp, unsigned long now) {
+  if (now - identStart < IDENT_BASELINE_MS || candidate.baselineSamples == 0) {
+    candidate.baseline = (candidate.baseline * candidate.baselineSamples + temp) /
+                         (candidate.baselineSamples + 1);
+    candidate.baselineSamples++;
+  }
+  if (candidate.lastMs != 0 && now > candidate.lastMs) {
+    float rate = (temp - candidate.lastTemp) * 1000.0 / (now - candidate.lastMs);
+    candidate.slope = 0.7 * candidate.slope + 0.3 * rate;
+  }
+  candidate.lastTemp = temp;
+  candidate.lastMs = now;
+}
+
+// After every round: look for a confirmed rise, publish progress
+static void evaluateIdentification(unsigned long now) {
+  bool watching = now - identStart >= IDENT_BASELINE_MS;
+  IdentCandidate* best = nullptr;
+  IdentCandidate* leader = nullptr;
+
+  for (auto& candidate : identCandidates) {
+    if (candidate.baselineSamples == 0) continue;
+    float rise = candidate.lastTemp - candidate.baseline;
+    candidate.overRounds = (watching && rise >= identThreshold) ? candidate.overRounds + 1 : 0;
+    if (leader == nullptr || rise > leader->lastTemp - leader->baseline) leader = &candidate;
+    if (candidate.overRounds >= IDENT_CONFIRM_ROUNDS &&
+        (best == nullptr || rise > best->lastTemp - best->baseline)) {
+      best = &candidate;
+    }
+  }
+
+  // Confidence: how far the winner stands above every other sensor (an
+  // ambient change lifts them all), discounted once it stops climbing
+  uint8_t confidence = 0;
+  if (best != nullptr) {
+    float rise = best->lastTemp - best->baseline;
+    float otherRise = 0.0;
+    for (const auto& candidate : identCandidates) {
+      if (&candidate == best || candidate.baselineSamples == 0) continue;
+      otherRise = max(otherRise, candidate.lastTemp - candidate.baseline);
+    }
+    float separation = constrain(1.0 - otherRise / rise, 0.0, 1.0);
+    float trend = (best->slope >= IDENT_MIN_SLOPE) ? 1.0 : 0.7;
+    confidence = separation * trend * 100.0 + 0.5;
+    leader = best;
+  }
+
+  portENTER_CRITICAL(&identMux);
+  identStatus.rounds++;
+  identStatus.elapsedMs = now - identStart;
+  if (identStatus.state == IDENT_BASELINE && watching) identStatus.state = IDENT_WATCHING;
+  if (leader != nullptr) {
+    memcpy(identStatus.uid, leader->uid, 8);
+    identStatus.rise = leader->lastTemp - leader->baseline;
+    identStatus.slope = leader->slope;
+  }
+  identStatus.confidence = confidence;
+  portEXIT_CRITICAL(&identMux);
+
+  if (best != nullptr) {
+    finishIdentification(IDENT_DETECTED);
+  } else if (now - identStart >= identTimeoutMs) {
+    finishIdentification(IDENT_TIMEOUT);
+  }
+}
+
+// Advance the session by at most one bus transaction
+static void updateIdentification() {
+  portENTER_CRITICAL(&identMux);
+  bool cancel = identCancelPending;
+  bool start = identStartPending && identPhase == IDENT_PHASE_OFF && !cancel;
+  uint32_t timeoutMs = pendingTimeoutMs;
+  float threshold = pendingThreshold;
+  identCancelPending = false;
+  if (start || cancel) identStartPending = false;
+  portEXIT_CRITICAL(&identMux);
+
+  if (cancel) {
+    if (identPhase != IDENT_PHASE_OFF && identPhase != IDENT_PHASE_RESTORE) {
+      finishIdentification(IDENT_CANCELLED);
+    } else {
+      portENTER_CRITICAL(&identMux);
+      identStatus.state = IDENT_CANCELLED;  // Cancelled before it started
+      portEXIT_CRITICAL(&identMux);
+    }
+  }
+  if (start) beginIdentification(timeoutMs, threshold);
+
+  // A ROM walk owns the bus until its 64th bit
+  if (identPhase == IDENT_PHASE_OFF || oneWireSearchInDevice(busSearch)) return;
+
+  unsigned long now = millis();
+  IdentCandidate& candidate = identCandidates[identCursor];
+  bool roundDone = false;
+
+  switch (identPhase) {
+    case IDENT_PHASE_SETUP:
+    case IDENT_PHASE_RESTORE:
+      writeSensorResolution(candidate.bus, candidate.uid,
+                            identPhase == IDENT_PHASE_SETUP ? IDENT_RESOLUTION : cfg.temp_resolution);
+      break;
+
+    case IDENT_PHASE_CONVERT: {
+      OneWire& oneWire = *oneWireBuses[candidate.bus];
+      if (oneWire.reset()) {
+        oneWire.select(candidate.uid);
+        oneWire.write(DS18B20_CMD_CONVERT);
+      }
+      identConvertEnd = now;
+      break;
+    }
+
+    case IDENT_PHASE_WAIT:
+      if (now - identConvertEnd >= ds18b20ConversionTime(IDENT_RESOLUTION)) {
+        identPhase = IDENT_PHASE_READ;
       }
+      return;
+
+    case IDENT_PHASE_READ: {
+      float temp = 0.0;
+      if (readScratchpad(candidate.bus, candidate.uid, temp) && temp > -55.0 && temp < 125.0) {
+        sampleCandidate(candidate, temp, now);
+      }
+      break;
     }
+
+    default:
+      return;
   }
 
-  // Process PSU voltage
-  uint32_t sum = 0;
-  for (int i = 0; i < 10; i++) {
-    sum += adcSamples[4][i];
+  if (++identCursor < identCandidates.size()) return;
+  identCursor = 0;
+
+  switch (identPhase) {
+    case IDENT_PHASE_SETUP:   identPhase = IDENT_PHASE_CONVERT; break;
+    case IDENT_PHASE_CONVERT: identPhase = IDENT_PHASE_WAIT; break;
+    case IDENT_PHASE_READ:    identPhase = IDENT_PHASE_CONVERT; roundDone = true; break;
+    case IDENT_PHASE_RESTORE:
+      identPhase = IDENT_PHASE_OFF;
+      break;
+    default:
+      break;
   }
-  float adcValue = sum / 10.0;
-  float measuredVoltage = (adcValue / ADC_RESOLUTION) * 3.3;
-  psuVoltage = measuredVoltage * cfg.psu_voltage_cal;
+  if (roundDone) evaluateIdentification(now);
+}
 
-  if (psuVoltage < psuMin && psuVoltage > 10.0) psuMin = psuVoltage;
-  if (psuVoltage > psuMax) psuMax = psuVoltage;
+void exportSensorIdentificationJson(JsonDocument& doc) {
+  static const char* const stateNames[] = {
+    "idle", "baseline", "watching", "detected", "timeout", "cancelled", "no_sensors"
+  };
+
+  SensorIdentStatus status;
+  getSensorIdentification(status);
+  doc["session"] = status.session;
+  doc["state"] = stateNames[status.state];
+  doc["candidates"] = status.candidates;
+  doc["rounds"] = status.rounds;
+  doc["elapsedMs"] = status.elapsedMs;
+  if (status.rounds > 0) {
+    // The detected sensor, or the one leading so far
+    doc["uid"] = uidToString(status.uid);
+    doc["rise"] = status.rise;
+    doc["slope"] = status.slope;
+  }
+  if (status.state == IDENT_DETECTED) {
+    doc["confidence"] = status.confidence;
+  }
+}
+
+// Advance the acquisition state machine - call every loop(), never blocks
+// for more than one scratchpad read (plus one identification transaction)
+void updateTemperatureAcquisition() {
+  HEAP_SCOPE(HEAP_SENSORS, "updateTemperatureAcquisition");
+  // Mappings edited from the web API take effect between passes
+  if (sensorTablesChanged && tempAcqState != TEMP_ACQ_READING) {
+    sensorTablesChanged = false;
+    rebuildSensorCache();
+  }
+
+  updateIdentification();
+
+  unsigned long now = millis();
+  uint16_t conversionMs = ds18b20ConversionTime(cfg.temp_resolution);
+
+  switch (tempAcqState) {
+    case TEMP_ACQ_IDLE:
+      if (busCount == 0) return;
+      // The bus scan runs while the buses are idle, and a ROM walk in
+      // progress is finished first - the convert reset would abort it
+      if (now - conversionStart < max(cfg.temp_update_interval, conversionMs) ||
+          oneWireSearchInDevice(busSearch)) {
+        updateBusScan();
+        return;
+      }
+      EVT_INSTANT("ds18b20_convert");
+      // Every sensor converts at the configured resolution again
+      if (identPhase == IDENT_PHASE_OFF) identCandidates.clear();
+      for (uint8_t b = 0; b < busCount; b++) {
+        busDrivers[b]->requestTemperatures();  // Broadcast convert, returns immediately
+      }
+      conversionStart = now;
+      tempAcqState = TEMP_ACQ_CONVERTING;
+      break;
+
+    case TEMP_ACQ_CONVERTING:
+      // Externally powered sensors convert with the bus free, so the scan
+      // gets the conversion time too. Parasite-powered ones need the line
+      // held high until they finish.
+      if (now - conversionStart < conversionMs || oneWireSearchInDevice(busSearch)) {
+        if (!parasitePower) updateBusScan();
+        return;
+      }
+      readCursor = 0;
+      passValid = 0;
+      passBusUs = 0;
+      tempAcqState = TEMP_ACQ_READING;
+      break;
+
+    case TEMP_ACQ_READING:
+      if (!readNextScratchpad()) return;
+      publishChannels();
+      tempAcqState = TEMP_ACQ_IDLE;
+
+      // Reformat only the display values that changed
+      viewModelUpdate();
+      break;
+  }
 }
 
 // ========== Sensor Management Functions ==========
 
-// Initialize DS18B20 sensors on OneWire bus
+// Initialize DS18B20 sensors on every configured OneWire bus
 void initDS18B20Sensors() {
-  Serial.println("[SENSORS] Initializing DS18B20 sensors...");
+  LOGI("SENSORS", "Initializing DS18B20 sensors...");
+  LOGI("SENSORS", "Resolution %d-bit, conversion %d ms, update every %d ms",
+       cfg.temp_resolution, ds18b20ConversionTime(cfg.temp_resolution),
+       max(cfg.temp_update_interval, ds18b20ConversionTime(cfg.temp_resolution)));
 
-  ds18b20Sensors.begin();
-  int deviceCount = ds18b20Sensors.getDeviceCount();
+  discoveredSensors.clear();
+  for (uint8_t i = 0; i < ONEWIRE_MAX_BUSES && busCount < ONEWIRE_MAX_BUSES; i++) {
+    uint8_t pin = cfg.onewire_pins[i];
+    if (pin == ONEWIRE_PIN_NONE) continue;
 
-  Serial.printf("[SENSORS] Found %d DS18B20 sensor(s) on bus\n", deviceCount);
+    uint8_t bus = busCount++;
+    oneWireBuses[bus] = new OneWire(pin);
+    busDrivers[bus] = new DallasTemperature(oneWireBuses[bus]);
+    DallasTemperature& drivers = *busDrivers[bus];
 
-  // Set resolution to 12-bit for all sensors (0.0625°C precision)
-  ds18b20Sensors.setResolution(12);
+    drivers.begin();
+    int deviceCount = drivers.getDeviceCount();
+    if (drivers.isParasitePowerMode()) parasitePower = true;
+    LOGI("SENSORS", "Bus %d (GPIO%d): %d DS18B20 sensor(s)", bus, pin, deviceCount);
 
-  // Set wait for conversion to false for non-blocking operation
-  ds18b20Sensors.setWaitForConversion(false);
+    // Resolution trades precision for update rate (12-bit: 0.0625°C, 750 ms)
+    drivers.setResolution(cfg.temp_resolution);
 
-  // Print discovered sensor UIDs
-  for (int i = 0; i < deviceCount; i++) {
-    uint8_t addr[8];
-    if (ds18b20Sensors.getAddress(addr, i)) {
-      Serial.printf("[SENSORS] Sensor %d UID: ", i);
-      for (int j = 0; j < 8; j++) {
-        Serial.printf("%02X", addr[j]);
-        if (j < 7) Serial.print(":");
-      }
-      Serial.println();
+    // Set wait for conversion to false for non-blocking operation
+    drivers.setWaitForConversion(false);
+
+    // Print discovered sensor UIDs
+    for (int d = 0; d < deviceCount; d++) {
+      DiscoveredSensor found = {};
+      if (!drivers.getAddress(found.uid, d) || !isDS18B20Family(found.uid)) continue;
+      found.bus = bus;
+      found.present = true;
+      discoveredSensors.push_back(found);
+
+      LOGI("SENSORS", "Sensor %d UID: %s", d, uidToString(found.uid).c_str());
     }
   }
 
-  Serial.println("[SENSORS] DS18B20 initialization complete");
+  // Size the cache and channel arrays from what is configured and present;
+  // rebuildSensorCache() grows them when sensors are added later
+  if (!reserveChannels(sensorMappings.size() + discoveredSensors.size())) return;
+
+  rebuildSensorCache();
+  LOGI("SENSORS", "Sensor cache: %d sensor(s), %d channel(s), capacity %d",
+       sensorCacheCount(), temperatureCount, sensorCacheCapacity());
+  LOGI("SENSORS", "DS18B20 initialization complete");
 }
 
 // Get sensor count from mappings
@@ -203,24 +1062,423 @@ int getSensorCount() {
   return sensorMappings.size();
 }
 
-// Get temperature by alias (e.g., "temp0")
-float getTempByAlias(const char* alias) {
+// ========== Sensor Mapping Storage ==========
+// Mappings persist in NVS as one versioned binary record, restored at boot
+// with a single read. Per mapping: uid[8], flags, then alias, name and notes
+// as length-prefixed strings. JSON import/export is for the web API.
+
+#define SENSOR_MAP_MAGIC    0x50414D53  // "SMAP"
+#define SENSOR_MAP_VERSION  1
+#define SENSOR_MAP_NVS_NS   "sensors"
+#define SENSOR_MAP_NVS_KEY  "map"
+#define SENSOR_MAP_MAX      SENSOR_CACHE_MAX
+#define SENSOR_MAP_ENABLED  0x01
+
+struct SensorMapHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t count;
+  uint16_t payloadLen;
+  uint16_t crc;          // OneWire::crc16 of the payload
+  uint16_t reserved;
+};
+
+// Hash index over sensorMappings: bucket -> mapping index
+#define MAP_BUCKETS      128    // >= 2 * SENSOR_MAP_MAX, power of two
+#define MAP_BUCKET_EMPTY 0xFF
+static uint8_t mapUidBuckets[MAP_BUCKETS];
+static uint8_t mapAliasBuckets[MAP_BUCKETS];
+
+// Largest record: every string at full length
+static size_t maxRecordSize(size_t count) {
+  return sizeof(SensorMapHeader) +
+         count * (8 + 1 + 3 + sizeof(SensorMapping::alias) + sizeof(SensorMapping::friendlyName) +
+                  sizeof(SensorMapping::notes));
+}
+
+// Rebuild the UID and alias index - call with the mapping lock held
+static void rebuildMappingIndex() {
+  memset(mapUidBuckets, MAP_BUCKET_EMPTY, sizeof(mapUidBuckets));
+  memset(mapAliasBuckets, MAP_BUCKET_EMPTY, sizeof(mapAliasBuckets));
+
+  for (size_t i = 0; i < sensorMappings.size(); i++) {
+    uint8_t b = sensorUIDHash(sensorMappings[i].uid) & (MAP_BUCKETS - 1);
+    while (mapUidBuckets[b] != MAP_BUCKET_EMPTY) b = (b + 1) & (MAP_BUCKETS - 1);
+    mapUidBuckets[b] = i;
+
+    if (sensorMappings[i].alias[0] == '\0') continue;
+    b = sensorAliasHash(sensorMappings[i].alias) & (MAP_BUCKETS - 1);
+    while (mapAliasBuckets[b] != MAP_BUCKET_EMPTY) b = (b + 1) & (MAP_BUCKETS - 1);
+    mapAliasBuckets[b] = i;
+  }
+}
+
+// Mapping index for a UID or alias, -1 if none - call with the lock held.
+// Probes are bounded, so an index not yet built at boot is harmless.
+static int findMappingByUID(const uint8_t uid[8]) {
+  uint8_t b = sensorUIDHash(uid) & (MAP_BUCKETS - 1);
+  for (uint8_t n = 0; n < MAP_BUCKETS && mapUidBuckets[b] != MAP_BUCKET_EMPTY; n++) {
+    uint8_t index = mapUidBuckets[b];
+    if (index < sensorMappings.size() && memcmp(sensorMappings[index].uid, uid, 8) == 0) return index;
+    b = (b + 1) & (MAP_BUCKETS - 1);
+  }
+  return -1;
+}
+
+static int findMappingByAlias(const char* alias) {
+  uint8_t b = sensorAliasHash(alias) & (MAP_BUCKETS - 1);
+  for (uint8_t n = 0; n < MAP_BUCKETS && mapAliasBuckets[b] != MAP_BUCKET_EMPTY; n++) {
+    uint8_t index = mapAliasBuckets[b];
+    if (index < sensorMappings.size() && strcmp(sensorMappings[index].alias, alias) == 0) return index;
+    b = (b + 1) & (MAP_BUCKETS - 1);
+  }
+  return -1;
+}
+
+static uint8_t* putString(uint8_t* p, const char* s) {
+  uint8_t len = strlen(s);
+  *p++ = len;
+  memcpy(p, s, len);
+  return p + len;
+}
+
+static bool getString(const uint8_t*& p, const uint8_t* end, char* dst, size_t dstSize) {
+  if (p >= end) return false;
+  uint8_t len = *p++;
+  if (len >= dstSize || p + len > end) return false;
+  memcpy(dst, p, len);
+  dst[len] = '\0';
+  p += len;
+  return true;
+}
+
+// A serialized mapping record, built under mappingMutex and stored after
+// it is released
+struct MappingRecord {
+  uint8_t* data;            // nullptr with no mappings (the key is removed)
+  size_t len;
+  uint8_t count;
+  bool ok;                  // false if out of memory
+};
+
+// Serialize the mappings - call with mappingMutex held
+static MappingRecord buildMappingRecord() {
+  MappingRecord out = {nullptr, 0, 0, true};
+  if (sensorMappings.empty()) return out;
+
+  uint8_t* record = (uint8_t*)malloc(maxRecordSize(sensorMappings.size()));
+  if (record == nullptr) {
+    out.ok = false;
+    return out;
+  }
+
+  uint8_t* payload = record + sizeof(SensorMapHeader);
+  uint8_t* p = payload;
   for (const auto& mapping : sensorMappings) {
-    if (strcmp(mapping.alias, alias) == 0 && mapping.enabled) {
-      float temp = ds18b20Sensors.getTempC(mapping.uid);
-      if (temp != DEVICE_DISCONNECTED_C && temp > -55.0 && temp < 125.0) {
-        return temp;
+    memcpy(p, mapping.uid, 8);
+    p += 8;
+    *p++ = mapping.enabled ? SENSOR_MAP_ENABLED : 0;
+    p = putString(p, mapping.alias);
+    p = putString(p, mapping.friendlyName);
+    p = putString(p, mapping.notes);
+  }
+
+  SensorMapHeader header = {};
+  header.magic = SENSOR_MAP_MAGIC;
+  header.version = SENSOR_MAP_VERSION;
+  header.count = sensorMappings.size();
+  header.payloadLen = p - payload;
+  header.crc = OneWire::crc16(payload, header.payloadLen);
+  memcpy(record, &header, sizeof(header));
+
+  out.data = record;
+  out.len = p - record;
+  out.count = header.count;
+  return out;
+}
+
+// Store a record in NVS and free it - call with mappingSaveMutex held and
+// mappingMutex released
+static bool writeMappingRecord(MappingRecord record) {
+  if (!record.ok) return false;
+
+  Preferences store;
+  if (!store.begin(SENSOR_MAP_NVS_NS, false)) {
+    LOGE("SENSORS", "Failed to open NVS for sensor mappings");
+    free(record.data);
+    return false;
+  }
+  if (record.data == nullptr) {
+    store.remove(SENSOR_MAP_NVS_KEY);
+    store.end();
+    return true;
+  }
+
+  bool saved = store.putBytes(SENSOR_MAP_NVS_KEY, record.data, record.len) == record.len;
+  store.end();
+  free(record.data);
+
+  LOGI("SENSORS", "%s %d sensor mapping(s), %u bytes",
+       saved ? "Saved" : "Failed to save", record.count, (unsigned)record.len);
+  return saved;
+}
+
+// Decode a stored record into mappings; false if it is damaged or unknown
+static bool parseMappingRecord(const uint8_t* record, size_t len, std::vector<SensorMapping>& out) {
+  SensorMapHeader header;
+  if (len < sizeof(header)) return false;
+  memcpy(&header, record, sizeof(header));
+
+  if (header.magic != SENSOR_MAP_MAGIC || header.version != SENSOR_MAP_VERSION ||
+      sizeof(header) + header.payloadLen != len || header.count > SENSOR_MAP_MAX) {
+    return false;
+  }
+
+  const uint8_t* p = record + sizeof(header);
+  const uint8_t* end = p + header.payloadLen;
+  if (OneWire::crc16(p, header.payloadLen) != header.crc) return false;
+
+  out.reserve(header.count);
+  for (uint8_t i = 0; i < header.count; i++) {
+    SensorMapping mapping = {};
+    if (p + 9 > end) return false;
+    memcpy(mapping.uid, p, 8);
+    mapping.enabled = (p[8] & SENSOR_MAP_ENABLED) != 0;
+    p += 9;
+    if (!getString(p, end, mapping.alias, sizeof(mapping.alias)) ||
+        !getString(p, end, mapping.friendlyName, sizeof(mapping.friendlyName)) ||
+        !getString(p, end, mapping.notes, sizeof(mapping.notes))) {
+      return false;
+    }
+    out.push_back(mapping);
+  }
+  return p == end;
+}
+
+// Restore the mappings from NVS - call before initDS18B20Sensors()
+void loadSensorConfig() {
+  std::vector<SensorMapping> loaded;
+
+  Preferences store;
+  size_t len = 0;
+  uint8_t* record = nullptr;
+  if (store.begin(SENSOR_MAP_NVS_NS, true)) {
+    len = store.getBytesLength(SENSOR_MAP_NVS_KEY);
+    if (len > 0 && len <= maxRecordSize(SENSOR_MAP_MAX)) {
+      record = (uint8_t*)malloc(len);
+      if (record != nullptr && store.getBytes(SENSOR_MAP_NVS_KEY, record, len) != len) {
+        free(record);
+        record = nullptr;
       }
     }
+    store.end();
+  }
+
+  if (record != nullptr) {
+    if (!parseMappingRecord(record, len, loaded)) {
+      LOGW("SENSORS", "Stored sensor mappings are damaged - ignoring them");
+      loaded.clear();
+    }
+    free(record);
+  }
+
+  lockMappings();
+  sensorMappings.swap(loaded);
+  rebuildMappingIndex();
+  unlockMappings();
+  LOGI("SENSORS", "Loaded %d sensor mapping(s)", (int)sensorMappings.size());
+}
+
+// Store the current mappings in NVS
+void saveSensorConfig() {
+  lockMappingSave();
+  lockMappings();
+  MappingRecord record = buildMappingRecord();
+  unlockMappings();
+  writeMappingRecord(record);
+  unlockMappingSave();
+}
+
+// Add or update a mapping by UID. The alias must be unique.
+bool addSensorMapping(const uint8_t uid[8], const char* name, const char* alias) {
+  if (alias == nullptr || alias[0] == '\0' || strlen(alias) >= sizeof(SensorMapping::alias)) {
+    return false;
+  }
+
+  lockMappingSave();
+  lockMappings();
+  int index = findMappingByUID(uid);
+  int aliasOwner = findMappingByAlias(alias);
+  if (aliasOwner >= 0 && aliasOwner != index) {
+    unlockMappings();
+    unlockMappingSave();
+    LOGW("SENSORS", "Alias %s is already in use", alias);
+    return false;
+  }
+
+  if (index < 0) {
+    if (sensorMappings.size() >= SENSOR_MAP_MAX) {
+      unlockMappings();
+      unlockMappingSave();
+      return false;
+    }
+    SensorMapping mapping = {};
+    memcpy(mapping.uid, uid, 8);
+    mapping.enabled = true;
+    sensorMappings.push_back(mapping);
+    index = sensorMappings.size() - 1;
+  }
+
+  SensorMapping& mapping = sensorMappings[index];
+  strlcpy(mapping.friendlyName, name != nullptr ? name : "", sizeof(mapping.friendlyName));
+  strlcpy(mapping.alias, alias, sizeof(mapping.alias));
+  rebuildMappingIndex();
+  MappingRecord record = buildMappingRecord();
+  unlockMappings();
+  sensorTablesChanged = true;
+
+  bool saved = writeMappingRecord(record);
+  unlockMappingSave();
+  return saved;
+}
+
+// Remove a mapping by alias
+bool removeSensorMapping(const char* alias) {
+  lockMappingSave();
+  lockMappings();
+  int index = findMappingByAlias(alias);
+  if (index < 0) {
+    unlockMappings();
+    unlockMappingSave();
+    return false;
+  }
+
+  sensorMappings.erase(sensorMappings.begin() + index);
+  rebuildMappingIndex();
+  MappingRecord record = buildMappingRecord();
+  unlockMappings();
+  sensorTablesChanged = true;
+
+  bool saved = writeMappingRecord(record);
+  unlockMappingSave();
+  return saved;
+}
+
+// Write the mappings as {"version":1,"sensors":[{uid,name,alias,enabled,notes}]}
+void exportSensorMappingsJson(JsonDocument& doc) {
+  doc["version"] = SENSOR_MAP_VERSION;
+  JsonArray sensors = doc.createNestedArray("sensors");
+
+  lockMappings();
+  for (const auto& mapping : sensorMappings) {
+    JsonObject sensor = sensors.createNestedObject();
+    sensor["uid"] = uidToString(mapping.uid);
+    sensor["name"] = mapping.friendlyName;
+    sensor["alias"] = mapping.alias;
+    sensor["enabled"] = mapping.enabled;
+    sensor["notes"] = mapping.notes;
+  }
+  unlockMappings();
+}
+
+// Replace all mappings with the ones in an exported JSON document.
+// Returns nullptr on success, otherwise an error message (nothing changes).
+const char* importSensorMappingsJson(const char* json) {
+  JsonDocument doc;
+  if (deserializeJson(doc, json)) return "invalid JSON";
+
+  JsonArray sensors = doc["sensors"].as<JsonArray>();
+  if (sensors.isNull()) return "missing sensors array";
+  if (sensors.size() > SENSOR_MAP_MAX) return "too many sensors";
+
+  std::vector<SensorMapping> imported;
+  imported.reserve(sensors.size());
+  for (JsonObject sensor : sensors) {
+    const char* uid = sensor["uid"] | "";
+    const char* alias = sensor["alias"] | "";
+    SensorMapping mapping = {};
+    if (!stringToUID(uid, mapping.uid)) return "invalid uid";
+    if (alias[0] == '\0' || strlen(alias) >= sizeof(SensorMapping::alias)) return "invalid alias";
+
+    strlcpy(mapping.alias, alias, sizeof(mapping.alias));
+    strlcpy(mapping.friendlyName, sensor["name"] | "", sizeof(mapping.friendlyName));
+    strlcpy(mapping.notes, sensor["notes"] | "", sizeof(mapping.notes));
+    mapping.enabled = sensor["enabled"] | true;
+
+    for (const auto& other : imported) {
+      if (memcmp(other.uid, mapping.uid, 8) == 0) return "duplicate uid";
+      if (strcmp(other.alias, mapping.alias) == 0) return "duplicate alias";
+    }
+    imported.push_back(mapping);
+  }
+
+  lockMappingSave();
+  lockMappings();
+  sensorMappings.swap(imported);
+  rebuildMappingIndex();
+  MappingRecord record = buildMappingRecord();
+  unlockMappings();
+  sensorTablesChanged = true;
+
+  bool saved = writeMappingRecord(record);
+  unlockMappingSave();
+  return saved ? nullptr : "failed to save";
+}
+
+// UIDs currently present on the buses (no bus access)
+std::vector<String> getDiscoveredUIDs() {
+  std::vector<String> uids;
+  lockMappings();
+  uids.reserve(discoveredSensors.size());
+  for (const auto& found : discoveredSensors) {
+    if (found.present) uids.push_back(uidToString(found.uid));
+  }
+  unlockMappings();
+  return uids;
+}
+
+// "28FF641E8C160450"
+String uidToString(const uint8_t uid[8]) {
+  char text[17];
+  for (int i = 0; i < 8; i++) {
+    snprintf(text + i * 2, 3, "%02X", uid[i]);
+  }
+  return String(text);
+}
+
+// Parse 16 hex digits; ':' or '-' separators are skipped
+bool stringToUID(const String& str, uint8_t uid[8]) {
+  memset(uid, 0, 8);
+  int digits = 0;
+  for (size_t i = 0; i < str.length(); i++) {
+    char c = str[i];
+    if (c == ':' || c == '-') continue;
+    if (!isxdigit((unsigned char)c) || digits >= 16) {
+      memset(uid, 0, 8);
+      return false;
+    }
+    uint8_t nibble = isdigit((unsigned char)c) ? c - '0' : toupper((unsigned char)c) - 'A' + 10;
+    uid[digits / 2] = (uid[digits / 2] << 4) | nibble;
+    digits++;
+  }
+  if (digits != 16) memset(uid, 0, 8);
+  return digits == 16;
+}
+
+// Get temperature by alias (e.g., "temp0") from the sensor cache
+float getTempByAlias(const char* alias) {
+  SensorReading reading;
+  if (sensorCacheGetByAlias(alias, reading) && reading.valid) {
+    return reading.tempC;
   }
   return NAN;  // Return NaN if sensor not found or invalid reading
 }
 
-// Get temperature by UID
+// Get temperature by UID from the sensor cache
 float getTempByUID(const uint8_t uid[8]) {
-  float temp = ds18b20Sensors.getTempC(uid);
-  if (temp != DEVICE_DISCONNECTED_C && temp > -55.0 && temp < 125.0) {
-    return temp;
+  SensorReading reading;
+  if (sensorCacheGetByUID(uid, reading) && reading.valid) {
+    return reading.tempC;
   }
   return NAN;
 }
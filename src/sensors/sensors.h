@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <ArduinoJson.h>
 
 // ========== Sensor Mapping Structures ==========
 struct SensorMapping {
@@ -17,43 +18,57 @@ struct SensorMapping {
 // Read temperature sensors (DS18B20 OneWire on CYD)
 void readTemperatures();
 
+// Advance the non-blocking DS18B20 acquisition (convert, wait, read) - call every loop()
+void updateTemperatureAcquisition();
+
+// DS18B20 conversion time in ms for a resolution of 9-12 bits
+uint16_t ds18b20ConversionTime(uint8_t resolution);
+
 // Calculate temperature from thermistor ADC value (legacy - for future use)
 float calculateThermistorTemp(float adcValue);
 
-// Update temperature history buffer
+// Hottest of the four temperature channels
+float getMaxTemperature();
+
+// Append all temperature channels to the history store (1 Hz)
 void updateTempHistory();
 
 // ========== Fan Control ==========
 // Control fan speed based on temperature
 void controlFan();
 
-// Calculate fan RPM from tachometer pulses
+// Update fan RPM from the tachometer (every loop)
 void calculateRPM();
 
-// Tachometer interrupt handler
-void IRAM_ATTR tachISR();
-
 // ========== PSU Monitoring ==========
-// Non-blocking sensor sampling (ADC for PSU voltage)
+// Non-blocking sensor sampling (drains the PSU block acquisition)
 void sampleSensorsNonBlocking();
 
-// Process averaged ADC readings
+// Apply the latest PSU block (voltage, min/max)
 void processAdcReadings();
 
 // ========== Sensor Management Functions ==========
 // Initialize DS18B20 sensors
 void initDS18B20Sensors();
 
-// Load sensor configuration from SD card
+// Restore sensor mappings from NVS (one binary record) - call before initDS18B20Sensors()
 void loadSensorConfig();
 
-// Save sensor configuration to SD card
+// Store sensor mappings in NVS (add/remove/import save automatically)
 void saveSensorConfig();
 
-// Get temperature by sensor alias (e.g., "temp0")
+// Rebuild the sensor cache after the mappings change
+void rebuildSensorCache();
+
+// Bumped by rebuildSensorCache() when channels were added, removed,
+// renumbered or renamed: layouts bound to "tempN" or an alias, and their
+// expressions, must be loaded again
+uint16_t getSensorChannelGeneration();
+
+// Get temperature by sensor alias (e.g., "temp0") - cached, no bus access
 float getTempByAlias(const char* alias);
 
-// Get temperature by UID
+// Get temperature by UID - cached, no bus access
 float getTempByUID(const uint8_t uid[8]);
 
 // Get number of configured sensors
@@ -65,44 +80,103 @@ bool addSensorMapping(const uint8_t uid[8], const char* name, const char* alias)
 // Remove sensor mapping by alias
 bool removeSensorMapping(const char* alias);
 
-// Discover all DS18B20 sensors on the bus
+// UIDs of the DS18B20 sensors currently present (init + background scan)
 std::vector<String> getDiscoveredUIDs();
 
+// ========== Hot-Plug Events ==========
+// Raised by the background bus scan when a sensor appears or disappears
+enum SensorEventType : uint8_t {
+    SENSOR_EVENT_ADDED = 0,
+    SENSOR_EVENT_REMOVED
+};
+
+struct SensorEvent {
+    uint32_t seq;            // Increments per event, starting at 1
+    uint32_t timeMs;         // millis() when raised
+    SensorEventType type;
+    uint8_t bus;
+    bool mapped;             // The UID has a sensor mapping
+    uint8_t uid[8];
+};
+
+// Bus scan timing (step = reset or one ROM bit, slice = one loop() tick)
+struct BusScanStats {
+    uint32_t scans;          // Completed scans
+    uint32_t errors;         // Scans abandoned (bus fault, CRC)
+    uint32_t scanStartMs;
+    uint32_t scanMs;         // Wall time of the last scan
+    uint16_t scanSteps;
+    uint16_t scanTicks;
+    uint16_t maxStepUs;
+    uint16_t maxSliceUs;
+    uint8_t present;         // Sensors found by the last scan
+};
+
+// Copy up to maxEvents events newer than `since` (a seq). Returns the count.
+uint8_t getSensorEvents(uint32_t since, SensorEvent* out, uint8_t maxEvents);
+const BusScanStats& getBusScanStats();
+
+// JSON import/export of the mappings ({"version":1,"sensors":[...]}).
+// Import replaces every mapping; it returns nullptr or an error message.
+void exportSensorMappingsJson(JsonDocument& doc);
+const char* importSensorMappingsJson(const char* json);
+
 // Convert UID to hex string
 String uidToString(const uint8_t uid[8]);
 
-// Convert hex string to UID
-void stringToUID(const String& str, uint8_t uid[8]);
+// Convert a hex string to a UID: exactly 16 hex digits, ':' and '-' ignored.
+// Returns false (uid zeroed) for any other character or digit count.
+bool stringToUID(const String& str, uint8_t uid[8]);
+
+// ========== Touch Identification ==========
+// A background session that finds the unmapped sensor being held by hand.
+// Runs from updateTemperatureAcquisition(); monitoring continues meanwhile.
+enum SensorIdentState : uint8_t {
+    IDENT_IDLE = 0,          // No session since boot
+    IDENT_BASELINE,          // Measuring baselines (first second) - hands off
+    IDENT_WATCHING,          // Waiting for a rise
+    IDENT_DETECTED,          // uid is the touched sensor
+    IDENT_TIMEOUT,
+    IDENT_CANCELLED,
+    IDENT_NO_SENSORS         // Every present sensor is already mapped
+};
+
+struct SensorIdentStatus {
+    uint16_t session;        // Increments per started session
+    SensorIdentState state;
+    uint8_t candidates;      // Unmapped sensors being watched
+    uint8_t confidence;      // 0-100, set on detection
+    uint8_t uid[8];          // Detected sensor, or the one leading so far
+    float rise;              // C over its baseline
+    float slope;             // C/s
+    uint32_t rounds;         // Completed sampling rounds (~100 ms + 3 ms per sensor)
+    uint32_t elapsedMs;
+};
+
+// Start a session (any task). False if one is running or the threshold is not positive.
+bool startSensorIdentification(uint32_t timeoutMs, float thresholdDelta = 1.0);
+void cancelSensorIdentification();
+void getSensorIdentification(SensorIdentStatus& out);
+void exportSensorIdentificationJson(JsonDocument& doc);
 
-// Detect touched sensor (temperature rise detection)
+// Non-blocking: starts a session if none is running; returns the touched
+// UID once per detection, "" while waiting or after a timeout
 String detectTouchedSensor(unsigned long timeoutMs, float thresholdDelta = 1.0);
 
 // ========== External Variables ==========
 // These are defined in main.cpp and accessed by sensor functions
-extern float temperatures[4];
-extern float peakTemps[4];
+extern float* temperatures;      // Channel N = data source "tempN", sized at init
+extern float* peakTemps;
+extern uint8_t temperatureCount;  // Channels in use (at least 4 once initialized)
 extern float psuVoltage;
 extern float psuMin;
 extern float psuMax;
 extern uint8_t fanSpeed;
 extern uint16_t fanRPM;
-extern volatile uint16_t tachCounter;
 
-// ADC sampling variables
-extern uint32_t adcSamples[5][10];
-extern uint8_t adcSampleIndex;
-extern uint8_t adcCurrentSensor;
-extern unsigned long lastAdcSample;
+// Set when a PSU sample block completes
 extern bool adcReady;
 
-// Temperature history
-extern float *tempHistory;
-extern uint16_t historySize;
-extern uint16_t historyIndex;
-
-// Timing
-extern unsigned long lastTachRead;
-
 // Sensor mappings vector
 extern std::vector<SensorMapping> sensorMappings;
 
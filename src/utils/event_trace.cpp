@@ -0,0 +1,216 @@
+#include "event_trace.h"
+
+#if EVENT_TRACE
+
+#include <atomic>
+#include <new>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static_assert((EVENT_TRACE_EVENTS & (EVENT_TRACE_EVENTS - 1)) == 0, "EVENT_TRACE_EVENTS must be a power of two");
+
+struct TraceEvent {
+    uint32_t us;
+    const char* name;                   // Stored last; nullptr while the slot is written
+    char phase;                         // 'B', 'E', 'i', 'b', 'e'
+    uint8_t core;
+    uint8_t task;                       // Index into the task table
+};
+
+static TraceEvent ring[EVENT_TRACE_EVENTS];
+static std::atomic<uint32_t> nextEvent{0};
+static std::atomic<uint32_t> clearedAt{0};
+static volatile bool recording = true;
+static std::atomic<bool> dumping{false};
+
+// Tasks are numbered in the order they first record; a dump names them
+static TaskHandle_t taskHandles[EVENT_TRACE_TASKS];
+static char taskNames[EVENT_TRACE_TASKS][configMAX_TASK_NAME_LEN];
+static std::atomic<uint8_t> taskCount{0};
+static portMUX_TYPE taskMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t taskIndex(TaskHandle_t handle) {
+    uint8_t count = taskCount.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < count; i++) {
+        if (taskHandles[i] == handle) return i;
+    }
+
+    portENTER_CRITICAL(&taskMux);
+    count = taskCount.load(std::memory_order_relaxed);
+    uint8_t index = count;
+    for (uint8_t i = 0; i < count; i++) {
+        if (taskHandles[i] == handle) index = i;
+    }
+    if (index == count) {
+        if (count < EVENT_TRACE_TASKS) {
+            taskHandles[count] = handle;
+            strlcpy(taskNames[count], pcTaskGetName(handle), sizeof(taskNames[count]));
+            taskCount.store(count + 1, std::memory_order_release);
+        } else {
+            index = EVENT_TRACE_TASKS - 1;  // Table full: shares the last row
+        }
+    }
+    portEXIT_CRITICAL(&taskMux);
+    return index;
+}
+
+// ========== Functions (any task) ==========
+
+void eventTraceRecord(char phase, const char* name) {
+    if (!recording) return;
+
+    uint32_t n = nextEvent.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& event = ring[n & (EVENT_TRACE_EVENTS - 1)];
+    __atomic_store_n(&event.name, (const char*)nullptr, __ATOMIC_RELAXED);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.us = micros();
+    event.phase = phase;
+    event.core = xPortGetCoreID();
+    event.task = taskIndex(xTaskGetCurrentTaskHandle());
+    __atomic_store_n(&event.name, name, __ATOMIC_RELEASE);
+}
+
+void eventTraceSetRecording(bool enabled) {
+    recording = enabled;
+}
+
+void eventTraceClear() {
+    clearedAt.store(nextEvent.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+EventTraceStats getEventTraceStats() {
+    EventTraceStats stats;
+    stats.recording = recording;
+    stats.events = nextEvent.load(std::memory_order_relaxed);
+    stats.tasks = taskCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ========== Chrome Trace Dump ==========
+
+enum DumpSection : uint8_t {
+    DUMP_HEADER,
+    DUMP_TASKS,
+    DUMP_EVENTS,
+    DUMP_FOOTER,
+    DUMP_DONE
+};
+
+struct EventTraceDump {
+    uint32_t next;                      // Ring position
+    uint32_t end;
+    uint32_t baseUs;                    // ts 0
+    uint8_t section;
+    uint8_t task;
+    bool resume;                        // Recording was on at open
+    uint8_t pieceLen;                   // Formatted, not yet sent: piece[pieceSent, pieceLen)
+    uint8_t pieceSent;
+    char piece[200];
+};
+
+EventTraceDump* eventTraceDumpOpen() {
+    if (dumping.exchange(true)) return nullptr;
+    EventTraceDump* dump = new (std::nothrow) EventTraceDump();
+    if (dump == nullptr) {
+        dumping.store(false);
+        return nullptr;
+    }
+
+    dump->resume = recording;
+    recording = false;
+    dump->end = nextEvent.load(std::memory_order_acquire);
+    // Events still being recorded past end may land on the oldest slots;
+    // one per task at most
+    uint32_t oldest = dump->end > EVENT_TRACE_EVENTS ? dump->end - EVENT_TRACE_EVENTS + EVENT_TRACE_TASKS : 0;
+    uint32_t cleared = clearedAt.load(std::memory_order_relaxed);
+    dump->next = (int32_t)(cleared - oldest) > 0 ? cleared : oldest;
+    dump->baseUs = dump->next != dump->end ? ring[dump->next & (EVENT_TRACE_EVENTS - 1)].us : 0;
+    dump->section = DUMP_HEADER;
+    return dump;
+}
+
+// Format the next piece of JSON into text; false when the section is done
+static bool nextPiece(EventTraceDump* dump, char* text, size_t len) {
+    switch (dump->section) {
+        case DUMP_HEADER:
+            snprintf(text, len,
+                     "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"baseUs\":%lu},\"traceEvents\":[\n"
+                     "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"FluidDash\"}}",
+                     (unsigned long)dump->baseUs);
+            dump->section = DUMP_TASKS;
+            return true;
+
+        case DUMP_TASKS:
+            if (dump->task >= taskCount.load(std::memory_order_acquire)) return false;
+            snprintf(text, len, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     dump->task, taskNames[dump->task]);
+            dump->task++;
+            return true;
+
+        case DUMP_EVENTS:
+            while (dump->next != dump->end) {
+                const TraceEvent& event = ring[dump->next++ & (EVENT_TRACE_EVENTS - 1)];
+                const char* name = __atomic_load_n(&event.name, __ATOMIC_ACQUIRE);
+                if (name == nullptr) continue;  // Was being written when recording paused
+                TraceEvent copy = event;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (__atomic_load_n(&event.name, __ATOMIC_RELAXED) != name) continue;
+                unsigned long ts = copy.us - dump->baseUs;
+                if (copy.phase == 'E') {
+                    snprintf(text, len, ",\n{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%lu,\"pid\":1,\"tid\":%u}",
+                             name, ts, copy.task);
+                } else if (copy.phase == 'b' || copy.phase == 'e') {
+                    // Async slices pair by cat + id + name; one track per name
+                    snprintf(text, len, ",\n{\"name\":\"%s\",\"cat\":\"async\",\"id\":1,\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":%u,\"args\":{\"task\":\"%s\",\"core\":%u}}",
+                             name, copy.phase, ts, copy.task, taskNames[copy.task], copy.core);
+                } else {
+                    snprintf(text, len, ",\n{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%lu,\"pid\":1,\"tid\":%u,\"args\":{\"core\":%u}}",
+                             name, copy.phase, copy.phase == 'i' ? "\"s\":\"t\"," : "", ts, copy.task, copy.core);
+                }
+                return true;
+            }
+            return false;
+
+        case DUMP_FOOTER:
+            snprintf(text, len, "\n]}\n");
+            dump->section = DUMP_DONE;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+size_t eventTraceDumpRead(EventTraceDump* dump, uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (dump->pieceSent == dump->pieceLen) {
+            if (dump->section == DUMP_DONE) break;
+            if (!nextPiece(dump, dump->piece, sizeof(dump->piece))) {
+                dump->section++;
+                continue;
+            }
+            dump->pieceLen = strlen(dump->piece);
+            dump->pieceSent = 0;
+        }
+        // Whole pieces only, unless one does not fit in an empty buffer
+        size_t left = dump->pieceLen - dump->pieceSent;
+        if (left > maxLen - written) {
+            if (written > 0) break;
+            left = maxLen;
+        }
+        memcpy(buffer + written, dump->piece + dump->pieceSent, left);
+        dump->pieceSent += left;
+        written += left;
+    }
+    return written;
+}
+
+void eventTraceDumpClose(EventTraceDump* dump) {
+    if (dump == nullptr) return;
+    if (dump->resume) recording = true;
+    delete dump;
+    dumping.store(false);
+}
+
+#endif // EVENT_TRACE
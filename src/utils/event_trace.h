@@ -0,0 +1,85 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <Arduino.h>
+
+// ========== Event Trace Recorder ==========
+// Timeline of what the firmware's tasks do, for chrome://tracing or
+// ui.perfetto.dev: EVT_BEGIN / EVT_END(name) bracket a slice on the calling
+// task, EVT_SCOPE(name) brackets the rest of a block, EVT_INSTANT(name)
+// marks a point. Each event records micros(), the task and the core into a
+// ring of EVENT_TRACE_EVENTS (the most recent few seconds); GET
+// /api/event-trace downloads the ring as Chrome trace JSON.
+//
+// Built only with -DEVENT_TRACE=1 (platformio.ini): otherwise the macros
+// expand to nothing and the recorder and its endpoint do not exist.
+//
+// name must be a string literal without quotes or backslashes (the ring
+// keeps the pointer, the dump writes it as is). Begin and end of a slice
+// must be on the same task and nest; EVT_ASYNC_BEGIN / EVT_ASYNC_END(name)
+// are for spans that do not (held across callbacks, ended by another task)
+// and get a track of their own. An event costs about 1 µs.
+
+#ifndef EVENT_TRACE
+#define EVENT_TRACE 0
+#endif
+
+#if EVENT_TRACE
+
+#ifndef EVENT_TRACE_EVENTS
+#define EVENT_TRACE_EVENTS  1024        // Power of two, 12 bytes each
+#endif
+#define EVENT_TRACE_TASKS   16          // Distinct tasks named in a dump
+
+struct EventTraceStats {
+    bool recording;
+    uint32_t events;                    // Recorded since boot
+    uint8_t tasks;
+};
+
+// ========== Functions (any task) ==========
+void eventTraceRecord(char phase, const char* name);
+
+// Recording starts at boot; a dump pauses it while it is sent
+void eventTraceSetRecording(bool recording);
+void eventTraceClear();
+EventTraceStats getEventTraceStats();
+
+// Chrome trace JSON of the ring, written in pieces into buffers of any
+// size: open (fails while another dump is running), read until it returns
+// 0, close. Recording is paused from open to close.
+struct EventTraceDump;
+EventTraceDump* eventTraceDumpOpen();
+size_t eventTraceDumpRead(EventTraceDump* dump, uint8_t* buffer, size_t maxLen);
+void eventTraceDumpClose(EventTraceDump* dump);
+
+class EventTraceScope {
+public:
+    explicit EventTraceScope(const char* name) : name(name) { eventTraceRecord('B', name); }
+    ~EventTraceScope() { eventTraceRecord('E', name); }
+private:
+    const char* name;
+};
+
+#define EVT_CONCAT_(a, b)       a##b
+#define EVT_CONCAT(a, b)        EVT_CONCAT_(a, b)
+
+#define EVT_BEGIN(name)         eventTraceRecord('B', name)
+#define EVT_END(name)           eventTraceRecord('E', name)
+#define EVT_INSTANT(name)       eventTraceRecord('i', name)
+#define EVT_ASYNC_BEGIN(name)   eventTraceRecord('b', name)
+#define EVT_ASYNC_END(name)     eventTraceRecord('e', name)
+#define EVT_SCOPE(name)         EventTraceScope EVT_CONCAT(evtScope_, __LINE__)(name)
+
+#else
+
+#define EVT_BEGIN(name)         do {} while (0)
+#define EVT_END(name)           do {} while (0)
+#define EVT_INSTANT(name)       do {} while (0)
+#define EVT_ASYNC_BEGIN(name)   do {} while (0)
+#define EVT_ASYNC_END(name)     do {} while (0)
+#define EVT_SCOPE(name)         do {} while (0)
+
+#endif // EVENT_TRACE
+
+#endif // EVENT_TRACE_H
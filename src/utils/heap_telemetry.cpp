@@ -0,0 +1,181 @@
+#include "heap_telemetry.h"
+#include "utils/log.h"
+
+#if HEAP_TAGGING
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#endif
+
+static HeapSample samples[HEAP_HISTORY_SAMPLES];
+static uint16_t sampleHead = 0;             // Next slot
+static uint16_t sampleCount = 0;
+static uint32_t lastSampleMs = 0;
+static uint32_t minLargestBlock = UINT32_MAX;
+
+// ========== Functions ==========
+
+#if HEAP_TAGGING
+static void reportSteadySites();
+#endif
+
+void heapTelemetryUpdate() {
+    uint32_t now = millis();
+    if (sampleCount > 0 && now - lastSampleMs < HEAP_SAMPLE_MS) return;
+    lastSampleMs = now;
+
+    HeapSample& sample = samples[sampleHead];
+    sample.freeBytes = ESP.getFreeHeap();
+    sample.largestBlock = ESP.getMaxAllocHeap();
+    if (sample.largestBlock < minLargestBlock) minLargestBlock = sample.largestBlock;
+    sampleHead = (sampleHead + 1) % HEAP_HISTORY_SAMPLES;
+    if (sampleCount < HEAP_HISTORY_SAMPLES) sampleCount++;
+
+#if HEAP_TAGGING
+    reportSteadySites();
+#endif
+}
+
+HeapStats getHeapStats() {
+    HeapStats stats;
+    stats.freeBytes = ESP.getFreeHeap();
+    stats.largestBlock = ESP.getMaxAllocHeap();
+    stats.minFreeBytes = ESP.getMinFreeHeap();
+    stats.minLargestBlock = min(minLargestBlock, stats.largestBlock);
+    stats.heapSize = ESP.getHeapSize();
+    stats.fragmentationPct = stats.freeBytes
+        ? 100.0f * (1.0f - (float)stats.largestBlock / stats.freeBytes) : 0;
+    return stats;
+}
+
+size_t getHeapSamples(HeapSample* out, size_t max, uint32_t& sampleAgeMs) {
+    size_t count = min((size_t)sampleCount, max);
+    size_t start = (sampleHead + HEAP_HISTORY_SAMPLES - count) % HEAP_HISTORY_SAMPLES;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = samples[(start + i) % HEAP_HISTORY_SAMPLES];
+    }
+    sampleAgeMs = millis() - lastSampleMs;
+    return count;
+}
+
+#if HEAP_TAGGING
+
+// ========== Allocation Tagging ==========
+// The linker sends every malloc / calloc / realloc / free in the image,
+// libraries included, through the __wrap_ functions below
+// (-Wl,--wrap=malloc ...). Nothing here may allocate or log.
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+__thread HeapSite* heapCurrentSite = nullptr;
+
+static HeapSite untaggedSite = {"untagged", HEAP_OTHER, true};
+static HeapSite* lastSite = &untaggedSite;
+static portMUX_TYPE siteMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool tagging = false;       // Off until setup(): no TLS before the scheduler
+static volatile bool steady = false;
+
+static const char* const subsystemNames[HEAP_SUBSYSTEMS] = {
+    "other", "web", "network", "render", "sensors", "history"
+};
+
+static inline HeapSite* currentSite() {
+    HeapSite* site = heapCurrentSite;
+    return site ? site : &untaggedSite;
+}
+
+static inline void countAlloc(size_t size) {
+    HeapSite* site = currentSite();
+    __atomic_fetch_add(&site->allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&site->allocBytes, size, __ATOMIC_RELAXED);
+    if (steady) {
+        __atomic_fetch_add(&site->steadyAllocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&site->steadyBytes, size, __ATOMIC_RELAXED);
+        site->lastSteadyMs = millis();
+    }
+}
+
+static inline void countFree(void* ptr) {
+    HeapSite* site = currentSite();
+    __atomic_fetch_add(&site->frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&site->freeBytes, heap_caps_get_allocated_size(ptr), __ATOMIC_RELAXED);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    if (tagging && ptr) countAlloc(size);
+    return ptr;
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    if (tagging && ptr) countAlloc(count * size);
+    return ptr;
+}
+
+// A String or vector growing in place is still an allocation: counted as
+// a free of the old block and an allocation of the new size
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    if (!tagging) return __real_realloc(ptr, size);
+    if (ptr) countFree(ptr);
+    void* result = __real_realloc(ptr, size);
+    if (result && size > 0) countAlloc(size);
+    return result;
+}
+
+extern "C" void __wrap_free(void* ptr) {
+    if (tagging && ptr) countFree(ptr);
+    __real_free(ptr);
+}
+
+void heapTaggingInit() {
+    tagging = true;
+}
+
+void heapRegisterSite(HeapSite& site) {
+    portENTER_CRITICAL(&siteMux);
+    if (!site.registered) {
+        lastSite->next = &site;
+        lastSite = &site;
+        site.registered = true;
+    }
+    portEXIT_CRITICAL(&siteMux);
+}
+
+HeapSite* heapFirstSite() {
+    return &untaggedSite;
+}
+
+void heapSitesReset() {
+    for (HeapSite* site = &untaggedSite; site; site = site->next) {
+        site->allocs = site->frees = 0;
+        site->allocBytes = site->freeBytes = 0;
+        site->steadyAllocs = site->steadyBytes = 0;
+        site->lastSteadyMs = 0;
+        site->reported = false;
+    }
+}
+
+const char* heapSubsystemName(HeapSubsystem subsystem) {
+    return subsystem < HEAP_SUBSYSTEMS ? subsystemNames[subsystem] : "?";
+}
+
+static void reportSteadySites() {
+    if (!steady) {
+        steady = millis() >= HEAP_STEADY_AFTER_MS;
+        return;
+    }
+    for (HeapSite* site = &untaggedSite; site; site = site->next) {
+        if (site->steadyAllocs == 0 || site->reported) continue;
+        site->reported = true;
+        LOGW("HEAP", "%s (%s) allocates in steady state: %lu allocations, %lu bytes",
+             site->name, heapSubsystemName(site->subsystem),
+             (unsigned long)site->steadyAllocs, (unsigned long)site->steadyBytes);
+    }
+}
+
+#endif // HEAP_TAGGING
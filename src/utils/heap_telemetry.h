@@ -0,0 +1,128 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <Arduino.h>
+
+// ========== Heap Telemetry ==========
+// Free heap, largest free block and the lowest free heap since boot,
+// sampled every HEAP_SAMPLE_MS into a one-hour ring for GET /api/heap.
+// Fragmentation is 1 - largest / free: with plenty free but a small largest
+// block, the next HTML page String or JsonDocument no longer fits.
+//
+// Allocation tagging (build with -DHEAP_TAGGING=1 and the --wrap link flags
+// in platformio.ini) counts every malloc / calloc / realloc / free against
+// the HEAP_SCOPE site the calling task is in, and sites add up into
+// subsystems:
+//
+//   void parseFluidNCStatus(String status) {
+//       HEAP_SCOPE(HEAP_NETWORK, "parseFluidNCStatus");
+//
+// An inner scope takes over until it returns, so each scope should cover
+// the work of one subsystem only: a function another subsystem calls into
+// (viewModelUpdate() from the sensor paths) opens its own scope.
+//
+// Allocations outside any scope (lwIP, WiFi, libraries) go to "untagged".
+// From HEAP_STEADY_AFTER_MS after boot, allocations are also counted as
+// steady state. A site with steady-state allocations keeps allocating while
+// the firmware runs, so it is a fragmentation suspect. It is logged once
+// and listed under "steady".
+//
+// A free is counted against the site the freeing task is in, so net bytes
+// are exact only for memory freed in the scope that allocated it (request
+// documents, temporary Strings).
+
+#define HEAP_SAMPLE_MS          20000
+#define HEAP_HISTORY_SAMPLES    180     // One hour
+#define HEAP_STEADY_AFTER_MS    60000
+
+#ifndef HEAP_TAGGING
+#define HEAP_TAGGING 0
+#endif
+
+struct HeapStats {
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+    uint32_t minFreeBytes;              // Lowest since boot (ESP-IDF watermark)
+    uint32_t minLargestBlock;           // Lowest sampled
+    uint32_t heapSize;
+    float fragmentationPct;
+};
+
+struct HeapSample {
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+};
+
+// ========== Functions ==========
+// Call from loop(); samples every HEAP_SAMPLE_MS
+void heapTelemetryUpdate();
+
+HeapStats getHeapStats();
+
+// Copy up to max samples, oldest first; returns the count. sampleAgeMs is
+// the age of the newest one.
+size_t getHeapSamples(HeapSample* out, size_t max, uint32_t& sampleAgeMs);
+
+#if HEAP_TAGGING
+
+enum HeapSubsystem : uint8_t {
+    HEAP_OTHER,                         // Untagged
+    HEAP_WEB,
+    HEAP_NETWORK,
+    HEAP_RENDER,
+    HEAP_SENSORS,
+    HEAP_HISTORY,
+    HEAP_SUBSYSTEMS
+};
+
+struct HeapSite {
+    const char* name;
+    HeapSubsystem subsystem;
+    bool registered;
+    bool reported;                      // Steady-state allocation logged
+    HeapSite* next;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t allocBytes;
+    uint32_t freeBytes;
+    uint32_t steadyAllocs;
+    uint32_t steadyBytes;
+    uint32_t lastSteadyMs;
+};
+
+extern __thread HeapSite* heapCurrentSite;
+
+// Start counting; call once from setup()
+void heapTaggingInit();
+void heapRegisterSite(HeapSite& site);
+
+// Sites in registration order ("untagged" first)
+HeapSite* heapFirstSite();
+void heapSitesReset();
+const char* heapSubsystemName(HeapSubsystem subsystem);
+
+class HeapScope {
+public:
+    explicit HeapScope(HeapSite& site) : previous(heapCurrentSite) {
+        if (!site.registered) heapRegisterSite(site);
+        heapCurrentSite = &site;
+    }
+    ~HeapScope() { heapCurrentSite = previous; }
+private:
+    HeapSite* previous;
+};
+
+#define HEAP_CONCAT_(a, b)      a##b
+#define HEAP_CONCAT(a, b)       HEAP_CONCAT_(a, b)
+
+#define HEAP_SCOPE(subsystem, name) \
+    static HeapSite HEAP_CONCAT(heapSite_, __LINE__) = {name, subsystem}; \
+    HeapScope HEAP_CONCAT(heapScope_, __LINE__)(HEAP_CONCAT(heapSite_, __LINE__))
+
+#else
+
+#define HEAP_SCOPE(subsystem, name) do {} while (0)
+
+#endif // HEAP_TAGGING
+
+#endif // HEAP_TELEMETRY_H
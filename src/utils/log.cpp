@@ -0,0 +1,139 @@
+#include "log.h"
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define LOG_TASK_STACK      3072
+#define LOG_TASK_PRIORITY   1           // Same as loop(), below WiFi / async_tcp
+#define LOG_TASK_CORE       0
+#define LOG_DRAIN_MS        20          // Poll interval when the ring is empty
+#define LOG_DRAIN_BATCH     4
+
+static_assert((LOG_RING_LINES & (LOG_RING_LINES - 1)) == 0, "LOG_RING_LINES must be a power of two");
+
+// version is 2n+1 while line n is written and 2n+2 once it is complete.
+// A reader copies the line, then checks that version did not move.
+struct LogSlot {
+    std::atomic<uint32_t> version;
+    LogLine line;
+};
+
+static LogSlot ring[LOG_RING_LINES];
+static std::atomic<uint32_t> nextLine{0};
+static std::atomic<uint32_t> droppedLines{0};
+static std::atomic<uint32_t> truncatedLines{0};
+static TaskHandle_t drainTask = nullptr;
+static uint32_t drainCursor = 0;
+
+// ========== Output ==========
+
+static void printLine(const LogLine& line) {
+    Serial.printf("%lu.%03lu %s [%s] %s\n", (unsigned long)(line.ms / 1000), (unsigned long)(line.ms % 1000),
+                  logLevelName(line.level), line.tag, line.text);
+}
+
+static void drainLoop(void*) {
+    LogLine lines[LOG_DRAIN_BATCH];
+    for (;;) {
+        uint32_t lost = 0;
+        size_t count = logRead(drainCursor, lines, LOG_DRAIN_BATCH, lost);
+        if (lost) {
+            droppedLines.fetch_add(lost, std::memory_order_relaxed);
+            Serial.printf("... %lu log lines dropped\n", (unsigned long)lost);
+        }
+        for (size_t i = 0; i < count; i++) printLine(lines[i]);
+        if (count == 0) vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+    }
+}
+
+// ========== Functions ==========
+
+void logInit() {
+    if (drainTask != nullptr) return;
+    // Everything so far was printed directly
+    drainCursor = nextLine.load(std::memory_order_acquire);
+    if (xTaskCreatePinnedToCore(drainLoop, "log_drain", LOG_TASK_STACK, nullptr,
+                                LOG_TASK_PRIORITY, &drainTask, LOG_TASK_CORE) != pdPASS) {
+        drainTask = nullptr;
+        Serial.println("[LOG] Failed to start drain task - logging directly");
+    }
+}
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+    uint32_t n = nextLine.fetch_add(1, std::memory_order_relaxed);
+    LogSlot& slot = ring[n & (LOG_RING_LINES - 1)];
+
+    slot.version.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.line.seq = n;
+    slot.line.ms = millis();
+    slot.line.tag = tag;
+    slot.line.level = level;
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(slot.line.text, LOG_LINE_MAX, fmt, args);
+    va_end(args);
+    if (len >= LOG_LINE_MAX) {
+        truncatedLines.fetch_add(1, std::memory_order_relaxed);
+    } else if (len > 0 && slot.line.text[len - 1] == '\n') {
+        slot.line.text[len - 1] = '\0';
+    }
+    slot.version.store(2 * n + 2, std::memory_order_release);
+
+    if (drainTask == nullptr) printLine(slot.line);
+}
+
+// 1: copied, 0: not written yet (or still being written), -1: overwritten
+static int readLine(uint32_t n, LogLine& out) {
+    const LogSlot& slot = ring[n & (LOG_RING_LINES - 1)];
+    uint32_t expected = 2 * n + 2;
+    uint32_t version = slot.version.load(std::memory_order_acquire);
+    if (version != expected) {
+        return (int32_t)(version - expected) > 0 ? -1 : 0;
+    }
+    memcpy(&out, &slot.line, sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.version.load(std::memory_order_relaxed) == expected ? 1 : -1;
+}
+
+size_t logRead(uint32_t& cursor, LogLine* out, size_t max, uint32_t& lost) {
+    uint32_t next = nextLine.load(std::memory_order_acquire);
+    uint32_t oldest = next > LOG_RING_LINES ? next - LOG_RING_LINES : 0;
+    if ((int32_t)(cursor - next) > 0) {
+        cursor = oldest;
+    } else if ((int32_t)(oldest - cursor) > 0) {
+        lost += oldest - cursor;
+        cursor = oldest;
+    }
+
+    size_t count = 0;
+    while (count < max && cursor != next) {
+        int result = readLine(cursor, out[count]);
+        if (result == 0) break;
+        if (result > 0) {
+            count++;
+        } else {
+            lost++;
+        }
+        cursor++;
+    }
+    return count;
+}
+
+uint32_t logNextLine() {
+    return nextLine.load(std::memory_order_relaxed);
+}
+
+LogStats getLogStats() {
+    LogStats stats;
+    stats.lines = nextLine.load(std::memory_order_relaxed);
+    stats.dropped = droppedLines.load(std::memory_order_relaxed);
+    stats.truncated = truncatedLines.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* logLevelName(uint8_t level) {
+    static const char* const names[] = {"-", "E", "W", "I", "D", "V"};
+    return level <= LOG_LEVEL_VERBOSE ? names[level] : "?";
+}
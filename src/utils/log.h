@@ -0,0 +1,104 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+// ========== Logging ==========
+// LOGE / LOGW / LOGI / LOGD / LOGV(tag, fmt, ...) format one line into a
+// RAM ring and return. They never wait for the UART or take a lock, so a call
+// costs its vsnprintf (tens of µs) from loop(), async_tcp or any other task.
+// A low-priority task drains the ring to Serial, and GET /api/logs reads it.
+//
+// Calls below LOG_LEVEL (build flag, default LOG_LEVEL_INFO) compile to
+// nothing, arguments included. A file can set LOG_FILE_LEVEL before
+// including this header to log more (or less) than the rest of the build.
+//
+// Until logInit() starts the drain task, lines are printed as they are logged, so
+// the boot log cannot outrun the ring.
+//
+// tag must be a string literal (the ring keeps the pointer). Lines longer
+// than LOG_LINE_MAX - 1 characters are cut.
+
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+#define LOG_LEVEL_VERBOSE   5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL           LOG_LEVEL_INFO
+#endif
+#ifndef LOG_FILE_LEVEL
+#define LOG_FILE_LEVEL      LOG_LEVEL
+#endif
+
+#define LOG_RING_LINES      64          // Power of two
+#define LOG_LINE_MAX        115         // Message bytes per line, including the NUL (LogLine = 128 B)
+
+struct LogLine {
+    uint32_t seq;                       // Line number since boot
+    uint32_t ms;                        // millis() when logged
+    const char* tag;
+    uint8_t level;
+    char text[LOG_LINE_MAX];
+};
+
+struct LogStats {
+    uint32_t lines;                     // Lines logged since boot
+    uint32_t dropped;                   // Overwritten before the drain task printed them
+    uint32_t truncated;                 // Longer than LOG_LINE_MAX - 1
+};
+
+// ========== Functions ==========
+// Start the drain task; lines logged from then on are printed by it
+void logInit();
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Copy up to max complete lines from cursor on, advancing cursor. Lines
+// overwritten before they could be read are skipped and counted in lost.
+// A cursor ahead of the ring (e.g. from before a reboot) restarts at the
+// oldest line still held.
+size_t logRead(uint32_t& cursor, LogLine* out, size_t max, uint32_t& lost);
+
+// Number the next line will get
+uint32_t logNextLine();
+
+LogStats getLogStats();
+
+// "E", "W", "I", "D", "V"
+const char* logLevelName(uint8_t level);
+
+// ========== Macros ==========
+#if LOG_FILE_LEVEL >= LOG_LEVEL_ERROR
+#define LOGE(tag, ...)  logWrite(LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#else
+#define LOGE(tag, ...)  do {} while (0)
+#endif
+
+#if LOG_FILE_LEVEL >= LOG_LEVEL_WARN
+#define LOGW(tag, ...)  logWrite(LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#else
+#define LOGW(tag, ...)  do {} while (0)
+#endif
+
+#if LOG_FILE_LEVEL >= LOG_LEVEL_INFO
+#define LOGI(tag, ...)  logWrite(LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#else
+#define LOGI(tag, ...)  do {} while (0)
+#endif
+
+#if LOG_FILE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOGD(tag, ...)  logWrite(LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#else
+#define LOGD(tag, ...)  do {} while (0)
+#endif
+
+#if LOG_FILE_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOGV(tag, ...)  logWrite(LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#else
+#define LOGV(tag, ...)  do {} while (0)
+#endif
+
+#endif // LOG_H
@@ -0,0 +1,252 @@
+#include "perf.h"
+#include <math.h>
+
+static_assert((PERF_POLL_SAMPLE & (PERF_POLL_SAMPLE - 1)) == 0, "PERF_POLL_SAMPLE must be a power of two");
+static_assert(PERF_STAGES <= 32, "stage masks are 32 bits");
+
+struct StageData {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint16_t hist[PERF_HIST_BUCKETS];
+};
+
+static StageData stages[PERF_STAGES];
+static uint32_t stageCycles[PERF_STAGES];  // This iteration, valid where ranMask is set
+static uint32_t ranMask = 0;
+static uint32_t polledMask = 1u << PERF_LOOP;  // Stages recorded by perfPoll (sampled)
+static uint32_t loopStart = 0;
+static uint32_t lastMark = 0;
+static uint32_t iterations = 0;
+static uint64_t loopCycles = 0;             // All iterations
+static uint32_t worstCycles = 0;
+static uint32_t worstAtMs = 0;
+static bool worstSampled = false;
+static uint32_t worstStages[PERF_STAGES];
+static uint32_t statsSinceMs = 0;
+static uint32_t cpuMhz = 240;
+static float markCost = 0;
+static float iterationCost = 0;
+static volatile bool resetRequested = false;
+static volatile bool hudEnabled = false;
+static uint32_t sampleRandom = 0x9E3779B9;  // xorshift32 state
+
+bool perfPollSampled = false;
+
+static const char* const stageNames[PERF_STAGES] = {
+    "button", "psu_sample", "temperature", "adc", "fan", "tach",
+    "history", "recorders", "websocket", "display", "loop"
+};
+
+// ========== Histogram ==========
+
+static inline int bucketOf(uint32_t cycles) {
+    if (cycles < (1u << PERF_HIST_MIN_BITS)) return 0;
+    int octave = 31 - __builtin_clz(cycles);
+    return 1 + (octave - PERF_HIST_MIN_BITS) * 4 + ((cycles >> (octave - 2)) & 3);
+}
+
+// Exclusive upper bound of a bucket, in cycles
+static uint64_t bucketLimit(int bucket) {
+    if (bucket == 0) return 1u << PERF_HIST_MIN_BITS;
+    int octave = (bucket - 1) / 4 + PERF_HIST_MIN_BITS;
+    return (uint64_t)(5 + (bucket - 1) % 4) << (octave - 2);
+}
+
+static inline void record(StageData& stage, uint32_t cycles) {
+    stage.count++;
+    stage.totalCycles += cycles;
+    if (cycles < stage.minCycles) stage.minCycles = cycles;
+    if (cycles > stage.maxCycles) stage.maxCycles = cycles;
+    if (++stage.hist[bucketOf(cycles)] == UINT16_MAX) {
+        for (uint16_t& count : stage.hist) count >>= 1;
+    }
+}
+
+static float percentileCycles(const StageData& stage, float fraction) {
+    uint32_t total = 0;
+    for (uint16_t count : stage.hist) total += count;
+    if (total == 0) return 0;
+
+    uint32_t target = (uint32_t)ceilf(total * fraction);
+    uint32_t seen = 0;
+    for (int b = 0; b < PERF_HIST_BUCKETS; b++) {
+        seen += stage.hist[b];
+        if (seen >= target) {
+            uint64_t limit = bucketLimit(b);
+            if (limit > stage.maxCycles) limit = stage.maxCycles;
+            if (limit < stage.minCycles) limit = stage.minCycles;
+            return (float)limit;
+        }
+    }
+    return (float)stage.maxCycles;
+}
+
+static void clearStats() {
+    memset(stages, 0, sizeof(stages));
+    for (StageData& stage : stages) stage.minCycles = UINT32_MAX;
+    iterations = 0;
+    loopCycles = 0;
+    worstCycles = 0;
+    worstAtMs = 0;
+    worstSampled = false;
+    memset(worstStages, 0, sizeof(worstStages));
+    statsSinceMs = millis();
+}
+
+static inline uint32_t cycleCount() {
+    return ESP.getCycleCount();
+}
+
+// ========== Functions (loop task) ==========
+
+void perfInit() {
+    cpuMhz = ESP.getCpuFreqMHz();
+    clearStats();
+
+    // Time the profiler against itself, then start clean
+    uint32_t start = cycleCount();
+    for (int i = 0; i < 256; i++) {
+        perfLoopBegin();
+        perfLoopEnd();
+    }
+    iterationCost = (cycleCount() - start) / 256.0f;
+
+    perfLoopBegin();
+    start = cycleCount();
+    for (int i = 0; i < 64; i++) perfMark(PERF_BUTTON);
+    markCost = (cycleCount() - start) / 64.0f;
+    perfLoopEnd();
+
+    clearStats();
+}
+
+void perfLoopBegin() {
+    if (resetRequested) {
+        clearStats();
+        resetRequested = false;
+    }
+    // Random rather than every Nth iteration, which can alias with periodic work
+    sampleRandom ^= sampleRandom << 13;
+    sampleRandom ^= sampleRandom >> 17;
+    sampleRandom ^= sampleRandom << 5;
+    perfPollSampled = (sampleRandom & (PERF_POLL_SAMPLE - 1)) == 0;
+    iterations++;
+    ranMask = 0;
+    loopStart = lastMark = cycleCount();
+}
+
+void perfLoopEnd() {
+    uint32_t total = cycleCount() - loopStart;
+    loopCycles += total;
+
+    StageData& loop = stages[PERF_LOOP];
+    if (perfPollSampled) {
+        record(loop, total);
+    } else {
+        if (total < loop.minCycles) loop.minCycles = total;
+        if (total > loop.maxCycles) loop.maxCycles = total;
+    }
+
+    if (total > worstCycles) {
+        worstCycles = total;
+        worstAtMs = millis();
+        worstSampled = perfPollSampled;
+        for (int i = 0; i < PERF_LOOP; i++) {
+            worstStages[i] = (ranMask & (1u << i)) ? stageCycles[i] : 0;
+        }
+        worstStages[PERF_LOOP] = total;
+    }
+}
+
+void perfStart() {
+    lastMark = cycleCount();
+}
+
+void perfMark(PerfStage stage) {
+    uint32_t now = cycleCount();
+    uint32_t cycles = now - lastMark;
+    lastMark = now;
+    record(stages[stage], cycles);
+    stageCycles[stage] = cycles;
+    ranMask |= 1u << stage;
+}
+
+void perfPollMark(PerfStage stage) {
+    polledMask |= 1u << stage;
+    perfMark(stage);
+}
+
+// ========== Functions (any task) ==========
+
+PerfStageStats getPerfStageStats(PerfStage stage) {
+    StageData data = stages[stage];
+    float mhz = (float)cpuMhz;
+
+    PerfStageStats stats = {};
+    stats.count = data.count;
+    if (data.maxCycles == 0 && data.count == 0) return stats;
+    stats.minUs = data.minCycles == UINT32_MAX ? 0 : data.minCycles / mhz;
+    stats.maxUs = data.maxCycles / mhz;
+    if (data.count > 0) {
+        stats.p50Us = percentileCycles(data, 0.50f) / mhz;
+        stats.p99Us = percentileCycles(data, 0.99f) / mhz;
+        stats.avgUs = (float)data.totalCycles / data.count / mhz;
+    }
+    // perfPoll stages are timed on the iterations the loop stage is recorded
+    // on; scale them up to all iterations
+    float total = (float)data.totalCycles;
+    uint32_t sampled = stages[PERF_LOOP].count;
+    if ((polledMask & (1u << stage)) && sampled > 0) total *= (float)iterations / sampled;
+    stats.sharePct = loopCycles ? 100.0f * total / loopCycles : 0;
+
+    // Every iteration adds to loopCycles; use it rather than the sample
+    if (stage == PERF_LOOP && iterations > 0) {
+        stats.avgUs = (float)loopCycles / iterations / mhz;
+        stats.sharePct = 100.0f;
+    }
+    return stats;
+}
+
+PerfWorst getPerfWorst() {
+    PerfWorst worst = {};
+    float mhz = (float)cpuMhz;
+    worst.us = worstCycles / mhz;
+    worst.atMs = worstAtMs;
+    worst.pollsSampled = worstSampled;
+    for (int i = 0; i < PERF_STAGES; i++) worst.stageUs[i] = worstStages[i] / mhz;
+    return worst;
+}
+
+PerfSummary getPerfSummary() {
+    PerfSummary summary = {};
+    summary.iterations = iterations;
+    summary.sinceMs = statsSinceMs;
+    summary.cpuMhz = cpuMhz;
+    summary.markCycles = markCost;
+    summary.iterationCycles = iterationCost;
+
+    uint32_t marks = 0;
+    for (int i = 0; i < PERF_LOOP; i++) marks += stages[i].count;
+    if (loopCycles > 0) {
+        summary.overheadPct = 100.0f * (iterations * iterationCost + marks * markCost) / loopCycles;
+    }
+    return summary;
+}
+
+const char* perfStageName(PerfStage stage) {
+    return stage < PERF_STAGES ? stageNames[stage] : "?";
+}
+
+void perfRequestReset() {
+    resetRequested = true;
+}
+
+void perfSetHud(bool enabled) {
+    hudEnabled = enabled;
+}
+
+bool perfHudEnabled() {
+    return hudEnabled;
+}
@@ -0,0 +1,103 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <Arduino.h>
+
+// ========== Loop Stage Profiler ==========
+// Times the stages of loop() with the CPU cycle counter (loop() is pinned to
+// one core) into per-stage histograms, for GET /api/perf and the optional
+// on-screen HUD. Times include preemption by other tasks on the loop core.
+//
+//   perfLoopBegin();
+//   handleButton();       perfPoll(PERF_BUTTON);     // every iteration
+//   if (adcReady) {
+//       perfStart();
+//       processAdcReadings(); perfMark(PERF_ADC);    // when it runs
+//   }
+//   perfLoopEnd();
+//
+// perfMark() records the time since the previous perfMark / perfPoll /
+// perfStart. Stages that run on every pass of the idle loop use perfPoll(),
+// which only records on a random one iteration in PERF_POLL_SAMPLE: timing all of
+// them every pass would cost several % of an idle iteration (~20 µs).
+// Iteration totals and the worst iteration are measured on every pass.
+//
+// Histograms have 4 buckets per power of two of cycles (±12%); bucket
+// counts are halved when one saturates, so percentiles lean towards recent
+// behaviour. Statistics are read without locking; a reading can be off by
+// the iteration in progress.
+
+#define PERF_POLL_SAMPLE    16          // Power of two
+#define PERF_HIST_MIN_BITS  6           // Times below 64 cycles share bucket 0
+#define PERF_HIST_BUCKETS   (1 + (32 - PERF_HIST_MIN_BITS) * 4)
+
+enum PerfStage {
+    PERF_BUTTON,                // handleButton
+    PERF_PSU_SAMPLE,            // sampleSensorsNonBlocking
+    PERF_TEMPERATURE,           // updateTemperatureAcquisition
+    PERF_ADC,                   // processAdcReadings
+    PERF_FAN,                   // controlFan
+    PERF_TACH,                  // calculateRPM
+    PERF_HISTORY,               // updateTempHistory + heapTelemetryUpdate
+    PERF_RECORDERS,             // telemetryLogUpdate + motionTraceUpdate
+    PERF_WEBSOCKET,             // webSocket.loop (includes parseFluidNCStatus)
+    PERF_DISPLAY,               // updateDisplay
+    PERF_LOOP,                  // Whole iteration
+    PERF_STAGES
+};
+
+struct PerfStageStats {
+    uint32_t count;             // Times run (perfPoll stages: sampled runs)
+    float minUs;
+    float p50Us;
+    float p99Us;
+    float maxUs;
+    float avgUs;
+    float sharePct;             // Of the loop's busy time (sampled for perfPoll stages)
+};
+
+struct PerfWorst {
+    float us;                   // Longest iteration
+    uint32_t atMs;              // millis() when it ended
+    bool pollsSampled;          // perfPoll stages were timed in that iteration
+    float stageUs[PERF_STAGES]; // 0 for stages that did not run (or were not sampled)
+};
+
+struct PerfSummary {
+    uint32_t iterations;
+    uint32_t sinceMs;           // Statistics start (boot or last reset)
+    uint32_t cpuMhz;
+    float markCycles;           // Calibrated cost of one recorded stage
+    float iterationCycles;      // Calibrated fixed cost per iteration
+    float overheadPct;          // Estimated profiler time / loop busy time
+};
+
+// ========== Functions (loop task) ==========
+// Calibrate the profiler's own cost; call once from setup()
+void perfInit();
+
+void perfLoopBegin();
+void perfLoopEnd();
+void perfStart();
+void perfMark(PerfStage stage);
+
+extern bool perfPollSampled;    // Set by perfLoopBegin()
+void perfPollMark(PerfStage stage);
+
+inline void perfPoll(PerfStage stage) {
+    if (perfPollSampled) perfPollMark(stage);
+}
+
+// ========== Functions (any task) ==========
+PerfStageStats getPerfStageStats(PerfStage stage);
+PerfWorst getPerfWorst();
+PerfSummary getPerfSummary();
+const char* perfStageName(PerfStage stage);
+
+// Statistics are cleared by the loop task at its next iteration
+void perfRequestReset();
+
+void perfSetHud(bool enabled);
+bool perfHudEnabled();
+
+#endif // PERF_H
@@ -0,0 +1,205 @@
+#include "stall_monitor.h"
+#include "utils/log.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define STALL_TASK_STACK    3072
+#define STALL_TASK_PRIORITY 5           // Above async_tcp: a busy web server cannot hide a stall
+#define STALL_TASK_CORE     0           // loop() runs on core 1
+#define STALL_MAGIC         0x53544C31  // "STL1"
+
+struct StallRtc {
+    uint32_t magic;
+    uint32_t boot;
+    uint32_t count;                     // Records written; ring position
+    StallRecord records[STALL_RECORDS];
+};
+
+// Not cleared by a reset; random after power-on (checked by stallInit)
+RTC_NOINIT_ATTR StallMarks stallMarks;
+static RTC_NOINIT_ATTR StallRtc rtc;
+
+static const char* resetReason = "unknown";
+static bool resetStageValid = false;
+static uint8_t resetStage = STALL_SETUP;
+static TaskHandle_t monitorTask = nullptr;
+static volatile uint32_t stageSinceMs = 0;  // When the monitor last saw loop() move on
+static uint32_t generation = 0;             // Bumped by stallClear()
+static portMUX_TYPE recordMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "poweron";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int_wdt";
+        case ESP_RST_TASK_WDT:  return "task_wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
+
+const char* stallStageName(uint8_t stage) {
+    return stage == STALL_SETUP ? "setup" : perfStageName((PerfStage)stage);
+}
+
+static const char* ownerOrNone(const char* owner) {
+    return owner[0] ? owner : "free";
+}
+
+// ========== Monitor ==========
+
+static void monitorLoop(void*) {
+    uint32_t lastSeq = stallMarks.seq;
+    uint32_t sinceMs = millis();
+    int open = -1;                          // Record of the stall in progress
+    uint32_t openGeneration = 0;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(STALL_POLL_MS));
+        uint32_t now = millis();
+        uint32_t seq = stallMarks.seq;
+
+        if (seq != lastSeq) {
+            lastSeq = seq;
+            sinceMs = stageSinceMs = now;
+            if (open < 0) continue;
+
+            StallRecord record;
+            portENTER_CRITICAL(&recordMux);
+            bool current = openGeneration == generation;
+            if (current) {
+                rtc.records[open].flags &= ~STALL_OPEN;
+                record = rtc.records[open];
+            }
+            portEXIT_CRITICAL(&recordMux);
+            open = -1;
+            if (current) {
+                LOGW("STALL", "Stage %s stalled %lu ms (SD mutex: %s)", stallStageName(record.stage),
+                     (unsigned long)record.durationMs, ownerOrNone(record.lockOwner));
+            }
+            continue;
+        }
+
+        uint32_t stalledMs = now - sinceMs;
+        if (stalledMs < STALL_THRESHOLD_MS) continue;
+
+        portENTER_CRITICAL(&recordMux);
+        if (open >= 0 && openGeneration != generation) open = -1;
+        if (open < 0) {
+            open = rtc.count++ % STALL_RECORDS;
+            openGeneration = generation;
+            StallRecord& record = rtc.records[open];
+            memset(&record, 0, sizeof(record));
+            record.boot = rtc.boot;
+            record.atMs = sinceMs;
+            record.stage = stallMarks.stage;
+            record.flags = STALL_OPEN;
+        }
+        StallRecord& record = rtc.records[open];
+        record.durationMs = stalledMs;
+        // The first holder seen during the stall, and for how long it held
+        if (stallMarks.lockOwner[0]) {
+            if (!record.lockOwner[0]) {
+                strlcpy(record.lockOwner, stallMarks.lockOwner, sizeof(record.lockOwner));
+            }
+            if (strncmp(record.lockOwner, stallMarks.lockOwner, sizeof(record.lockOwner)) == 0) {
+                record.lockHeldMs = now - stallMarks.lockSinceMs;
+            }
+        }
+        portEXIT_CRITICAL(&recordMux);
+    }
+}
+
+// ========== Functions ==========
+
+void stallInit() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    resetReason = resetReasonName(reason);
+
+    bool valid = reason != ESP_RST_POWERON && rtc.magic == STALL_MAGIC;
+    if (valid) {
+        rtc.boot++;
+        resetStageValid = true;
+        resetStage = stallMarks.stage;
+        LOGW("STALL", "Reset (%s) during stage %s, boot %lu", resetReason,
+             stallStageName(resetStage), (unsigned long)rtc.boot);
+
+        // Stalls of the previous boot, oldest first; an open one never ended
+        uint32_t count = min(rtc.count, (uint32_t)STALL_RECORDS);
+        for (uint32_t i = rtc.count - count; i != rtc.count; i++) {
+            StallRecord& record = rtc.records[i % STALL_RECORDS];
+            if (record.flags & STALL_OPEN) record.flags = STALL_RESET;
+            if (record.boot != rtc.boot - 1) continue;
+            record.lockOwner[STALL_OWNER_LEN - 1] = '\0';
+            LOGW("STALL", "  at %lu ms: %s stalled %lu ms%s (SD mutex: %s, held %lu ms)",
+                 (unsigned long)record.atMs, stallStageName(record.stage),
+                 (unsigned long)record.durationMs, (record.flags & STALL_RESET) ? " until the reset" : "",
+                 ownerOrNone(record.lockOwner), (unsigned long)record.lockHeldMs);
+        }
+    } else {
+        memset(&rtc, 0, sizeof(rtc));
+        rtc.magic = STALL_MAGIC;
+        rtc.boot = 1;
+    }
+
+    memset((void*)&stallMarks, 0, sizeof(stallMarks));
+    stallMarks.stage = STALL_SETUP;
+}
+
+void stallStart() {
+    if (monitorTask != nullptr) return;
+    stageSinceMs = millis();
+    if (xTaskCreatePinnedToCore(monitorLoop, "stall_mon", STALL_TASK_STACK, nullptr,
+                                STALL_TASK_PRIORITY, &monitorTask, STALL_TASK_CORE) != pdPASS) {
+        monitorTask = nullptr;
+        LOGE("STALL", "Failed to start monitor task");
+    }
+}
+
+void stallLockTaken() {
+    strlcpy(stallMarks.lockOwner, pcTaskGetName(nullptr), sizeof(stallMarks.lockOwner));
+    stallMarks.lockSinceMs = millis();
+}
+
+void stallLockReleased() {
+    stallMarks.lockOwner[0] = '\0';
+}
+
+StallState getStallState() {
+    StallState state;
+    state.boot = rtc.boot;
+    state.resetReason = resetReason;
+    state.resetStageValid = resetStageValid;
+    state.resetStage = resetStage;
+    state.stage = stallMarks.stage;
+    state.stageMs = monitorTask ? millis() - stageSinceMs : 0;
+    strlcpy(state.lockOwner, stallMarks.lockOwner, sizeof(state.lockOwner));
+    state.lockHeldMs = state.lockOwner[0] ? millis() - stallMarks.lockSinceMs : 0;
+    state.stalls = rtc.count;
+    return state;
+}
+
+size_t getStallRecords(StallRecord* out, size_t max) {
+    portENTER_CRITICAL(&recordMux);
+    size_t count = min((size_t)min(rtc.count, (uint32_t)STALL_RECORDS), max);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = rtc.records[(rtc.count - 1 - i) % STALL_RECORDS];
+    }
+    portEXIT_CRITICAL(&recordMux);
+    return count;
+}
+
+void stallClear() {
+    portENTER_CRITICAL(&recordMux);
+    rtc.count = 0;
+    memset(rtc.records, 0, sizeof(rtc.records));
+    generation++;
+    portEXIT_CRITICAL(&recordMux);
+}
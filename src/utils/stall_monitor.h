@@ -0,0 +1,91 @@
+#ifndef STALL_MONITOR_H
+#define STALL_MONITOR_H
+
+#include <Arduino.h>
+#include "perf.h"
+
+// ========== Loop Stall Monitor ==========
+// loop() marks the stage it enters (PerfStage) and the SD mutex helpers
+// mark its holder, in RTC slow memory that survives a watchdog or panic
+// reset. A monitor task on core 0 checks every STALL_POLL_MS that loop()
+// moved on. A stage running for STALL_THRESHOLD_MS or more is recorded
+// with its duration and the SD mutex holder (to STALL_POLL_MS), in a ring
+// of STALL_RECORDS that is also in RTC memory. A stall still open at a
+// reset is the one the watchdog (10 s) fired on.
+//
+// At boot the stalls recorded before the reset are logged, and GET
+// /api/stalls lists them with the reset reason and the stage that was
+// running when the reset happened. The records are lost on power-on.
+//
+//   stallEnter(PERF_DISPLAY);
+//   updateDisplay();
+//
+// PERF_LOOP stands for "between stages": loop() code that is not marked,
+// and the time loop() waits for other tasks after its iteration.
+// STALL_SETUP is setup(), until the first stage is entered.
+
+#define STALL_THRESHOLD_MS  500
+#define STALL_POLL_MS       100
+#define STALL_RECORDS       8
+#define STALL_OWNER_LEN     16          // configMAX_TASK_NAME_LEN
+#define STALL_SETUP         PERF_STAGES // Stage value for setup()
+
+enum StallFlags : uint8_t {
+    STALL_OPEN  = 0x01,                 // Still running (or ended by the reset)
+    STALL_RESET = 0x02                  // Open when the device reset
+};
+
+struct StallRecord {
+    uint32_t boot;                      // Boot it happened in (counted since power-on)
+    uint32_t atMs;                      // millis() when the stage started
+    uint32_t durationMs;
+    uint32_t lockHeldMs;                // How long the holder had held the SD mutex
+    uint8_t stage;                      // PerfStage or STALL_SETUP
+    uint8_t flags;                      // StallFlags
+    char lockOwner[STALL_OWNER_LEN];    // SD mutex holder, "" if free
+};
+
+struct StallState {
+    uint32_t boot;
+    const char* resetReason;
+    bool resetStageValid;               // Not a power-on: resetStage is meaningful
+    uint8_t resetStage;                 // Stage running when the device reset
+    uint8_t stage;                      // Now
+    uint32_t stageMs;                   // How long it has been running (to STALL_POLL_MS)
+    char lockOwner[STALL_OWNER_LEN];
+    uint32_t lockHeldMs;
+    uint32_t stalls;                    // Recorded since power-on / clear
+};
+
+// Written by loop() and the SD mutex holders, read by the monitor
+struct StallMarks {
+    volatile uint32_t seq;              // Bumped on every stage entry
+    volatile uint8_t stage;
+    volatile uint32_t lockSinceMs;
+    char lockOwner[STALL_OWNER_LEN];
+};
+
+extern StallMarks stallMarks;           // RTC_NOINIT
+
+// ========== Functions ==========
+// Call first in setup(): reads what the previous boot left in RTC memory
+void stallInit();
+// Call at the end of setup(): starts the monitor
+void stallStart();
+
+inline void stallEnter(PerfStage stage) {
+    stallMarks.stage = stage;
+    stallMarks.seq = stallMarks.seq + 1;
+}
+
+// SD mutex holder (sd_mutex.h)
+void stallLockTaken();
+void stallLockReleased();
+
+StallState getStallState();
+const char* stallStageName(uint8_t stage);
+// Copy up to max records, newest first; returns the count
+size_t getStallRecords(StallRecord* out, size_t max);
+void stallClear();
+
+#endif // STALL_MONITOR_H
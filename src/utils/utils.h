@@ -4,7 +4,7 @@
 #include <Arduino.h>
 
 // ========== Memory Management ==========
-// Allocate temperature history buffer based on config
+// Allocate the temperature history store (per channel, see history_store.h)
 void allocateHistoryBuffer();
 
 // ========== Watchdog Functions ==========
@@ -12,8 +12,6 @@ void allocateHistoryBuffer();
 // They are declared in esp32-hal.h and don't need to be redeclared here
 
 // ========== External Variables ==========
-extern float *tempHistory;
-extern uint16_t historySize;
-extern uint16_t historyIndex;
+extern uint8_t temperatureCount;
 
 #endif // UTILS_H
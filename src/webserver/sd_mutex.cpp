@@ -1,25 +1,79 @@
 #include "sd_mutex.h"
+#include "utils/log.h"
 #include <Arduino.h>
 
 SemaphoreHandle_t g_sdCardMutex = NULL;
 
 void initSDMutex() {
-    Serial.printf("[SD_MUTEX] Creating mutex...\n");
+    LOGD("SD_MUTEX", "Creating mutex...");
 
     g_sdCardMutex = xSemaphoreCreateMutex();
 
     if (g_sdCardMutex == NULL) {
-        Serial.println("[SD_MUTEX] FATAL: xSemaphoreCreateMutex() failed!");
+        LOGE("SD_MUTEX", "FATAL: xSemaphoreCreateMutex() failed!");
         return;
     }
 
-    Serial.printf("[SD_MUTEX] ✓ Mutex created at 0x%p\n", g_sdCardMutex);
+    LOGD("SD_MUTEX", "✓ Mutex created at 0x%p", g_sdCardMutex);
 
     // Test it immediately
     if (xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         xSemaphoreGive(g_sdCardMutex);
-        Serial.println("[SD_MUTEX] ✓ Mutex test PASSED");
+        LOGD("SD_MUTEX", "✓ Mutex test PASSED");
     } else {
-        Serial.println("[SD_MUTEX] ✗ Mutex test FAILED - cannot acquire!");
+        LOGE("SD_MUTEX", "✗ Mutex test FAILED - cannot acquire!");
+    }
+}
+
+// ========== Deferred Close ==========
+
+#define SD_DEFERRED_CLOSE_MAX 4
+
+volatile uint8_t g_sdDeferredCloses = 0;
+static File deferredFiles[SD_DEFERRED_CLOSE_MAX];
+static portMUX_TYPE deferredMux = portMUX_INITIALIZER_UNLOCKED;
+
+void sdMutexClose(File& file, TickType_t ticks) {
+    if (!file) return;
+    if (sdMutexTake(ticks) == pdTRUE) {
+        file.close();
+        sdMutexGive();
+        return;
+    }
+
+    bool queued = false;
+    portENTER_CRITICAL(&deferredMux);
+    for (uint8_t i = 0; i < SD_DEFERRED_CLOSE_MAX && !queued; i++) {
+        if (deferredFiles[i]) continue;
+        deferredFiles[i] = file;
+        g_sdDeferredCloses++;
+        queued = true;
+    }
+    portEXIT_CRITICAL(&deferredMux);
+
+    if (!queued) {
+        LOGW("SD_MUTEX", "Close queue full - waiting for the card");
+        sdMutexTake(portMAX_DELAY);
+        file.close();
+        sdMutexGive();
+        return;
+    }
+    file = File();
+
+    // The holder may have released it before the file was queued
+    if (sdMutexTake(0) == pdTRUE) sdMutexGive();
+}
+
+void sdCloseDeferred() {
+    for (uint8_t i = 0; i < SD_DEFERRED_CLOSE_MAX; i++) {
+        File file;
+        portENTER_CRITICAL(&deferredMux);
+        if (deferredFiles[i]) {
+            file = deferredFiles[i];
+            deferredFiles[i] = File();
+            g_sdDeferredCloses--;
+        }
+        portEXIT_CRITICAL(&deferredMux);
+        if (file) file.close();
     }
 }
@@ -3,9 +3,51 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <FS.h>
+#include "utils/event_trace.h"
+#include "utils/stall_monitor.h"
 
 extern SemaphoreHandle_t g_sdCardMutex;
+extern volatile uint8_t g_sdDeferredCloses;
 
 void initSDMutex();
 
+// Close file under g_sdCardMutex, for callers that must not wait on it
+// indefinitely (async_tcp callbacks: an upload holds it across callbacks
+// on that same task). Waits up to ticks; if the card stays busy the file
+// is queued and closed by the holder in sdMutexGive(). Never drops it
+// open - a File's destructor would close it outside the lock.
+void sdMutexClose(File& file, TickType_t ticks);
+
+// Close the queued files - holder only (sdMutexGive())
+void sdCloseDeferred();
+
+// Take / give g_sdCardMutex. The holder is marked for the stall monitor.
+// With EVENT_TRACE the hold shows as an "sd_mutex" async slice (uploads
+// hold it across callbacks) and time spent blocked on another holder as an
+// "sd_wait" slice.
+inline BaseType_t sdMutexTake(TickType_t ticks) {
+#if EVENT_TRACE
+    if (xSemaphoreTake(g_sdCardMutex, 0) != pdTRUE) {
+        if (ticks == 0) return pdFALSE;
+        EVT_BEGIN("sd_wait");
+        BaseType_t taken = xSemaphoreTake(g_sdCardMutex, ticks);
+        EVT_END("sd_wait");
+        if (taken != pdTRUE) return taken;
+    }
+    EVT_ASYNC_BEGIN("sd_mutex");
+#else
+    if (xSemaphoreTake(g_sdCardMutex, ticks) != pdTRUE) return pdFALSE;
+#endif
+    stallLockTaken();
+    return pdTRUE;
+}
+
+inline BaseType_t sdMutexGive() {
+    if (g_sdDeferredCloses) sdCloseDeferred();
+    stallLockReleased();
+    EVT_ASYNC_END("sd_mutex");
+    return xSemaphoreGive(g_sdCardMutex);
+}
+
 #endif // SD_MUTEX_H
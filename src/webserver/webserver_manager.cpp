@@ -1,9 +1,25 @@
 #include "webserver_manager.h"
 #include "sd_mutex.h"
+#include "display/layout_parser.h"
+#include "display/layout_analyzer.h"
+#include "sensors/sensors.h"
+#include "sensors/psu_monitor.h"
+#include "sensors/fan_tach.h"
+#include "sensors/fan_control.h"
+#include "history/telemetry_log.h"
+#include "history/history_stream.h"
+#include "history/motion_trace.h"
+#include "config/config.h"
+#include "utils/log.h"
+#include "utils/perf.h"
+#include "utils/event_trace.h"
+#include "utils/heap_telemetry.h"
+#include "utils/stall_monitor.h"
 #include <SD.h>
 #include <ArduinoJson.h>
 #include <FS.h>
 #include <vector>
+#include <new>
 
 // Global instance
 WebServerManager webServer;
@@ -28,22 +44,23 @@ void WebServerManager::begin() {
 
     // Start server
     server->begin();
-    Serial.println("AsyncWebServer started");
+    LOGI("WEB", "AsyncWebServer started");
 }
 
 // Stop the web server
 void WebServerManager::stop() {
     server->end();
-    Serial.println("AsyncWebServer stopped");
+    LOGI("WEB", "AsyncWebServer stopped");
 }
 
 // Helper function to list directory recursively
 void WebServerManager::listDirRecursive(File dir, String prefix, JsonArray& files, int depth) {
+    HEAP_SCOPE(HEAP_WEB, "listDirRecursive");
     if (depth > 3) return;  // Limit recursion depth
 
     // Verify dir is valid before using it
     if (!dir) {
-        Serial.println("[listDirRecursive] Invalid directory handle");
+        LOGW("listDirRecursive", "Invalid directory handle");
         return;
     }
 
@@ -57,7 +74,7 @@ void WebServerManager::listDirRecursive(File dir, String prefix, JsonArray& file
         // The ESP32 SD library can return invalid File objects
         const char* entryName = entry.name();
         if (!entryName) {
-            Serial.println("[listDirRecursive] Warning: entry.name() returned NULL, skipping");
+            LOGW("listDirRecursive", "entry.name() returned NULL, skipping");
             entry.close();
             continue;
         }
@@ -83,29 +100,72 @@ void WebServerManager::listDirRecursive(File dir, String prefix, JsonArray& file
     }
 }
 
+// Parse screen JSON with the real layout model and send the lint report.
+// Runs on the async_tcp task, so the layout lives on the heap.
+static void sendLayoutAnalysis(AsyncWebServerRequest *request, const char* json) {
+    uint32_t budgetMs = LAYOUT_FRAME_BUDGET_MS;
+    if (request->hasParam("budget_ms")) {
+        const char* text = request->getParam("budget_ms")->value().c_str();
+        char* end;
+        long value = strtol(text, &end, 10);
+        if (end == text || *end != '\0' || value < 1 || value > LAYOUT_BUDGET_MAX_MS) {
+            char error[64];
+            snprintf(error, sizeof(error), "{\"error\":\"budget_ms must be 1-%d\"}", LAYOUT_BUDGET_MAX_MS);
+            request->send(400, "application/json", error);
+            return;
+        }
+        budgetMs = value;
+    }
+
+    ScreenLayout* layout = new (std::nothrow) ScreenLayout();
+    if (layout == nullptr) {
+        request->send(503, "application/json", "{\"error\":\"Out of memory\"}");
+        return;
+    }
+
+    if (!parseScreenJson(json, *layout, false)) {
+        delete layout;
+        request->send(400, "application/json", "{\"error\":\"Invalid screen JSON\"}");
+        return;
+    }
+
+    LayoutReport report;
+    analyzeLayout(*layout, budgetMs * 1000UL, report);
+
+    JsonDocument doc;
+    layoutReportToJson(*layout, report, doc.to<JsonObject>());
+    delete layout;
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
 // Setup screen-related routes
 void WebServerManager::setupScreenRoutes() {
     // GET /api/screens - List all screen JSON files
     server->on("/api/screens", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/screens");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/screens");
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/screens] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/screens", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/screens] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/screens", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/screens] Failed to acquire lock (timeout)");
+            LOGE("API/screens", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/screens] ✓ Lock acquired");
+        LOGD("API/screens", "✓ Lock acquired");
 
         File screensDir = SD.open("/screens");
         if (!screensDir || !screensDir.isDirectory()) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/screens] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/screens", "✓ Unlocked");
             request->send(500, "application/json", "{\"error\":\"Failed to open screens directory\"}");
             return;
         }
@@ -122,7 +182,7 @@ void WebServerManager::setupScreenRoutes() {
             // CRITICAL: Validate entry before accessing methods
             const char* entryName = entry.name();
             if (!entryName) {
-                Serial.println("[API/screens] Warning: entry.name() returned NULL, skipping");
+                LOGW("API/screens", "entry.name() returned NULL, skipping");
                 entry.close();
                 continue;
             }
@@ -141,8 +201,8 @@ void WebServerManager::setupScreenRoutes() {
             entry.close();
         }
         screensDir.close();
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/screens] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/screens", "✓ Unlocked");
 
         String response;
         serializeJson(doc, response);
@@ -152,29 +212,31 @@ void WebServerManager::setupScreenRoutes() {
     // POST /api/upload-screen - Upload a screen JSON file
     server->on("/api/upload-screen", HTTP_POST,
         [](AsyncWebServerRequest *request) {
+            HEAP_SCOPE(HEAP_WEB, "POST /api/upload-screen");
             request->send(200, "application/json", "{\"success\":true}");
         },
         [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+            EVT_SCOPE("POST /api/upload-screen");
             static File uploadFile;
             static bool mutexLocked = false;
 
             if (index == 0) {
-                Serial.printf("Upload start: %s\n", filename.c_str());
+                LOGD("WEB", "Upload start: %s", filename.c_str());
 
                 if (g_sdCardMutex == NULL) {
-                    Serial.println("[API/upload-screen] CRASH PREVENTED: Mutex is NULL!");
+                    LOGE("API/upload-screen", "CRASH PREVENTED: Mutex is NULL!");
                     mutexLocked = false;
                     return;
                 }
 
-                Serial.printf("[API/upload-screen] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-                BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+                LOGD("API/upload-screen", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+                BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
                 if (lockResult != pdTRUE) {
-                    Serial.println("[API/upload-screen] Failed to acquire lock (timeout)");
+                    LOGE("API/upload-screen", "Failed to acquire lock (timeout)");
                     mutexLocked = false;
                     return;
                 }
-                Serial.println("[API/upload-screen] ✓ Lock acquired");
+                LOGD("API/upload-screen", "✓ Lock acquired");
                 mutexLocked = true;
 
                 if (!SD.exists("/screens")) {
@@ -185,10 +247,10 @@ void WebServerManager::setupScreenRoutes() {
                 uploadFile = SD.open(filepath, FILE_WRITE);
 
                 if (!uploadFile) {
-                    BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-                    Serial.printf("[API/upload-screen] ✓ Unlocked (result=%d)\n", unlockResult);
+                    sdMutexGive();
+                    LOGD("API/upload-screen", "✓ Unlocked");
                     mutexLocked = false;
-                    Serial.println("Failed to open file for writing");
+                    LOGE("WEB", "Failed to open file for writing");
                     return;
                 }
             }
@@ -202,17 +264,19 @@ void WebServerManager::setupScreenRoutes() {
                     uploadFile.close();
                 }
                 if (mutexLocked) {
-                    BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-                    Serial.printf("[API/upload-screen] ✓ Unlocked (result=%d)\n", unlockResult);
+                    sdMutexGive();
+                    LOGD("API/upload-screen", "✓ Unlocked");
                     mutexLocked = false;
                 }
-                Serial.printf("Upload complete: %s, total size: %d\n", filename.c_str(), index + len);
+                LOGI("WEB", "Upload complete: %s, total size: %d", filename.c_str(), index + len);
             }
         }
     );
 
     // DELETE /api/delete-screen?filename=xxx
     server->on("/api/delete-screen", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("DELETE /api/delete-screen");
+        HEAP_SCOPE(HEAP_WEB, "DELETE /api/delete-screen");
         if (!request->hasParam("filename")) {
             request->send(400, "application/json", "{\"error\":\"Missing filename parameter\"}");
             return;
@@ -222,30 +286,30 @@ void WebServerManager::setupScreenRoutes() {
         String filepath = "/screens/" + filename;
 
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/delete-screen] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/delete-screen", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/delete-screen] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/delete-screen", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/delete-screen] Failed to acquire lock (timeout)");
+            LOGE("API/delete-screen", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/delete-screen] ✓ Lock acquired");
+        LOGD("API/delete-screen", "✓ Lock acquired");
 
         if (!SD.exists(filepath)) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/delete-screen] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/delete-screen", "✓ Unlocked");
             request->send(404, "application/json", "{\"error\":\"File not found\"}");
             return;
         }
 
         bool success = SD.remove(filepath);
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/delete-screen] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/delete-screen", "✓ Unlocked");
 
         if (success) {
             request->send(200, "application/json", "{\"success\":true}");
@@ -253,12 +317,91 @@ void WebServerManager::setupScreenRoutes() {
             request->send(500, "application/json", "{\"error\":\"Failed to delete file\"}");
         }
     });
+
+    // GET /api/analyze-screen?filename=xxx[&budget_ms=N] - Lint a saved screen
+    server->on("/api/analyze-screen", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/analyze-screen");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/analyze-screen");
+        if (!request->hasParam("filename")) {
+            request->send(400, "application/json", "{\"error\":\"Missing filename parameter\"}");
+            return;
+        }
+
+        String filepath = "/screens/" + request->getParam("filename")->value();
+
+        if (g_sdCardMutex == NULL) {
+            LOGE("API/analyze-screen", "CRASH PREVENTED: Mutex is NULL!");
+            request->send(500, "text/plain", "SD mutex not initialized");
+            return;
+        }
+
+        LOGD("API/analyze-screen", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
+        if (lockResult != pdTRUE) {
+            LOGE("API/analyze-screen", "Failed to acquire lock (timeout)");
+            request->send(503, "text/plain", "SD card busy");
+            return;
+        }
+        LOGD("API/analyze-screen", "✓ Lock acquired");
+
+        File file = SD.open(filepath, FILE_READ);
+        if (!file || file.size() > 8192) {
+            if (file) file.close();
+            sdMutexGive();
+            LOGD("API/analyze-screen", "✓ Unlocked");
+            request->send(404, "application/json", "{\"error\":\"File not found or too large\"}");
+            return;
+        }
+
+        size_t fileSize = file.size();
+        char* json = (char*)malloc(fileSize + 1);
+        if (json != nullptr) {
+            json[file.readBytes(json, fileSize)] = '\0';
+        }
+        file.close();
+        sdMutexGive();
+        LOGD("API/analyze-screen", "✓ Unlocked");
+
+        if (json == nullptr) {
+            request->send(503, "application/json", "{\"error\":\"Out of memory\"}");
+            return;
+        }
+        sendLayoutAnalysis(request, json);
+        free(json);
+    });
+
+    // POST /api/analyze-screen[?budget_ms=N] - Lint a screen JSON body (editor)
+    server->on("/api/analyze-screen", HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            HEAP_SCOPE(HEAP_WEB, "POST /api/analyze-screen");
+            if (request->_tempObject == nullptr) {
+                request->send(400, "application/json", "{\"error\":\"Missing or too large body\"}");
+                return;
+            }
+            sendLayoutAnalysis(request, (const char*)request->_tempObject);
+        },
+        NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            // Collect the body; the server frees _tempObject with the request
+            if (index == 0 && total <= 8192) {
+                request->_tempObject = malloc(total + 1);
+            }
+            if (request->_tempObject == nullptr) return;
+
+            char* body = (char*)request->_tempObject;
+            memcpy(body + index, data, len);
+            if (index + len == total) {
+                body[total] = '\0';
+            }
+        }
+    );
 }
 
 // Setup schema-related routes
 void WebServerManager::setupSchemaRoutes() {
     // GET /api/schema/screen-elements - Return JSON schema for screen elements
     server->on("/api/schema/screen-elements", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/schema/screen-elements");
         JsonDocument doc;
 
         doc["title"] = "Screen Element Schema";
@@ -309,25 +452,27 @@ void WebServerManager::setupSchemaRoutes() {
 void WebServerManager::setupFileRoutes() {
     // GET /api/files - List all files on SD card
     server->on("/api/files", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/files");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/files");
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/files] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/files", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/files] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/files", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/files] Failed to acquire lock (timeout)");
+            LOGE("API/files", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/files] ✓ Lock acquired");
+        LOGD("API/files", "✓ Lock acquired");
 
         File root = SD.open("/");
         if (!root || !root.isDirectory()) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/files] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/files", "✓ Unlocked");
             request->send(500, "application/json", "{\"error\":\"Failed to open root directory\"}");
             return;
         }
@@ -338,8 +483,8 @@ void WebServerManager::setupFileRoutes() {
         listDirRecursive(root, "", files, 0);
 
         root.close();
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/files] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/files", "✓ Unlocked");
 
         String response;
         serializeJson(doc, response);
@@ -348,6 +493,8 @@ void WebServerManager::setupFileRoutes() {
 
     // GET /api/download?path=xxx - Download a file
     server->on("/api/download", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/download");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/download");
         if (!request->hasParam("path")) {
             request->send(400, "application/json", "{\"error\":\"Missing path parameter\"}");
             return;
@@ -356,31 +503,31 @@ void WebServerManager::setupFileRoutes() {
         String filepath = request->getParam("path")->value();
 
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/download] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/download", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/download] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/download", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/download] Failed to acquire lock (timeout)");
+            LOGE("API/download", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/download] ✓ Lock acquired");
+        LOGD("API/download", "✓ Lock acquired");
 
         if (!SD.exists(filepath)) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/download] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/download", "✓ Unlocked");
             request->send(404, "application/json", "{\"error\":\"File not found\"}");
             return;
         }
 
         File file = SD.open(filepath, FILE_READ);
         if (!file) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/download] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/download", "✓ Unlocked");
             request->send(500, "application/json", "{\"error\":\"Failed to open file\"}");
             return;
         }
@@ -389,16 +536,16 @@ void WebServerManager::setupFileRoutes() {
         size_t fileSize = file.size();
         if (fileSize > 102400) {  // 100KB limit
             file.close();
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/download] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/download", "✓ Unlocked");
             request->send(413, "application/json", "{\"error\":\"File too large\"}");
             return;
         }
 
         String content = file.readString();
         file.close();
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/download] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/download", "✓ Unlocked");
 
         // Now safe to send - file is closed, mutex is unlocked
         request->send(200, "application/octet-stream", content);
@@ -406,6 +553,8 @@ void WebServerManager::setupFileRoutes() {
 
     // DELETE /api/delete-file?path=xxx - Delete a file
     server->on("/api/delete-file", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("DELETE /api/delete-file");
+        HEAP_SCOPE(HEAP_WEB, "DELETE /api/delete-file");
         if (!request->hasParam("path")) {
             request->send(400, "application/json", "{\"error\":\"Missing path parameter\"}");
             return;
@@ -414,30 +563,30 @@ void WebServerManager::setupFileRoutes() {
         String filepath = request->getParam("path")->value();
 
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/delete-file] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/delete-file", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/delete-file] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/delete-file", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/delete-file] Failed to acquire lock (timeout)");
+            LOGE("API/delete-file", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/delete-file] ✓ Lock acquired");
+        LOGD("API/delete-file", "✓ Lock acquired");
 
         if (!SD.exists(filepath)) {
-            BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-            Serial.printf("[API/delete-file] ✓ Unlocked (result=%d)\n", unlockResult);
+            sdMutexGive();
+            LOGD("API/delete-file", "✓ Unlocked");
             request->send(404, "application/json", "{\"error\":\"File not found\"}");
             return;
         }
 
         bool success = SD.remove(filepath);
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/delete-file] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/delete-file", "✓ Unlocked");
 
         if (success) {
             request->send(200, "application/json", "{\"success\":true}");
@@ -448,27 +597,29 @@ void WebServerManager::setupFileRoutes() {
 
     // GET /api/disk-usage - Get SD card disk usage
     server->on("/api/disk-usage", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/disk-usage");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/disk-usage");
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/disk-usage] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/disk-usage", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/disk-usage] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        LOGD("API/disk-usage", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
         if (lockResult != pdTRUE) {
-            Serial.println("[API/disk-usage] Failed to acquire lock (timeout)");
+            LOGE("API/disk-usage", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
-        Serial.println("[API/disk-usage] ✓ Lock acquired");
+        LOGD("API/disk-usage", "✓ Lock acquired");
 
         uint64_t cardSize = SD.cardSize() / (1024 * 1024);
         uint64_t totalBytes = SD.totalBytes() / (1024 * 1024);
         uint64_t usedBytes = SD.usedBytes() / (1024 * 1024);
 
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/disk-usage] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/disk-usage", "✓ Unlocked");
 
         JsonDocument doc;
         doc["cardSizeMB"] = cardSize;
@@ -486,6 +637,7 @@ void WebServerManager::setupFileRoutes() {
 void WebServerManager::setupLegacyRoutes() {
     // GET / - Root page with API documentation
     server->on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /");
         String html = "<html><head><title>FluidDash API</title></head><body>";
         html += "<h1>FluidDash Web Server</h1>";
         html += "<p>AsyncWebServer is running. Available endpoints:</p>";
@@ -507,6 +659,8 @@ void WebServerManager::setupLegacyRoutes() {
         html += "<li>GET <a href='/api/status'>/api/status</a> - System status</li>";
         html += "<li>GET <a href='/api/config'>/api/config</a> - Current configuration</li>";
         html += "<li>GET <a href='/api/sensor-mappings'>/api/sensor-mappings</a> - Sensor mappings</li>";
+        html += "<li>GET <a href='/api/sensors/events'>/api/sensors/events</a> - Sensor hot-plug events (?since=seq)</li>";
+        html += "<li>GET <a href='/api/sensors/identify'>/api/sensors/identify</a> - Touch identification status (POST ?timeout=ms&threshold=C starts, DELETE cancels)</li>";
         html += "</ul>";
         html += "<h2>Schema</h2>";
         html += "<ul>";
@@ -518,21 +672,25 @@ void WebServerManager::setupLegacyRoutes() {
 
     // GET /settings - Settings page
     server->on("/settings", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /settings");
         request->send(200, "text/html", "<html><body><h1>Settings</h1><p>Settings page placeholder</p></body></html>");
     });
 
     // GET /admin - Admin page
     server->on("/admin", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /admin");
         request->send(200, "text/html", "<html><body><h1>Admin</h1><p>Admin page placeholder</p></body></html>");
     });
 
     // GET /wifi - WiFi configuration page
     server->on("/wifi", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /wifi");
         request->send(200, "text/html", "<html><body><h1>WiFi Configuration</h1><p>WiFi config placeholder</p></body></html>");
     });
 
     // GET /api/config - Get current configuration
     server->on("/api/config", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/config");
         JsonDocument doc;
         doc["wifi"]["ssid"] = "FluidDash";
         doc["wifi"]["connected"] = true;
@@ -546,25 +704,27 @@ void WebServerManager::setupLegacyRoutes() {
 
     // GET /api/status - Get system status
     server->on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/status");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/status");
         // EXPLICIT verification
         if (g_sdCardMutex == NULL) {
-            Serial.println("[API/status] CRASH PREVENTED: Mutex is NULL!");
+            LOGE("API/status", "CRASH PREVENTED: Mutex is NULL!");
             request->send(500, "text/plain", "SD mutex not initialized");
             return;
         }
 
-        Serial.printf("[API/status] Attempting to lock mutex at 0x%p\n", g_sdCardMutex);
+        LOGD("API/status", "Attempting to lock mutex at 0x%p", g_sdCardMutex);
 
         // EXPLICIT lock with return value check
-        BaseType_t lockResult = xSemaphoreTake(g_sdCardMutex, pdMS_TO_TICKS(5000));
+        BaseType_t lockResult = sdMutexTake(pdMS_TO_TICKS(5000));
 
         if (lockResult != pdTRUE) {
-            Serial.println("[API/status] Failed to acquire lock (timeout)");
+            LOGE("API/status", "Failed to acquire lock (timeout)");
             request->send(503, "text/plain", "SD card busy");
             return;
         }
 
-        Serial.println("[API/status] ✓ Lock acquired");
+        LOGD("API/status", "✓ Lock acquired");
 
         // Build response with SD operations
         JsonDocument doc;
@@ -576,8 +736,8 @@ void WebServerManager::setupLegacyRoutes() {
         doc["sdCardPresent"] = sdPresent;
 
         // EXPLICIT unlock
-        BaseType_t unlockResult = xSemaphoreGive(g_sdCardMutex);
-        Serial.printf("[API/status] ✓ Unlocked (result=%d)\n", unlockResult);
+        sdMutexGive();
+        LOGD("API/status", "✓ Unlocked");
 
         String response;
         serializeJson(doc, response);
@@ -587,59 +747,689 @@ void WebServerManager::setupLegacyRoutes() {
     // POST /api/save - Save configuration
     server->on("/api/save", HTTP_POST,
         [](AsyncWebServerRequest *request) {
+            HEAP_SCOPE(HEAP_WEB, "POST /api/save");
             request->send(200, "application/json", "{\"success\":true}");
         },
         NULL,
         [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
             // Handle body data
             if (index == 0) {
-                Serial.printf("Receiving config data, total: %d\n", total);
+                LOGD("WEB", "Receiving config data, total: %d", total);
             }
 
             if (index + len == total) {
-                Serial.println("Config data received completely");
+                LOGI("WEB", "Config data received completely");
                 // Parse and save configuration here
             }
         }
     );
 
-    // GET /api/sensor-mappings - Get sensor mappings
+    // GET /api/sensor-mappings - Export sensor mappings (plus UIDs found on the buses)
     server->on("/api/sensor-mappings", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/sensor-mappings");
         JsonDocument doc;
-        JsonArray mappings = doc.createNestedArray("mappings");
-
-        JsonObject mapping1 = mappings.createNestedObject();
-        mapping1["id"] = "temp1";
-        mapping1["name"] = "Engine Temperature";
-        mapping1["unit"] = "C";
-        mapping1["min"] = 0;
-        mapping1["max"] = 150;
-
-        JsonObject mapping2 = mappings.createNestedObject();
-        mapping2["id"] = "pressure1";
-        mapping2["name"] = "Oil Pressure";
-        mapping2["unit"] = "PSI";
-        mapping2["min"] = 0;
-        mapping2["max"] = 100;
+        exportSensorMappingsJson(doc);
+
+        JsonArray discovered = doc.createNestedArray("discovered");
+        for (const String& uid : getDiscoveredUIDs()) {
+            discovered.add(uid);
+        }
 
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response);
     });
 
-    // POST /api/sensor-mappings - Update sensor mappings
+    // POST /api/sensor-mappings - Import sensor mappings (replaces all, same format as GET)
     server->on("/api/sensor-mappings", HTTP_POST,
         [](AsyncWebServerRequest *request) {
+            HEAP_SCOPE(HEAP_WEB, "POST /api/sensor-mappings");
+            if (request->_tempObject == nullptr) {
+                request->send(400, "application/json", "{\"error\":\"Missing or too large body\"}");
+                return;
+            }
+
+            const char* error = importSensorMappingsJson((const char*)request->_tempObject);
+            if (error != nullptr) {
+                JsonDocument doc;
+                doc["error"] = error;
+                String response;
+                serializeJson(doc, response);
+                request->send(400, "application/json", response);
+                return;
+            }
+
+            LOGI("API/sensor-mappings", "Imported %d mapping(s)", getSensorCount());
             request->send(200, "application/json", "{\"success\":true}");
         },
         NULL,
         [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            // Collect the body; the server frees _tempObject with the request
+            if (index == 0 && total <= 8192) {
+                request->_tempObject = malloc(total + 1);
+            }
+            if (request->_tempObject == nullptr) return;
+
+            char* body = (char*)request->_tempObject;
+            memcpy(body + index, data, len);
             if (index + len == total) {
-                Serial.println("Sensor mappings updated");
-                // Parse and save sensor mappings here
+                body[total] = '\0';
             }
         }
     );
+
+    // GET /api/sensors/events?since=N - Sensors added/removed after event N, plus bus scan timing
+    server->on("/api/sensors/events", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/sensors/events");
+        uint32_t since = 0;
+        if (request->hasParam("since")) {
+            since = request->getParam("since")->value().toInt();
+        }
+
+        SensorEvent events[16];
+        uint8_t count = getSensorEvents(since, events, 16);
+
+        JsonDocument doc;
+        JsonArray list = doc.createNestedArray("events");
+        for (uint8_t i = 0; i < count; i++) {
+            JsonObject event = list.createNestedObject();
+            event["seq"] = events[i].seq;
+            event["time"] = events[i].timeMs;
+            event["type"] = events[i].type == SENSOR_EVENT_ADDED ? "added" : "removed";
+            event["uid"] = uidToString(events[i].uid);
+            event["bus"] = events[i].bus;
+            event["mapped"] = events[i].mapped;
+        }
+
+        const BusScanStats& stats = getBusScanStats();
+        JsonObject scan = doc.createNestedObject("scan");
+        scan["scans"] = stats.scans;
+        scan["errors"] = stats.errors;
+        scan["present"] = stats.present;
+        scan["steps"] = stats.scanSteps;
+        scan["ticks"] = stats.scanTicks;
+        scan["scanMs"] = stats.scanMs;
+        scan["maxStepUs"] = stats.maxStepUs;
+        scan["maxSliceUs"] = stats.maxSliceUs;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/psu - Latest PSU block (mean/min/max/ripple) and alert counters
+    server->on("/api/psu", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/psu");
+        PsuBlock block = psuLastBlock();
+        PsuStats stats = getPsuStats();
+
+        JsonDocument doc;
+        JsonObject last = doc.createNestedObject("block");
+        last["seq"] = block.seq;
+        last["time"] = block.timeMs;
+        last["samples"] = block.samples;
+        last["mean"] = block.meanMv / 1000.0;
+        last["min"] = block.minMv / 1000.0;
+        last["max"] = block.maxMv / 1000.0;
+        last["ripple"] = block.rippleMv / 1000.0;
+
+        doc["rateHz"] = PSU_SAMPLE_RATE_HZ;
+        doc["blocks"] = stats.blocks;
+        doc["samples"] = stats.samples;
+        doc["min"] = stats.minMv / 1000.0;
+        doc["max"] = stats.maxMv / 1000.0;
+        doc["maxRipple"] = stats.maxRippleMv / 1000.0;
+        doc["lowAlerts"] = stats.lowAlerts;
+        doc["highAlerts"] = stats.highAlerts;
+        doc["readErrors"] = stats.readErrors;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/fan - Controller state, measured RPM and tachometer health
+    server->on("/api/fan", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/fan");
+        TachStats tach = getTachStats();
+        FanControlStatus control = getFanControlStatus();
+        static const char* const states[] = {"run", "kick", "fault"};
+
+        JsonDocument doc;
+        doc["speed"] = fanSpeed;
+        doc["mode"] = control.mode == FAN_MODE_PID ? "pid" : "curve";
+        doc["state"] = states[control.state];
+        doc["demand"] = control.demand;
+        doc["duty"] = control.duty;
+        doc["targetRpm"] = control.targetRpm;
+        doc["trim"] = control.trim;
+        doc["kicks"] = control.kicks;
+        doc["faults"] = control.faults;
+        doc["noTemp"] = control.noTemp;
+        doc["rpm"] = tach.rpm;
+        doc["periodUs"] = tach.periodUs;
+        doc["stalled"] = tach.stalled;
+        doc["revolutions"] = tach.revolutions;
+        doc["glitches"] = tach.glitches;
+        doc["stalls"] = tach.stalls;
+        doc["lostPeriods"] = tach.lostPeriods;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/log - SD telemetry log state, write amplification and flush latency
+    server->on("/api/log", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/log");
+        TelemetryLogStats stats = getTelemetryLogStats();
+
+        JsonDocument doc;
+        doc["enabled"] = cfg.enable_logging;
+        doc["running"] = stats.running;
+        doc["segment"] = stats.segment;
+        doc["segmentBlocks"] = stats.segmentBlocks;
+        doc["temps"] = stats.temps;
+        doc["records"] = stats.records;
+        doc["droppedRecords"] = stats.droppedRecords;
+        doc["blocks"] = stats.blocks;
+        doc["partialBlocks"] = stats.partialBlocks;
+        doc["writeErrors"] = stats.writeErrors;
+        doc["payloadBytes"] = stats.payloadBytes;
+        doc["writtenBytes"] = stats.writtenBytes;
+        doc["writeAmplification"] = stats.payloadBytes ? (float)stats.writtenBytes / stats.payloadBytes : 0;
+        doc["flushAvgUs"] = stats.flushAvgUs;
+        doc["flushMaxUs"] = stats.flushMaxUs;
+        doc["lockWaitMaxUs"] = stats.lockWaitMaxUs;
+        doc["recoveredBlocks"] = stats.recoveredBlocks;
+        doc["tornBlocks"] = stats.tornBlocks;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // POST /api/log?enable=0|1 - Switch telemetry logging (saved to NVS)
+    server->on("/api/log", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/log");
+        if (!request->hasParam("enable")) {
+            request->send(400, "application/json", "{\"error\":\"Missing enable parameter\"}");
+            return;
+        }
+        cfg.enable_logging = request->getParam("enable")->value().toInt() != 0;
+        saveConfig();
+        request->send(200, "application/json",
+                      cfg.enable_logging ? "{\"enabled\":true}" : "{\"enabled\":false}");
+    });
+
+    // GET /api/logs?since=N - Log lines from the RAM ring, N = "next" of the previous call
+    server->on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/logs");
+        uint32_t next = logNextLine();
+        uint32_t cursor = next > LOG_RING_LINES ? next - LOG_RING_LINES : 0;
+        if (request->hasParam("since")) {
+            cursor = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+        }
+        LogStats stats = getLogStats();
+
+        JsonDocument doc;
+        JsonArray lines = doc["lines"].to<JsonArray>();
+        uint32_t lost = 0;
+        LogLine batch[8];
+        size_t count;
+        do {
+            count = logRead(cursor, batch, 8, lost);
+            for (size_t i = 0; i < count; i++) {
+                JsonObject line = lines.add<JsonObject>();
+                line["n"] = batch[i].seq;
+                line["t"] = batch[i].ms;
+                line["level"] = logLevelName(batch[i].level);
+                line["tag"] = batch[i].tag;
+                line["msg"] = batch[i].text;
+            }
+        } while (count == 8);
+        doc["next"] = cursor;
+        doc["lost"] = lost;
+        doc["logged"] = stats.lines;
+        doc["dropped"] = stats.dropped;
+        doc["truncated"] = stats.truncated;
+        doc["level"] = logLevelName(LOG_LEVEL);
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/perf - loop() stage latency (utils/perf.h)
+    server->on("/api/perf", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/perf");
+        PerfSummary summary = getPerfSummary();
+        PerfWorst worst = getPerfWorst();
+
+        JsonDocument doc;
+        doc["iterations"] = summary.iterations;
+        doc["seconds"] = (millis() - summary.sinceMs) / 1000;
+        doc["cpuMhz"] = summary.cpuMhz;
+        doc["overheadPct"] = summary.overheadPct;
+        doc["markCycles"] = summary.markCycles;
+        doc["iterationCycles"] = summary.iterationCycles;
+        doc["hud"] = perfHudEnabled();
+
+        JsonObject stages = doc["stages"].to<JsonObject>();
+        for (int i = 0; i < PERF_STAGES; i++) {
+            PerfStageStats stats = getPerfStageStats((PerfStage)i);
+            JsonObject stage = stages[perfStageName((PerfStage)i)].to<JsonObject>();
+            stage["count"] = stats.count;
+            stage["minUs"] = stats.minUs;
+            stage["p50Us"] = stats.p50Us;
+            stage["p99Us"] = stats.p99Us;
+            stage["maxUs"] = stats.maxUs;
+            stage["avgUs"] = stats.avgUs;
+            stage["sharePct"] = stats.sharePct;
+        }
+
+        JsonObject worstObj = doc["worst"].to<JsonObject>();
+        worstObj["us"] = worst.us;
+        worstObj["agoMs"] = worst.atMs ? millis() - worst.atMs : 0;
+        worstObj["pollsSampled"] = worst.pollsSampled;
+        JsonObject worstStages = worstObj["stages"].to<JsonObject>();
+        for (int i = 0; i < PERF_LOOP; i++) {
+            if (worst.stageUs[i] > 0) worstStages[perfStageName((PerfStage)i)] = worst.stageUs[i];
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // POST /api/perf?reset=1&hud=0|1 - Clear the statistics, show or hide the on-screen HUD
+    server->on("/api/perf", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/perf");
+        if (request->hasParam("reset") && request->getParam("reset")->value().toInt() != 0) {
+            perfRequestReset();
+        }
+        if (request->hasParam("hud")) {
+            perfSetHud(request->getParam("hud")->value().toInt() != 0);
+        }
+        request->send(200, "application/json", perfHudEnabled() ? "{\"hud\":true}" : "{\"hud\":false}");
+    });
+
+    // GET /api/stalls - Loop stalls, kept across watchdog resets (utils/stall_monitor.h)
+    server->on("/api/stalls", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/stalls");
+        StallState state = getStallState();
+
+        JsonDocument doc;
+        doc["boot"] = state.boot;
+        doc["resetReason"] = state.resetReason;
+        if (state.resetStageValid) doc["resetStage"] = stallStageName(state.resetStage);
+        doc["thresholdMs"] = STALL_THRESHOLD_MS;
+        doc["stage"] = stallStageName(state.stage);
+        doc["stageMs"] = state.stageMs;
+        JsonObject lock = doc["sdMutex"].to<JsonObject>();
+        lock["owner"] = state.lockOwner[0] ? state.lockOwner : nullptr;
+        lock["heldMs"] = state.lockHeldMs;
+        doc["recorded"] = state.stalls;
+
+        StallRecord records[STALL_RECORDS];
+        size_t count = getStallRecords(records, STALL_RECORDS);
+        JsonArray stalls = doc["stalls"].to<JsonArray>();
+        for (size_t i = 0; i < count; i++) {
+            const StallRecord& record = records[i];
+            JsonObject stall = stalls.add<JsonObject>();
+            stall["boot"] = record.boot;
+            stall["atMs"] = record.atMs;
+            stall["ms"] = record.durationMs;
+            stall["stage"] = stallStageName(record.stage);
+            if (record.flags & STALL_OPEN) stall["open"] = true;
+            if (record.flags & STALL_RESET) stall["reset"] = true;
+            if (record.lockOwner[0]) {
+                stall["lockOwner"] = record.lockOwner;
+                stall["lockHeldMs"] = record.lockHeldMs;
+            }
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // POST /api/stalls?clear=1 - Forget the recorded stalls
+    server->on("/api/stalls", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/stalls");
+        if (request->hasParam("clear") && request->getParam("clear")->value().toInt() != 0) {
+            stallClear();
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // GET /api/heap - Free heap, largest block and their history (utils/heap_telemetry.h)
+    server->on("/api/heap", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/heap");
+        HeapStats stats = getHeapStats();
+
+        JsonDocument doc;
+        doc["free"] = stats.freeBytes;
+        doc["largest"] = stats.largestBlock;
+        doc["minFree"] = stats.minFreeBytes;
+        doc["minLargest"] = stats.minLargestBlock;
+        doc["size"] = stats.heapSize;
+        doc["fragmentationPct"] = stats.fragmentationPct;
+
+        // [free, largest] every sampleSeconds, oldest first
+        static HeapSample samples[HEAP_HISTORY_SAMPLES];  // Too big for the async_tcp stack
+        uint32_t sampleAgeMs;
+        size_t count = getHeapSamples(samples, HEAP_HISTORY_SAMPLES, sampleAgeMs);
+        doc["sampleSeconds"] = HEAP_SAMPLE_MS / 1000;
+        doc["lastSampleAgoMs"] = sampleAgeMs;
+        JsonArray history = doc["samples"].to<JsonArray>();
+        for (size_t i = 0; i < count; i++) {
+            JsonArray sample = history.add<JsonArray>();
+            sample.add(samples[i].freeBytes);
+            sample.add(samples[i].largestBlock);
+        }
+
+#if HEAP_TAGGING
+        doc["tagging"] = true;
+        uint32_t subsystemAllocs[HEAP_SUBSYSTEMS] = {};
+        int32_t subsystemNet[HEAP_SUBSYSTEMS] = {};
+        JsonArray sites = doc["sites"].to<JsonArray>();
+        JsonArray steady = doc["steady"].to<JsonArray>();
+        for (HeapSite* site = heapFirstSite(); site; site = site->next) {
+            JsonObject entry = sites.add<JsonObject>();
+            entry["name"] = site->name;
+            entry["subsystem"] = heapSubsystemName(site->subsystem);
+            entry["allocs"] = site->allocs;
+            entry["frees"] = site->frees;
+            entry["allocBytes"] = site->allocBytes;
+            entry["netBytes"] = (int32_t)(site->allocBytes - site->freeBytes);
+            entry["steadyAllocs"] = site->steadyAllocs;
+            entry["steadyBytes"] = site->steadyBytes;
+            if (site->steadyAllocs > 0) {
+                entry["lastSteadyAgoMs"] = millis() - site->lastSteadyMs;
+                steady.add(site->name);
+            }
+            subsystemAllocs[site->subsystem] += site->allocs;
+            subsystemNet[site->subsystem] += (int32_t)(site->allocBytes - site->freeBytes);
+        }
+        JsonObject subsystems = doc["subsystems"].to<JsonObject>();
+        for (int i = 0; i < HEAP_SUBSYSTEMS; i++) {
+            JsonObject subsystem = subsystems[heapSubsystemName((HeapSubsystem)i)].to<JsonObject>();
+            subsystem["allocs"] = subsystemAllocs[i];
+            subsystem["netBytes"] = subsystemNet[i];
+        }
+#else
+        doc["tagging"] = false;
+#endif
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+#if HEAP_TAGGING
+    // POST /api/heap?reset=1 - Clear the per-site allocation counters
+    server->on("/api/heap", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/heap");
+        if (request->hasParam("reset") && request->getParam("reset")->value().toInt() != 0) {
+            heapSitesReset();
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+#endif
+
+#if EVENT_TRACE
+    // GET /api/event-trace - The event ring as Chrome trace JSON
+    // (chrome://tracing, ui.perfetto.dev); recording pauses while it is sent
+    server->on("/api/event-trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/event-trace");
+        EventTraceDump* dump = eventTraceDumpOpen();
+        if (dump == nullptr) {
+            request->send(503, "application/json", "{\"error\":\"Trace dump in progress\"}");
+            return;
+        }
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [dump](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return eventTraceDumpRead(dump, buffer, maxLen);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"fluiddash_trace.json\"");
+        request->onDisconnect([dump]() {
+            eventTraceDumpClose(dump);
+        });
+        request->send(response);
+    });
+
+    // POST /api/event-trace?run=0|1&clear=1 - Pause / resume recording, drop recorded events
+    server->on("/api/event-trace", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/event-trace");
+        if (request->hasParam("clear") && request->getParam("clear")->value().toInt() != 0) {
+            eventTraceClear();
+        }
+        if (request->hasParam("run")) {
+            eventTraceSetRecording(request->getParam("run")->value().toInt() != 0);
+        }
+        EventTraceStats stats = getEventTraceStats();
+        JsonDocument doc;
+        doc["recording"] = stats.recording;
+        doc["events"] = stats.events;
+        doc["tasks"] = stats.tasks;
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+#endif
+
+    // GET /api/trace - Motion trace state and the trace files on the card
+    server->on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/trace");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/trace");
+        MotionTraceStats stats = getMotionTraceStats();
+
+        JsonDocument doc;
+        doc["enabled"] = cfg.enable_trace;
+        doc["running"] = stats.running;
+        doc["file"] = stats.file;
+        doc["fileBlocks"] = stats.fileBlocks;
+        doc["reports"] = stats.reports;
+        doc["droppedReports"] = stats.droppedReports;
+        doc["blocks"] = stats.blocks;
+        doc["encodedBytes"] = stats.encodedBytes;
+        doc["bytesPerReport"] = stats.reports ? (float)stats.encodedBytes / stats.reports : 0;
+        doc["writeErrors"] = stats.writeErrors;
+        doc["flushMaxUs"] = stats.flushMaxUs;
+
+        JsonArray files = doc["files"].to<JsonArray>();
+        if (stats.running && sdMutexTake(pdMS_TO_TICKS(1000)) == pdTRUE) {
+            File dir = SD.open(TELEMETRY_DIR);
+            if (dir) {
+                for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+                    unsigned number;
+                    const char* name = strrchr(entry.name(), '/');
+                    name = name ? name + 1 : entry.name();
+                    if (sscanf(name, "trc_%u.bin", &number) == 1) {
+                        JsonObject file = files.add<JsonObject>();
+                        file["n"] = number;
+                        file["size"] = entry.size();
+                    }
+                    entry.close();
+                }
+                dir.close();
+            }
+            sdMutexGive();
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // POST /api/trace?enable=0|1 - Switch the motion trace (saved to NVS)
+    server->on("/api/trace", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/trace");
+        if (!request->hasParam("enable")) {
+            request->send(400, "application/json", "{\"error\":\"Missing enable parameter\"}");
+            return;
+        }
+        cfg.enable_trace = request->getParam("enable")->value().toInt() != 0;
+        saveConfig();
+        request->send(200, "application/json",
+                      cfg.enable_trace ? "{\"enabled\":true}" : "{\"enabled\":false}");
+    });
+
+    // GET /api/trace-file?n=N - Stream a trace file (any size; the SD mutex
+    // is taken per chunk)
+    server->on("/api/trace-file", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/trace-file");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/trace-file");
+        if (!request->hasParam("n")) {
+            request->send(400, "application/json", "{\"error\":\"Missing n parameter\"}");
+            return;
+        }
+        char path[32];
+        motionTraceFilePath(path, sizeof(path), request->getParam("n")->value().toInt());
+
+        if (g_sdCardMutex == NULL || sdMutexTake(pdMS_TO_TICKS(5000)) != pdTRUE) {
+            request->send(503, "text/plain", "SD card busy");
+            return;
+        }
+        File* file = SD.exists(path) ? new (std::nothrow) File(SD.open(path, FILE_READ)) : nullptr;
+        sdMutexGive();
+        if (file == nullptr || !*file) {
+            delete file;
+            request->send(404, "application/json", "{\"error\":\"File not found\"}");
+            return;
+        }
+
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/octet-stream",
+            [file](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                EVT_SCOPE("trace-file chunk");
+                if (sdMutexTake(pdMS_TO_TICKS(100)) != pdTRUE) return RESPONSE_TRY_AGAIN;
+                size_t read = file->read(buffer, maxLen);
+                sdMutexGive();
+                return read;
+            });
+        request->onDisconnect([file]() {
+            sdMutexClose(*file, pdMS_TO_TICKS(5000));
+            delete file;
+        });
+        request->send(response);
+    });
+
+    // GET /api/history?from=&to=&points=&sensors=0,1&format=json|csv&source=auto|ram|sd
+    // Temperature history downsampled with LTTB, streamed in chunks
+    server->on("/api/history", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EVT_SCOPE("GET /api/history");
+        HEAP_SCOPE(HEAP_WEB, "GET /api/history");
+        uint32_t to = request->hasParam("to")
+            ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : telemetryClockNow();
+        uint32_t from = request->hasParam("from")
+            ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) : (to > 3600 ? to - 3600 : 0);
+        uint16_t points = 500;
+        if (request->hasParam("points")) {
+            points = constrain(request->getParam("points")->value().toInt(), 1L, (long)HISTORY_STREAM_MAX_POINTS);
+        }
+
+        // Every listed sensor is answered or the request fails: more than
+        // HISTORY_STREAM_MAX_SENSORS, or an entry that is not a number, is a 400
+        uint8_t sensors[HISTORY_STREAM_MAX_SENSORS];
+        uint8_t sensorCount = 0;
+        if (request->hasParam("sensors")) {
+            const char* p = request->getParam("sensors")->value().c_str();
+            bool valid = true;
+            while (valid) {
+                char* end;
+                unsigned long sensor = strtoul(p, &end, 10);
+                valid = isdigit((unsigned char)*p) && end != p && (*end == ',' || *end == '\0') &&
+                        sensor <= UINT8_MAX && sensorCount < HISTORY_STREAM_MAX_SENSORS;
+                if (!valid) break;
+                sensors[sensorCount++] = sensor;
+                if (*end == '\0') break;
+                p = end + 1;
+            }
+            if (!valid) {
+                request->send(400, "application/json",
+                              String("{\"error\":\"") + historyStreamErrorText(HISTORY_ERROR_BAD_ARGS) + "\"}");
+                return;
+            }
+        } else {
+            while (sensorCount < min(temperatureCount, (uint8_t)HISTORY_STREAM_MAX_SENSORS)) {
+                sensors[sensorCount] = sensorCount;
+                sensorCount++;
+            }
+        }
+
+        HistoryFormat format = HISTORY_FORMAT_JSON;
+        if (request->hasParam("format") && request->getParam("format")->value() == "csv") {
+            format = HISTORY_FORMAT_CSV;
+        }
+        HistorySource source = HISTORY_SOURCE_AUTO;
+        if (request->hasParam("source")) {
+            String value = request->getParam("source")->value();
+            if (value == "ram") source = HISTORY_SOURCE_RAM;
+            else if (value == "sd") source = HISTORY_SOURCE_SD;
+        }
+
+        HistoryStreamError error;
+        HistoryStream* stream = historyStreamOpen(from, to, points, sensors, sensorCount, source, format, error);
+        if (stream == nullptr) {
+            bool busy = error == HISTORY_ERROR_TOO_MANY || error == HISTORY_ERROR_NO_MEMORY;
+            request->send(busy ? 503 : 400, "application/json",
+                          String("{\"error\":\"") + historyStreamErrorText(error) + "\"}");
+            return;
+        }
+
+        AsyncWebServerResponse *response = request->beginChunkedResponse(
+            format == HISTORY_FORMAT_CSV ? "text/csv" : "application/json",
+            [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                EVT_SCOPE("history chunk");
+                return historyStreamRead(stream, buffer, maxLen);
+            });
+        request->onDisconnect([stream]() {
+            historyStreamClose(stream);
+        });
+        request->send(response);
+    });
+
+    // POST /api/sensors/identify?timeout=ms&threshold=C - Start a touch identification session
+    server->on("/api/sensors/identify", HTTP_POST, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "POST /api/sensors/identify");
+        uint32_t timeoutMs = 30000;
+        float threshold = 1.0;
+        if (request->hasParam("timeout")) {
+            timeoutMs = request->getParam("timeout")->value().toInt();
+        }
+        if (request->hasParam("threshold")) {
+            threshold = request->getParam("threshold")->value().toFloat();
+        }
+
+        bool started = startSensorIdentification(timeoutMs, threshold);
+
+        JsonDocument doc;
+        exportSensorIdentificationJson(doc);
+        if (!started) {
+            doc["error"] = threshold > 0 ? "Identification already running" : "Invalid threshold";
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(started ? 202 : (threshold > 0 ? 409 : 400), "application/json", response);
+    });
+
+    // GET /api/sensors/identify - Session state, leading sensor and (once detected) confidence
+    server->on("/api/sensors/identify", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "GET /api/sensors/identify");
+        JsonDocument doc;
+        exportSensorIdentificationJson(doc);
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // DELETE /api/sensors/identify - Cancel the running session
+    server->on("/api/sensors/identify", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+        HEAP_SCOPE(HEAP_WEB, "DELETE /api/sensors/identify");
+        cancelSensorIdentification();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
 }
 
 // Check if web server is connected/running
@@ -0,0 +1,214 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// ========== Host Arduino Core ==========
+// Just enough of the ESP32 Arduino core for the host tests (pio test -e
+// native) to compile firmware modules unchanged. Nothing here touches
+// hardware: millis() and micros() read a clock the test moves with
+// nativeAdvanceUs(), and pins read back what the test wrote.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+#define F(text) (text)
+
+#define LOW             0
+#define HIGH            1
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+#define ADC_11db        3
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// ========== Clock ==========
+
+inline uint64_t nativeClockUs = 0;
+
+inline unsigned long millis() { return (unsigned long)(nativeClockUs / 1000); }
+inline unsigned long micros() { return (unsigned long)nativeClockUs; }
+inline void nativeAdvanceUs(uint64_t us) { nativeClockUs += us; }
+inline void nativeAdvanceMs(uint64_t ms) { nativeClockUs += ms * 1000; }
+inline void delay(unsigned long ms) { nativeAdvanceMs(ms); }
+inline void delayMicroseconds(uint32_t us) { nativeAdvanceUs(us); }
+inline void yield() {}
+
+// ========== Pins ==========
+
+inline uint8_t nativePinLevel[40];
+inline uint32_t nativePwmDuty[16];
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { if (pin < 40) nativePinLevel[pin] = level; }
+inline int digitalRead(uint8_t pin) { return pin < 40 ? nativePinLevel[pin] : LOW; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t, void (*)(), int) {}
+inline void detachInterrupt(uint8_t) {}
+inline uint16_t analogRead(uint8_t) { return 0; }
+inline uint32_t analogReadMilliVolts(uint8_t) { return 0; }
+inline void analogSetWidth(uint8_t) {}
+inline void analogSetAttenuation(int) {}
+inline double ledcSetup(uint8_t, double frequency, uint8_t) { return frequency; }
+inline void ledcAttachPin(uint8_t, uint8_t) {}
+inline void ledcWrite(uint8_t channel, uint32_t duty) { if (channel < 16) nativePwmDuty[channel] = duty; }
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < (T)low ? (T)low : (value > (T)high ? (T)high : value);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+// ========== String ==========
+
+class String {
+public:
+    String() {}
+    String(const char* text) : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    String(char c) : s(1, c) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+    String(float value, unsigned int decimals = 2) { format(value, decimals); }
+    String(double value, unsigned int decimals = 2) { format(value, decimals); }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    void reserve(unsigned int size) { s.reserve(size); }
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { s += other ? other : ""; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int value) { s += std::to_string(value); return *this; }
+    String& operator+=(unsigned int value) { s += std::to_string(value); return *this; }
+    String& operator+=(long value) { s += std::to_string(value); return *this; }
+    String& operator+=(unsigned long value) { s += std::to_string(value); return *this; }
+    bool concat(const char* other) { *this += other; return true; }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool equals(const char* other) const { return *this == other; }
+    bool equalsIgnoreCase(const String& other) const {
+        return s.size() == other.s.size() &&
+               std::equal(s.begin(), s.end(), other.s.begin(),
+                          [](char a, char b) { return tolower(a) == tolower(b); });
+    }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.size() >= suffix.s.size() &&
+               s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return found(s.find(text.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s.size() ? String(s.substr(from, to - from)) : String();
+    }
+
+    void trim() {
+        size_t start = s.find_first_not_of(" \t\r\n");
+        size_t end = s.find_last_not_of(" \t\r\n");
+        s = start == std::string::npos ? std::string() : s.substr(start, end - start + 1);
+    }
+    void toLowerCase() { for (char& c : s) c = tolower(c); }
+    void toUpperCase() { for (char& c : s) c = toupper(c); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        for (size_t pos = s.find(from.s); pos != std::string::npos; pos = s.find(from.s, pos + to.s.size())) {
+            s.replace(pos, from.s.size(), to.s);
+        }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+private:
+    std::string s;
+
+    void format(double value, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+        s = buf;
+    }
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+};
+
+inline String operator+(const String& a, const String& b) { String r = a; r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r = a; r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r = a; r += b; return r; }
+inline String operator+(const String& a, char b) { String r = a; r += b; return r; }
+
+// ========== Serial ==========
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    void flush() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(const uint8_t*, size_t len) { return len; }
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) { (void)format; return 0; }
+    size_t print(const char* text) { return strlen(text); }
+    size_t print(const String& text) { return text.length(); }
+    size_t println(const char* text = "") { return strlen(text) + 1; }
+    size_t println(const String& text) { return text.length() + 1; }
+};
+
+inline HardwareSerial Serial;
+
+// ========== ESP ==========
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getHeapSize() { return 300000; }
+    uint32_t getCycleCount() { return (uint32_t)(nativeClockUs * 240); }
+    uint32_t getCpuFreqMHz() { return 240; }
+    void restart() {}
+};
+
+inline EspClass ESP;
+
+#endif // NATIVE_ARDUINO_H
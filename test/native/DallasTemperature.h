@@ -0,0 +1,67 @@
+#ifndef NATIVE_DALLAS_TEMPERATURE_H
+#define NATIVE_DALLAS_TEMPERATURE_H
+
+// ========== Host DallasTemperature ==========
+// The calls initDS18B20Sensors() and the acquisition make, on top of the
+// simulated bus in OneWire.h
+
+#include "OneWire.h"
+
+class DallasTemperature {
+public:
+    explicit DallasTemperature(OneWire* wire) : wire(wire) {}
+
+    void begin() {}
+
+    uint8_t getDeviceCount() {
+        uint8_t count = 0;
+        for (const NativeDS18B20& device : devices()) count += device.present ? 1 : 0;
+        return count;
+    }
+
+    bool getAddress(uint8_t* addr, uint8_t index) {
+        for (const NativeDS18B20& device : devices()) {
+            if (!device.present) continue;
+            if (index-- == 0) {
+                memcpy(addr, device.rom, 8);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Every present device, through its scratchpad (TH/TL kept)
+    void setResolution(uint8_t resolution) {
+        for (const NativeDS18B20& device : devices()) {
+            if (!device.present) continue;
+            wire->reset();
+            wire->select(device.rom);
+            wire->write(0x4E);
+            wire->write(device.scratchpad[2]);
+            wire->write(device.scratchpad[3]);
+            wire->write(((constrain(resolution, 9, 12) - 9) << 5) | 0x1F);
+        }
+    }
+
+    void setWaitForConversion(bool) {}
+
+    bool isParasitePowerMode() {
+        for (const NativeDS18B20& device : devices()) {
+            if (device.present && device.parasite) return true;
+        }
+        return false;
+    }
+
+    void requestTemperatures() {
+        if (!wire->reset()) return;
+        wire->skip();
+        wire->write(0x44);
+    }
+
+private:
+    OneWire* wire;
+
+    std::vector<NativeDS18B20>& devices() { return nativeOneWireBus[wire->nativePin()]; }
+};
+
+#endif // NATIVE_DALLAS_TEMPERATURE_H
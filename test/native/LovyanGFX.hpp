@@ -0,0 +1,33 @@
+#ifndef NATIVE_LOVYANGFX_HPP
+#define NATIVE_LOVYANGFX_HPP
+
+#include <Arduino.h>
+
+// Panel types display.h names, and the drawing calls the firmware makes
+// outside display.cpp. Nothing is drawn.
+namespace lgfx {
+
+class Panel_ST7796 {};
+class Bus_SPI {};
+class Light_PWM {};
+
+class LGFX_Device {
+public:
+    void fillScreen(uint16_t) {}
+    void fillRect(int32_t, int32_t, int32_t, int32_t, uint16_t) {}
+    void drawRect(int32_t, int32_t, int32_t, int32_t, uint16_t) {}
+    void drawFastHLine(int32_t, int32_t, int32_t, uint16_t) {}
+    void drawFastVLine(int32_t, int32_t, int32_t, uint16_t) {}
+    void drawLine(int32_t, int32_t, int32_t, int32_t, uint16_t) {}
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setTextSize(float) {}
+    void setCursor(int32_t, int32_t) {}
+    size_t print(const char* text) { return strlen(text); }
+    size_t printf(const char* format, ...) { (void)format; return 0; }
+    int32_t textWidth(const char* text) { return 6 * strlen(text); }
+};
+
+} // namespace lgfx
+
+#endif // NATIVE_LOVYANGFX_HPP
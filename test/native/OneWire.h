@@ -0,0 +1,228 @@
+#ifndef NATIVE_ONEWIRE_H
+#define NATIVE_ONEWIRE_H
+
+// ========== Host OneWire Bus ==========
+// A simulated bus of DS18B20s per GPIO, driven at the protocol level: the
+// firmware's resets, ROM commands, scratchpad reads and writes and ROM
+// search bits reach the devices in nativeOneWireBus[pin]. Every
+// transaction advances the native clock by its bus time (reset 960 us,
+// 70 us per bit), so micros()-sliced code sees realistic costs.
+
+#include "Arduino.h"
+#include <vector>
+
+#define NATIVE_OW_RESET_US  960
+#define NATIVE_OW_BIT_US    70
+
+struct NativeDS18B20 {
+    uint8_t rom[8];
+    float tempC;                // What the next conversion measures
+    uint8_t scratchpad[9];
+    bool present;
+    bool badCrc;                // Scratchpad reads come back corrupted
+    bool parasite;              // Powered from the data line
+    uint16_t conversions;
+};
+
+inline std::vector<NativeDS18B20> nativeOneWireBus[40];
+
+class OneWire {
+public:
+    explicit OneWire(uint8_t pin) : pin(pin) {}
+
+    uint8_t nativePin() const { return pin; }
+
+    uint8_t reset() {
+        nativeAdvanceUs(NATIVE_OW_RESET_US);
+        phase = PHASE_ROM;
+        selected = -1;
+        for (const NativeDS18B20& device : devices()) {
+            if (device.present) return 1;
+        }
+        phase = PHASE_IDLE;
+        return 0;
+    }
+
+    void select(const uint8_t rom[8]) {
+        nativeAdvanceUs(9 * 8 * NATIVE_OW_BIT_US);
+        selected = -1;
+        if (phase != PHASE_ROM) return;
+        for (size_t i = 0; i < devices().size(); i++) {
+            if (devices()[i].present && memcmp(devices()[i].rom, rom, 8) == 0) selected = i;
+        }
+        phase = selected >= 0 ? PHASE_FUNCTION : PHASE_IDLE;
+    }
+
+    void skip() { write(0xCC); }
+
+    void write(uint8_t value, uint8_t power = 0) {
+        (void)power;
+        nativeAdvanceUs(8 * NATIVE_OW_BIT_US);
+        switch (phase) {
+            case PHASE_ROM:
+                if (value == 0xCC) {
+                    selected = NATIVE_OW_ALL;
+                    phase = PHASE_FUNCTION;
+                } else if (value == 0xF0) {
+                    beginSearch();
+                } else {
+                    phase = PHASE_IDLE;
+                }
+                break;
+
+            case PHASE_FUNCTION:
+                function(value);
+                break;
+
+            case PHASE_WRITE:
+                if (selected >= 0) {
+                    NativeDS18B20& device = devices()[selected];
+                    device.scratchpad[2 + writeCount] = writeCount == 2 ? (value | 0x1F) : value;
+                    device.scratchpad[8] = crc8(device.scratchpad, 8);
+                }
+                if (++writeCount == 3) phase = PHASE_IDLE;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    uint8_t read() {
+        nativeAdvanceUs(8 * NATIVE_OW_BIT_US);
+        if (phase != PHASE_READ || readPos >= 9) return 0xFF;
+        return readBuffer[readPos++];
+    }
+
+    void read_bytes(uint8_t* buf, uint16_t count) {
+        for (uint16_t i = 0; i < count; i++) buf[i] = read();
+    }
+
+    // ROM search: the id bit and its complement, wired-AND over the
+    // devices still in the walk
+    uint8_t read_bit() {
+        nativeAdvanceUs(NATIVE_OW_BIT_US);
+        if (phase != PHASE_SEARCH) return 1;
+        uint8_t level = 1;
+        for (size_t i = 0; i < devices().size(); i++) {
+            if (!inSearch[i] || !devices()[i].present) continue;
+            uint8_t bit = romBit(devices()[i], searchBit);
+            if ((searchReads == 0 ? bit : !bit) == 0) level = 0;
+        }
+        searchReads++;
+        return level;
+    }
+
+    void write_bit(uint8_t value) {
+        nativeAdvanceUs(NATIVE_OW_BIT_US);
+        if (phase != PHASE_SEARCH) return;
+        for (size_t i = 0; i < devices().size(); i++) {
+            if (inSearch[i] && romBit(devices()[i], searchBit) != (value ? 1 : 0)) inSearch[i] = false;
+        }
+        searchReads = 0;
+        if (++searchBit == 64) phase = PHASE_IDLE;
+    }
+
+    void depower() {}
+
+    static uint8_t crc8(const uint8_t* addr, uint8_t len) {
+        uint8_t crc = 0;
+        while (len--) {
+            uint8_t in = *addr++;
+            for (uint8_t i = 0; i < 8; i++) {
+                uint8_t mix = (crc ^ in) & 0x01;
+                crc >>= 1;
+                if (mix) crc ^= 0x8C;
+                in >>= 1;
+            }
+        }
+        return crc;
+    }
+
+    static uint16_t crc16(const uint8_t* input, uint16_t len, uint16_t crc = 0) {
+        static const uint8_t oddparity[16] = {0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0};
+        for (uint16_t i = 0; i < len; i++) {
+            uint16_t cdata = input[i];
+            cdata = (cdata ^ crc) & 0xFF;
+            crc >>= 8;
+            if (oddparity[cdata & 0x0F] ^ oddparity[cdata >> 4]) crc ^= 0xC001;
+            cdata <<= 6;
+            crc ^= cdata;
+            cdata <<= 1;
+            crc ^= cdata;
+        }
+        return crc;
+    }
+
+private:
+    enum Phase { PHASE_IDLE, PHASE_ROM, PHASE_FUNCTION, PHASE_READ, PHASE_WRITE, PHASE_SEARCH };
+    static const int NATIVE_OW_ALL = -2;
+
+    uint8_t pin;
+    Phase phase = PHASE_IDLE;
+    int selected = -1;
+    uint8_t readBuffer[9];
+    uint8_t readPos = 0;
+    uint8_t writeCount = 0;
+    std::vector<bool> inSearch;
+    uint8_t searchBit = 0;
+    uint8_t searchReads = 0;
+
+    std::vector<NativeDS18B20>& devices() { return nativeOneWireBus[pin]; }
+
+    static uint8_t romBit(const NativeDS18B20& device, uint8_t bit) {
+        return (device.rom[bit >> 3] >> (bit & 7)) & 1;
+    }
+
+    void beginSearch() {
+        inSearch.assign(devices().size(), true);
+        searchBit = 0;
+        searchReads = 0;
+        phase = PHASE_SEARCH;
+    }
+
+    void function(uint8_t command) {
+        phase = PHASE_IDLE;
+        if (command == 0x44) {
+            for (size_t i = 0; i < devices().size(); i++) {
+                if (selected == NATIVE_OW_ALL || selected == (int)i) convert(devices()[i]);
+            }
+        } else if (command == 0xBE && selected >= 0) {
+            memcpy(readBuffer, devices()[selected].scratchpad, 9);
+            if (devices()[selected].badCrc) readBuffer[8] ^= 0xFF;
+            readPos = 0;
+            phase = PHASE_READ;
+        } else if (command == 0x4E) {
+            writeCount = 0;
+            phase = PHASE_WRITE;
+        }
+    }
+
+    // Latch tempC at the configured resolution (undefined low bits set)
+    static void convert(NativeDS18B20& device) {
+        if (!device.present) return;
+        uint8_t resolution = ((device.scratchpad[4] >> 5) & 0x03) + 9;
+        int16_t raw = (int16_t)lroundf(device.tempC * 16.0f);
+        raw |= (1 << (12 - resolution)) - 1;
+        device.scratchpad[0] = raw & 0xFF;
+        device.scratchpad[1] = (raw >> 8) & 0xFF;
+        device.scratchpad[8] = crc8(device.scratchpad, 8);
+        device.conversions++;
+    }
+};
+
+// A powered-up DS18B20 (family 0x28, scratchpad at the 85 C reset value)
+inline NativeDS18B20 nativeDS18B20(uint8_t serial, float tempC) {
+    NativeDS18B20 device = {};
+    const uint8_t rom[7] = {0x28, serial, (uint8_t)(serial * 37 + 11), 0x07, 0x16, 0x04, 0x50};
+    memcpy(device.rom, rom, 7);
+    device.rom[7] = OneWire::crc8(device.rom, 7);
+    const uint8_t scratchpad[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+    memcpy(device.scratchpad, scratchpad, 8);
+    device.scratchpad[8] = OneWire::crc8(device.scratchpad, 8);
+    device.tempC = tempC;
+    device.present = true;
+    return device;
+}
+
+#endif // NATIVE_ONEWIRE_H
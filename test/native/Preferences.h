@@ -0,0 +1,96 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+// ========== Host Preferences ==========
+// NVS in memory: namespace -> key -> bytes. Tests seed or inspect it
+// through nativeNvs and clear it between runs.
+
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nativeNvs;
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        space = name;
+        this->readOnly = readOnly;
+        open = true;
+        return true;
+    }
+    void end() { open = false; }
+
+    bool isKey(const char* key) { return find(key) != nullptr; }
+    bool remove(const char* key) {
+        if (!writable()) return false;
+        return nativeNvs[space].erase(key) > 0;
+    }
+    bool clear() {
+        if (!writable()) return false;
+        nativeNvs[space].clear();
+        return true;
+    }
+
+    size_t putBool(const char* key, bool value) { return put(key, (uint8_t)value); }
+    size_t putUChar(const char* key, uint8_t value) { return put(key, value); }
+    size_t putUShort(const char* key, uint16_t value) { return put(key, value); }
+    size_t putFloat(const char* key, float value) { return put(key, value); }
+    size_t putString(const char* key, const String& value) {
+        return putBytes(key, value.c_str(), value.length() + 1);
+    }
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        if (!writable()) return 0;
+        const uint8_t* bytes = (const uint8_t*)value;
+        nativeNvs[space][key].assign(bytes, bytes + len);
+        return len;
+    }
+
+    bool getBool(const char* key, bool defaultValue = false) { return get(key, (uint8_t)defaultValue) != 0; }
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return get(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = NAN) { return get(key, defaultValue); }
+    String getString(const char* key, const String& defaultValue = String()) {
+        const std::vector<uint8_t>* value = find(key);
+        return value != nullptr && !value->empty() ? String((const char*)value->data()) : defaultValue;
+    }
+    size_t getBytesLength(const char* key) {
+        const std::vector<uint8_t>* value = find(key);
+        return value != nullptr ? value->size() : 0;
+    }
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        const std::vector<uint8_t>* value = find(key);
+        if (value == nullptr || value->size() > maxLen) return 0;
+        memcpy(buf, value->data(), value->size());
+        return value->size();
+    }
+
+private:
+    std::string space;
+    bool readOnly = false;
+    bool open = false;
+
+    bool writable() const { return open && !readOnly; }
+
+    const std::vector<uint8_t>* find(const char* key) {
+        if (!open) return nullptr;
+        auto ns = nativeNvs.find(space);
+        if (ns == nativeNvs.end()) return nullptr;
+        auto value = ns->second.find(key);
+        return value != ns->second.end() ? &value->second : nullptr;
+    }
+
+    template <typename T>
+    size_t put(const char* key, T value) { return putBytes(key, &value, sizeof(value)); }
+
+    template <typename T>
+    T get(const char* key, T defaultValue) {
+        const std::vector<uint8_t>* value = find(key);
+        if (value == nullptr || value->size() != sizeof(T)) return defaultValue;
+        T result;
+        memcpy(&result, value->data(), sizeof(T));
+        return result;
+    }
+};
+
+#endif // NATIVE_PREFERENCES_H
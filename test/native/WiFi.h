@@ -0,0 +1,22 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+    String toString() const { return String("192.168.4.1"); }
+};
+
+// Network name SSID() reports; tests may set it
+inline std::string nativeWifiSsid = "test";
+
+class WiFiClass {
+public:
+    IPAddress localIP() { return IPAddress(); }
+    String SSID() { return String(nativeWifiSsid); }
+};
+
+inline WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
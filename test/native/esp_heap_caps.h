@@ -0,0 +1,15 @@
+#ifndef NATIVE_ESP_HEAP_CAPS_H
+#define NATIVE_ESP_HEAP_CAPS_H
+
+// ========== Host Heap Caps ==========
+// The block size behind a pointer, as the ESP-IDF heap reports it (the
+// allocator's usable size, so at least what was requested)
+
+#include <stddef.h>
+#include <malloc.h>
+
+inline size_t heap_caps_get_allocated_size(void* ptr) {
+    return malloc_usable_size(ptr);
+}
+
+#endif // NATIVE_ESP_HEAP_CAPS_H
@@ -0,0 +1,42 @@
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+// ========== Host FreeRTOS ==========
+// The host tests run on one thread: critical sections and mutexes only
+// count how often they are entered, so a test can check the pairing.
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define portMAX_DELAY           0xFFFFFFFFUL
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define configMAX_TASK_NAME_LEN 16
+#define tskNO_AFFINITY          0x7FFFFFFF
+
+struct portMUX_TYPE {
+    int depth;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+inline int nativeCriticalDepth = 0;
+
+inline void nativeEnterCritical(portMUX_TYPE* mux) { mux->depth++; nativeCriticalDepth++; }
+inline void nativeExitCritical(portMUX_TYPE* mux) { mux->depth--; nativeCriticalDepth--; }
+
+#define portENTER_CRITICAL(mux)     nativeEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)      nativeExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) nativeEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)  nativeExitCritical(mux)
+
+inline BaseType_t xPortGetCoreID() { return 1; }
+
+#endif // NATIVE_FREERTOS_H
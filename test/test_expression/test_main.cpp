@@ -0,0 +1,247 @@
+// Host tests for the computed data sources (display/expression.cpp):
+//   pio test -e native -f test_expression
+//
+// The view model is replaced by a table of fake sources, so the tests see
+// exactly which sources a program reads and when.
+
+#define LOG_FILE_LEVEL LOG_LEVEL_WARN
+
+#include <unity.h>
+#include <chrono>
+#include <stdarg.h>
+#include "display/expression.cpp"
+
+// ========== Fake Sources ==========
+
+static float sourceValue[256];
+static uint16_t sourceGeneration[256];
+static uint32_t sourceReads = 0;
+
+uint8_t lookupDataSource(const char* name) {
+    if (strcmp(name, "psuVoltage") == 0) return DS_PSU_VOLTAGE;
+    if (strcmp(name, "feedRate") == 0) return DS_FEED_RATE;
+    if (strcmp(name, "machineState") == 0) return DS_MACHINE_STATE;
+    if (strncmp(name, "temp", 4) == 0 && isdigit((unsigned char)name[4])) {
+        int channel = atoi(name + 4);
+        if (channel < 16) return DS_TEMP_BASE + channel;
+    }
+    return DS_NONE;
+}
+
+bool isStringSource(uint8_t source) {
+    return source >= DS_FIRST_STRING && source < DS_COUNT;
+}
+
+float readDataSource(uint8_t source) {
+    sourceReads++;
+    return sourceValue[source];
+}
+
+uint16_t getSourceGeneration(uint8_t source) {
+    return sourceGeneration[source];
+}
+
+static void setSource(uint8_t source, float value) {
+    sourceValue[source] = value;
+    sourceGeneration[source]++;
+}
+
+// ========== Log Capture ==========
+
+static uint8_t lastLogLevel = LOG_LEVEL_NONE;
+static char lastLogText[LOG_LINE_MAX];
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+    (void)tag;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(lastLogText, sizeof(lastLogText), fmt, args);
+    va_end(args);
+    lastLogLevel = level;
+}
+
+void setUp() {
+    exprReset();
+    memset(sourceValue, 0, sizeof(sourceValue));
+    memset(sourceGeneration, 0, sizeof(sourceGeneration));
+    sourceReads = 0;
+    lastLogLevel = LOG_LEVEL_NONE;
+    lastLogText[0] = '\0';
+}
+
+void tearDown() {}
+
+// ========== Compiler ==========
+
+static void test_evaluates_arithmetic_and_precedence() {
+    sourceValue[DS_TEMP_BASE + 0] = 30.0f;
+    sourceValue[DS_TEMP_BASE + 1] = 4.0f;
+    uint8_t program = compileExpression("=temp0 + temp1 * 2 - -1");
+    TEST_ASSERT_NOT_EQUAL(EXPR_NONE, program);
+    TEST_ASSERT_EQUAL_FLOAT(39.0f, exprValue(program));
+
+    program = compileExpression("=(temp0 + temp1) / 2");
+    TEST_ASSERT_EQUAL_FLOAT(17.0f, exprValue(program));
+}
+
+static void test_division_by_zero_yields_zero() {
+    sourceValue[DS_PSU_VOLTAGE] = 24.0f;
+    uint8_t program = compileExpression("=psuVoltage / feedRate");
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, exprValue(program));
+}
+
+static void test_functions_skip_stale_inputs() {
+    sourceValue[DS_TEMP_BASE + 0] = 20.0f;
+    sourceValue[DS_TEMP_BASE + 1] = NAN;
+    sourceValue[DS_TEMP_BASE + 2] = 40.0f;
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, exprValue(compileExpression("=max(temp0,temp1,temp2)")));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, exprValue(compileExpression("=min(temp0,temp1,temp2)")));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, exprValue(compileExpression("=avg(temp0,temp1,temp2)")));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, exprValue(compileExpression("=abs(temp0-25)")));
+    TEST_ASSERT_TRUE(isnan(exprValue(compileExpression("=max(temp1)"))));
+}
+
+static void test_identical_expressions_share_a_program() {
+    uint8_t a = compileExpression("=temp0+1");
+    uint8_t b = compileExpression("temp0 + 1");
+    TEST_ASSERT_EQUAL_UINT8(a, b);
+    TEST_ASSERT_EQUAL_UINT8(1, exprCount());
+}
+
+static void test_errors_are_logged_as_warnings() {
+    const char* bad[] = {
+        "=temp0+", "=temp99", "=machineState+1", "=foo(temp0)", "=abs(temp0,temp1)",
+        "=(temp0", "=temp0 $ 2", "=", "=max(temp0,temp1,temp2,temp3,temp4,temp5,temp6,temp7,temp8)"
+    };
+    for (const char* text : bad) {
+        lastLogLevel = LOG_LEVEL_NONE;
+        TEST_ASSERT_EQUAL_UINT8(EXPR_NONE, compileExpression(text));
+        TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, lastLogLevel);
+        TEST_ASSERT_NOT_NULL(checkExpression(text));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, exprCount());
+}
+
+static void test_check_does_not_add_programs() {
+    TEST_ASSERT_NULL(checkExpression("=temp0*2"));
+    TEST_ASSERT_EQUAL_UINT8(0, exprCount());
+}
+
+static void test_reset_empties_the_pool() {
+    char text[24];
+    for (int i = 0; i < EXPR_MAX_PROGRAMS; i++) {
+        snprintf(text, sizeof(text), "=temp0+%d", i);
+        TEST_ASSERT_EQUAL_UINT8(i, compileExpression(text));
+    }
+    TEST_ASSERT_EQUAL_UINT8(EXPR_NONE, compileExpression("=temp1"));
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, lastLogLevel);
+
+    exprReset();
+    TEST_ASSERT_EQUAL_UINT8(0, exprCount());
+    TEST_ASSERT_EQUAL_UINT8(0, compileExpression("=temp1"));
+    TEST_ASSERT_EQUAL_STRING("temp1", exprText(0));
+}
+
+// ========== Change Detection ==========
+
+static void test_reevaluates_only_when_an_input_changes() {
+    uint8_t a = compileExpression("=temp0+temp1");
+    uint8_t b = compileExpression("=psuVoltage*2");
+    uint16_t genA = exprGeneration(a);
+    uint16_t genB = exprGeneration(b);
+
+    sourceReads = 0;
+    exprUpdate();
+    TEST_ASSERT_EQUAL_UINT32(0, sourceReads);
+
+    setSource(DS_TEMP_BASE + 1, 5.0f);
+    exprUpdate();
+    TEST_ASSERT_EQUAL_UINT32(2, sourceReads);       // temp0 and temp1, not psuVoltage
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, exprValue(a));
+    TEST_ASSERT_EQUAL_UINT16(genA + 1, exprGeneration(a));
+    TEST_ASSERT_EQUAL_UINT16(genB, exprGeneration(b));
+
+    // Same value again: evaluated, but the generation stays
+    setSource(DS_TEMP_BASE + 1, 5.0f);
+    exprUpdate();
+    TEST_ASSERT_EQUAL_UINT16(genA + 1, exprGeneration(a));
+}
+
+// Two inputs whose generation changes cancel out in a sum (one wraps)
+static void test_sees_changes_that_cancel_in_a_sum() {
+    sourceGeneration[DS_TEMP_BASE + 0] = 0xFFFF;
+    sourceGeneration[DS_TEMP_BASE + 1] = 0;
+    uint8_t program = compileExpression("=temp0+temp1");
+
+    sourceValue[DS_TEMP_BASE + 0] = 10.0f;
+    sourceValue[DS_TEMP_BASE + 1] = 20.0f;
+    sourceGeneration[DS_TEMP_BASE + 0] = 0;
+    sourceGeneration[DS_TEMP_BASE + 1] = 0xFFFF;
+    exprUpdate();
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, exprValue(program));
+}
+
+// ========== Benchmark ==========
+// 60 distinct expressions over 16 temperature channels, as a full set of
+// layouts could define. Reports the cost of an idle update, of an update
+// after one channel changed, and of a forced pass over every program.
+
+static void benchmark_sixty_expressions() {
+    char text[EXPR_TEXT_LEN];
+    for (int i = 0; i < 60; i++) {
+        int a = i % 16, b = (i * 7 + 3) % 16, c = (i * 5 + 1) % 16;
+        switch (i % 4) {
+            case 0: snprintf(text, sizeof(text), "=max(temp%d,temp%d,temp%d)+%d", a, b, c, i); break;
+            case 1: snprintf(text, sizeof(text), "=avg(temp%d,temp%d)*%d", a, b, i); break;
+            case 2: snprintf(text, sizeof(text), "=abs(temp%d-temp%d)/%d", a, b, i); break;
+            default: snprintf(text, sizeof(text), "=(psuVoltage-24)*%d+temp%d", i, a); break;
+        }
+        TEST_ASSERT_NOT_EQUAL(EXPR_NONE, compileExpression(text));
+    }
+    TEST_ASSERT_EQUAL_UINT8(60, exprCount());
+
+    const int rounds = 2000;
+    using Clock = std::chrono::steady_clock;
+
+    sourceReads = 0;
+    Clock::time_point start = Clock::now();
+    for (int n = 0; n < rounds; n++) exprUpdate();
+    double idleNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds;
+    TEST_ASSERT_EQUAL_UINT32(0, sourceReads);
+
+    sourceReads = 0;
+    start = Clock::now();
+    for (int n = 0; n < rounds; n++) {
+        setSource(DS_TEMP_BASE + 5, (float)n);
+        exprUpdate();
+    }
+    double oneNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds;
+    uint32_t readsPerUpdate = sourceReads / rounds;
+    TEST_ASSERT_GREATER_THAN_UINT32(0, readsPerUpdate);
+    TEST_ASSERT_LESS_THAN_UINT32(60, readsPerUpdate);
+
+    start = Clock::now();
+    exprBenchmark(rounds);
+    double forcedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds;
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "60 expressions: idle update %.0f ns, one channel changed %.0f ns (%lu reads), forced pass %.0f ns",
+             idleNs, oneNs, (unsigned long)readsPerUpdate, forcedNs);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_evaluates_arithmetic_and_precedence);
+    RUN_TEST(test_division_by_zero_yields_zero);
+    RUN_TEST(test_functions_skip_stale_inputs);
+    RUN_TEST(test_identical_expressions_share_a_program);
+    RUN_TEST(test_errors_are_logged_as_warnings);
+    RUN_TEST(test_check_does_not_add_programs);
+    RUN_TEST(test_reset_empties_the_pool);
+    RUN_TEST(test_reevaluates_only_when_an_input_changes);
+    RUN_TEST(test_sees_changes_that_cancel_in_a_sum);
+    RUN_TEST(benchmark_sixty_expressions);
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+// Host tests for the fan control engine (sensors/fan_control.cpp):
+//   pio test -e native -f test_fan_control
+//
+// fanControlUpdate() runs at 20 Hz, as controlFan() calls it, against a
+// plant model: a heat source on a heatsink cooled by the fan, a fan that
+// spins up with a lag, and a DS18B20 that reads the heatsink once per
+// second in 1/16 C steps. Each test reports settle time and overshoot.
+
+#include <unity.h>
+#include "sensors/fan_control.cpp"
+
+Config cfg;
+
+void logWrite(uint8_t, const char*, const char*, ...) {}
+
+#define STEP_MS         50          // One PSU block
+#define AMBIENT_C       25.0
+#define HEAT_CAPACITY   400.0       // J/K of the heatsink
+#define LOSS_STILL      0.5         // W/K with the fan stopped
+#define LOSS_FAN        4.0         // W/K added at full airflow
+#define FAN_RPM_FULL    2000.0      // Plant fan at 100% duty
+#define FAN_START_DUTY  15.0        // % below which the plant fan does not turn
+#define FAN_TAU_S       2.0         // Spin-up/down time constant
+#define SENSOR_TAU_S    5.0         // Sensor to heatsink coupling
+
+// ========== Plant ==========
+
+struct Plant {
+    double heatW;
+    double tempC;               // Heatsink
+    double sensorC;             // Sensor body, lagging the heatsink
+    double rpm;
+    double rpmScale;            // Fan RPM at full duty relative to FAN_RPM_FULL
+    float readingC;             // Last DS18B20 conversion
+    bool holdReading;           // Keep readingC (fan-only tests)
+    uint32_t nowMs;
+    uint8_t pwm;
+    uint32_t pwmChanges;
+};
+
+static Plant plant;
+
+static void resetPlant(double heatW, double tempC) {
+    plant = {};
+    plant.heatW = heatW;
+    plant.tempC = tempC;
+    plant.sensorC = tempC;
+    plant.rpmScale = 1.0;
+    plant.readingC = roundf(tempC * 16) / 16;
+    plant.nowMs = 1000;
+}
+
+// One controller step: the controller sees the last reading and the fan
+// RPM, then the plant advances STEP_MS at the duty it got
+static void step() {
+    uint8_t pwm = fanControlUpdate(plant.readingC, lround(plant.rpm), false, true, plant.nowMs);
+    if (pwm != plant.pwm) plant.pwmChanges++;
+    plant.pwm = pwm;
+
+    const double dt = STEP_MS / 1000.0;
+    double duty = pwm / 2.55;
+    double targetRpm = duty < FAN_START_DUTY ? 0 : FAN_RPM_FULL * plant.rpmScale * duty / 100;
+    plant.rpm += (targetRpm - plant.rpm) * dt / FAN_TAU_S;
+
+    double loss = LOSS_STILL + LOSS_FAN * plant.rpm / FAN_RPM_FULL;
+    plant.tempC += (plant.heatW - loss * (plant.tempC - AMBIENT_C)) * dt / HEAT_CAPACITY;
+    plant.sensorC += (plant.tempC - plant.sensorC) * dt / SENSOR_TAU_S;
+
+    plant.nowMs += STEP_MS;
+    if (plant.nowMs % 1000 == 0 && !plant.holdReading) plant.readingC = roundf(plant.sensorC * 16) / 16;
+}
+
+// ========== Response ==========
+
+struct Response {
+    double peak;                // Highest value seen
+    double low;                 // Lowest value seen
+    uint32_t settleMs;          // Last time outside the band (from the start of the run)
+};
+
+// Run for durationS, tracking the measured signal against target +- band
+static Response run(uint32_t durationS, double (*signal)(), double target, double band) {
+    Response response = {-1e9, 1e9, 0};
+    uint32_t startMs = plant.nowMs;
+    for (uint32_t n = 0; n < durationS * 1000 / STEP_MS; n++) {
+        step();
+        double value = signal();
+        response.peak = max(response.peak, value);
+        response.low = min(response.low, value);
+        if (fabs(value - target) > band) response.settleMs = plant.nowMs - startMs;
+    }
+    return response;
+}
+
+static double heatsinkTemp() { return plant.tempC; }
+static double fanRpm() { return plant.rpm; }
+
+static void report(const char* what, const Response& response, double overshoot) {
+    char message[120];
+    snprintf(message, sizeof(message), "%s: settled in %.0f s, overshoot %.2f",
+             what, response.settleMs / 1000.0, overshoot);
+    TEST_MESSAGE(message);
+}
+
+void setUp() {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.temp_threshold_low = 30.0;
+    cfg.temp_threshold_high = 50.0;
+    cfg.fan_min_speed = 30;
+    cfg.fan_max_speed_limit = 100;
+    cfg.fan_mode = FAN_MODE_PID;
+    cfg.fan_hysteresis = 2.0;
+    cfg.fan_target_temp = 45.0;
+    cfg.fan_max_rpm = 0;
+    fanControlReset();
+}
+
+void tearDown() {}
+
+// ========== PID ==========
+
+// Cold start with 60 W: the heatsink rises to the setpoint and holds it
+static void test_pid_settles_from_a_cold_start() {
+    resetPlant(60, AMBIENT_C);
+    Response response = run(3600, heatsinkTemp, cfg.fan_target_temp, 0.5);
+    double overshoot = response.peak - cfg.fan_target_temp;
+    report("PID cold start", response, overshoot);
+
+    TEST_ASSERT_TRUE(response.settleMs <= 15 * 60 * 1000);
+    TEST_ASSERT_TRUE(overshoot <= 2.0);
+    TEST_ASSERT_FLOAT_WITHIN(0.25, cfg.fan_target_temp, plant.tempC);
+    TEST_ASSERT_FALSE(getFanControlStatus().noTemp);
+}
+
+// Settled at 60 W, then 90 W: bounded excursion and back on the setpoint
+static void test_pid_rejects_a_load_step() {
+    resetPlant(60, AMBIENT_C);
+    run(3600, heatsinkTemp, cfg.fan_target_temp, 0.5);
+    uint32_t changes = plant.pwmChanges;
+
+    plant.heatW = 90;
+    Response response = run(3600, heatsinkTemp, cfg.fan_target_temp, 0.5);
+    double overshoot = response.peak - cfg.fan_target_temp;
+    report("PID 60->90 W", response, overshoot);
+
+    TEST_ASSERT_TRUE(response.settleMs <= 15 * 60 * 1000);
+    TEST_ASSERT_TRUE(overshoot <= 3.0);
+    TEST_ASSERT_FLOAT_WITHIN(0.25, cfg.fan_target_temp, plant.tempC);
+    // Settled, the duty moves with the 1/16 C reading steps, not every block
+    TEST_ASSERT_TRUE(plant.pwmChanges - changes < 3600);
+}
+
+// More heat than the fan can take: pinned at the limit without winding up,
+// so it comes off the limit promptly once the load drops
+static void test_pid_recovers_from_saturation() {
+    resetPlant(150, AMBIENT_C);
+    run(1800, heatsinkTemp, cfg.fan_target_temp, 0.5);
+    TEST_ASSERT_EQUAL_UINT8(255, plant.pwm);
+    TEST_ASSERT_TRUE(getFanControlStatus().integral <= 100.0f);
+
+    plant.heatW = 60;
+    Response response = run(3600, heatsinkTemp, cfg.fan_target_temp, 0.5);
+    double undershoot = cfg.fan_target_temp - response.low;
+    report("PID 150->60 W", response, undershoot);
+
+    TEST_ASSERT_TRUE(response.settleMs <= 20 * 60 * 1000);
+    TEST_ASSERT_TRUE(undershoot <= 3.0);
+}
+
+// ========== Curve ==========
+
+// Proportional: settles off the setpoint, and the hysteresis keeps the
+// duty from chattering on the reading steps
+static void test_curve_settles_without_chatter() {
+    cfg.fan_mode = FAN_MODE_CURVE;
+    resetPlant(60, AMBIENT_C);
+    run(3600, heatsinkTemp, 0, 0);
+    uint32_t changes = plant.pwmChanges;
+    double settled = plant.tempC;
+
+    Response response = run(600, heatsinkTemp, settled, 0.25);
+    report("Curve steady state", response, response.peak - response.low);
+
+    TEST_ASSERT_EQUAL_UINT32(0, response.settleMs);
+    TEST_ASSERT_TRUE(plant.pwmChanges - changes <= 2);
+    TEST_ASSERT_TRUE(settled > cfg.temp_threshold_low && settled < cfg.temp_threshold_high);
+}
+
+// ========== RPM Targeting ==========
+
+// A worn fan (85% of the rated RPM): the trim brings it onto the target
+static void test_rpm_trim_reaches_the_target() {
+    cfg.fan_mode = FAN_MODE_CURVE;
+    cfg.fan_max_rpm = FAN_RPM_FULL;
+    resetPlant(0, 40.0);
+    plant.holdReading = true;       // 40 C: 65% demand
+    plant.rpmScale = 0.85;
+    double target = FAN_RPM_FULL * 0.65;
+    plant.rpm = target * plant.rpmScale;    // Running open loop at the demand
+
+    Response response = run(60, fanRpm, target, target * 0.02);
+    double overshoot = (response.peak - target) / target * 100;
+    report("RPM trim (% overshoot)", response, overshoot);
+
+    TEST_ASSERT_EQUAL_UINT16(lround(target), getFanControlStatus().targetRpm);
+    TEST_ASSERT_TRUE(response.settleMs <= 20 * 1000);
+    TEST_ASSERT_TRUE(overshoot <= 5.0);
+    TEST_ASSERT_FLOAT_WITHIN(target * 0.01, target, plant.rpm);
+    TEST_ASSERT_TRUE(getFanControlStatus().trim > 0);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pid_settles_from_a_cold_start);
+    RUN_TEST(test_pid_rejects_a_load_step);
+    RUN_TEST(test_pid_recovers_from_saturation);
+    RUN_TEST(test_curve_settles_without_chatter);
+    RUN_TEST(test_rpm_trim_reaches_the_target);
+    return UNITY_END();
+}
@@ -0,0 +1,244 @@
+// Host tests for the fan tachometer (sensors/fan_tach.cpp):
+//   pio test -e native -f test_fan_tach
+//
+// A simulated fan feeds the software edge source (tachSimulateEdge) with
+// TACH_PULSES_PER_REV falling edges per revolution while tachUpdate() runs
+// once per LOOP_US, as loop() calls it. Covers accuracy from 0 to 10,000
+// RPM and how long a new speed takes to show.
+
+#include <unity.h>
+#include "sensors/fan_tach.cpp"
+
+void logWrite(uint8_t, const char*, const char*, ...) {}
+
+#define LOOP_US     1000
+#define TACH_PIN    4
+
+static double fanRpm = 0;
+static double nextEdgeUs = 0;
+static uint32_t bounceUs = 0;       // Second edge this long after each one (0 = clean)
+static uint16_t lowestRpm = 0;      // Readings since resetReadings()
+static uint16_t highestRpm = 0;
+
+static void setFanRpm(double rpm) {
+    if (fanRpm == 0) nextEdgeUs = nativeClockUs;    // Spinning up: first edge now
+    fanRpm = rpm;
+}
+
+static void resetReadings() {
+    lowestRpm = UINT16_MAX;
+    highestRpm = 0;
+}
+
+// One loop() pass: the edges due until the end of it, then tachUpdate()
+static void tick(bool update = true) {
+    uint64_t end = nativeClockUs + LOOP_US;
+    while (fanRpm > 0 && nextEdgeUs <= end) {
+        nativeClockUs = llround(nextEdgeUs);
+        tachSimulateEdge(micros());
+        if (bounceUs) tachSimulateEdge(micros() + bounceUs);
+        nextEdgeUs += 60000000.0 / (fanRpm * TACH_PULSES_PER_REV);
+    }
+    nativeClockUs = end;
+    if (!update) return;
+    uint16_t rpm = tachUpdate();
+    lowestRpm = min(lowestRpm, rpm);
+    highestRpm = max(highestRpm, rpm);
+}
+
+static void runFan(uint32_t durationUs) {
+    for (uint32_t t = 0; t < durationUs; t += LOOP_US) tick();
+}
+
+// Readings within 0.2% (+1 RPM for the rounding) of rpm
+static uint16_t tolerance(double rpm) {
+    return (uint16_t)(rpm / 500) + 1;
+}
+
+static bool reads(double rpm) {
+    return abs((int32_t)getTachStats().rpm - (int32_t)lround(rpm)) <= tolerance(rpm);
+}
+
+// Microseconds until the reading is within tolerance of rpm (UINT32_MAX if
+// it is not within maxUs)
+static uint32_t latencyTo(double rpm, uint32_t maxUs) {
+    for (uint32_t t = 0; t <= maxUs; t += LOOP_US) {
+        if (reads(rpm)) return t;
+        tick();
+    }
+    return UINT32_MAX;
+}
+
+static uint32_t periodUs(double rpm) {
+    return (uint32_t)(60000000.0 / rpm);
+}
+
+// Back to a freshly initialized tach and a stopped fan
+static void resetTach() {
+    stats = {};
+    eventCount = 0;
+    consumed = 0;
+    pendingUs = 0;
+    edgeCount = 0;
+    haveEdge = false;
+    fanRpm = 0;
+    bounceUs = 0;
+    nativeClockUs = 1000000;
+    resetReadings();
+    tachInit(TACH_PIN);
+}
+
+void setUp() {
+    resetTach();
+}
+
+void tearDown() {}
+
+// ========== Accuracy ==========
+
+static void test_stopped_fan_reads_zero_and_stalls() {
+    runFan(TACH_STALL_US + 100000);
+    TEST_ASSERT_EQUAL_UINT16(0, getTachStats().rpm);
+    TEST_ASSERT_TRUE(getTachStats().stalled);
+    TEST_ASSERT_EQUAL_UINT32(1, getTachStats().stalls);
+    TEST_ASSERT_EQUAL_UINT32(0, getTachStats().revolutions);
+}
+
+// From standstill to each speed: the first reading after two revolutions
+// (the first one only starts the period), then steady within tolerance
+static void test_accuracy_from_60_to_10000_rpm() {
+    const double speeds[] = {60, 100, 250, 600, 1000, 1700, 2500, 3300, 4000,
+                             5500, 7000, 8500, 9100, 10000};
+    char message[120];
+    double worstError = 0;
+    double worstRevs = 0;
+
+    for (double rpm : speeds) {
+        resetTach();
+        setFanRpm(rpm);
+        uint32_t latency = latencyTo(rpm, 3 * periodUs(rpm) + 100000);
+        TEST_ASSERT_TRUE_MESSAGE(latency <= 2 * periodUs(rpm) + LOOP_US, "first reading too late");
+        worstRevs = max(worstRevs, (double)latency / periodUs(rpm));
+
+        resetReadings();
+        runFan(max(10 * periodUs(rpm), (uint32_t)200000));
+        TEST_ASSERT_TRUE(reads(rpm));
+        TEST_ASSERT_UINT16_WITHIN(tolerance(rpm), lround(rpm), lowestRpm);
+        TEST_ASSERT_UINT16_WITHIN(tolerance(rpm), lround(rpm), highestRpm);
+        TEST_ASSERT_FALSE(getTachStats().stalled);
+        TEST_ASSERT_EQUAL_UINT32(0, getTachStats().glitches);
+        TEST_ASSERT_EQUAL_UINT32(0, getTachStats().lostPeriods);
+        worstError = max(worstError, max(fabs(lowestRpm - rpm), fabs(highestRpm - rpm)) / rpm);
+    }
+
+    snprintf(message, sizeof(message), "60-10000 RPM: worst error %.3f%%, first reading after %.2f revolutions",
+             worstError * 100, worstRevs);
+    TEST_MESSAGE(message);
+}
+
+// ========== Update Latency ==========
+
+static void test_small_step_shows_within_two_revolutions() {
+    setFanRpm(3000);
+    runFan(1000000);
+    setFanRpm(3300);
+    uint32_t latency = latencyTo(3300, 1000000);
+    TEST_ASSERT_TRUE(latency <= 2 * periodUs(3300) + LOOP_US);
+    TEST_ASSERT_EQUAL_UINT32(0, getTachStats().glitches);
+}
+
+// Beyond TACH_STEP_TOLERANCE the step needs a second period to confirm it
+static void test_large_steps_show_within_three_revolutions() {
+    char message[120];
+
+    setFanRpm(3000);
+    runFan(1000000);
+    setFanRpm(6000);
+    uint32_t up = latencyTo(6000, 1000000);
+    TEST_ASSERT_TRUE(up <= 3 * periodUs(6000) + LOOP_US);
+    runFan(500000);
+    TEST_ASSERT_TRUE(reads(6000));
+
+    setFanRpm(1500);
+    uint32_t down = latencyTo(1500, 1000000);
+    TEST_ASSERT_TRUE(down <= 3 * periodUs(1500) + LOOP_US);
+    runFan(500000);
+    TEST_ASSERT_TRUE(reads(1500));
+
+    snprintf(message, sizeof(message), "3000->6000 RPM in %lu us, 6000->1500 RPM in %lu us",
+             (unsigned long)up, (unsigned long)down);
+    TEST_MESSAGE(message);
+}
+
+// The reading falls while the revolution in progress overruns, and is 0
+// once it has run TACH_STALL_US without one
+static void test_stopping_fan_falls_then_stalls() {
+    setFanRpm(3000);
+    runFan(1000000);
+    setFanRpm(0);
+
+    runFan(100000);
+    TEST_ASSERT_TRUE(getTachStats().rpm < 3000 * 100 / 125);
+    TEST_ASSERT_FALSE(getTachStats().stalled);
+
+    uint32_t latency = latencyTo(0, TACH_STALL_US);
+    TEST_ASSERT_TRUE(latency < TACH_STALL_US);
+    TEST_ASSERT_TRUE(getTachStats().stalled);
+    TEST_ASSERT_EQUAL_UINT32(1, getTachStats().stalls);
+
+    // Restart: a fresh reading, not a step from the old period
+    setFanRpm(1200);
+    TEST_ASSERT_TRUE(latencyTo(1200, 1000000) <= 2 * periodUs(1200) + LOOP_US);
+    TEST_ASSERT_FALSE(getTachStats().stalled);
+}
+
+// ========== Noise ==========
+
+static void test_bounce_inside_the_filter_is_ignored() {
+    setFanRpm(2000);
+    runFan(500000);
+    bounceUs = TACH_FILTER_US - 2;
+    resetReadings();
+    runFan(500000);
+    TEST_ASSERT_UINT16_WITHIN(tolerance(2000), 2000, lowestRpm);
+    TEST_ASSERT_UINT16_WITHIN(tolerance(2000), 2000, highestRpm);
+    TEST_ASSERT_EQUAL_UINT32(0, getTachStats().glitches);
+}
+
+// A stray edge mid-revolution shifts the revolution boundary: the short
+// period it makes is rejected and the reading never jumps
+static void test_stray_edge_is_rejected() {
+    setFanRpm(2000);
+    runFan(500000);
+    resetReadings();
+    tachSimulateEdge(micros());
+    runFan(500000);
+    TEST_ASSERT_TRUE(getTachStats().glitches >= 1);
+    TEST_ASSERT_UINT16_WITHIN(tolerance(2000) + 2000 / 10, 2000, lowestRpm);
+    TEST_ASSERT_UINT16_WITHIN(tolerance(2000) + 2000 / 10, 2000, highestRpm);
+    TEST_ASSERT_TRUE(reads(2000));
+}
+
+// A loop() stall longer than TACH_RING revolutions loses the oldest
+// periods, not the reading
+static void test_slow_loop_overruns_the_ring() {
+    setFanRpm(10000);
+    runFan(100000);
+    for (int i = 0; i < 100; i++) tick(false);      // 100 ms: ~16 revolutions
+    tick();
+    TEST_ASSERT_TRUE(getTachStats().lostPeriods >= 8);
+    TEST_ASSERT_TRUE(reads(10000));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_stopped_fan_reads_zero_and_stalls);
+    RUN_TEST(test_accuracy_from_60_to_10000_rpm);
+    RUN_TEST(test_small_step_shows_within_two_revolutions);
+    RUN_TEST(test_large_steps_show_within_three_revolutions);
+    RUN_TEST(test_stopping_fan_falls_then_stalls);
+    RUN_TEST(test_bounce_inside_the_filter_is_ignored);
+    RUN_TEST(test_stray_edge_is_rejected);
+    RUN_TEST(test_slow_loop_overruns_the_ring);
+    return UNITY_END();
+}
@@ -0,0 +1,249 @@
+// Host tests for heap allocation tagging (utils/heap_telemetry.cpp):
+//   pio test -e native_heap_tagging
+//
+// Built with HEAP_TAGGING and the --wrap link flags, as the firmware is
+// when tagging is on, so malloc / calloc / realloc / free go through the
+// hooks. The loop stages run against them and each allocation must land in
+// the site of the subsystem that made it.
+
+#define LOG_FILE_LEVEL LOG_LEVEL_WARN
+
+// operator new / delete below are malloc / free; GCC flags the pairing
+// once they inline into the library containers
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+#include <unity.h>
+#include <stdarg.h>
+#include <new>
+#include "utils/heap_telemetry.cpp"
+#include "config/config.cpp"
+#include "sensors/sensors.cpp"
+#include "sensors/sensor_cache.cpp"
+#include "sensors/sensor_pipeline.cpp"
+#include "sensors/onewire_search.cpp"
+#include "sensors/fan_control.cpp"
+#include "display/view_model.cpp"
+#include "display/expression.cpp"
+
+#if !HEAP_TAGGING
+#error "Build with -DHEAP_TAGGING=1 and the --wrap flags (pio test -e native_heap_tagging)"
+#endif
+
+// new / delete through malloc / free, as in the ESP32 toolchain, so String
+// and container allocations reach the hooks too
+void* operator new(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+// ========== Firmware Globals ==========
+// What main.cpp defines for the modules above
+
+Preferences prefs;
+float* temperatures = nullptr;
+float* peakTemps = nullptr;
+uint8_t temperatureCount = 0;
+float psuVoltage, psuMin, psuMax;
+uint8_t fanSpeed;
+uint16_t fanRPM;
+bool adcReady;
+float posX, posY, posZ, posA;
+float wposX, wposY, wposZ, wposA;
+int feedRate;
+int spindleRPM;
+String machineState = "IDLE";
+unsigned long jobStartTime;
+bool isJobRunning;
+
+// PSU, tach and history store are not part of these tests
+static PsuBlock psuBlock;
+static TachStats tachStats;
+bool psuMonitorPoll() { return false; }
+const PsuBlock& psuLastBlock() { return psuBlock; }
+uint16_t tachUpdate() { return 0; }
+const TachStats& getTachStats() { return tachStats; }
+uint8_t historyStoreChannels() { return 0; }
+bool historyStoreResize(uint8_t) { return true; }
+bool historyStoreRemap(const uint8_t*, uint8_t) { return true; }
+void historyStoreAppend(uint32_t, const float*, uint8_t) {}
+
+// ========== Log Capture ==========
+
+static uint8_t warnings = 0;
+static char lastWarning[LOG_LINE_MAX];
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+    (void)tag;
+    if (level > LOG_LEVEL_WARN) return;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(lastWarning, sizeof(lastWarning), fmt, args);
+    va_end(args);
+    warnings++;
+}
+
+// ========== Helpers ==========
+
+static HeapSite* findSite(const char* name) {
+    for (HeapSite* site = heapFirstSite(); site; site = site->next) {
+        if (strcmp(site->name, name) == 0) return site;
+    }
+    return nullptr;
+}
+
+// Allocate and free size bytes in the caller's scope
+static void churn(size_t size) {
+    void* volatile ptr = malloc(size);
+    free(ptr);
+}
+
+static void networkWork() {
+    HEAP_SCOPE(HEAP_NETWORK, "test networkWork");
+    churn(48);
+}
+
+// One loop() pass of the stages under test, ms of simulated time apart:
+// PSU block at 20 Hz, history stage at 1 Hz
+static void runLoop(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += 50) {
+        updateTemperatureAcquisition();
+        processAdcReadings();
+        if (t % 1000 == 0) {
+            updateTempHistory();
+            heapTelemetryUpdate();
+        }
+        nativeAdvanceMs(50);
+    }
+}
+
+void setUp() {
+    heapCurrentSite = nullptr;
+    heapSitesReset();
+    steady = false;
+    sampleCount = 0;
+    nativeClockUs = 0;
+    nativeWifiSsid = "test";
+    viewModelReset();
+    lastNetworkRefresh = 0;
+    warnings = 0;
+    lastWarning[0] = '\0';
+}
+
+void tearDown() {}
+
+// ========== Scopes ==========
+
+static void test_allocations_count_against_the_open_scope() {
+    HEAP_SCOPE(HEAP_SENSORS, "test scope");
+    HeapSite* site = heapCurrentSite;
+    TEST_ASSERT_NOT_NULL(site);
+
+    void* volatile a = malloc(100);
+    void* volatile b = calloc(4, 25);
+    a = realloc(a, 300);        // A free of the old block and a new allocation
+    free(a);
+    free(b);
+
+    TEST_ASSERT_EQUAL_UINT32(3, site->allocs);
+    TEST_ASSERT_EQUAL_UINT32(500, site->allocBytes);
+    TEST_ASSERT_EQUAL_UINT32(3, site->frees);
+    TEST_ASSERT_TRUE(site->freeBytes >= site->allocBytes);
+    TEST_ASSERT_EQUAL(HEAP_SENSORS, site->subsystem);
+}
+
+static void test_outside_any_scope_is_untagged() {
+    HeapSite* untagged = heapFirstSite();
+    TEST_ASSERT_EQUAL_STRING("untagged", untagged->name);
+    churn(64);
+    TEST_ASSERT_EQUAL_UINT32(1, untagged->allocs);
+    TEST_ASSERT_EQUAL_UINT32(64, untagged->allocBytes);
+}
+
+// An inner scope takes over until it returns, then the outer one resumes
+static void test_inner_scope_takes_over_and_returns() {
+    HEAP_SCOPE(HEAP_WEB, "test outer");
+    HeapSite* outer = heapCurrentSite;
+    churn(16);
+    networkWork();
+    churn(16);
+
+    TEST_ASSERT_TRUE(heapCurrentSite == outer);
+    TEST_ASSERT_EQUAL_UINT32(2, outer->allocs);
+    TEST_ASSERT_EQUAL_UINT32(32, outer->allocBytes);
+    HeapSite* inner = findSite("test networkWork");
+    TEST_ASSERT_NOT_NULL(inner);
+    TEST_ASSERT_EQUAL_UINT32(1, inner->allocs);
+    TEST_ASSERT_EQUAL(HEAP_NETWORK, inner->subsystem);
+}
+
+// ========== Loop Stages ==========
+
+// Each stage's site belongs to one subsystem
+static void test_loop_stages_register_one_subsystem_each() {
+    runLoop(1000);
+    struct { const char* name; HeapSubsystem subsystem; } expected[] = {
+        {"updateTemperatureAcquisition", HEAP_SENSORS},
+        {"processAdcReadings", HEAP_SENSORS},
+        {"viewModelUpdate", HEAP_RENDER},
+        {"updateTempHistory", HEAP_HISTORY},
+    };
+    for (auto& stage : expected) {
+        HeapSite* site = findSite(stage.name);
+        TEST_ASSERT_NOT_NULL_MESSAGE(site, stage.name);
+        TEST_ASSERT_EQUAL_MESSAGE(stage.subsystem, site->subsystem, stage.name);
+    }
+}
+
+// The network strings the view model refreshes are a render allocation,
+// even when the refresh runs from processAdcReadings()
+static void test_view_model_strings_are_render_not_sensors() {
+    nativeWifiSsid = "a network name longer than a short string";
+    runLoop(10000);
+
+    HeapSite* viewModel = findSite("viewModelUpdate");
+    HeapSite* adc = findSite("processAdcReadings");
+    TEST_ASSERT_NOT_NULL(viewModel);
+    TEST_ASSERT_NOT_NULL(adc);
+    TEST_ASSERT_TRUE(viewModel->allocs > 0);
+    TEST_ASSERT_EQUAL_UINT32(viewModel->allocs, viewModel->frees);
+    TEST_ASSERT_EQUAL_UINT32(0, adc->allocs);
+    TEST_ASSERT_EQUAL_UINT32(0, findSite("updateTemperatureAcquisition")->allocs);
+    TEST_ASSERT_EQUAL_UINT32(0, findSite("updateTempHistory")->allocs);
+}
+
+// Past HEAP_STEADY_AFTER_MS, the one site still allocating is reported,
+// once, under its own name
+static void test_steady_state_run_reports_the_allocating_site() {
+    nativeWifiSsid = "a network name longer than a short string";
+    runLoop(HEAP_STEADY_AFTER_MS + 2 * HEAP_SAMPLE_MS);
+
+    TEST_ASSERT_TRUE(steady);
+    TEST_ASSERT_TRUE(findSite("viewModelUpdate")->steadyAllocs > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, findSite("processAdcReadings")->steadyAllocs);
+    TEST_ASSERT_EQUAL_UINT32(0, findSite("updateTemperatureAcquisition")->steadyAllocs);
+    TEST_ASSERT_EQUAL_UINT32(0, findSite("updateTempHistory")->steadyAllocs);
+    TEST_ASSERT_EQUAL_UINT8(1, warnings);
+    TEST_ASSERT_NOT_NULL(strstr(lastWarning, "viewModelUpdate (render)"));
+
+    runLoop(2 * HEAP_SAMPLE_MS);
+    TEST_ASSERT_EQUAL_UINT8(1, warnings);
+}
+
+int main(int argc, char** argv) {
+    initDefaultConfig();
+    heapTaggingInit();
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_count_against_the_open_scope);
+    RUN_TEST(test_outside_any_scope_is_untagged);
+    RUN_TEST(test_inner_scope_takes_over_and_returns);
+    RUN_TEST(test_loop_stages_register_one_subsystem_each);
+    RUN_TEST(test_view_model_strings_are_render_not_sensors);
+    RUN_TEST(test_steady_state_run_reports_the_allocating_site);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+// Host tests for the temperature history store (history/history_store.cpp):
+//   pio test -e native -f test_history_store
+//
+// Channel ch reads rampValue(ch, t) at second t, so every point a query
+// returns can be checked against the temperature it should average.
+
+#include <unity.h>
+#include "history/history_store.cpp"
+
+#define TEST_CHANNELS 4
+
+// 20 C + 1 C per channel, rising 1 C per 1000 s
+static float rampValue(uint8_t ch, uint32_t timeS) {
+    return 20.0f + ch + timeS * 0.001f;
+}
+
+// Append seconds [fromS, toS] of every channel; a channel in staleMask reads NAN
+static void appendRamp(uint32_t fromS, uint32_t toS, uint8_t channels, uint32_t staleMask = 0) {
+    float values[HISTORY_MAX_CHANNELS];
+    for (uint32_t t = fromS; t <= toS; t++) {
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            values[ch] = (staleMask & (1UL << ch)) ? NAN : rampValue(ch, t);
+        }
+        historyStoreAppend(t, values, channels);
+    }
+}
+
+// Back to an empty, uninitialized store
+static void resetStore() {
+    memset(tiers, 0, sizeof(tiers));
+    memset(accumulators, 0, sizeof(accumulators));
+    channelCount = 0;
+    lastTime = 0;
+    started = false;
+    reshaping = false;
+}
+
+void setUp() {
+    resetStore();
+}
+
+void tearDown() {}
+
+// ========== Graph Presets ==========
+// Every graph_time x graph_int choice of the settings page, queried the way
+// drawTempGraph() does (240 px wide graph)
+
+static const uint16_t graphTimes[] = {60, 300, 600, 1800, 3600};
+static const uint16_t graphIntervals[] = {1, 5, 10, 30, 60};
+
+static void test_every_graph_preset() {
+    const uint32_t now = 4000;
+    TEST_ASSERT_TRUE(historyStoreInit(TEST_CHANNELS));
+    appendRamp(1, now, TEST_CHANNELS);
+
+    static HistoryPoint points[240];
+    char message[96];
+    for (uint16_t span : graphTimes) {
+        for (uint16_t interval : graphIntervals) {
+            uint32_t from = now - span;
+            uint16_t maxPoints = constrain(span / interval, (uint32_t)2, (uint32_t)240);
+            snprintf(message, sizeof(message), "graph_time %u, graph_int %u", span, interval);
+
+            for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) {
+                uint16_t count = historyQuery(ch, from, now, maxPoints, points);
+                TEST_ASSERT_GREATER_OR_EQUAL_UINT16_MESSAGE(2, count, message);
+                TEST_ASSERT_LESS_OR_EQUAL_UINT16_MESSAGE(maxPoints, count, message);
+
+                // The whole span is covered, oldest first, without gaps
+                uint16_t period = historyTierPeriod(historyChooseTier(from, now, maxPoints));
+                TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(from, points[0].time, message);
+                TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(from - period, points[0].time, message);
+                TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(now - span / count - period,
+                                                           points[count - 1].time, message);
+                for (uint16_t i = 0; i < count; i++) {
+                    TEST_ASSERT_TRUE_MESSAGE(points[i].avg != HISTORY_NONE, message);
+                    if (i > 0) TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(points[i - 1].time, points[i].time, message);
+                    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.15f, rampValue(ch, max(points[i].time, from)),
+                                                     historyToCelsius(points[i].avg), message);
+                    TEST_ASSERT_LESS_OR_EQUAL_INT16_MESSAGE(points[i].avg, points[i].min, message);
+                    TEST_ASSERT_GREATER_OR_EQUAL_INT16_MESSAGE(points[i].avg, points[i].max, message);
+                }
+            }
+        }
+    }
+}
+
+// A stale channel comes back as gaps, the others are unaffected
+static void test_stale_channel_is_a_gap() {
+    TEST_ASSERT_TRUE(historyStoreInit(TEST_CHANNELS));
+    appendRamp(1, 600, TEST_CHANNELS, 1UL << 2);
+
+    HistoryPoint points[60];
+    uint16_t count = historyQuery(2, 300, 600, 60, points);
+    TEST_ASSERT_GREATER_THAN_UINT16(0, count);
+    for (uint16_t i = 0; i < count; i++) TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, points[i].avg);
+
+    count = historyQuery(1, 300, 600, 60, points);
+    for (uint16_t i = 0; i < count; i++) TEST_ASSERT_TRUE(points[i].avg != HISTORY_NONE);
+}
+
+// ========== Resize ==========
+
+static void test_resize_keeps_newest_history() {
+    TEST_ASSERT_TRUE(historyStoreInit(TEST_CHANNELS));
+    appendRamp(1, 3000, TEST_CHANNELS);
+
+    // 64 channels no longer fit at full depth: every tier is shortened
+    TEST_ASSERT_TRUE(historyStoreResize(HISTORY_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT8(HISTORY_MAX_CHANNELS, historyStoreChannels());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(HISTORY_RAM_BUDGET + sizeof(accumulators), historyStoreBytes());
+    TEST_ASSERT_FALSE(reshaping);
+
+    HistoryPoint point;
+    for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) {
+        TEST_ASSERT_TRUE(historyReadBucket(0, ch, 3000, point));
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, rampValue(ch, 3000), historyToCelsius(point.avg));
+        TEST_ASSERT_TRUE(historyReadBucket(1, ch, 290, point));
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, rampValue(ch, 2904.5f), historyToCelsius(point.avg));
+    }
+    // New channels start empty
+    TEST_ASSERT_FALSE(historyReadBucket(0, TEST_CHANNELS, 3000, point));
+
+    // And back: the surviving channels keep what the short layout held
+    appendRamp(3001, 3010, HISTORY_MAX_CHANNELS);
+    TEST_ASSERT_TRUE(historyStoreResize(TEST_CHANNELS));
+    TEST_ASSERT_TRUE(historyReadBucket(0, 3, 3010, point));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, rampValue(3, 3010), historyToCelsius(point.avg));
+    TEST_ASSERT_FALSE(historyReadBucket(0, TEST_CHANNELS, 3010, point));
+}
+
+// While series are being moved no bucket is readable, and a query that
+// started before a resize reads the rest of its span as gaps
+static void test_reads_during_resize() {
+    TEST_ASSERT_TRUE(historyStoreInit(TEST_CHANNELS));
+    appendRamp(1, 600, TEST_CHANNELS);
+
+    HistoryPoint point;
+    setReshaping(true);
+    TEST_ASSERT_FALSE(historyReadBucket(0, 0, 600, point));
+    HistoryPoint points[60];
+    uint16_t count = historyQuery(0, 300, 600, 60, points);
+    for (uint16_t i = 0; i < count; i++) TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, points[i].avg);
+    setReshaping(false);
+
+    TEST_ASSERT_TRUE(historyReadBucket(0, 0, 600, point));
+    TEST_ASSERT_EQUAL_UINT16(60, historyQuery(0, 400, 600, 60, points));
+    TEST_ASSERT_EQUAL_UINT16(0, historyQuery(TEST_CHANNELS, 400, 600, 60, points));
+}
+
+// ========== Remap ==========
+
+// Reads the history channel `from` had when the store held the ramp
+static void assertChannelHolds(uint8_t ch, uint8_t from, uint32_t timeS) {
+    HistoryPoint point;
+    TEST_ASSERT_TRUE(historyReadBucket(0, ch, timeS, point));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, rampValue(from, timeS), historyToCelsius(point.avg));
+    // The open 10 s bucket moves with its channel too
+    TEST_ASSERT_TRUE(historyReadBucket(1, ch, timeS / 10, point));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, rampValue(from, timeS / 10 * 10) + 0.001f * (timeS % 10) / 2,
+                             historyToCelsius(point.avg));
+}
+
+static void test_remap_follows_the_sensors() {
+    TEST_ASSERT_TRUE(historyStoreInit(TEST_CHANNELS));
+    appendRamp(1, 605, TEST_CHANNELS);
+
+    // A new sensor took channel 2, the others moved up
+    const uint8_t grow[] = {2, 0, HISTORY_NO_CHANNEL, 1, 3};
+    TEST_ASSERT_TRUE(historyStoreRemap(grow, 5));
+    TEST_ASSERT_EQUAL_UINT8(5, historyStoreChannels());
+    TEST_ASSERT_FALSE(reshaping);
+    assertChannelHolds(0, 2, 605);
+    assertChannelHolds(1, 0, 605);
+    assertChannelHolds(3, 1, 605);
+    assertChannelHolds(4, 3, 605);
+    HistoryPoint point;
+    TEST_ASSERT_FALSE(historyReadBucket(0, 2, 605, point));
+    TEST_ASSERT_FALSE(historyReadBucket(1, 2, 60, point));
+
+    // Two sensors removed: channel 0 was old channel 4 (ramp 3)
+    const uint8_t shrink[] = {4, 1};
+    TEST_ASSERT_TRUE(historyStoreRemap(shrink, 2));
+    TEST_ASSERT_EQUAL_UINT8(2, historyStoreChannels());
+    assertChannelHolds(0, 3, 605);
+    assertChannelHolds(1, 0, 605);
+
+    // Nothing moved: nothing to do
+    const uint8_t same[] = {0, 1};
+    uint32_t generation = layoutGeneration;
+    TEST_ASSERT_TRUE(historyStoreRemap(same, 2));
+    TEST_ASSERT_EQUAL_UINT32(generation, layoutGeneration);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_graph_preset);
+    RUN_TEST(test_stale_channel_is_a_gap);
+    RUN_TEST(test_resize_keeps_newest_history);
+    RUN_TEST(test_reads_during_resize);
+    RUN_TEST(test_remap_follows_the_sensors);
+    return UNITY_END();
+}
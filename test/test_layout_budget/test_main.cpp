@@ -0,0 +1,187 @@
+// Render-cost check of every shipped layout (screens/*.json):
+//   pio test -e native -f test_layout_budget -v
+//
+// Parses each file with parseScreenJson() and the display-list compiler, as
+// loadScreenConfig() does, and runs the layout analyzer with its uncalibrated
+// (40 MHz SPI) cost model. A layout over LAYOUT_FRAME_BUDGET_MS fails the
+// run, so pio exits non-zero. The printed tables are the ones in
+// DISPLAY_LIST_COMPILER.md.
+
+#include <unity.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include "display/layout_parser.cpp"
+#include "display/display_list.cpp"
+#include "display/layout_analyzer.cpp"
+#include "display/view_model.cpp"
+#include "display/expression.cpp"
+
+// ========== Firmware Globals ==========
+// What main.cpp, sensors.cpp and display.cpp define for the modules above
+
+Config cfg;
+LGFX gfx;
+LGFX::LGFX() {}
+
+static float channelTemps[4] = {20.0f, 21.0f, 22.0f, 23.0f};
+float* temperatures = channelTemps;
+uint8_t temperatureCount = 4;
+float posX, posY, posZ, posA;
+float wposX, wposY, wposZ, wposA;
+int feedRate;
+int spindleRPM;
+float psuVoltage;
+uint8_t fanSpeed;
+String machineState = "IDLE";
+unsigned long jobStartTime;
+bool isJobRunning;
+
+float getMaxTemperature() { return 23.0f; }
+int8_t sensorCacheFindAlias(const char*) { return SENSOR_CACHE_NONE; }
+
+// ========== Layout Files ==========
+
+#define LAYOUT_FILE_MAX 8192    // loadScreenConfig() refuses larger files
+
+// screens/ next to test/, wherever the suite is compiled from
+static std::string screensDir() {
+    std::string file = __FILE__;
+    size_t pos = file.rfind("test/test_layout_budget/");
+    return file.substr(0, pos == std::string::npos ? 0 : pos) + "screens";
+}
+
+static std::vector<std::string> layoutFiles() {
+    std::vector<std::string> names;
+    DIR* dir = opendir(screensDir().c_str());
+    if (dir == nullptr) return names;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) names.push_back(name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static bool readLayout(const std::string& name, std::string& json) {
+    std::ifstream file(screensDir() + "/" + name);
+    if (!file) return false;
+    std::stringstream text;
+    text << file.rdbuf();
+    json = text.str();
+    return true;
+}
+
+static ScreenLayout layout;
+
+void setUp() {
+    memset(&layout, 0, sizeof(layout));
+}
+
+void tearDown() {}
+
+// ========== Tests ==========
+
+static void test_every_layout_loads() {
+    std::vector<std::string> names = layoutFiles();
+    TEST_ASSERT_TRUE_MESSAGE(!names.empty(), "no screens/*.json found");
+
+    for (const std::string& name : names) {
+        std::string json;
+        TEST_ASSERT_TRUE_MESSAGE(readLayout(name, json), name.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(json.size() <= LAYOUT_FILE_MAX, (name + ": larger than 8192 bytes").c_str());
+        TEST_ASSERT_TRUE_MESSAGE(parseScreenJson(json.c_str(), layout, false), (name + ": does not parse").c_str());
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, layout.droppedElements, (name + ": over 60 elements").c_str());
+    }
+}
+
+static void test_every_layout_within_budget() {
+    std::vector<std::string> names = layoutFiles();
+    std::string over;
+    std::string listRows, costRows;
+    char row[200];
+
+    for (const std::string& name : names) {
+        std::string json;
+        if (!readLayout(name, json) || !parseScreenJson(json.c_str(), layout, false)) continue;
+
+        LayoutReport report;
+        analyzeLayout(layout, LAYOUT_FRAME_BUDGET_MS * 1000UL, report);
+
+        float saved = layout.pixelsBefore
+            ? 100.0f * (layout.pixelsBefore - layout.pixelsAfter) / layout.pixelsBefore : 0;
+        char styles[16];
+        snprintf(styles, sizeof(styles), "%u -> %u", layout.stateChangesBefore, layout.stateChangesAfter);
+        snprintf(row, sizeof(row), "| %-16s | %8u | %3u | %13lu | %12lu | %4.1f%% | %13s |\n",
+                 name.c_str(), layout.elementCount, layout.opCount,
+                 (unsigned long)layout.pixelsBefore, (unsigned long)layout.pixelsAfter, saved, styles);
+        listRows += row;
+        snprintf(row, sizeof(row), "| %-16s | %6.1f ms | %6lu KB | %15.1f ms | %7.2fx | %15u |\n",
+                 name.c_str(), report.fullDrawUs / 1000.0f, (unsigned long)(report.fullDrawBytes / 1000),
+                 report.updateUs / 1000.0f, report.overdraw, report.unboxedDynamic);
+        costRows += row;
+
+        if (!report.withinBudget) {
+            snprintf(row, sizeof(row), " %s (%.1f ms)", name.c_str(), report.fullDrawUs / 1000.0f);
+            over += row;
+        }
+    }
+
+    printf("\n| Layout           | Elements | Ops | Pixels before | Pixels after | Saved | Style changes |\n"
+           "|------------------|---------:|----:|--------------:|-------------:|------:|--------------:|\n%s",
+           listRows.c_str());
+    printf("\n| Layout           | Full draw | SPI bytes | Update all dynamic | Overdraw | Unboxed dynamic |\n"
+           "|------------------|----------:|----------:|-------------------:|---------:|----------------:|\n%s\n",
+           costRows.c_str());
+
+    if (!over.empty()) {
+        std::string message = "over the " + std::to_string(LAYOUT_FRAME_BUDGET_MS) + " ms budget:" + over;
+        TEST_FAIL_MESSAGE(message.c_str());
+    }
+}
+
+// The check itself: a tight budget must fail a real layout
+static void test_over_budget_is_flagged() {
+    std::string json;
+    TEST_ASSERT_TRUE(readLayout("monitor.json", json));
+    TEST_ASSERT_TRUE(parseScreenJson(json.c_str(), layout, false));
+
+    LayoutReport report;
+    analyzeLayout(layout, 1000UL, report);
+    TEST_ASSERT_FALSE(report.withinBudget);
+    analyzeLayout(layout, LAYOUT_BUDGET_MAX_MS * 1000UL, report);
+    TEST_ASSERT_TRUE(report.withinBudget);
+}
+
+static void test_report_json() {
+    TEST_ASSERT_TRUE(parseScreenJson(
+        "{\"name\":\"t\",\"elements\":["
+        "{\"type\":\"temp\",\"x\":0,\"y\":0,\"data\":\"temp0\"},"
+        "{\"type\":\"dynamic\",\"x\":0,\"y\":20,\"w\":60,\"h\":16,\"data\":\"nosuch\"}]}",
+        layout, false));
+
+    LayoutReport report;
+    analyzeLayout(layout, LAYOUT_FRAME_BUDGET_MS * 1000UL, report);
+    JsonDocument doc;
+    layoutReportToJson(layout, report, doc.to<JsonObject>());
+
+    TEST_ASSERT_EQUAL(2, doc["dynamic_elements"].as<int>());
+    TEST_ASSERT_EQUAL(1, doc["unboxed_dynamic"].size());
+    TEST_ASSERT_EQUAL(0, doc["unboxed_dynamic"][0].as<int>());
+    TEST_ASSERT_EQUAL(1, doc["unknown_sources"].size());
+    TEST_ASSERT_EQUAL(1, doc["unknown_sources"][0]["element"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("nosuch", doc["unknown_sources"][0]["data"].as<const char*>());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_layout_loads);
+    RUN_TEST(test_every_layout_within_budget);
+    RUN_TEST(test_over_budget_is_flagged);
+    RUN_TEST(test_report_json);
+    return UNITY_END();
+}
@@ -0,0 +1,466 @@
+// Host tests for DS18B20 acquisition with more than 16 sensors
+// (sensors/sensors.cpp and the modules it feeds):
+//   pio test -e native -f test_sensor_channels
+//
+// Two simulated buses (test/native/OneWire.h) carry 20 sensors. The tests
+// run the firmware's own init, acquisition and bus scan against them and
+// check that every channel reaches the cache, the channel arrays, the
+// "tempN" and alias data sources and the status temperature list.
+
+#define LOG_FILE_LEVEL LOG_LEVEL_WARN
+
+#include <unity.h>
+#include <stdarg.h>
+#include "config/config.cpp"
+#include "sensors/sensors.cpp"
+#include "sensors/sensor_cache.cpp"
+#include "sensors/sensor_pipeline.cpp"
+#include "sensors/onewire_search.cpp"
+#include "sensors/fan_control.cpp"
+#include "display/view_model.cpp"
+#include "display/expression.cpp"
+
+// ========== Firmware Globals ==========
+// What main.cpp defines for the modules above
+
+Preferences prefs;
+float* temperatures = nullptr;
+float* peakTemps = nullptr;
+uint8_t temperatureCount = 0;
+float psuVoltage, psuMin, psuMax;
+uint8_t fanSpeed;
+uint16_t fanRPM;
+bool adcReady;
+float posX, posY, posZ, posA;
+float wposX, wposY, wposZ, wposA;
+int feedRate;
+int spindleRPM;
+String machineState = "IDLE";
+unsigned long jobStartTime;
+bool isJobRunning;
+
+// PSU, tach and history are not part of these tests
+static PsuBlock psuBlock;
+static TachStats tachStats;
+bool psuMonitorPoll() { return false; }
+const PsuBlock& psuLastBlock() { return psuBlock; }
+uint16_t tachUpdate() { return 0; }
+const TachStats& getTachStats() { return tachStats; }
+uint8_t historyStoreChannels() { return 0; }
+bool historyStoreResize(uint8_t) { return true; }
+bool historyStoreRemap(const uint8_t*, uint8_t) { return true; }
+void historyStoreAppend(uint32_t, const float*, uint8_t) {}
+
+// ========== Log Capture ==========
+
+static uint8_t warnings = 0;
+static char lastWarning[LOG_LINE_MAX];
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+    (void)tag;
+    if (level > LOG_LEVEL_WARN) return;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(lastWarning, sizeof(lastWarning), fmt, args);
+    va_end(args);
+    warnings++;
+}
+
+// ========== Simulated Buses ==========
+
+#define BUS_A_PIN       ONE_WIRE_BUS_1
+#define BUS_B_PIN       26
+#define BUS_A_SENSORS   12
+#define BUS_B_SENSORS   8
+#define TEST_SENSORS    (BUS_A_SENSORS + BUS_B_SENSORS)
+
+// Sensor n reads 20 C + 0.5 C * n
+static float sensorTemp(uint8_t n) {
+    return 20.0f + 0.5f * n;
+}
+
+static NativeDS18B20& sensor(uint8_t n) {
+    return n < BUS_A_SENSORS ? nativeOneWireBus[BUS_A_PIN][n] : nativeOneWireBus[BUS_B_PIN][n - BUS_A_SENSORS];
+}
+
+// Config register of a resolution (bits 5-6)
+static uint8_t configFor(uint8_t resolution) {
+    return ((resolution - 9) << 5) | 0x1F;
+}
+
+// Run loop() ticks of the acquisition for ms of simulated time
+static void runAcquisition(uint32_t ms) {
+    unsigned long end = millis() + ms;
+    while (millis() < end) {
+        updateTemperatureAcquisition();
+        nativeAdvanceMs(1);
+    }
+}
+
+// Back to a fresh boot: empty NVS, default config, no buses or channels
+static void resetFirmware() {
+    for (auto& bus : nativeOneWireBus) bus.clear();
+    nativeNvs.clear();
+    for (uint8_t b = 0; b < busCount; b++) {
+        delete busDrivers[b];
+        delete oneWireBuses[b];
+    }
+    busCount = 0;
+    parasitePower = false;
+    free(temperatures);
+    free(peakTemps);
+    temperatures = nullptr;
+    peakTemps = nullptr;
+    temperatureCount = 0;
+    sensorMappings.clear();
+    discoveredSensors.clear();
+    tempAcqState = TEMP_ACQ_IDLE;
+    conversionStart = 0;
+    scanActive = false;
+    lastScanEnd = 0;
+    memset(&busSearch, 0, sizeof(busSearch));
+    resolutionPending.clear();
+    identPhase = IDENT_PHASE_OFF;
+    identCandidates.clear();
+    identStatus = {};
+    identStartPending = false;
+    sensorTablesChanged = false;
+    viewModelReset();
+    fanControlReset();
+    warnings = 0;
+    lastWarning[0] = '\0';
+    initDefaultConfig();
+}
+
+// 20 sensors on two buses, initialized and through one full pass
+static void bootTwentySensors() {
+    for (uint8_t n = 0; n < TEST_SENSORS; n++) {
+        uint8_t pin = n < BUS_A_SENSORS ? BUS_A_PIN : BUS_B_PIN;
+        nativeOneWireBus[pin].push_back(nativeDS18B20(n + 1, sensorTemp(n)));
+    }
+    cfg.onewire_pins[1] = BUS_B_PIN;
+    loadSensorConfig();
+    initDS18B20Sensors();
+    runAcquisition(2500);
+}
+
+void setUp() {
+    resetFirmware();
+}
+
+void tearDown() {}
+
+// ========== Acquisition ==========
+
+static void test_every_sensor_gets_a_channel() {
+    bootTwentySensors();
+    TEST_ASSERT_EQUAL_UINT8(2, busCount);
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS, sensorCacheCount());
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS, temperatureCount);
+
+    // Unmapped sensors are numbered in bus order
+    char alias[8];
+    for (uint8_t ch = 0; ch < TEST_SENSORS; ch++) {
+        TEST_ASSERT_EQUAL_MEMORY(sensor(ch).rom, sensorCacheUID(ch), 8);
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(ch), temperatures[ch]);
+        snprintf(alias, sizeof(alias), "temp%d", ch);
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(ch), getTempByAlias(alias));
+        TEST_ASSERT_EQUAL_UINT8(DS_TEMP_BASE + ch, lookupDataSource(alias));
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(ch), readDataSource(DS_TEMP_BASE + ch));
+        // Every sensor was set to the configured resolution
+        TEST_ASSERT_EQUAL_HEX8(configFor(cfg.temp_resolution), sensor(ch).scratchpad[4]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(DS_NONE, lookupDataSource("temp20"));
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(TEST_SENSORS - 1), getMaxTemperature());
+    TEST_ASSERT_EQUAL_UINT8(0, warnings);
+}
+
+static void test_status_lists_every_channel() {
+    bootTwentySensors();
+
+    char list[VM_MAX_TEMP_SOURCES * 12];
+    size_t len = viewModelCopyTemperatures(list, sizeof(list));
+    TEST_ASSERT_EQUAL_size_t(strlen(list), len);
+
+    uint8_t values = 0;
+    char* save = nullptr;
+    for (char* value = strtok_r(list, ",", &save); value != nullptr; value = strtok_r(nullptr, ",", &save)) {
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(values), atof(value));
+        values++;
+    }
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS, values);
+}
+
+// A sensor that stops answering goes stale; the others keep publishing
+static void test_silent_sensor_goes_stale() {
+    bootTwentySensors();
+    sensor(17).badCrc = true;
+    runAcquisition(5000);
+
+    TEST_ASSERT_TRUE(isnan(temperatures[17]));
+    TEST_ASSERT_TRUE(isnan(getTempByAlias("temp17")));
+    for (uint8_t ch = 0; ch < TEST_SENSORS; ch++) {
+        if (ch != 17) TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(ch), temperatures[ch]);
+    }
+}
+
+// Nothing left to measure: no maximum, and the fan runs at its limit
+static void test_all_stale_drives_the_fan_at_the_limit() {
+    cfg.fan_max_speed_limit = 90;
+    bootTwentySensors();
+    controlFan();
+    TEST_ASSERT_EQUAL_UINT8(cfg.fan_min_speed, fanSpeed);
+
+    for (uint8_t n = 0; n < TEST_SENSORS; n++) sensor(n).badCrc = true;
+    runAcquisition(5000);
+    TEST_ASSERT_TRUE(isnan(getMaxTemperature()));
+    warnings = 0;
+    controlFan();
+    TEST_ASSERT_EQUAL_UINT8(90, fanSpeed);
+    TEST_ASSERT_EQUAL_UINT32(lroundf(90 * 2.55f), nativePwmDuty[0]);
+    TEST_ASSERT_TRUE(getFanControlStatus().noTemp);
+    TEST_ASSERT_EQUAL_UINT8(1, warnings);
+
+    // One channel back: the curve takes over again
+    sensor(3).badCrc = false;
+    runAcquisition(2500);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(3), getMaxTemperature());
+    controlFan();
+    TEST_ASSERT_FALSE(getFanControlStatus().noTemp);
+    TEST_ASSERT_EQUAL_UINT8(cfg.fan_min_speed, fanSpeed);
+}
+
+// ========== Mappings and Hot Plug ==========
+
+static void test_mapping_moves_a_sensor_to_channel_zero() {
+    bootTwentySensors();
+    uint16_t generation = getSensorChannelGeneration();
+
+    TEST_ASSERT_TRUE(addSensorMapping(sensor(18).rom, "Spindle", "spindle"));
+    runAcquisition(2500);
+
+    TEST_ASSERT_TRUE(getSensorChannelGeneration() != generation);
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS, temperatureCount);
+    TEST_ASSERT_EQUAL_MEMORY(sensor(18).rom, sensorCacheUID(0), 8);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(18), temperatures[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(18), getTempByAlias("spindle"));
+    TEST_ASSERT_EQUAL_UINT8(DS_TEMP_BASE, lookupDataSource("spindle"));
+    // The others moved up one channel
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(0), temperatures[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(19), temperatures[19]);
+
+    // The mapping was stored and comes back at boot
+    sensorMappings.clear();
+    loadSensorConfig();
+    TEST_ASSERT_EQUAL_size_t(1, sensorMappings.size());
+    TEST_ASSERT_EQUAL_STRING("spindle", sensorMappings[0].alias);
+}
+
+// Only 16 hex digits make a UID; anything else fails the import and
+// nothing is stored
+static void test_import_rejects_malformed_uids() {
+    const char* bad[] = {"ZZZZZZZZZZZZZZZZ", "28FF641E8C16045", "28FF641E8C1604501", "28FF641E8C16045G", ""};
+    char json[128];
+    for (const char* uid : bad) {
+        snprintf(json, sizeof(json), "{\"sensors\":[{\"uid\":\"%s\",\"alias\":\"spindle\"}]}", uid);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("invalid uid", importSensorMappingsJson(json), uid);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, sensorMappings.size());
+
+    const uint8_t uid[8] = {0x28, 0xFF, 0x64, 0x1E, 0x8C, 0x16, 0x04, 0x50};
+    TEST_ASSERT_NULL(importSensorMappingsJson("{\"sensors\":[{\"uid\":\"28:ff:64:1e:8c:16:04:50\",\"alias\":\"spindle\"}]}"));
+    sensorMappings.clear();
+    loadSensorConfig();
+    TEST_ASSERT_EQUAL_size_t(1, sensorMappings.size());
+    TEST_ASSERT_EQUAL_MEMORY(uid, sensorMappings[0].uid, 8);
+}
+
+static void test_hot_plugged_sensor_gets_a_channel() {
+    bootTwentySensors();
+    nativeOneWireBus[BUS_B_PIN].push_back(nativeDS18B20(TEST_SENSORS + 1, 60.0f));
+
+    // Found by the first scan that starts after the plug, then read from
+    // the next pass. 20 sensors leave little idle time between passes: the
+    // scan also runs during conversions.
+    runAcquisition(2 * BUS_SCAN_INTERVAL_MS + 5000);
+
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS + 1, temperatureCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 60.0f, temperatures[TEST_SENSORS]);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, 60.0f, getTempByAlias("temp20"));
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS + 1, getBusScanStats().present);
+
+    SensorEvent events[4];
+    TEST_ASSERT_EQUAL_UINT8(1, getSensorEvents(0, events, 4));
+    TEST_ASSERT_EQUAL(SENSOR_EVENT_ADDED, events[0].type);
+    TEST_ASSERT_EQUAL_UINT8(1, events[0].bus);
+}
+
+// More sensors than the room sized at boot: the cache, pipeline and
+// channel arrays grow instead of leaving the new ones untracked
+static void test_hot_plugged_sensors_grow_the_channels() {
+    const uint8_t added = 24;
+    bootTwentySensors();
+    for (uint8_t n = 0; n < added; n++) {
+        nativeOneWireBus[BUS_B_PIN].push_back(nativeDS18B20(TEST_SENSORS + 1 + n, 30.0f + 0.5f * n));
+    }
+    runAcquisition(2 * BUS_SCAN_INTERVAL_MS + 5000);
+
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS + added, sensorCacheCount());
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS + added, temperatureCount);
+    TEST_ASSERT_TRUE(sensorCacheCapacity() >= TEST_SENSORS + added);
+    for (uint8_t n = 0; n < TEST_SENSORS; n++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(n), temperatures[n]);
+    }
+    // In search order after the boot channels
+    for (uint8_t n = 0; n < added; n++) {
+        int8_t ch = sensorCacheFindUID(nativeOneWireBus[BUS_B_PIN][BUS_B_SENSORS + n].rom);
+        TEST_ASSERT_TRUE(ch >= TEST_SENSORS);
+        TEST_ASSERT_FLOAT_WITHIN(0.07f, 30.0f + 0.5f * n, temperatures[ch]);
+    }
+    TEST_ASSERT_NULL(strstr(lastWarning, "cache full"));
+}
+
+static void test_new_sensors_get_the_resolution_one_per_tick() {
+    cfg.temp_resolution = 10;
+    bootTwentySensors();
+    for (uint8_t n = 0; n < 3; n++) {
+        nativeOneWireBus[BUS_B_PIN].push_back(nativeDS18B20(TEST_SENSORS + 1 + n, 40.0f));
+    }
+
+    // Power-on 12 bits until the scan has found them, then one write per tick
+    uint8_t written = 0;
+    unsigned long limit = millis() + 2 * BUS_SCAN_INTERVAL_MS + 5000;
+    while (written < 3 && millis() < limit) {
+        updateTemperatureAcquisition();
+        nativeAdvanceMs(1);
+        uint8_t now = 0;
+        for (uint8_t n = 0; n < 3; n++) {
+            now += nativeOneWireBus[BUS_B_PIN][BUS_B_SENSORS + n].scratchpad[4] == configFor(10);
+        }
+        TEST_ASSERT_LESS_OR_EQUAL_UINT8(written + 1, now);
+        written = now;
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, written);
+}
+
+// ========== Touch Identification ==========
+
+static void test_identification_holds_candidate_channels() {
+    bootTwentySensors();
+    runAcquisition(3000);
+    float held = temperatures[5];
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(5), held);
+
+    // Drift that 12-bit and 9-bit conversions both see: for the passes of
+    // the session, none of it may reach the channel
+    sensor(5).tempC = sensorTemp(5) + 0.6875f;
+    TEST_ASSERT_TRUE(startSensorIdentification(30000, 1.0f));
+    unsigned long end = millis() + 4000;
+    while (millis() < end) {
+        runAcquisition(1);
+        TEST_ASSERT_EQUAL_FLOAT(held, temperatures[5]);
+    }
+    SensorIdentStatus status;
+    getSensorIdentification(status);
+    TEST_ASSERT_EQUAL(IDENT_WATCHING, status.state);
+    TEST_ASSERT_EQUAL_UINT8(TEST_SENSORS, status.candidates);
+    TEST_ASSERT_EQUAL_HEX8(configFor(9), sensor(5).scratchpad[4]);
+
+    // A hand on sensor 5
+    sensor(5).tempC += 3.0f;
+    unsigned long limit = millis() + 5000;
+    do {
+        runAcquisition(1);
+        getSensorIdentification(status);
+    } while (status.state == IDENT_WATCHING && millis() < limit);
+    TEST_ASSERT_EQUAL(IDENT_DETECTED, status.state);
+    TEST_ASSERT_EQUAL_MEMORY(sensor(5).rom, status.uid, 8);
+
+    // Back at 12 bits, the channel follows the sensor again (through the filter)
+    runAcquisition(25000);
+    TEST_ASSERT_EQUAL_HEX8(configFor(12), sensor(5).scratchpad[4]);
+    TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(5) + 3.6875f, temperatures[5]);
+    for (uint8_t ch = 0; ch < TEST_SENSORS; ch++) {
+        if (ch != 5) TEST_ASSERT_FLOAT_WITHIN(0.07f, sensorTemp(ch), temperatures[ch]);
+    }
+}
+
+// A parasite-powered sensor needs the line to itself while converting
+static void test_parasite_power_keeps_the_scan_off_conversions() {
+    nativeOneWireBus[BUS_A_PIN].push_back(nativeDS18B20(1, 30.0f));
+    nativeOneWireBus[BUS_A_PIN][0].parasite = true;
+    initDS18B20Sensors();
+    runAcquisition(BUS_SCAN_INTERVAL_MS + 1000);
+
+    while (tempAcqState != TEMP_ACQ_CONVERTING) runAcquisition(1);
+    uint16_t ticks = getBusScanStats().scanTicks;
+    while (tempAcqState == TEMP_ACQ_CONVERTING) runAcquisition(1);
+    TEST_ASSERT_EQUAL_UINT16(ticks, getBusScanStats().scanTicks);
+    // Between passes it still runs
+    TEST_ASSERT_GREATER_THAN_UINT32(0, getBusScanStats().scans);
+}
+
+// ========== Configuration ==========
+
+static void storeOneWirePins(const uint8_t* pins) {
+    prefs.begin("fluiddash", false);
+    prefs.putBytes("ow_pins", pins, ONEWIRE_MAX_BUSES);
+    prefs.end();
+}
+
+static void test_invalid_and_repeated_pins_are_dropped() {
+    // Flash pin, a repeat, an input-only pin and the fan PWM pin
+    const uint8_t pins[ONEWIRE_MAX_BUSES] = {BUS_B_PIN, 7, BUS_B_PIN, 35};
+    storeOneWirePins(pins);
+    loadConfig();
+
+    TEST_ASSERT_EQUAL_UINT8(BUS_B_PIN, cfg.onewire_pins[0]);
+    for (uint8_t i = 1; i < ONEWIRE_MAX_BUSES; i++) {
+        TEST_ASSERT_EQUAL_UINT8(ONEWIRE_PIN_NONE, cfg.onewire_pins[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, warnings);
+}
+
+static void test_no_usable_pin_falls_back_to_the_default_bus() {
+    const uint8_t pins[ONEWIRE_MAX_BUSES] = {FAN_PWM, TFT_CS, ONEWIRE_PIN_NONE, 60};
+    storeOneWirePins(pins);
+    loadConfig();
+
+    TEST_ASSERT_EQUAL_UINT8(ONE_WIRE_BUS_1, cfg.onewire_pins[0]);
+    for (uint8_t i = 1; i < ONEWIRE_MAX_BUSES; i++) {
+        TEST_ASSERT_EQUAL_UINT8(ONEWIRE_PIN_NONE, cfg.onewire_pins[i]);
+    }
+}
+
+static void test_update_interval_is_clamped() {
+    prefs.begin("fluiddash", false);
+    prefs.putUShort("temp_int", 0);
+    prefs.end();
+    loadConfig();
+    TEST_ASSERT_EQUAL_UINT16(TEMP_INTERVAL_MIN_MS, cfg.temp_update_interval);
+
+    prefs.begin("fluiddash", false);
+    prefs.putUShort("temp_int", 60000);
+    prefs.end();
+    loadConfig();
+    TEST_ASSERT_EQUAL_UINT16(TEMP_INTERVAL_MAX_MS, cfg.temp_update_interval);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_sensor_gets_a_channel);
+    RUN_TEST(test_status_lists_every_channel);
+    RUN_TEST(test_silent_sensor_goes_stale);
+    RUN_TEST(test_all_stale_drives_the_fan_at_the_limit);
+    RUN_TEST(test_mapping_moves_a_sensor_to_channel_zero);
+    RUN_TEST(test_import_rejects_malformed_uids);
+    RUN_TEST(test_hot_plugged_sensor_gets_a_channel);
+    RUN_TEST(test_hot_plugged_sensors_grow_the_channels);
+    RUN_TEST(test_new_sensors_get_the_resolution_one_per_tick);
+    RUN_TEST(test_identification_holds_candidate_channels);
+    RUN_TEST(test_parasite_power_keeps_the_scan_off_conversions);
+    RUN_TEST(test_invalid_and_repeated_pins_are_dropped);
+    RUN_TEST(test_no_usable_pin_falls_back_to_the_default_bus);
+    RUN_TEST(test_update_interval_is_clamped);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+// Host tests for the temperature processing pipeline (sensors/sensor_pipeline.cpp):
+//   pio test -e native -f test_sensor_pipeline
+//
+// One group per stage (gate, hold, offset, filter, peak), driven through
+// sensorPipelineProcess() the way readNextScratchpad() calls it, and a
+// benchmark of 32 channels per pass.
+
+#include <unity.h>
+#include <chrono>
+#include "sensors/sensor_pipeline.cpp"
+
+Config cfg;
+
+void logWrite(uint8_t, const char*, const char*, ...) {}
+
+#define TEST_CHANNELS   32
+#define STALE_MS        3500    // 3 missed 1 s cycles + half a cycle, as rebuildSensorCache() sets
+
+static uint32_t now = 0;
+
+// One sample 1 s after the previous one
+static PipeResult sample(uint8_t ch, float tempC, bool readOk = true) {
+    now += 1000;
+    return sensorPipelineProcess(ch, readOk, tempC, now);
+}
+
+void setUp() {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.temp_filter = TEMP_FILTER_NONE;
+    TEST_ASSERT_TRUE(sensorPipelineInit(TEST_CHANNELS));
+    sensorPipelineReset(STALE_MS);
+    pipeStats = {};
+    now = 0;
+}
+
+void tearDown() {}
+
+// ========== Gate ==========
+
+static void test_first_sample_is_taken_as_is() {
+    TEST_ASSERT_TRUE(isnan(sensorPipelineValue(0)));
+    TEST_ASSERT_FALSE(sensorPipelineValid(0));
+    TEST_ASSERT_EQUAL(PIPE_ACCEPTED, sample(0, 25.0f));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, sensorPipelineValue(0));
+    TEST_ASSERT_TRUE(sensorPipelineValid(0));
+}
+
+static void test_out_of_range_is_rejected() {
+    sample(0, 25.0f);
+    TEST_ASSERT_EQUAL(PIPE_OUT_OF_RANGE, sample(0, 126.0f));
+    TEST_ASSERT_EQUAL(PIPE_OUT_OF_RANGE, sample(0, -56.0f));
+    TEST_ASSERT_EQUAL(PIPE_OUT_OF_RANGE, sample(0, NAN));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, sensorPipelineValue(0));
+    TEST_ASSERT_EQUAL_UINT32(3, getSensorPipelineStats().outOfRange);
+}
+
+static void test_single_spike_is_held_back() {
+    sample(0, 25.0f);
+    TEST_ASSERT_EQUAL(PIPE_SPIKE, sample(0, 60.0f));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, sensorPipelineValue(0));
+    // Not repeated: dropped
+    TEST_ASSERT_EQUAL(PIPE_ACCEPTED, sample(0, 25.5f));
+    TEST_ASSERT_EQUAL_FLOAT(25.5f, sensorPipelineValue(0));
+    TEST_ASSERT_EQUAL_UINT32(1, getSensorPipelineStats().spikes);
+}
+
+static void test_repeated_step_is_accepted() {
+    sample(0, 25.0f);
+    TEST_ASSERT_EQUAL(PIPE_SPIKE, sample(0, 60.0f));
+    TEST_ASSERT_EQUAL(PIPE_ACCEPTED, sample(0, 60.5f));
+    TEST_ASSERT_EQUAL_FLOAT(60.5f, sensorPipelineValue(0));
+}
+
+// ========== Hold ==========
+
+static void test_failed_reads_hold_then_go_stale() {
+    sample(0, 30.0f);
+    // Within STALE_MS: the last good value stays
+    TEST_ASSERT_EQUAL(PIPE_READ_FAILED, sample(0, 0.0f, false));
+    TEST_ASSERT_EQUAL(PIPE_READ_FAILED, sample(0, 0.0f, false));
+    TEST_ASSERT_EQUAL(PIPE_READ_FAILED, sample(0, 0.0f, false));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, sensorPipelineValue(0));
+    TEST_ASSERT_TRUE(sensorPipelineValid(0));
+
+    // Older than that: NAN, never 0.0
+    sample(0, 0.0f, false);
+    TEST_ASSERT_TRUE(isnan(sensorPipelineValue(0)));
+    TEST_ASSERT_FALSE(sensorPipelineValid(0));
+    TEST_ASSERT_EQUAL_UINT32(1, getSensorPipelineStats().staleEvents);
+    TEST_ASSERT_EQUAL_UINT32(4, getSensorPipelineStats().readFailures);
+
+    // The next good sample restarts the channel, whatever the step
+    TEST_ASSERT_EQUAL(PIPE_ACCEPTED, sample(0, 50.0f));
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, sensorPipelineValue(0));
+}
+
+static void test_seed_carries_a_channel_over() {
+    sensorPipelineSeed(3, 41.0f, 45.0f, 0);
+    TEST_ASSERT_EQUAL_FLOAT(41.0f, sensorPipelineValue(3));
+    TEST_ASSERT_EQUAL_FLOAT(45.0f, sensorPipelinePeak(3));
+    // Stale from the seeded time, not from the seed call
+    now = STALE_MS;
+    TEST_ASSERT_EQUAL(PIPE_READ_FAILED, sample(3, 0.0f, false));
+    TEST_ASSERT_TRUE(isnan(sensorPipelineValue(3)));
+}
+
+// ========== Offset ==========
+
+static void test_offsets_apply_to_the_legacy_channels() {
+    cfg.temp_offset_x = 1.5f;
+    cfg.temp_offset_z = -2.0f;
+    sensorPipelineLoadOffsets();
+    for (uint8_t ch = 0; ch < 5; ch++) sample(ch, 30.0f);
+    TEST_ASSERT_EQUAL_FLOAT(31.5f, sensorPipelineValue(0));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, sensorPipelineValue(1));
+    TEST_ASSERT_EQUAL_FLOAT(28.0f, sensorPipelineValue(3));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, sensorPipelineValue(4));
+}
+
+// ========== Filter ==========
+
+static void test_ema_filter() {
+    cfg.temp_filter = TEMP_FILTER_EMA;
+    sample(0, 20.0f);
+    sample(0, 24.0f);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, sensorPipelineValue(0));
+    sample(0, 24.0f);
+    TEST_ASSERT_EQUAL_FLOAT(21.75f, sensorPipelineValue(0));
+}
+
+static void test_median_filter_drops_a_small_outlier() {
+    cfg.temp_filter = TEMP_FILTER_MEDIAN;
+    const float inputs[] = {20.0f, 20.5f, 29.0f, 20.25f, 20.75f};
+    for (float input : inputs) sample(0, input);
+    TEST_ASSERT_EQUAL_FLOAT(20.5f, sensorPipelineValue(0));
+    // Window of 5: the outlier ages out
+    sample(0, 20.5f);
+    sample(0, 20.5f);
+    sample(0, 20.5f);
+    TEST_ASSERT_EQUAL_FLOAT(20.5f, sensorPipelineValue(0));
+}
+
+// ========== Peak ==========
+
+static void test_peak_follows_the_filtered_value() {
+    cfg.temp_filter = TEMP_FILTER_EMA;
+    TEST_ASSERT_TRUE(isnan(sensorPipelinePeak(0)));
+    sample(0, 20.0f);
+    sample(0, 28.0f);     // Filtered: 22
+    sample(0, 20.0f);
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, sensorPipelinePeak(0));
+    // A stale channel keeps its peak
+    for (int i = 0; i < 4; i++) sample(0, 0.0f, false);
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, sensorPipelinePeak(0));
+}
+
+static void test_reset_empties_every_channel() {
+    for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) sample(ch, 30.0f);
+    sensorPipelineReset(STALE_MS);
+    for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) {
+        TEST_ASSERT_TRUE(isnan(sensorPipelineValue(ch)));
+        TEST_ASSERT_TRUE(isnan(sensorPipelinePeak(ch)));
+    }
+    TEST_ASSERT_EQUAL(PIPE_READ_FAILED, sensorPipelineProcess(TEST_CHANNELS, true, 30.0f, now));
+}
+
+// ========== Benchmark ==========
+// A pass of 32 channels, as one acquisition cycle runs them (one sample
+// per channel), with each filter. Inputs wander by a few tenths of a
+// degree, with a read failure and a spike now and then.
+
+static void benchmark_thirty_two_channels() {
+    const int passes = 20000;
+    const uint8_t filters[] = {TEMP_FILTER_NONE, TEMP_FILTER_EMA, TEMP_FILTER_MEDIAN};
+    const char* const names[] = {"none", "EMA", "median"};
+    using Clock = std::chrono::steady_clock;
+    char message[120];
+
+    for (uint8_t f = 0; f < 3; f++) {
+        cfg.temp_filter = filters[f];
+        sensorPipelineReset(STALE_MS);
+        uint32_t accepted = getSensorPipelineStats().accepted;
+
+        Clock::time_point start = Clock::now();
+        for (int n = 0; n < passes; n++) {
+            now += 1000;
+            for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) {
+                uint32_t noise = (n * 31 + ch * 17) % 97;
+                bool readOk = noise != 0;
+                float tempC = 25.0f + ch * 0.5f + noise * 0.01f + (noise == 1 ? 40.0f : 0.0f);
+                sensorPipelineProcess(ch, readOk, tempC, now);
+            }
+        }
+        double passNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / passes;
+
+        TEST_ASSERT_GREATER_THAN_UINT32(accepted + passes * TEST_CHANNELS * 9 / 10,
+                                        getSensorPipelineStats().accepted);
+        for (uint8_t ch = 0; ch < TEST_CHANNELS; ch++) TEST_ASSERT_TRUE(sensorPipelineValid(ch));
+
+        snprintf(message, sizeof(message), "32 channels, %s filter: %.0f ns per pass (%.1f ns per sample)",
+                 names[f], passNs, passNs / TEST_CHANNELS);
+        TEST_MESSAGE(message);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sample_is_taken_as_is);
+    RUN_TEST(test_out_of_range_is_rejected);
+    RUN_TEST(test_single_spike_is_held_back);
+    RUN_TEST(test_repeated_step_is_accepted);
+    RUN_TEST(test_failed_reads_hold_then_go_stale);
+    RUN_TEST(test_seed_carries_a_channel_over);
+    RUN_TEST(test_offsets_apply_to_the_legacy_channels);
+    RUN_TEST(test_ema_filter);
+    RUN_TEST(test_median_filter_drops_a_small_outlier);
+    RUN_TEST(test_peak_follows_the_filtered_value);
+    RUN_TEST(test_reset_empties_every_channel);
+    RUN_TEST(benchmark_thirty_two_channels);
+    return UNITY_END();
+}
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Decode FluidDash motion trace files (/logs/trc_NNNNN.bin) - see
+src/history/motion_trace.h for the format.
+
+  trace_decode.py csv trc_00003.bin [more files] > trace.csv
+  trace_decode.py csv http://fluiddash.local/api/trace-file?n=3 > trace.csv
+  trace_decode.py replay trc_00003.bin [--port 81] [--speed 4] [--loop]
+
+replay pretends to be FluidNC: point the dashboard's FluidNC IP at this
+machine and it receives the recorded status reports over its normal
+WebSocket connection, at the recorded pace (times --speed), and parses them
+with parseFluidNCStatus() like live ones.
+
+Standard library only.
+"""
+
+import argparse
+import base64
+import hashlib
+import socket
+import struct
+import sys
+import threading
+import time
+import urllib.request
+
+BLOCK_SIZE = 512
+MAGIC = 0x3142544D                  # "MTB1"
+HEADER = struct.Struct("<IIIHHHBBII")
+STATE = struct.Struct("<6i4B")
+DATA_OFFSET = HEADER.size + STATE.size
+RTC_TIME = 0x01
+
+AXES = "XYZA"
+TRACE_FEED, TRACE_SPINDLE, TRACE_STATE, TRACE_OVERRIDES = 0x10, 0x20, 0x40, 0x80
+
+# TelemetryMachineState, as FluidNC spells them
+STATES = ["Offline", "Idle", "Run", "Hold", "Jog", "Alarm", "Door", "Check", "Home", "Sleep", "Other"]
+
+
+def crc16(data):
+    """OneWire::crc16 (CRC-16/ARC)"""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def div_trunc(num, den):
+    """C integer division (toward zero)"""
+    q = abs(num) // abs(den)
+    return q if (num >= 0) == (den > 0) else -q
+
+
+def decode_block(block):
+    """Yield one dict per report of a valid block"""
+    (magic, file_no, sequence, count, used, crc, flags, axes,
+     clock, base_ms) = HEADER.unpack_from(block)
+    values = STATE.unpack_from(block, HEADER.size)
+    pos = list(values[0:4])
+    feed, spindle = values[4], values[5]
+    state = values[6]
+    overrides = list(values[7:10])
+
+    # clock is the record clock at base_ms; the clock runs with millis()
+    boot_clock = clock - base_ms // 1000
+    last_ms = base_ms
+    prev_pos, prev_dt = None, 0
+    data = block[DATA_OFFSET:DATA_OFFSET + used]
+    p = 0
+    for _ in range(count):
+        mask = data[p]
+        p += 1
+        dt, p = read_varint(data, p)
+        new_pos = []
+        for axis in range(4):
+            predicted = pos[axis]
+            if prev_dt:
+                predicted += div_trunc((pos[axis] - prev_pos[axis]) * dt, prev_dt)
+            if mask & (1 << axis):
+                residual, p = read_varint(data, p)
+                predicted += unzigzag(residual)
+            new_pos.append(predicted)
+        if mask & TRACE_FEED:
+            delta, p = read_varint(data, p)
+            feed += unzigzag(delta)
+        if mask & TRACE_SPINDLE:
+            delta, p = read_varint(data, p)
+            spindle += unzigzag(delta)
+        if mask & TRACE_STATE:
+            state = data[p]
+            p += 1
+        if mask & TRACE_OVERRIDES:
+            overrides = list(data[p:p + 3])
+            p += 3
+
+        prev_pos, prev_dt, pos = pos, dt, new_pos
+        last_ms += dt
+        yield {
+            "ms": last_ms,
+            "time": boot_clock + last_ms / 1000.0,
+            "rtc": bool(flags & RTC_TIME),
+            "state": STATES[state] if state < len(STATES) else "Other",
+            "pos": [v / 1000.0 for v in pos],
+            "feed": feed,
+            "spindle": spindle,
+            "overrides": overrides,
+        }
+
+
+def read_source(source):
+    if source.startswith("http://") or source.startswith("https://"):
+        with urllib.request.urlopen(source) as response:
+            return response.read()
+    with open(source, "rb") as f:
+        return f.read()
+
+
+def decode(sources):
+    """Yield every report of the files, stopping each at a torn block"""
+    for source in sources:
+        data = read_source(source)
+        for n in range(len(data) // BLOCK_SIZE):
+            block = bytearray(data[n * BLOCK_SIZE:(n + 1) * BLOCK_SIZE])
+            magic, _, sequence = struct.unpack_from("<III", block)
+            crc = struct.unpack_from("<H", block, 16)[0]
+            struct.pack_into("<H", block, 16, 0)
+            if magic != MAGIC or sequence != n + 1 or crc16(block) != crc:
+                print(f"{source}: block {n + 1} damaged, {len(data) // BLOCK_SIZE - n} blocks skipped",
+                      file=sys.stderr)
+                break
+            yield from decode_block(bytes(block))
+        if len(data) % BLOCK_SIZE:
+            print(f"{source}: {len(data) % BLOCK_SIZE} trailing bytes (torn block)", file=sys.stderr)
+
+
+def status_line(report):
+    x, y, z, a = report["pos"]
+    return "<%s|MPos:%.3f,%.3f,%.3f,%.3f|FS:%d,%d|Ov:%d,%d,%d>" % (
+        report["state"], x, y, z, a, report["feed"], report["spindle"], *report["overrides"])
+
+
+def write_csv(sources):
+    out = sys.stdout
+    out.write("time,ms,state,x,y,z,a,feed,spindle,feed_ovr,rapid_ovr,spindle_ovr\n")
+    for r in decode(sources):
+        out.write("%.3f,%d,%s,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d\n" % (
+            r["time"], r["ms"], r["state"], *r["pos"], r["feed"], r["spindle"], *r["overrides"]))
+
+
+# ========== Replay (minimal WebSocket server) ==========
+
+def ws_frame(payload, opcode=0x2):
+    header = bytes([0x80 | opcode])
+    if len(payload) < 126:
+        header += bytes([len(payload)])
+    elif len(payload) < 65536:
+        header += bytes([126]) + struct.pack(">H", len(payload))
+    else:
+        header += bytes([127]) + struct.pack(">Q", len(payload))
+    return header + payload
+
+
+def ws_accept(conn):
+    request = b""
+    while b"\r\n\r\n" not in request:
+        chunk = conn.recv(1024)
+        if not chunk:
+            return False
+        request += chunk
+    key = None
+    for line in request.decode(errors="replace").split("\r\n"):
+        if line.lower().startswith("sec-websocket-key:"):
+            key = line.split(":", 1)[1].strip()
+    if key is None:
+        return False
+    accept = base64.b64encode(hashlib.sha1((key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11").encode()).digest())
+    conn.sendall(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                 b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+    return True
+
+
+def ws_drain(conn, lock, closed):
+    """Read the client's frames ("?" polls); answer pings, stop on close"""
+    try:
+        while True:
+            head = conn.recv(2)
+            if len(head) < 2:
+                break
+            opcode, length = head[0] & 0x0F, head[1] & 0x7F
+            if length == 126:
+                length = struct.unpack(">H", conn.recv(2))[0]
+            elif length == 127:
+                length = struct.unpack(">Q", conn.recv(8))[0]
+            mask = conn.recv(4) if head[1] & 0x80 else b"\0\0\0\0"
+            payload = b""
+            while len(payload) < length:
+                payload += conn.recv(length - len(payload))
+            payload = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+            if opcode == 0x8:
+                break
+            if opcode == 0x9:
+                with lock:
+                    conn.sendall(ws_frame(payload, 0xA))
+    except OSError:
+        pass
+    closed.set()
+
+
+def replay(sources, port, speed, loop):
+    reports = list(decode(sources))
+    if not reports:
+        sys.exit("No reports to replay")
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("", port))
+    server.listen(1)
+    print(f"{len(reports)} reports; waiting for the dashboard on port {port}", file=sys.stderr)
+
+    while True:
+        conn, address = server.accept()
+        if not ws_accept(conn):
+            conn.close()
+            continue
+        print(f"Dashboard connected from {address[0]}", file=sys.stderr)
+        lock, closed = threading.Lock(), threading.Event()
+        threading.Thread(target=ws_drain, args=(conn, lock, closed), daemon=True).start()
+
+        try:
+            while not closed.is_set():
+                start, first_ms = time.monotonic(), reports[0]["ms"]
+                for n, report in enumerate(reports):
+                    delay = (report["ms"] - first_ms) / 1000.0 / speed - (time.monotonic() - start)
+                    if delay > 0 and closed.wait(delay):
+                        break
+                    with lock:
+                        conn.sendall(ws_frame(status_line(report).encode()))
+                    if n % 100 == 0:
+                        print(f"\r{n + 1}/{len(reports)}", end="", file=sys.stderr)
+                print(file=sys.stderr)
+                if not loop:
+                    break
+        except OSError:
+            pass
+        conn.close()
+        if not loop:
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    csv_parser = sub.add_parser("csv", help="decode to CSV on stdout")
+    csv_parser.add_argument("sources", nargs="+", help="trace files or /api/trace-file URLs, oldest first")
+    replay_parser = sub.add_parser("replay", help="serve the reports to a dashboard as FluidNC would")
+    replay_parser.add_argument("sources", nargs="+")
+    replay_parser.add_argument("--port", type=int, default=81, help="WebSocket port (cfg.fluidnc_port)")
+    replay_parser.add_argument("--speed", type=float, default=1.0, help="playback speed factor")
+    replay_parser.add_argument("--loop", action="store_true", help="repeat until interrupted")
+    args = parser.parse_args()
+
+    if args.command == "csv":
+        write_csv(args.sources)
+    else:
+        replay(args.sources, args.port, args.speed, args.loop)
+
+
+if __name__ == "__main__":
+    main()